@@ -70,6 +70,10 @@ std::string GraphicsErrCategory::message(int ev) const {
       return "Dispatch compute is not allowed in render pass";
     case GraphicsErrc::UnsupportedExtension:
       return "Extension is not suported";
+    case GraphicsErrc::InvalidCommandBundle:
+      return "Command bundle is incomplete, or doesn't match render-pass";
+    case GraphicsErrc::InvalidVertexInput:
+      return "Vertex streams don't match vertex shader inputs";
     }
   return "(unrecognized error)";
   }
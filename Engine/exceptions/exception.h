@@ -82,6 +82,8 @@ enum class GraphicsErrc {
   ComputeCallInRenderPass      = 12,
   UnsupportedExtension         = 13,
   InvalidAccelerationStructure = 14,
+  InvalidCommandBundle         = 15,
+  InvalidVertexInput           = 16,
   };
 
 struct GraphicsErrCategory : std::error_category {
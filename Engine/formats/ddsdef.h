@@ -110,9 +110,45 @@ namespace Tempest {
       DWORD      dwTextureStage;
       };
 
+    struct DDSHEADERDXT10 {
+      DWORD      dxgiFormat;
+      DWORD      resourceDimension;
+      DWORD      miscFlag;
+      DWORD      arraySize;
+      DWORD      miscFlags2;
+      };
+
     const unsigned int FOURCC_DXT1 = 827611204;
     const unsigned int FOURCC_DXT3 = 861165636;
     const unsigned int FOURCC_DXT5 = 894720068;
+    const unsigned int FOURCC_ATI1 = 826889281;
+    const unsigned int FOURCC_ATI2 = 843666497;
+    const unsigned int FOURCC_BC4U = 1429488450;
+    const unsigned int FOURCC_BC5U = 1429553986;
+    const unsigned int FOURCC_DX10 = 808540228;
+
+    // subset of DXGI_FORMAT, used by DDSHEADERDXT10
+    enum DdsDxgiFormat : uint32_t {
+      DDS_DXGI_R16G16B16A16_FLOAT  = 10,
+      DDS_DXGI_R10G10B10A2_UNORM   = 24,
+      DDS_DXGI_R11G11B10_FLOAT     = 26,
+      DDS_DXGI_R8G8B8A8_UNORM      = 28,
+      DDS_DXGI_R8G8B8A8_UNORM_SRGB = 29,
+      DDS_DXGI_R16G16_FLOAT        = 34,
+      DDS_DXGI_R16_FLOAT           = 54,
+      DDS_DXGI_BC1_UNORM           = 71,
+      DDS_DXGI_BC1_UNORM_SRGB      = 72,
+      DDS_DXGI_BC2_UNORM           = 74,
+      DDS_DXGI_BC2_UNORM_SRGB      = 75,
+      DDS_DXGI_BC3_UNORM           = 77,
+      DDS_DXGI_BC3_UNORM_SRGB      = 78,
+      DDS_DXGI_BC4_UNORM           = 80,
+      DDS_DXGI_BC5_UNORM           = 83,
+      DDS_DXGI_BC7_UNORM           = 98,
+      DDS_DXGI_BC7_UNORM_SRGB      = 99,
+      };
+
+    const unsigned int DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
     }
 #pragma pack(pop)
   }
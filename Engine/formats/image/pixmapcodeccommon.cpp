@@ -230,6 +230,7 @@ bool PixmapCodecCommon::save(ODevice &f, const char *ext, const uint8_t* cdata,
     case TextureFormat::RG16:
     case TextureFormat::RGB16:
     case TextureFormat::RGBA16:
+    case TextureFormat::RGBA8_SRGB:
       isNorm = true;
       break;
     case TextureFormat::R32F:
@@ -256,9 +257,20 @@ bool PixmapCodecCommon::save(ODevice &f, const char *ext, const uint8_t* cdata,
     case TextureFormat::DXT1:
     case TextureFormat::DXT3:
     case TextureFormat::DXT5:
+    case TextureFormat::DXT1_SRGB:
+    case TextureFormat::DXT3_SRGB:
+    case TextureFormat::DXT5_SRGB:
+    case TextureFormat::BC4:
+    case TextureFormat::BC5:
+    case TextureFormat::BC7:
+    case TextureFormat::BC7_SRGB:
+      break;
+    case TextureFormat::RGB10A2:
       break;
     case TextureFormat::R11G11B10UF:
     case TextureFormat::RGBA16F:
+    case TextureFormat::R16F:
+    case TextureFormat::RG16F:
       // hdr or exr?
       break;
     }
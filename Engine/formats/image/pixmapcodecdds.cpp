@@ -1,15 +1,39 @@
 #include "pixmapcodecdds.h"
 
 #include <Tempest/IDevice>
+#include <Tempest/Pixmap>
 
 #include <algorithm>
 #include <cstring>
 
-#include "thirdparty/squish/squish.h"
 #include "../ddsdef.h"
 
 using namespace Tempest;
 
+static TextureFormat dxgiFormat(uint32_t dxgi) {
+  using namespace Tempest::Detail;
+  switch(dxgi) {
+    case DDS_DXGI_R16G16B16A16_FLOAT:  return TextureFormat::RGBA16F;
+    case DDS_DXGI_R10G10B10A2_UNORM:   return TextureFormat::RGB10A2;
+    case DDS_DXGI_R11G11B10_FLOAT:     return TextureFormat::R11G11B10UF;
+    case DDS_DXGI_R8G8B8A8_UNORM:      return TextureFormat::RGBA8;
+    case DDS_DXGI_R8G8B8A8_UNORM_SRGB: return TextureFormat::RGBA8_SRGB;
+    case DDS_DXGI_R16G16_FLOAT:        return TextureFormat::RG16F;
+    case DDS_DXGI_R16_FLOAT:           return TextureFormat::R16F;
+    case DDS_DXGI_BC1_UNORM:           return TextureFormat::DXT1;
+    case DDS_DXGI_BC1_UNORM_SRGB:      return TextureFormat::DXT1_SRGB;
+    case DDS_DXGI_BC2_UNORM:           return TextureFormat::DXT3;
+    case DDS_DXGI_BC2_UNORM_SRGB:      return TextureFormat::DXT3_SRGB;
+    case DDS_DXGI_BC3_UNORM:           return TextureFormat::DXT5;
+    case DDS_DXGI_BC3_UNORM_SRGB:      return TextureFormat::DXT5_SRGB;
+    case DDS_DXGI_BC4_UNORM:           return TextureFormat::BC4;
+    case DDS_DXGI_BC5_UNORM:           return TextureFormat::BC5;
+    case DDS_DXGI_BC7_UNORM:           return TextureFormat::BC7;
+    case DDS_DXGI_BC7_UNORM_SRGB:      return TextureFormat::BC7_SRGB;
+    }
+  return TextureFormat::Undefined;
+  }
+
 PixmapCodecDDS::PixmapCodecDDS() {  
   }
 
@@ -33,44 +57,50 @@ uint8_t* PixmapCodecDDS::load(PixmapCodec::Context &c, uint32_t &ow, uint32_t &o
   ow = ddsd.dwWidth;
   oh = ddsd.dwHeight;
 
-  int compressType = squish::kDxt1;
   switch(ddsd.ddpfPixelFormat.dwFourCC) {
     case FOURCC_DXT1:
-      bpp          = 3;
-      compressType = squish::kDxt1;
-      frm          = TextureFormat::DXT1;
+      frm = TextureFormat::DXT1;
       break;
-
     case FOURCC_DXT3:
-      bpp          = 4;
-      compressType = squish::kDxt3;
-      frm          = TextureFormat::DXT3;
+      frm = TextureFormat::DXT3;
       break;
-
     case FOURCC_DXT5:
-      bpp          = 4;
-      compressType = squish::kDxt5;
-      frm          = TextureFormat::DXT5;
+      frm = TextureFormat::DXT5;
       break;
-
+    case FOURCC_ATI1:
+    case FOURCC_BC4U:
+      frm = TextureFormat::BC4;
+      break;
+    case FOURCC_ATI2:
+    case FOURCC_BC5U:
+      frm = TextureFormat::BC5;
+      break;
+    case FOURCC_DX10: {
+      DDSHEADERDXT10 dx10={};
+      if(f.read(&dx10,sizeof(dx10))!=sizeof(dx10))
+        return nullptr;
+      // arrays and cubemaps are not supported by Pixmap
+      if(dx10.arraySize>1 || (dx10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)!=0)
+        return nullptr;
+      frm = dxgiFormat(dx10.dxgiFormat);
+      if(frm==TextureFormat::Undefined)
+        return nullptr;
+      break;
+      }
     default:
       return nullptr;
     }
 
-  if( ddsd.dwLinearSize == 0 ) {
-    //return false;
-    }
-
   mipCnt            = std::max(1u, ddsd.dwMipMapCount);
-  size_t blocksize  = (compressType==squish::kDxt1) ? 8 : 16;
+  size_t blocksize  = Pixmap::blockSizeForFormat(frm);
   size_t bufferSize = 0;
 
-  size_t w = size_t(ow), h = size_t(oh);
+  uint32_t w = ow, h = oh;
   for(size_t i=0; i<mipCnt; i++){
-    size_t blockcount = ((w+3)/4)*((h+3)/4);
-    bufferSize += blockcount*blocksize;
-    w = std::max<size_t>(1,w/2);
-    h = std::max<size_t>(1,h/2);
+    Size blockcount = Pixmap::blockCount(frm,w,h);
+    bufferSize += size_t(blockcount.w)*size_t(blockcount.h)*blocksize;
+    w = std::max<uint32_t>(1,w/2);
+    h = std::max<uint32_t>(1,h/2);
     }
 
   uint8_t* ddsv = reinterpret_cast<uint8_t*>(std::malloc(bufferSize));
@@ -79,7 +109,7 @@ uint8_t* PixmapCodecDDS::load(PixmapCodec::Context &c, uint32_t &ow, uint32_t &o
     return nullptr;
     }
 
-  bpp    = 0;
+  bpp    = uint32_t(Pixmap::bppForFormat(frm));
   dataSz = bufferSize;
   return ddsv;
   }
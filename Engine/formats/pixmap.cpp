@@ -63,10 +63,10 @@ struct Pixmap::Impl {
 
     if(isCompressed(other.frm)) {
       assert(frm==TextureFormat::RGB8 || frm==TextureFormat::RGBA8); // rest is handled outside of this function
-      static const int kfrm[] = {squish::kDxt1,squish::kDxt3,squish::kDxt5};
+      const int kfrm = squishFormat(other.frm);
       if(frm==TextureFormat::RGB8)
-        ddsToRgba(data,other.data,w,h,kfrm[uint8_t(other.frm)-uint8_t(TextureFormat::DXT1)],3); else
-        ddsToRgba(data,other.data,w,h,kfrm[uint8_t(other.frm)-uint8_t(TextureFormat::DXT1)],4);
+        ddsToRgba(data,other.data,w,h,kfrm,3); else
+        ddsToRgba(data,other.data,w,h,kfrm,4);
       return;
       }
 
@@ -247,9 +247,18 @@ struct Pixmap::Impl {
 
   static uint8_t bytesPerChannel(TextureFormat frm) {
     switch(frm) {
-      case TextureFormat::DXT1:    return 0;
-      case TextureFormat::DXT3:    return 0;
-      case TextureFormat::DXT5:    return 0;
+      case TextureFormat::DXT1:      return 0;
+      case TextureFormat::DXT3:      return 0;
+      case TextureFormat::DXT5:      return 0;
+      case TextureFormat::DXT1_SRGB: return 0;
+      case TextureFormat::DXT3_SRGB: return 0;
+      case TextureFormat::DXT5_SRGB: return 0;
+      case TextureFormat::BC4:       return 0;
+      case TextureFormat::BC5:       return 0;
+      case TextureFormat::BC7:       return 0;
+      case TextureFormat::BC7_SRGB:  return 0;
+      // packed
+      case TextureFormat::RGB10A2:   return 0;
       //---
       default:
         return uint8_t(Pixmap::bppForFormat(frm)/Pixmap::componentCount(frm));
@@ -257,9 +266,24 @@ struct Pixmap::Impl {
     }
 
   static bool isCompressed(TextureFormat frm) {
-    return frm==TextureFormat::DXT1 ||
-           frm==TextureFormat::DXT3 ||
-           frm==TextureFormat::DXT5;
+    return isCompressedFormat(frm);
+    }
+
+  static int squishFormat(TextureFormat frm) {
+    switch(frm) {
+      case TextureFormat::DXT1:
+      case TextureFormat::DXT1_SRGB:
+        return squish::kDxt1;
+      case TextureFormat::DXT3:
+      case TextureFormat::DXT3_SRGB:
+        return squish::kDxt3;
+      case TextureFormat::DXT5:
+      case TextureFormat::DXT5_SRGB:
+        return squish::kDxt5;
+      default:
+        // BC4, BC5, BC7: decompression is not implemented
+        throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat, formatName(frm));
+      }
     }
 
   void save(ODevice& f,const char* ext){
@@ -455,6 +479,18 @@ size_t Pixmap::blockSizeForFormat(TextureFormat frm) {
     //---
     case TextureFormat::R11G11B10UF: return 4;
     case TextureFormat::RGBA16F:     return 8;
+    case TextureFormat::R16F:        return 2;
+    case TextureFormat::RG16F:       return 4;
+    case TextureFormat::RGB10A2:     return 4;
+    case TextureFormat::RGBA8_SRGB:  return 4;
+    //---
+    case TextureFormat::DXT1_SRGB:   return 8;
+    case TextureFormat::DXT3_SRGB:   return 16;
+    case TextureFormat::DXT5_SRGB:   return 16;
+    case TextureFormat::BC4:         return 8;
+    case TextureFormat::BC5:         return 16;
+    case TextureFormat::BC7:         return 16;
+    case TextureFormat::BC7_SRGB:    return 16;
     }
   return 0;
   }
@@ -495,6 +531,18 @@ uint8_t Pixmap::componentCount(TextureFormat frm) {
     //---
     case TextureFormat::R11G11B10UF: return 3;
     case TextureFormat::RGBA16F:     return 4;
+    case TextureFormat::R16F:        return 1;
+    case TextureFormat::RG16F:       return 2;
+    case TextureFormat::RGB10A2:     return 4;
+    case TextureFormat::RGBA8_SRGB:  return 4;
+    //---
+    case TextureFormat::DXT1_SRGB:   return 3;
+    case TextureFormat::DXT3_SRGB:   return 4;
+    case TextureFormat::DXT5_SRGB:   return 4;
+    case TextureFormat::BC4:         return 1;
+    case TextureFormat::BC5:         return 2;
+    case TextureFormat::BC7:         return 4;
+    case TextureFormat::BC7_SRGB:    return 4;
     }
   return 0;
   }
@@ -526,10 +574,21 @@ Size Pixmap::blockCount(TextureFormat frm, uint32_t w, uint32_t h) {
     case TextureFormat::Depth32F:
     case TextureFormat::R11G11B10UF:
     case TextureFormat::RGBA16F:
+    case TextureFormat::R16F:
+    case TextureFormat::RG16F:
+    case TextureFormat::RGB10A2:
+    case TextureFormat::RGBA8_SRGB:
       return Size(w,h);
     case TextureFormat::DXT1:
     case TextureFormat::DXT3:
     case TextureFormat::DXT5:
+    case TextureFormat::DXT1_SRGB:
+    case TextureFormat::DXT3_SRGB:
+    case TextureFormat::DXT5_SRGB:
+    case TextureFormat::BC4:
+    case TextureFormat::BC5:
+    case TextureFormat::BC7:
+    case TextureFormat::BC7_SRGB:
       return Size((w+3)/4,(h+3)/4);
       break;
     }
@@ -73,6 +73,48 @@ bool AbstractGraphicsApi::Props::hasAtomicFormat(TextureFormat f) const {
   return (atomFormat&m)!=0;
   }
 
+uint8_t* AbstractGraphicsApi::Buffer::map() {
+  return nullptr;
+  }
+
+void AbstractGraphicsApi::Buffer::flush(size_t, size_t) {
+  }
+
+void AbstractGraphicsApi::Buffer::invalidate(size_t, size_t) {
+  }
+
+uint64_t AbstractGraphicsApi::Buffer::deviceAddress() const {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+size_t AbstractGraphicsApi::DescArray::size() const {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+uint32_t AbstractGraphicsApi::DescArray::alloc(Texture*) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+uint32_t AbstractGraphicsApi::DescArray::alloc(Buffer*) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::DescArray::set(size_t, Texture*) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::DescArray::set(size_t, Buffer*) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::DescArray::free(size_t) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+CommandBufferStats AbstractGraphicsApi::CommandBuffer::stats() const {
+  return CommandBufferStats();
+  }
+
 void AbstractGraphicsApi::CommandBuffer::begin(Detail::SyncHint) {
   begin();
   }
@@ -81,6 +123,34 @@ void AbstractGraphicsApi::CommandBuffer::setPushData(const void* data, size_t si
   throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
   }
 
+void AbstractGraphicsApi::CommandBuffer::pushUniform(size_t id, const void* data, size_t size) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::CommandBuffer::setAddressUsage(const Buffer* const* read, size_t nread, const Buffer* const* write, size_t nwrite) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::CommandBuffer::setVertexStreams(const VertexStream* vbo, size_t count) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::CommandBuffer::setCullMode(RenderState::CullMode cull) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::CommandBuffer::setDepthTest(RenderState::ZTestMode z) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::CommandBuffer::setDepthWrite(bool enable) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+void AbstractGraphicsApi::CommandBuffer::setBlend(RenderState::BlendMode src, RenderState::BlendMode dst, RenderState::BlendOp op) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
 void AbstractGraphicsApi::CommandBuffer::setDebugMarker(std::string_view tag) {
   (void)tag;
   }
@@ -93,7 +163,20 @@ void AbstractGraphicsApi::CommandBuffer::dispatchMeshIndirect(const Buffer& indi
   throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
   }
 
-AbstractGraphicsApi::AccelerationStructure* AbstractGraphicsApi::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t geomSize) {
+void AbstractGraphicsApi::CommandBuffer::updateTlas(AccelerationStructure& tlas, const RtInstance* inst, AccelerationStructure* const* blas, size_t count) {
+  throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  }
+
+bool AbstractGraphicsApi::CommandBuffer::execute(CommandBuffer& bundle) {
+  (void)bundle;
+  return false;
+  }
+
+AbstractGraphicsApi::CommandBuffer* AbstractGraphicsApi::createCommandBundle(Device* d, const Detail::FrameBufferDesc& fbo, size_t fboSize, uint32_t w, uint32_t h) {
+  return nullptr;
+  }
+
+AbstractGraphicsApi::AccelerationStructure* AbstractGraphicsApi::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t geomSize, BlasFlags flags) {
   throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
   }
 
@@ -125,10 +208,35 @@ bool Detail::Bindings::contains(const AbstractGraphicsApi::NoCopy* res) const {
   return false;
   }
 
+bool Detail::FrameBufferLayout::operator ==(const FrameBufferLayout& other) const {
+  if(count!=other.count || w!=other.w || h!=other.h)
+    return false;
+  for(size_t i=0; i<count; ++i)
+    if(frm[i]!=other.frm[i] || sw[i]!=other.sw[i])
+      return false;
+  return true;
+  }
+
 std::shared_ptr<AbstractGraphicsApi::Fence> AbstractGraphicsApi::submit(Device* d, CommandBuffer* cmd)  {
   throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
   }
 
+DeviceStats AbstractGraphicsApi::Device::stats() const {
+  return DeviceStats();
+  }
+
 NonUniqResId AbstractGraphicsApi::Swapchain::syncId() const {
   return NonUniqResId(0x1);
   }
+
+PipelineStats AbstractGraphicsApi::Pipeline::stats() const {
+  return PipelineStats();
+  }
+
+PresentMode AbstractGraphicsApi::Swapchain::presentMode() const {
+  return PresentMode::Fifo;
+  }
+
+SwapchainStats AbstractGraphicsApi::Swapchain::stats() const {
+  return SwapchainStats();
+  }
@@ -4,6 +4,7 @@
 #include <Tempest/Color>
 #include <Tempest/Matrix4x4>
 #include <Tempest/Vec>
+#include <Tempest/RenderState>
 
 #include <memory>
 #include <atomic>
@@ -16,8 +17,9 @@
 namespace Tempest {
   class Pixmap;
   class Color;
-  class RenderState;
+  class SpecializationConstants;
   class Device;
+  class CommandBundle;
 
   namespace Decl {
   enum ComponentType:uint8_t {
@@ -37,6 +39,21 @@ namespace Tempest {
     uint3,
     uint4,
 
+    half1,
+    half2,
+    half4, // no half3: 3-component 16-bit formats are not generally supported for vertex input
+
+    // normalized integers: read as float by shader
+    unorm8x2,
+    unorm8x4,
+    snorm8x2,
+    snorm8x4,
+    unorm16x2,
+    unorm16x4,
+    snorm16x2,
+    snorm16x4,
+    a2b10g10r10, // packed unorm, x in low bits; signed data, such as normals, goes into snorm formats
+
     count
     };
 
@@ -61,14 +78,30 @@ namespace Tempest {
       case Decl::int4:
       case Decl::uint4:
         return 16;
+      case Decl::half1:
+      case Decl::unorm8x2:
+      case Decl::snorm8x2:
+        return 2;
+      case Decl::half2:
+      case Decl::unorm8x4:
+      case Decl::snorm8x4:
+      case Decl::unorm16x2:
+      case Decl::snorm16x2:
+      case Decl::a2b10g10r10:
+        return 4;
+      case Decl::half4:
+      case Decl::unorm16x4:
+      case Decl::snorm16x4:
+        return 8;
       }
     return 0;
     }
   }
 
   enum class ApiFlags : uint16_t{
-    NoFlags   =0,
-    Validation=1
+    NoFlags          =0,
+    Validation       =1,
+    EmulateMeshShader=2, //! ignore native mesh-shader support and use compute emulation, if backend has one
     };
 
   inline ApiFlags operator | (ApiFlags a, ApiFlags b){
@@ -79,6 +112,19 @@ namespace Tempest {
     return ApiFlags(uint16_t(a)&uint16_t(b));
     }
 
+  enum class BlasFlags : uint8_t {
+    None    = 0,
+    Compact = 1, //! compact after build: less memory, at cost of extra copy
+    };
+
+  inline BlasFlags operator | (BlasFlags a, BlasFlags b){
+    return BlasFlags(uint8_t(a)|uint8_t(b));
+    }
+
+  inline BlasFlags operator & (BlasFlags a, BlasFlags b){
+    return BlasFlags(uint8_t(a)&uint8_t(b));
+    }
+
   enum class DeviceType : uint8_t {
     Unknown   = 0,
     Virtual   = 1,
@@ -93,6 +139,8 @@ namespace Tempest {
     MaxBindings = 32,
     MaxBarriers = 64,
     MaxCmdChunks = 64,
+    MaxVertexStreams = 4,
+    MaxVertexAttribs = 16,
     };
 
   enum Topology : uint8_t {
@@ -128,6 +176,17 @@ namespace Tempest {
     DXT5,
     R11G11B10UF,
     RGBA16F,
+    R16F,
+    RG16F,
+    RGB10A2,
+    RGBA8_SRGB,
+    DXT1_SRGB,
+    DXT3_SRGB,
+    DXT5_SRGB,
+    BC4,
+    BC5,
+    BC7,
+    BC7_SRGB,
     Last
     };
 
@@ -159,6 +218,17 @@ namespace Tempest {
       case DXT5:        return "DXT5";
       case R11G11B10UF: return "R11G11B10UF";
       case RGBA16F:     return "RGBA16F";
+      case R16F:        return "R16F";
+      case RG16F:       return "RG16F";
+      case RGB10A2:     return "RGB10A2";
+      case RGBA8_SRGB:  return "RGBA8_SRGB";
+      case DXT1_SRGB:   return "DXT1_SRGB";
+      case DXT3_SRGB:   return "DXT3_SRGB";
+      case DXT5_SRGB:   return "DXT5_SRGB";
+      case BC4:         return "BC4";
+      case BC5:         return "BC5";
+      case BC7:         return "BC7";
+      case BC7_SRGB:    return "BC7_SRGB";
       case Last:
         break;
       }
@@ -170,7 +240,15 @@ namespace Tempest {
     }
 
   inline bool isCompressedFormat(TextureFormat f){
-    return f==TextureFormat::DXT1 || f==TextureFormat::DXT3 || f==TextureFormat::DXT5;
+    return f==TextureFormat::DXT1      || f==TextureFormat::DXT3      || f==TextureFormat::DXT5 ||
+           f==TextureFormat::DXT1_SRGB || f==TextureFormat::DXT3_SRGB || f==TextureFormat::DXT5_SRGB ||
+           f==TextureFormat::BC4       || f==TextureFormat::BC5       ||
+           f==TextureFormat::BC7       || f==TextureFormat::BC7_SRGB;
+    }
+
+  inline bool isSrgbFormat(TextureFormat f){
+    return f==TextureFormat::RGBA8_SRGB || f==TextureFormat::DXT1_SRGB || f==TextureFormat::DXT3_SRGB ||
+           f==TextureFormat::DXT5_SRGB  || f==TextureFormat::BC7_SRGB;
     }
 
   enum class ComponentSwizzle {
@@ -275,6 +353,9 @@ namespace Tempest {
     };
 
   namespace Detail {
+    class  ShaderCache;
+    struct ShaderKey;
+
     enum class IndexClass:uint8_t {
       i16=0,
       i32
@@ -381,6 +462,59 @@ namespace Tempest {
       AccessOp      store      = AccessOp::Discard;
     };
 
+  enum class PresentMode : uint8_t {
+    Fifo,        // vsync; always supported
+    FifoRelaxed, // vsync; late frames are presented immediately, with tearing
+    Mailbox,     // vsync; new frame replaces one, that is waiting in queue
+    Immediate,   // no vsync
+    };
+
+  struct SwapchainDesc final {
+    //! preferred present mode; Fifo is used, if mode is not supported by surface
+    PresentMode presentMode       = PresentMode::Fifo;
+    //! desired number of swapchain images, clamped to surface limits; 0 - implementation defined
+    uint32_t    imageCount        = 0;
+    //! max number of frames, submitted ahead of presentation engine; 0 - same as image count
+    uint32_t    maxFramesInFlight = 0;
+    //! Device::present acquires next image and only queues current one; presentation engine is called from internal thread
+    bool        presentThread     = false;
+    //! headless only: simulated display refresh interval, in microseconds; 0 - no pacing
+    uint64_t    refreshInterval   = 0;
+    //! headless only: read back every presented image, see Swapchain::presentedFrame
+    bool        readback          = false;
+    };
+
+  //! timings of last presented frame, in microseconds
+  struct SwapchainStats final {
+    uint64_t    frameId        = 0;
+    //! cpu time spent waiting for swapchain image
+    uint64_t    acquireWait    = 0;
+    //! cpu time spent in present call
+    uint64_t    presentTime    = 0;
+    //! time from present call to image shown on display, for most recent frame, known to be displayed; 0 - not available
+    uint64_t    displayLatency = 0;
+    };
+
+  //! device-side variants of render pipeline, created so far
+  struct PipelineStats final {
+    uint32_t    variants  = 0;
+    //! fast-linked from pipeline-library parts, see Props::pipelineLibrary
+    uint32_t    linked    = 0;
+    //! linked variants, replaced by link-time optimized pipeline
+    uint32_t    optimized = 0;
+    };
+
+  //! native command buffers, allocated by command buffer so far; recycled ones are not counted
+  struct CommandBufferStats final {
+    uint32_t    allocations = 0;
+    };
+
+  //! framebuffer objects, cached by device; limit is 0, if no cache is used (dynamic rendering)
+  struct DeviceStats final {
+    uint32_t    framebuffers     = 0;
+    uint32_t    framebufferLimit = 0;
+    };
+
   struct Uninitialized_t{};
   static constexpr auto Uninitialized = Uninitialized_t();
 
@@ -404,6 +538,7 @@ namespace Tempest {
           struct {
             size_t maxAttribs  = 16;
             size_t maxStride   = 2047;
+            bool   halfInput   = false; // 16-bit float vertex shader inputs
             } vbo;
 
           struct {
@@ -430,6 +565,12 @@ namespace Tempest {
             Size   maxViewportSize      = {4096, 4096};
             } render;
 
+          struct {
+            bool cullMode  = false;
+            bool depthTest = false; // z-test mode and z-write
+            bool blend     = false;
+            } dynamicState;
+
           struct {
             BasicPoint<int,3> maxGroups       = {65535,65535,65535};
             BasicPoint<int,3> maxGroupSize    = {128,128,64};
@@ -459,6 +600,7 @@ namespace Tempest {
           struct {
             bool              taskShader         = false;
             bool              meshShader         = false;
+            bool              emulated           = false; // task/mesh stages are executed as compute + indirect draw
 
             BasicPoint<int,3> maxGroups          = {65535,65535,65535};
             BasicPoint<int,3> maxGroupSize       = {128,128,64};
@@ -474,6 +616,8 @@ namespace Tempest {
           bool     storeAndAtomicFs  = false;
 
           bool     memoryModel       = false;
+          bool     deviceAddress     = false;
+          bool     pipelineLibrary   = false; // pipeline variants are linked from precompiled parts, optimized in background
 
           bool     hasSamplerFormat(TextureFormat f) const;
           bool     hasAttachFormat (TextureFormat f) const;
@@ -511,6 +655,7 @@ namespace Tempest {
       struct Device:NoCopy {
         virtual ~Device()=default;
         virtual void        waitIdle() = 0;
+        virtual DeviceStats stats() const;
         };
       struct Fence:NoCopy {
         virtual ~Fence()=default;
@@ -525,6 +670,8 @@ namespace Tempest {
         virtual uint32_t      imageCount() const=0;
         virtual uint32_t      w() const=0;
         virtual uint32_t      h() const=0;
+        virtual PresentMode   presentMode() const;
+        virtual SwapchainStats stats() const;
         };
       struct Texture:Shared  {
         virtual uint32_t      mipCount() const = 0;
@@ -533,6 +680,7 @@ namespace Tempest {
       struct Pipeline:Shared {
         virtual IVec3  workGroupSize() const = 0;
         virtual size_t sizeofBuffer(size_t id, size_t arraylen) const = 0;
+        virtual PipelineStats stats() const;
         };
       struct CompPipeline:Shared {
         virtual IVec3  workGroupSize() const = 0;
@@ -544,6 +692,15 @@ namespace Tempest {
         virtual ~Buffer()=default;
         virtual void  update  (const void* data, size_t off, size_t size)=0;
         virtual void  read    (      void* data, size_t off, size_t size)=0;
+
+        //! persistently mapped memory of buffer, or nullptr, if buffer is not host-visible
+        virtual uint8_t* map();
+        //! non-coherent memory: make host writes visible to device
+        virtual void     flush     (size_t off, size_t size);
+        //! non-coherent memory: make device writes visible to host
+        virtual void     invalidate(size_t off, size_t size);
+        //! GPU virtual address of buffer; requires Props::deviceAddress
+        virtual uint64_t deviceAddress() const;
         };
 
       struct RtGeometry {
@@ -552,13 +709,30 @@ namespace Tempest {
 
         size_t             vboSz   = 0;
         size_t             stride  = 0;
+        size_t             voffset = 0;
         size_t             iboSz   = 0;
         size_t             ioffset = 0;
         Detail::IndexClass icls    = Detail::IndexClass::i32;
         };
+      struct VertexStream {
+        const Buffer*       vbo    = nullptr;
+        size_t              offset = 0; // in bytes
+        size_t              stride = 0;
+        InputRate           rate   = InputRate::PerVertex;
+        uint8_t             formatSize = 0; // explicit formats of consecutive inputs; 0 - as reflected
+        Decl::ComponentType format[MaxVertexAttribs] = {};
+        };
       struct BlasBuildCtx {};
       struct AccelerationStructure:Shared {};
-      struct DescArray:NoCopy {};
+      struct DescArray:NoCopy {
+        virtual size_t   size() const;
+        //! writes into free slot; array grows, if there is no free slots
+        virtual uint32_t alloc(Texture* tex);
+        virtual uint32_t alloc(Buffer*  buf);
+        virtual void     set  (size_t slot, Texture* tex);
+        virtual void     set  (size_t slot, Buffer*  buf);
+        virtual void     free (size_t slot);
+        };
       struct BarrierDesc {
         const Texture*   texture   = nullptr;
         const Swapchain* swapchain = nullptr;
@@ -586,6 +760,7 @@ namespace Tempest {
         virtual void copy(Buffer& dest, size_t offset, Texture& src, uint32_t width, uint32_t height, uint32_t mip) = 0;
 
         virtual bool isRecording() const = 0;
+        virtual CommandBufferStats stats() const;
         virtual void begin(Detail::SyncHint hint);
         virtual void begin()=0;
         virtual void end()  =0;
@@ -595,16 +770,24 @@ namespace Tempest {
         virtual void setComputePipeline(CompPipeline& p)=0;
 
         virtual void setPushData(const void* data, size_t size);
+        virtual void pushUniform(size_t id, const void* data, size_t size);
         virtual void setBinding (size_t id, Texture *tex, uint32_t mipLevel, const ComponentMapping& m, const Sampler& smp) = 0;
         virtual void setBinding (size_t id, Buffer* buf, size_t offset) = 0;
         virtual void setBinding (size_t id, DescArray* arr) = 0;
         virtual void setBinding (size_t id, AccelerationStructure* tlas) = 0;
         virtual void setBinding (size_t id, const Sampler& smp) = 0;
+        //! buffers, accessed by subsequent draws/dispatches through device address
+        virtual void setAddressUsage(const Buffer* const* read, size_t nread, const Buffer* const* write, size_t nwrite);
 
         virtual void setViewport(const Rect& r)=0;
         virtual void setScissor (const Rect& r)=0;
+        virtual void setCullMode  (RenderState::CullMode cull);
+        virtual void setDepthTest (RenderState::ZTestMode z);
+        virtual void setDepthWrite(bool enable);
+        virtual void setBlend     (RenderState::BlendMode src, RenderState::BlendMode dst, RenderState::BlendOp op);
         virtual void setDebugMarker(std::string_view tag);
 
+        virtual void setVertexStreams(const VertexStream* vbo, size_t count);
         virtual void draw        (const Buffer* vbo, size_t stride, size_t offset, size_t vertexCount,
                                   size_t firstInstance, size_t instanceCount) = 0;
         virtual void drawIndexed (const Buffer* vbo, size_t stride, size_t voffset,
@@ -618,6 +801,11 @@ namespace Tempest {
 
         virtual void dispatch(size_t x, size_t y, size_t z) = 0;
         virtual void dispatchIndirect(const Buffer& indirect, size_t offset) = 0;
+
+        virtual void updateTlas(AccelerationStructure& tlas, const RtInstance* inst, AccelerationStructure* const* blas, size_t count);
+
+        //! executes bundle, created by createCommandBundle; false, if it has to be replayed by caller instead
+        virtual bool execute(CommandBuffer& bundle);
         };
 
       using PBuffer       = Detail::DSharedPtr<Buffer*>;
@@ -631,15 +819,19 @@ namespace Tempest {
     protected:
       virtual Device*    createDevice(std::string_view gpuName) = 0;
 
-      virtual Swapchain* createSwapchain(SystemApi::Window* w,AbstractGraphicsApi::Device *d) = 0;
+      virtual Swapchain* createSwapchain(SystemApi::Window* w,AbstractGraphicsApi::Device *d,const SwapchainDesc& desc) = 0;
 
-      virtual PPipeline  createPipeline(Device* d, const RenderState &st, Topology tp, const Shader* const* sh, size_t cnt)=0;
+      virtual PPipeline  createPipeline(Device* d, const RenderState &st, Topology tp, const Shader* const* sh, size_t cnt,
+                                        const SpecializationConstants& spec)=0;
 
-      virtual PCompPipeline createComputePipeline(Device* d, Shader* shader)=0;
+      virtual PCompPipeline createComputePipeline(Device* d, Shader* shader, const SpecializationConstants& spec)=0;
 
-      virtual PShader    createShader(Device *d,const void* source,size_t src_size)=0;
+      virtual PShader    createShader(Device *d,const void* source,size_t src_size,Detail::ShaderCache* cache,const Detail::ShaderKey* key)=0;
       virtual CommandBuffer*
                          createCommandBuffer(Device* d)=0;
+      //! pre-recorded command buffer for render-pass of given layout; nullptr, if backend only can replay bundles
+      virtual CommandBuffer*
+                         createCommandBundle(Device* d, const Detail::FrameBufferDesc& fbo, size_t fboSize, uint32_t w, uint32_t h);
 
       virtual DescArray* createDescriptors(Device* d, AbstractGraphicsApi::Texture** tex, size_t cnt, uint32_t mipLevel) = 0;
       virtual DescArray* createDescriptors(Device* d, AbstractGraphicsApi::Texture** tex, size_t cnt, uint32_t mipLevel, const Sampler& smp) = 0;
@@ -651,12 +843,12 @@ namespace Tempest {
       virtual PTexture   createStorage(Device* d, const uint32_t w, const uint32_t h, uint32_t mips, TextureFormat frm) = 0;
       virtual PTexture   createStorage(Device* d, const uint32_t w, const uint32_t h, const uint32_t depth, uint32_t mips, TextureFormat frm) = 0;
 
-      virtual AccelerationStructure* createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t geomSize);
+      virtual AccelerationStructure* createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t geomSize, BlasFlags flags);
       virtual AccelerationStructure* createTopAccelerationStruct(Device* d, const RtInstance* geom, AccelerationStructure*const* as, size_t geomSize);
 
       virtual void       readPixels   (Device* d, Pixmap& out, const PTexture t,
                                        TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip, bool storageImg) = 0;
-      virtual void       readBytes    (Device* d, Buffer* buf, void* out, size_t size) = 0;
+      virtual void       readBytes    (Device* d, Buffer* buf, void* out, size_t offset, size_t size) = 0;
 
       virtual void       present(Device *d, Swapchain* sw) = 0;
       virtual auto       submit (Device *d, CommandBuffer* cmd) -> std::shared_ptr<AbstractGraphicsApi::Fence> = 0;
@@ -664,6 +856,7 @@ namespace Tempest {
       virtual void       getCaps(Device *d, Props& caps)=0;
 
     friend class Tempest::Device;
+    friend class Tempest::CommandBundle;
     };
 
 namespace Detail {
@@ -688,5 +881,17 @@ namespace Detail {
     uint32_t                        imgId[MaxFramebufferAttachments+1] = {};
     };
 
+  //! formats and size of render-pass attachments; images of same swapchain are interchangeable
+  struct FrameBufferLayout {
+    TextureFormat                   frm[MaxFramebufferAttachments+1] = {};
+    AbstractGraphicsApi::Swapchain* sw [MaxFramebufferAttachments+1] = {};
+    uint8_t                         count = 0;
+    uint32_t                        w     = 0;
+    uint32_t                        h     = 0;
+
+    bool operator == (const FrameBufferLayout& other) const;
+    bool operator != (const FrameBufferLayout& other) const { return !(*this==other); }
+    };
+
   };
 }
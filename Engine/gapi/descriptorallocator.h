@@ -31,6 +31,13 @@ class DescriptorAllocator {
       return ret;
       }
 
+    //! access to allocated memory, synchronized with reallocation
+    template<class Func>
+    void update(Func f) {
+      std::lock_guard<SpinLock> guard(sync);
+      f();
+      }
+
     void free(uint32_t ptr, uint32_t num) {
       if(ptr==0xFFFFFFFF || num==0)
         return;
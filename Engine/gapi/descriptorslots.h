@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../utility/spinlock.h"
+
+namespace Tempest {
+namespace Detail {
+
+/**
+ * Slot allocator of updatable descriptor array.
+ *
+ * Released slots and released backend storage are reused only after every command buffer, that
+ * retained `epoch()` before release, is reset. Epochs are recycled in release order.
+ */
+class DescriptorSlots {
+  public:
+    struct Range {
+      uint32_t ptr = 0;
+      uint32_t num = 0;
+      };
+
+    struct Epoch {
+      uint32_t              id = 0;
+      std::vector<uint32_t> slots;
+      std::vector<Range>    ranges;
+      };
+
+    //! new slots at the end of array are free
+    void resize(uint32_t size) {
+      std::lock_guard<SpinLock> guard(sync);
+      const uint32_t prev = uint32_t(state.size());
+      if(size<=prev)
+        return;
+      state.resize(size, S_Free);
+      releasedIn.resize(size, 0);
+      for(uint32_t i=size; i>prev; --i)
+        freeList.push_back(i-1);
+      }
+
+    void markUsed(uint32_t slot) {
+      std::lock_guard<SpinLock> guard(sync);
+      state[slot] = S_Used;
+      }
+
+    template<class F>
+    bool alloc(uint32_t& slot, F freeRange) {
+      std::lock_guard<SpinLock> guard(sync);
+      recycle(freeRange);
+      while(!freeList.empty()) {
+        slot = freeList.back();
+        freeList.pop_back();
+        if(state[slot]!=S_Free)
+          continue; // overridden by set
+        state[slot] = S_Used;
+        return true;
+        }
+      return false;
+      }
+
+    bool release(uint32_t slot) {
+      std::lock_guard<SpinLock> guard(sync);
+      if(slot>=state.size() || state[slot]!=S_Used)
+        return false;
+      state     [slot] = S_Pending;
+      releasedIn[slot] = current->id;
+      current->slots.push_back(slot);
+      return true;
+      }
+
+    void release(const Range& r) {
+      std::lock_guard<SpinLock> guard(sync);
+      current->ranges.push_back(r);
+      }
+
+    //! command buffers hold epoch, while recorded
+    std::shared_ptr<Epoch> epoch() const {
+      std::lock_guard<SpinLock> guard(sync);
+      return current;
+      }
+
+    //! on destruction of array
+    template<class F>
+    void clear(F freeRange) {
+      std::lock_guard<SpinLock> guard(sync);
+      retired.push_back(std::move(current));
+      for(auto& e:retired)
+        for(auto& r:e->ranges)
+          freeRange(r);
+      retired.clear();
+      current = newEpoch();
+      }
+
+  private:
+    enum State : uint8_t {
+      S_Free,
+      S_Used,
+      S_Pending,
+      };
+
+    template<class F>
+    void recycle(F& freeRange) {
+      if(!current->slots.empty() || !current->ranges.empty()) {
+        retired.push_back(std::move(current));
+        current = newEpoch();
+        }
+      while(!retired.empty() && retired.front().use_count()==1) {
+        auto& e = *retired.front();
+        for(auto s:e.slots) {
+          // slot might be overridden and released again, in later epoch
+          if(state[s]!=S_Pending || releasedIn[s]!=e.id)
+            continue;
+          state[s] = S_Free;
+          freeList.push_back(s);
+          }
+        for(auto& r:e.ranges)
+          freeRange(r);
+        retired.pop_front();
+        }
+      }
+
+    std::shared_ptr<Epoch> newEpoch() {
+      auto e = std::make_shared<Epoch>();
+      e->id = ++epochId;
+      return e;
+      }
+
+    mutable SpinLock                   sync;
+    std::vector<State>                 state;
+    std::vector<uint32_t>              releasedIn;
+    std::vector<uint32_t>              freeList;
+    uint32_t                           epochId = 0;
+    std::shared_ptr<Epoch>             current = newEpoch();
+    std::deque<std::shared_ptr<Epoch>> retired;
+  };
+
+}
+}
@@ -11,7 +11,7 @@ using namespace Tempest;
 using namespace Tempest::Detail;
 
 void DxBlasBuildCtx::pushGeometry(DxDevice& dx,
-                                  const DxBuffer& ivbo, size_t vboSz, size_t stride,
+                                  const DxBuffer& ivbo, size_t vboSz, size_t stride, size_t voffset,
                                   const DxBuffer& iibo, size_t iboSz, size_t ioffset, IndexClass icls) {
   auto& vbo = const_cast<DxBuffer&>(ivbo);
   auto& ibo = const_cast<DxBuffer&>(iibo);
@@ -25,7 +25,7 @@ void DxBlasBuildCtx::pushGeometry(DxDevice& dx,
   geometryDesc.Triangles.IndexCount                 = UINT(iboSz);
   geometryDesc.Triangles.VertexCount                = UINT(vboSz);
   geometryDesc.Triangles.IndexBuffer                = ibo.impl->GetGPUVirtualAddress() + ioffset*sizeofIndex(icls);
-  geometryDesc.Triangles.VertexBuffer.StartAddress  = vbo.impl->GetGPUVirtualAddress();
+  geometryDesc.Triangles.VertexBuffer.StartAddress  = vbo.impl->GetGPUVirtualAddress() + voffset*stride;
   geometryDesc.Triangles.VertexBuffer.StrideInBytes = stride;
 
   geometry.push_back(geometryDesc);
@@ -59,11 +59,12 @@ DxAccelerationStructure::DxAccelerationStructure(DxDevice& dx, const AbstractGra
     auto& vbo     = *reinterpret_cast<const DxBuffer*>(geom[i].vbo);
     auto  vboSz   = geom[i].vboSz;
     auto  stride  = geom[i].stride;
+    auto  voffset = geom[i].voffset;
     auto& ibo     = *reinterpret_cast<const DxBuffer*>(geom[i].ibo);
     auto  iboSz   = geom[i].iboSz;
     auto  ioffset = geom[i].ioffset;
     auto  icls    = geom[i].icls;
-    ctx.pushGeometry(dx, vbo, vboSz, stride, ibo, iboSz, ioffset, icls);
+    ctx.pushGeometry(dx, vbo, vboSz, stride, voffset, ibo, iboSz, ioffset, icls);
     }
 
   const auto buildSizesInfo = ctx.buildSizes(dx);
@@ -12,7 +12,7 @@ class DxDevice;
 
 struct DxBlasBuildCtx : AbstractGraphicsApi::BlasBuildCtx {
   void pushGeometry(DxDevice& dx,
-                    const DxBuffer& vbo, size_t vboSz, size_t stride,
+                    const DxBuffer& vbo, size_t vboSz, size_t stride, size_t voffset,
                     const DxBuffer& ibo, size_t iboSz, size_t ioffset, IndexClass icls);
 
   D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO buildSizes(DxDevice& dx) const;
@@ -19,7 +19,7 @@ class DxDescriptorArray : public AbstractGraphicsApi::DescArray {
     DxDescriptorArray(DxDevice& dev, AbstractGraphicsApi::Buffer**  buf, size_t cnt);
     ~DxDescriptorArray();
 
-    size_t size() const;
+    size_t size() const override;
     auto   handleR()  const -> D3D12_GPU_DESCRIPTOR_HANDLE;
     auto   handleRW() const -> D3D12_GPU_DESCRIPTOR_HANDLE;
     auto   handleS()  const -> D3D12_GPU_DESCRIPTOR_HANDLE;
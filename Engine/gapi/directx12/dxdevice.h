@@ -121,6 +121,28 @@ inline DXGI_FORMAT nativeFormat(TextureFormat f) {
       return DXGI_FORMAT_R11G11B10_FLOAT;
     case TextureFormat::RGBA16F:
       return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case TextureFormat::R16F:
+      return DXGI_FORMAT_R16_FLOAT;
+    case TextureFormat::RG16F:
+      return DXGI_FORMAT_R16G16_FLOAT;
+    case TextureFormat::RGB10A2:
+      return DXGI_FORMAT_R10G10B10A2_UNORM;
+    case TextureFormat::RGBA8_SRGB:
+      return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    case TextureFormat::DXT1_SRGB:
+      return DXGI_FORMAT_BC1_UNORM_SRGB;
+    case TextureFormat::DXT3_SRGB:
+      return DXGI_FORMAT_BC2_UNORM_SRGB;
+    case TextureFormat::DXT5_SRGB:
+      return DXGI_FORMAT_BC3_UNORM_SRGB;
+    case TextureFormat::BC4:
+      return DXGI_FORMAT_BC4_UNORM;
+    case TextureFormat::BC5:
+      return DXGI_FORMAT_BC5_UNORM;
+    case TextureFormat::BC7:
+      return DXGI_FORMAT_BC7_UNORM;
+    case TextureFormat::BC7_SRGB:
+      return DXGI_FORMAT_BC7_UNORM_SRGB;
     }
   return DXGI_FORMAT_UNKNOWN;
   }
@@ -254,6 +276,30 @@ inline DXGI_FORMAT nativeFormat(Decl::ComponentType t) {
       return DXGI_FORMAT_R32G32B32_UINT;
     case Decl::uint4:
       return DXGI_FORMAT_R32G32B32A32_UINT;
+    case Decl::half1:
+      return DXGI_FORMAT_R16_FLOAT;
+    case Decl::half2:
+      return DXGI_FORMAT_R16G16_FLOAT;
+    case Decl::half4:
+      return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case Decl::unorm8x2:
+      return DXGI_FORMAT_R8G8_UNORM;
+    case Decl::unorm8x4:
+      return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case Decl::snorm8x2:
+      return DXGI_FORMAT_R8G8_SNORM;
+    case Decl::snorm8x4:
+      return DXGI_FORMAT_R8G8B8A8_SNORM;
+    case Decl::unorm16x2:
+      return DXGI_FORMAT_R16G16_UNORM;
+    case Decl::unorm16x4:
+      return DXGI_FORMAT_R16G16B16A16_UNORM;
+    case Decl::snorm16x2:
+      return DXGI_FORMAT_R16G16_SNORM;
+    case Decl::snorm16x4:
+      return DXGI_FORMAT_R16G16B16A16_SNORM;
+    case Decl::a2b10g10r10:
+      return DXGI_FORMAT_R10G10B10A2_UNORM;
     }
   return DXGI_FORMAT_UNKNOWN;
   }
@@ -65,8 +65,8 @@ static int calcShaderModel(const spirv_cross::CompilerHLSL& comp) {
   return shader_model;
   }
 
-DxShader::DxShader(const void *source, const size_t src_size)
-  : Shader(source, src_size){
+DxShader::DxShader(const void *source, const size_t src_size, ShaderCache* cache, const ShaderKey* key)
+  : Shader(source, src_size, cache, key){
   spirv_cross::CompilerHLSL::Options optHLSL;
 
   spirv_cross::CompilerGLSL::Options optGLSL;
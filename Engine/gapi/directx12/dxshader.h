@@ -12,7 +12,7 @@ namespace Detail {
 
 class DxShader : public Tempest::Detail::Shader {
   public:
-    DxShader(const void* source, const size_t src_size);
+    DxShader(const void* source, const size_t src_size, ShaderCache* cache = nullptr, const ShaderKey* key = nullptr);
     ~DxShader();
 
     enum Bindings : uint32_t {
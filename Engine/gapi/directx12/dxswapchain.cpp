@@ -4,10 +4,13 @@
 #include "dxdevice.h"
 #include "guid.h"
 
+#include <algorithm>
+#include <chrono>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
-DxSwapchain::DxSwapchain(DxDevice& dev, IDXGIFactory4& dxgi, SystemApi::Window* hwnd)
+DxSwapchain::DxSwapchain(DxDevice& dev, IDXGIFactory4& dxgi, SystemApi::Window* hwnd, const SwapchainDesc& desc)
   :dev(dev) {
   auto& device = *dev.device;
 
@@ -17,7 +20,14 @@ DxSwapchain::DxSwapchain(DxDevice& dev, IDXGIFactory4& dxgi, SystemApi::Window*
   auto rect = SystemApi::windowClientRect(hwnd);
   imgW = uint32_t(rect.w);
   imgH = uint32_t(rect.h);
-  imgCount = 3;// TODO
+  imgCount = desc.imageCount==0 ? 3 : std::clamp<uint32_t>(desc.imageCount, 2, DXGI_MAX_SWAP_CHAIN_BUFFERS);
+
+  // flip-model with zero sync interval drops stale queued frames, same as mailbox
+  // NOTE: true immediate needs DXGI_FEATURE_PRESENT_ALLOW_TEARING
+  if(desc.presentMode==PresentMode::Mailbox || desc.presentMode==PresentMode::Immediate) {
+    mode         = PresentMode::Mailbox;
+    syncInterval = 0;
+    }
 
   DXGI_SWAP_CHAIN_DESC1 sd = {};
   sd.Width  = imgW;
@@ -86,10 +96,14 @@ uint32_t DxSwapchain::currentBackBufferIndex() {
   }
 
 void DxSwapchain::queuePresent() {
-  static int vsunc = 1;
-  dxAssert(impl->Present(vsunc, 0));
+  auto t0 = std::chrono::steady_clock::now();
+  dxAssert(impl->Present(syncInterval, 0));
+  auto t1 = std::chrono::steady_clock::now();
 
   ++frameCounter;
+  frameStats.frameId     = frameCounter;
+  frameStats.presentTime = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count());
+
   dev.cmdQueue->Signal(fence.get(), frameCounter);
   }
 
@@ -19,7 +19,7 @@ class DxDevice;
 
 class DxSwapchain : public AbstractGraphicsApi::Swapchain {
   public:
-    DxSwapchain(DxDevice& device, IDXGIFactory4& dxgi, SystemApi::Window* hwnd);
+    DxSwapchain(DxDevice& device, IDXGIFactory4& dxgi, SystemApi::Window* hwnd, const SwapchainDesc& desc);
     DxSwapchain(DxSwapchain&& other) = delete;
     ~DxSwapchain() override;
 
@@ -29,6 +29,8 @@ class DxSwapchain : public AbstractGraphicsApi::Swapchain {
     void                     reset() override;
     uint32_t                 imageCount() const override { return imgCount; }
     uint32_t                 currentBackBufferIndex() override;
+    PresentMode              presentMode() const override { return mode; }
+    SwapchainStats           stats() const override { return frameStats; }
 
     void                     queuePresent();
 
@@ -53,6 +55,9 @@ class DxSwapchain : public AbstractGraphicsApi::Swapchain {
     uint32_t                imgCount     = 3;
     DXGI_FORMAT             frm          = DXGI_FORMAT_B8G8R8A8_UNORM;
     UINT64                  frameCounter = 0;
+    PresentMode             mode         = PresentMode::Fifo;
+    UINT                    syncInterval = 1;
+    SwapchainStats          frameStats;
   };
 
 }}
@@ -20,6 +20,7 @@
 #include "directx12/dxaccelerationstructure.h"
 
 #include <Tempest/Pixmap>
+#include <Tempest/SpecializationConstants>
 #include <Tempest/AccelerationStructure>
 
 using namespace Tempest;
@@ -158,13 +159,15 @@ AbstractGraphicsApi::Device* DirectX12Api::createDevice(std::string_view gpuName
   return impl->createDevice(gpuName);
   }
 
-AbstractGraphicsApi::Swapchain* DirectX12Api::createSwapchain(SystemApi::Window* w, AbstractGraphicsApi::Device* d) {
+AbstractGraphicsApi::Swapchain* DirectX12Api::createSwapchain(SystemApi::Window* w, AbstractGraphicsApi::Device* d, const SwapchainDesc& desc) {
   auto* dx = reinterpret_cast<Detail::DxDevice*>(d);
-  return new Detail::DxSwapchain(*dx,*impl->DXGIFactory,w);
+  return new Detail::DxSwapchain(*dx,*impl->DXGIFactory,w,desc);
   }
 
 AbstractGraphicsApi::PPipeline DirectX12Api::createPipeline(AbstractGraphicsApi::Device* d, const RenderState& st, Topology tp,
-                                                            const Shader*const*sh, size_t cnt) {
+                                                            const Shader*const*sh, size_t cnt, const SpecializationConstants& spec) {
+  if(!spec.isEmpty())
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension, "specialization constants");
   auto* dx = reinterpret_cast<Detail::DxDevice*>(d);
   const Detail::DxShader* shader[5] = {};
   for(size_t i=0; i<cnt; ++i)
@@ -172,14 +175,18 @@ AbstractGraphicsApi::PPipeline DirectX12Api::createPipeline(AbstractGraphicsApi:
   return PPipeline(new Detail::DxPipeline(*dx,st,tp,shader,cnt));
   }
 
-AbstractGraphicsApi::PCompPipeline DirectX12Api::createComputePipeline(AbstractGraphicsApi::Device* d, AbstractGraphicsApi::Shader* shader) {
+AbstractGraphicsApi::PCompPipeline DirectX12Api::createComputePipeline(AbstractGraphicsApi::Device* d, AbstractGraphicsApi::Shader* shader,
+                                                                       const SpecializationConstants& spec) {
+  if(!spec.isEmpty())
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension, "specialization constants");
   auto* dx = reinterpret_cast<Detail::DxDevice*>(d);
   return PCompPipeline(new Detail::DxCompPipeline(*dx,*reinterpret_cast<Detail::DxShader*>(shader)));
   }
 
 AbstractGraphicsApi::PShader DirectX12Api::createShader(AbstractGraphicsApi::Device*,
-                                                        const void* source, size_t src_size) {
-  return PShader(new Detail::DxShader(source,src_size));
+                                                        const void* source, size_t src_size,
+                                                        Detail::ShaderCache* cache, const Detail::ShaderKey* key) {
+  return PShader(new Detail::DxShader(source,src_size,cache,key));
   }
 
 AbstractGraphicsApi::PBuffer DirectX12Api::createBuffer(AbstractGraphicsApi::Device* d, const void* mem, size_t size,
@@ -356,7 +363,7 @@ AbstractGraphicsApi::PTexture DirectX12Api::createStorage(Device* d, const uint3
   return PTexture(pbuf.handler);
   }
 
-AbstractGraphicsApi::AccelerationStructure* DirectX12Api::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size) {
+AbstractGraphicsApi::AccelerationStructure* DirectX12Api::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size, BlasFlags /*flags*/) {
   auto& dx = *reinterpret_cast<DxDevice*>(d);
   return new DxAccelerationStructure(dx, geom,size);
   }
@@ -389,8 +396,8 @@ void DirectX12Api::readPixels(Device* d, Pixmap& out, const PTexture t,
     stage.read(reinterpret_cast<uint8_t*>(out.data())+i*bsz.w*bpb, i*pith, bsz.w*bpb);
   }
 
-void DirectX12Api::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer* buf, void* out, size_t size) {
-  buf->read(out,0,size);
+void DirectX12Api::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer* buf, void* out, size_t offset, size_t size) {
+  buf->read(out,offset,size);
   }
 
 AbstractGraphicsApi::CommandBuffer* DirectX12Api::createCommandBuffer(Device* d) {
@@ -17,12 +17,13 @@ class DirectX12Api : public AbstractGraphicsApi {
 
   protected:
     Device*        createDevice(std::string_view gpuName) override;
-    Swapchain*     createSwapchain(SystemApi::Window* w, Device *d) override;
+    Swapchain*     createSwapchain(SystemApi::Window* w, Device *d, const SwapchainDesc& desc) override;
 
     PPipeline      createPipeline(Device* d, const RenderState &st, Topology tp,
-                                  const Shader*const* shaders, size_t count) override;
-    PCompPipeline  createComputePipeline(Device* d, Shader* sh) override;
-    PShader        createShader(Device *d, const void* source, size_t src_size) override;
+                                  const Shader*const* shaders, size_t count, const SpecializationConstants& spec) override;
+    PCompPipeline  createComputePipeline(Device* d, Shader* sh, const SpecializationConstants& spec) override;
+    PShader        createShader(Device *d, const void* source, size_t src_size, Detail::ShaderCache* cache,
+                                const Detail::ShaderKey* key) override;
 
     PBuffer        createBuffer (Device* d, const void *mem, size_t size, MemUsage usage, BufferHeap flg) override;
     PTexture       createTexture(Device* d, const Pixmap& p, TextureFormat frm, uint32_t mips) override;
@@ -30,12 +31,12 @@ class DirectX12Api : public AbstractGraphicsApi {
     PTexture       createStorage(Device* d, const uint32_t w, const uint32_t h, uint32_t mips, TextureFormat frm) override;
     PTexture       createStorage(Device* d, const uint32_t w, const uint32_t h, const uint32_t depth, uint32_t mips, TextureFormat frm) override;
 
-    AccelerationStructure* createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size) override;
+    AccelerationStructure* createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size, BlasFlags flags) override;
     AccelerationStructure* createTopAccelerationStruct(Device* d, const RtInstance* inst, AccelerationStructure*const* as, size_t geomSize) override;
 
     void           readPixels(Device* d, Pixmap& out, const PTexture t,
                               TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip, bool storageImg) override;
-    void           readBytes(Device* d, Buffer* buf, void* out, size_t size) override;
+    void           readBytes(Device* d, Buffer* buf, void* out, size_t offset, size_t size) override;
 
     DescArray*     createDescriptors(Device* d, AbstractGraphicsApi::Texture** tex, size_t cnt, uint32_t mipLevel, const Sampler& smp) override;
     DescArray*     createDescriptors(Device* d, AbstractGraphicsApi::Texture** tex, size_t cnt, uint32_t mipLevel) override;
@@ -26,6 +26,11 @@ inline MemUsage operator & (MemUsage a,const MemUsage& b) {
   }
 
 
+enum class InputRate : uint8_t {
+  PerVertex   = 0,
+  PerInstance = 1,
+  };
+
 enum class BufferHeap : uint8_t {
   Device   = 0,
   Upload   = 1,
@@ -13,14 +13,14 @@
 using namespace Tempest::Detail;
 
 void MtBlasBuildCtx::pushGeometry(MtDevice& dx,
-                                  const MtBuffer& vbo, size_t vboSz, size_t stride,
+                                  const MtBuffer& vbo, size_t vboSz, size_t stride, size_t voffset,
                                   const MtBuffer& ibo, size_t iboSz, size_t ioffset, IndexClass icls) {
   auto geo = NsPtr<MTL::AccelerationStructureTriangleGeometryDescriptor>::init();
   if(geo==nullptr)
     throw std::system_error(GraphicsErrc::OutOfHostMemory);
 
   geo->setVertexBuffer(vbo.impl.get());
-  geo->setVertexBufferOffset(0);
+  geo->setVertexBufferOffset(voffset*stride);
   geo->setVertexStride(stride);
   geo->setVertexFormat(MTL::AttributeFormatFloat3);
   geo->setIndexBuffer(ibo.impl.get());
@@ -60,11 +60,12 @@ MtAccelerationStructure::MtAccelerationStructure(MtDevice& dx, const Tempest::Ab
     auto& vbo     = *reinterpret_cast<const MtBuffer*>(geom[i].vbo);
     auto  vboSz   = geom[i].vboSz;
     auto  stride  = geom[i].stride;
+    auto  voffset = geom[i].voffset;
     auto& ibo     = *reinterpret_cast<const MtBuffer*>(geom[i].ibo);
     auto  iboSz   = geom[i].iboSz;
     auto  ioffset = geom[i].ioffset;
     auto  icls    = geom[i].icls;
-    ctx.pushGeometry(dx, vbo, vboSz, stride, ibo, iboSz, ioffset, icls);
+    ctx.pushGeometry(dx, vbo, vboSz, stride, voffset, ibo, iboSz, ioffset, icls);
     }
   ctx.bake();
 
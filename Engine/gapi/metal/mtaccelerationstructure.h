@@ -14,7 +14,7 @@ class MtBuffer;
 
 struct MtBlasBuildCtx : AbstractGraphicsApi::BlasBuildCtx {
   void pushGeometry(MtDevice& dx,
-                    const MtBuffer& vbo, size_t vboSz, size_t stride,
+                    const MtBuffer& vbo, size_t vboSz, size_t stride, size_t voffset,
                     const MtBuffer& ibo, size_t iboSz, size_t ioffset, IndexClass icls);
   void bake();
 
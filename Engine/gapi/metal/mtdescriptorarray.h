@@ -19,7 +19,7 @@ class MtDescriptorArray : public AbstractGraphicsApi::DescArray {
     MtDescriptorArray(MtDevice& dev, AbstractGraphicsApi::Buffer**  buf, size_t cnt);
     ~MtDescriptorArray();
 
-    size_t       size() const;
+    size_t       size() const override;
     MTL::Buffer& data() { return *argsBuf.impl.get(); }
 
     void useResource(MTL::ComputeCommandEncoder& cmd, ShaderReflection::Stage st) const;
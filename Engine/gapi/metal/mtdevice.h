@@ -74,6 +74,28 @@ inline MTL::PixelFormat nativeFormat(TextureFormat frm) {
       return MTL::PixelFormatRG11B10Float;
     case RGBA16F:
       return MTL::PixelFormatRGBA16Float;
+    case R16F:
+      return MTL::PixelFormatR16Float;
+    case RG16F:
+      return MTL::PixelFormatRG16Float;
+    case RGB10A2:
+      return MTL::PixelFormatRGB10A2Unorm;
+    case RGBA8_SRGB:
+      return MTL::PixelFormatRGBA8Unorm_sRGB;
+    case DXT1_SRGB:
+      return MTL::PixelFormatBC1_RGBA_sRGB;
+    case DXT3_SRGB:
+      return MTL::PixelFormatBC2_RGBA_sRGB;
+    case DXT5_SRGB:
+      return MTL::PixelFormatBC3_RGBA_sRGB;
+    case BC4:
+      return MTL::PixelFormatBC4_RUnorm;
+    case BC5:
+      return MTL::PixelFormatBC5_RGUnorm;
+    case BC7:
+      return MTL::PixelFormatBC7_RGBAUnorm;
+    case BC7_SRGB:
+      return MTL::PixelFormatBC7_RGBAUnorm_sRGB;
     }
   return MTL::PixelFormatInvalid;
   }
@@ -109,6 +131,32 @@ inline MTL::VertexFormat nativeFormat(Decl::ComponentType t) {
       return MTL::VertexFormatUInt3;
     case Decl::ComponentType::uint4:
       return MTL::VertexFormatUInt4;
+
+    case Decl::ComponentType::half1:
+      return MTL::VertexFormatHalf;
+    case Decl::ComponentType::half2:
+      return MTL::VertexFormatHalf2;
+    case Decl::ComponentType::half4:
+      return MTL::VertexFormatHalf4;
+
+    case Decl::ComponentType::unorm8x2:
+      return MTL::VertexFormatUChar2Normalized;
+    case Decl::ComponentType::unorm8x4:
+      return MTL::VertexFormatUChar4Normalized;
+    case Decl::ComponentType::snorm8x2:
+      return MTL::VertexFormatChar2Normalized;
+    case Decl::ComponentType::snorm8x4:
+      return MTL::VertexFormatChar4Normalized;
+    case Decl::ComponentType::unorm16x2:
+      return MTL::VertexFormatUShort2Normalized;
+    case Decl::ComponentType::unorm16x4:
+      return MTL::VertexFormatUShort4Normalized;
+    case Decl::ComponentType::snorm16x2:
+      return MTL::VertexFormatShort2Normalized;
+    case Decl::ComponentType::snorm16x4:
+      return MTL::VertexFormatShort4Normalized;
+    case Decl::ComponentType::a2b10g10r10:
+      return MTL::VertexFormatUInt1010102Normalized;
     }
   return MTL::VertexFormatInvalid;
   }
@@ -222,12 +222,16 @@ void MtDevice::deductProps(AbstractGraphicsApi::Props& prop, MTL::Device& dev) {
                                       TextureFormat::R32F, TextureFormat::RG32F, TextureFormat::RGBA32F,
                                       TextureFormat::R32U, TextureFormat::RG32U, TextureFormat::RGBA32U,
                                       TextureFormat::R11G11B10UF, TextureFormat::RGBA16F,
+                                      TextureFormat::R16F, TextureFormat::RG16F, TextureFormat::RGB10A2,
+                                      TextureFormat::RGBA8_SRGB,
                                      };
 
   static const TextureFormat att[] = {TextureFormat::R8,   TextureFormat::RG8,   TextureFormat::RGBA8,
                                       TextureFormat::R16,  TextureFormat::RG16,  TextureFormat::RGBA16,
                                       TextureFormat::R32F, TextureFormat::RG32F, TextureFormat::RGBA32F,
                                       TextureFormat::R11G11B10UF, TextureFormat::RGBA16F,
+                                      TextureFormat::R16F, TextureFormat::RG16F, TextureFormat::RGB10A2,
+                                      TextureFormat::RGBA8_SRGB,
                                      };
 
   static const TextureFormat sso[] = {TextureFormat::R8,   TextureFormat::RG8,   TextureFormat::RGBA8,
@@ -272,7 +276,10 @@ void MtDevice::deductProps(AbstractGraphicsApi::Props& prop, MTL::Device& dev) {
 
 
   if(dev.supportsBCTextureCompression()) {
-    static const TextureFormat bc[] = {TextureFormat::DXT1, TextureFormat::DXT3, TextureFormat::DXT5};
+    static const TextureFormat bc[] = {TextureFormat::DXT1,      TextureFormat::DXT3,      TextureFormat::DXT5,
+                                       TextureFormat::DXT1_SRGB, TextureFormat::DXT3_SRGB, TextureFormat::DXT5_SRGB,
+                                       TextureFormat::BC4,       TextureFormat::BC5,
+                                       TextureFormat::BC7,       TextureFormat::BC7_SRGB};
     for(auto& i:bc)
       smpBit |= uint64_t(1) << uint64_t(i);
     }
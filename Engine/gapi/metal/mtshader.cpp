@@ -20,8 +20,8 @@ static uint32_t spvVersion(MTL::LanguageVersion v) {
   return spirv_cross::CompilerMSL::Options::make_msl_version(major,minor,0);
   }
 
-MtShader::MtShader(MtDevice& dev, const void* source, size_t srcSize)
-  : Shader(source, srcSize) {
+MtShader::MtShader(MtDevice& dev, const void* source, size_t srcSize, ShaderCache* cache, const ShaderKey* key)
+  : Shader(source, srcSize, cache, key) {
   auto pool = NsPtr<NS::AutoreleasePool>::init();
   spirv_cross::CompilerMSL::Options optMSL;
 #if defined(__OSX__)
@@ -14,7 +14,7 @@ class MtDevice;
 
 class MtShader : public Detail::Shader {
   public:
-    MtShader(MtDevice& dev, const void* source, size_t srcSize);
+    MtShader(MtDevice& dev, const void* source, size_t srcSize, ShaderCache* cache = nullptr, const ShaderKey* key = nullptr);
     ~MtShader();
 
     enum Bindings : uint32_t {
@@ -18,7 +18,7 @@ class MtDevice;
 
 class MtSwapchain : public AbstractGraphicsApi::Swapchain {
   public:
-    MtSwapchain(MtDevice& dev, SystemApi::Window* w);
+    MtSwapchain(MtDevice& dev, SystemApi::Window* w, const SwapchainDesc& desc);
     ~MtSwapchain();
 
     void          reset() override;
@@ -26,6 +26,8 @@ class MtSwapchain : public AbstractGraphicsApi::Swapchain {
     uint32_t      imageCount() const override;
     uint32_t      w() const override;
     uint32_t      h() const override;
+    PresentMode   presentMode() const override { return mode; }
+    SwapchainStats stats() const override;
     void          present();
     NonUniqResId  syncId() const override { return NonUniqResId::I_None; }
 
@@ -40,9 +42,11 @@ class MtSwapchain : public AbstractGraphicsApi::Swapchain {
     struct Impl;
     std::unique_ptr<Impl> pimpl;
 
-    SpinLock              sync;
+    mutable SpinLock      sync;
     MtDevice&             dev;
     Tempest::Size         sz;
+    PresentMode           mode       = PresentMode::Fifo;
+    SwapchainStats        frameStats;
 
     uint32_t              imgCount   = 0;
     uint32_t              currentImg = 0;
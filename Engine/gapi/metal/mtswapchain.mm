@@ -22,6 +22,9 @@
 #import <Metal/MTLTexture.h>
 #import <Metal/MTLCommandQueue.h>
 
+#include <algorithm>
+#include <chrono>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
@@ -92,7 +95,7 @@ static CGRect windowRect(UIWindow* wnd) {
 #endif
 
 // note : MoltenVK supports NSView, UIView, CAMetalLayer, so we should align to it
-MtSwapchain::MtSwapchain(MtDevice& dev, SystemApi::Window *w)
+MtSwapchain::MtSwapchain(MtDevice& dev, SystemApi::Window *w, const SwapchainDesc& desc)
   :dev(dev), pimpl(new Impl()) {
   NSObject* obj = reinterpret_cast<NSObject*>(w);
   if([obj isKindOfClass : [SysWindow class]])
@@ -115,9 +118,28 @@ MtSwapchain::MtSwapchain(MtDevice& dev, SystemApi::Window *w)
   lay.device = id<MTLDevice>(dev.impl.get());
     
   [lay setContentsScale:dpi];
+  if(desc.imageCount!=0) {
+    // CAMetalLayer accepts only 2 or 3 drawables
+    lay.maximumDrawableCount    = std::clamp<NSUInteger>(desc.imageCount, 2, 3);
+    }
 #if defined(__IOS__)
-  // Swapchain takes too much memory on 2GB iPhone
-  lay.maximumDrawableCount      = 2;
+  else {
+    // Swapchain takes too much memory on 2GB iPhone
+    lay.maximumDrawableCount    = 2;
+    }
+#endif
+#if defined(__OSX__)
+  // Mailbox and FifoRelaxed are not exposed by CAMetalLayer: fallback to Fifo, same as on Vulkan
+  if(desc.presentMode==PresentMode::Immediate) {
+    lay.displaySyncEnabled      = NO;
+    mode                        = PresentMode::Immediate;
+    } else {
+    lay.displaySyncEnabled      = YES;
+    mode                        = PresentMode::Fifo;
+    }
+#else
+  // display sync can't be disabled on iOS
+  mode                          = PresentMode::Fifo;
 #endif
   lay.pixelFormat               = MTLPixelFormatBGRA8Unorm;
   lay.allowsNextDrawableTimeout = NO;
@@ -157,11 +179,14 @@ uint32_t MtSwapchain::currentBackBufferIndex() {
   }
 
 void MtSwapchain::present() {
+  using clock = std::chrono::steady_clock;
   auto pool = NsPtr<NS::AutoreleasePool>::init();
   
   CA::MetalLayer* lay      = reinterpret_cast<CA::MetalLayer*>(pimpl->metalLayer());
   uint32_t        i        = currentImg;
+  const auto      t0       = clock::now();
   auto            drawable = lay->nextDrawable();
+  const auto      t1       = clock::now();
   if(drawable==nullptr)
     throw SwapchainSuboptimal();
   
@@ -205,6 +230,16 @@ void MtSwapchain::present() {
   cmd->commit();
 
   nextDrawable();
+
+  // display time of drawable is not tracked: displayLatency stays 0
+  frameStats.frameId     = frameStats.frameId+1;
+  frameStats.acquireWait = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count());
+  frameStats.presentTime = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(clock::now()-t0).count());
+  }
+
+SwapchainStats MtSwapchain::stats() const {
+  std::lock_guard<SpinLock> guard(sync);
+  return frameStats;
   }
 
 NsPtr<MTL::Texture> MtSwapchain::mkTexture() {
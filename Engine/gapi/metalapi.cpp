@@ -8,6 +8,7 @@
 
 #include <Tempest/Log>
 #include <Tempest/Pixmap>
+#include <Tempest/SpecializationConstants>
 
 #include "gapi/metal/mtdevice.h"
 #include "gapi/metal/mtbuffer.h"
@@ -67,16 +68,20 @@ AbstractGraphicsApi::Device* MetalApi::createDevice(std::string_view gpuName) {
   }
 
 AbstractGraphicsApi::Swapchain *MetalApi::createSwapchain(SystemApi::Window *w,
-                                                          AbstractGraphicsApi::Device* d) {
+                                                          AbstractGraphicsApi::Device* d,
+                                                          const SwapchainDesc& desc) {
   auto& dev = *reinterpret_cast<MtDevice*>(d);
-  return new MtSwapchain(dev,w);
+  return new MtSwapchain(dev,w,desc);
   }
 
 AbstractGraphicsApi::PPipeline MetalApi::createPipeline(AbstractGraphicsApi::Device *d,
                                                         const RenderState &st,
                                                         Topology tp,
                                                         const AbstractGraphicsApi::Shader*const* sh,
-                                                        size_t cnt) {
+                                                        size_t cnt,
+                                                        const SpecializationConstants& spec) {
+  if(!spec.isEmpty())
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension, "specialization constants");
   auto& dx = *reinterpret_cast<MtDevice*>(d);
   const Detail::MtShader* shader[5] = {};
   for(size_t i=0; i<cnt; ++i)
@@ -85,15 +90,19 @@ AbstractGraphicsApi::PPipeline MetalApi::createPipeline(AbstractGraphicsApi::Dev
   }
 
 AbstractGraphicsApi::PCompPipeline MetalApi::createComputePipeline(AbstractGraphicsApi::Device *d,
-                                                                   AbstractGraphicsApi::Shader *cs) {
+                                                                   AbstractGraphicsApi::Shader *cs,
+                                                                   const SpecializationConstants& spec) {
+  if(!spec.isEmpty())
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension, "specialization constants");
   auto& dx = *reinterpret_cast<MtDevice*>(d);
   auto& cx = *reinterpret_cast<const MtShader*>(cs);
   return PCompPipeline(new MtCompPipeline(dx,cx));
   }
 
-AbstractGraphicsApi::PShader MetalApi::createShader(AbstractGraphicsApi::Device *d, const void *source, size_t src_size) {
+AbstractGraphicsApi::PShader MetalApi::createShader(AbstractGraphicsApi::Device *d, const void *source, size_t src_size,
+                                                    Detail::ShaderCache* cache, const Detail::ShaderKey* key) {
   auto& dx = *reinterpret_cast<MtDevice*>(d);
-  return PShader(new MtShader(dx,source,src_size));
+  return PShader(new MtShader(dx,source,src_size,cache,key));
   }
 
 AbstractGraphicsApi::PBuffer MetalApi::createBuffer(AbstractGraphicsApi::Device *d, const void *mem, size_t size,
@@ -152,7 +161,7 @@ AbstractGraphicsApi::PTexture MetalApi::createStorage(Device* d,
   return PTexture(new MtTexture(dev,w,h,depth,mips,frm,true));
   }
 
-AbstractGraphicsApi::AccelerationStructure* MetalApi::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size) {
+AbstractGraphicsApi::AccelerationStructure* MetalApi::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size, BlasFlags /*flags*/) {
   auto& dev = *reinterpret_cast<MtDevice*>(d);
   // auto& ix  = *reinterpret_cast<MtBuffer*>(ibo);
   // auto& vx  = *reinterpret_cast<MtBuffer*>(vbo);
@@ -188,8 +197,8 @@ void MetalApi::readPixels(AbstractGraphicsApi::Device*,
   }
 
 void MetalApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer *buf,
-                         void *out, size_t size) {
-  buf->read(out,0,size);
+                         void *out, size_t offset, size_t size) {
+  buf->read(out,offset,size);
   }
 
 AbstractGraphicsApi::CommandBuffer *MetalApi::createCommandBuffer(AbstractGraphicsApi::Device *d) {
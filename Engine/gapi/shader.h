@@ -1,23 +1,28 @@
 #pragma once
 
 #include <Tempest/AbstractGraphicsApi>
+#include <Tempest/SpecializationConstants>
 
 #include "gapi/shaderreflection.h"
 
 namespace Tempest {
 namespace Detail {
 
+class  ShaderCache;
+struct ShaderKey;
+
 class Shader : public AbstractGraphicsApi::Shader {
   protected:
     using Binding = ShaderReflection::Binding;
 
     Shader() = default;
-    Shader(const void *source, size_t size);
+    Shader(const void *source, size_t size, ShaderCache* cache = nullptr, const ShaderKey* key = nullptr);
 
-    void fetchBindings(const uint32_t* source, const size_t size);
+    void fetchBindings(const uint32_t* source, const size_t size, ShaderCache* cache, const ShaderKey* key);
 
   public:
     const char* dbgShortName() const;
+    IVec3       workGroupSize(const SpecializationConstants& spec) const;
 
     struct Vert {
       std::vector<Decl::ComponentType> decl;
@@ -25,8 +30,9 @@ class Shader : public AbstractGraphicsApi::Shader {
       bool has_baseVertex_baseInstance = false;
       };
     struct Comp {
-      IVec3 wgSize;
-      bool  has_NumworkGroups = false;
+      IVec3    wgSize;
+      uint32_t wgSizeSpec[3] = {ShaderReflection::NoSpecId, ShaderReflection::NoSpecId, ShaderReflection::NoSpecId};
+      bool     has_NumworkGroups = false;
       };
     struct Dbg {
       std::string source;
@@ -0,0 +1,358 @@
+#include "shadercache.h"
+
+#include <Tempest/File>
+#include <Tempest/Log>
+
+#include <cstring>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+enum : uint32_t {
+  Magic   = 0x43485354, // "TSHC"
+  Version = 2,
+  };
+
+inline uint64_t rotl64(uint64_t x, int8_t r) {
+  return (x << r) | (x >> (64 - r));
+  }
+
+inline uint64_t fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdull;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ull;
+  k ^= k >> 33;
+  return k;
+  }
+
+// MurmurHash3_x64_128, by Austin Appleby (public domain)
+void murmur3(const void* key, size_t len, uint64_t out[2]) {
+  const uint8_t* data    = reinterpret_cast<const uint8_t*>(key);
+  const size_t   nblocks = len/16;
+
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+
+  const uint64_t c1 = 0x87c37b91114253d5ull;
+  const uint64_t c2 = 0x4cf5ad432745937full;
+
+  for(size_t i=0; i<nblocks; ++i) {
+    uint64_t k1 = 0, k2 = 0;
+    std::memcpy(&k1, data + i*16,     8);
+    std::memcpy(&k2, data + i*16 + 8, 8);
+
+    k1 *= c1; k1 = rotl64(k1,31); k1 *= c2; h1 ^= k1;
+    h1 = rotl64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+
+    k2 *= c2; k2 = rotl64(k2,33); k2 *= c1; h2 ^= k2;
+    h2 = rotl64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+    }
+
+  const uint8_t* tail = data + nblocks*16;
+  uint64_t       k1   = 0;
+  uint64_t       k2   = 0;
+  switch(len & 15) {
+    case 15: k2 ^= uint64_t(tail[14]) << 48; [[fallthrough]];
+    case 14: k2 ^= uint64_t(tail[13]) << 40; [[fallthrough]];
+    case 13: k2 ^= uint64_t(tail[12]) << 32; [[fallthrough]];
+    case 12: k2 ^= uint64_t(tail[11]) << 24; [[fallthrough]];
+    case 11: k2 ^= uint64_t(tail[10]) << 16; [[fallthrough]];
+    case 10: k2 ^= uint64_t(tail[ 9]) << 8;  [[fallthrough]];
+    case  9: k2 ^= uint64_t(tail[ 8]) << 0;
+             k2 *= c2; k2 = rotl64(k2,33); k2 *= c1; h2 ^= k2;
+             [[fallthrough]];
+    case  8: k1 ^= uint64_t(tail[ 7]) << 56; [[fallthrough]];
+    case  7: k1 ^= uint64_t(tail[ 6]) << 48; [[fallthrough]];
+    case  6: k1 ^= uint64_t(tail[ 5]) << 40; [[fallthrough]];
+    case  5: k1 ^= uint64_t(tail[ 4]) << 32; [[fallthrough]];
+    case  4: k1 ^= uint64_t(tail[ 3]) << 24; [[fallthrough]];
+    case  3: k1 ^= uint64_t(tail[ 2]) << 16; [[fallthrough]];
+    case  2: k1 ^= uint64_t(tail[ 1]) << 8;  [[fallthrough]];
+    case  1: k1 ^= uint64_t(tail[ 0]) << 0;
+             k1 *= c1; k1 = rotl64(k1,31); k1 *= c2; h1 ^= k1;
+    }
+
+  h1 ^= uint64_t(len);
+  h2 ^= uint64_t(len);
+
+  h1 += h2;
+  h2 += h1;
+
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+
+  h1 += h2;
+  h2 += h1;
+
+  out[0] = h1;
+  out[1] = h2;
+  }
+
+struct Writer {
+  std::vector<uint8_t>& out;
+
+  template<class T>
+  void put(const T& v) {
+    static_assert(std::is_trivially_copyable<T>::value, "POD only");
+    auto at = out.size();
+    out.resize(at+sizeof(T));
+    std::memcpy(out.data()+at, &v, sizeof(T));
+    }
+
+  void put(const void* data, size_t size) {
+    auto at = out.size();
+    out.resize(at+size);
+    if(size>0)
+      std::memcpy(out.data()+at, data, size);
+    }
+  };
+
+struct Reader {
+  const uint8_t* data = nullptr;
+  size_t         size = 0;
+  size_t         at   = 0;
+
+  template<class T>
+  bool get(T& v) {
+    return get(&v, sizeof(T));
+    }
+
+  bool get(void* dest, size_t sz) {
+    if(size-at<sz)
+      return false;
+    if(sz>0)
+      std::memcpy(dest, data+at, sz);
+    at += sz;
+    return true;
+    }
+  };
+
+}
+
+ShaderCache::ShaderCache() {
+  }
+
+ShaderCache::~ShaderCache() {
+  try {
+    save();
+    }
+  catch(...) {
+    Log::e("unable to write shader cache: \"", path, "\"");
+    }
+  }
+
+ShaderCache::Key ShaderCache::key(const void* source, size_t size) const {
+  Key k;
+  k.size     = size;
+  k.optimize = optimize.load();
+  murmur3(source, size, k.hash);
+  return k;
+  }
+
+void ShaderCache::open(std::string_view file) {
+  std::lock_guard<std::mutex> guard(sync);
+  path = std::string(file);
+  reflection.clear();
+  changed = false;
+
+  std::vector<uint8_t> data;
+  try {
+    RFile f(path);
+    data.resize(f.size());
+    if(f.read(data.data(), data.size())!=data.size())
+      return;
+    }
+  catch(const std::system_error&) {
+    // no cache yet
+    return;
+    }
+
+  Reader   rd  = {data.data(), data.size()};
+  uint32_t hdr[3] = {};
+  if(!rd.get(hdr) || hdr[0]!=Magic || hdr[1]!=Version)
+    return;
+
+  for(uint32_t i=0; i<hdr[2]; ++i) {
+    Key      k;
+    uint32_t sz = 0;
+    if(!rd.get(k.hash) || !rd.get(k.size) || !rd.get(sz))
+      break;
+    std::vector<uint8_t> blob(sz);
+    if(!rd.get(blob.data(), sz))
+      break;
+    reflection[k] = std::move(blob);
+    }
+  }
+
+void ShaderCache::save() {
+  std::lock_guard<std::mutex> guard(sync);
+  if(path.empty() || !changed)
+    return;
+
+  std::vector<uint8_t> data;
+  Writer wr = {data};
+  const uint32_t hdr[3] = {Magic, Version, uint32_t(reflection.size())};
+  wr.put(hdr);
+  for(auto& i:reflection) {
+    wr.put(i.first.hash);
+    wr.put(i.first.size);
+    wr.put(uint32_t(i.second.size()));
+    wr.put(i.second.data(), i.second.size());
+    }
+
+  WFile f(path);
+  f.write(data.data(), data.size());
+  changed = false;
+  }
+
+AbstractGraphicsApi::PShader ShaderCache::find(const Key& k) {
+  std::lock_guard<std::mutex> guard(sync);
+  auto it = shaders.find(k);
+  if(it==shaders.end())
+    return AbstractGraphicsApi::PShader();
+  return it->second;
+  }
+
+AbstractGraphicsApi::PShader ShaderCache::insert(const Key& k, AbstractGraphicsApi::PShader&& sh) {
+  std::lock_guard<std::mutex> guard(sync);
+  auto it = shaders.find(k);
+  if(it!=shaders.end()) {
+    // other thread did create same shader
+    return it->second;
+    }
+  if(shaders.size()>=sweepSize)
+    sweep();
+  shaders[k] = sh;
+  return std::move(sh);
+  }
+
+size_t ShaderCache::size() {
+  std::lock_guard<std::mutex> guard(sync);
+  return shaders.size();
+  }
+
+void ShaderCache::sweep() {
+  // shaders, referenced only by cache, can't be acquired by anyone else, while lock is held
+  for(auto it = shaders.begin(); it!=shaders.end();) {
+    if(it->second.handler->counter.load()==1)
+      it = shaders.erase(it); else
+      ++it;
+    }
+  sweepSize = std::max<size_t>(64, shaders.size()*2);
+  }
+
+void ShaderCache::reflect(ShaderReflection::ModuleInfo& ret, const uint32_t* source, size_t size, const Key* pk) {
+  bool persistent = false;
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    persistent = !path.empty();
+  }
+  if(!persistent) {
+    ShaderReflection::reflect(ret, source, size);
+    return;
+    }
+
+  // reflection runs on original bytecode: entry is shared by optimized and unoptimized modules
+  Key k = (pk!=nullptr) ? *pk : key(source, size*sizeof(uint32_t));
+  k.optimize = false;
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    auto it = reflection.find(k);
+    if(it!=reflection.end()) {
+      if(deserialize(ret, it->second))
+        return;
+      ret = ShaderReflection::ModuleInfo();
+      }
+  }
+
+  ShaderReflection::reflect(ret, source, size);
+
+  std::vector<uint8_t> blob;
+  serialize(blob, ret);
+
+  std::lock_guard<std::mutex> guard(sync);
+  reflection[k] = std::move(blob);
+  changed       = true;
+  }
+
+void ShaderCache::serialize(std::vector<uint8_t>& out, const ShaderReflection::ModuleInfo& info) {
+  Writer wr = {out};
+  wr.put(uint8_t(info.stage));
+  wr.put(int32_t(info.wgSize.x));
+  wr.put(int32_t(info.wgSize.y));
+  wr.put(int32_t(info.wgSize.z));
+  wr.put(info.wgSizeSpecId);
+  wr.put(uint8_t(info.hasBaseVertex));
+  wr.put(uint8_t(info.hasNumWorkgroups));
+
+  wr.put(uint32_t(info.source.size()));
+  wr.put(info.source.data(), info.source.size());
+
+  wr.put(uint32_t(info.vertexDecl.size()));
+  for(auto i:info.vertexDecl)
+    wr.put(uint8_t(i));
+
+  wr.put(uint32_t(info.lay.size()));
+  for(auto& b:info.lay) {
+    wr.put(b.layout);
+    wr.put(uint8_t(b.cls));
+    wr.put(uint8_t(b.stage));
+    wr.put(uint8_t(b.runtimeSized));
+    wr.put(uint8_t(b.is3DImage));
+    wr.put(b.arraySize);
+    wr.put(b.byteSize);
+    wr.put(b.varByteSize);
+    wr.put(b.spvId);
+    }
+  }
+
+bool ShaderCache::deserialize(ShaderReflection::ModuleInfo& out, const std::vector<uint8_t>& data) {
+  Reader   rd = {data.data(), data.size()};
+  uint8_t  stage = 0, baseVertex = 0, numWorkgroups = 0;
+  int32_t  wg[3] = {};
+  uint32_t count = 0;
+
+  if(!rd.get(stage) || !rd.get(wg) || !rd.get(out.wgSizeSpecId) || !rd.get(baseVertex) || !rd.get(numWorkgroups))
+    return false;
+  out.stage            = ShaderReflection::Stage(stage);
+  out.wgSize           = IVec3(wg[0], wg[1], wg[2]);
+  out.hasBaseVertex    = baseVertex!=0;
+  out.hasNumWorkgroups = numWorkgroups!=0;
+
+  if(!rd.get(count) || count>data.size())
+    return false;
+  out.source.resize(count);
+  if(!rd.get(&out.source[0], count))
+    return false;
+
+  if(!rd.get(count) || count>data.size())
+    return false;
+  out.vertexDecl.resize(count);
+  for(auto& i:out.vertexDecl) {
+    uint8_t v = 0;
+    if(!rd.get(v) || v>=Decl::count)
+      return false;
+    i = Decl::ComponentType(v);
+    }
+
+  if(!rd.get(count) || count>data.size())
+    return false;
+  out.lay.resize(count);
+  for(auto& b:out.lay) {
+    uint8_t cls = 0, stage = 0, runtimeSized = 0, is3DImage = 0;
+    if(!rd.get(b.layout) || !rd.get(cls) || !rd.get(stage) || !rd.get(runtimeSized) || !rd.get(is3DImage))
+      return false;
+    if(!rd.get(b.arraySize) || !rd.get(b.byteSize) || !rd.get(b.varByteSize) || !rd.get(b.spvId))
+      return false;
+    if(cls>=ShaderReflection::Count)
+      return false;
+    b.cls          = ShaderReflection::Class(cls);
+    b.stage        = ShaderReflection::Stage(stage);
+    b.runtimeSized = runtimeSized!=0;
+    b.is3DImage    = is3DImage!=0;
+    }
+  return rd.at==rd.size;
+  }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gapi/shaderreflection.h"
+
+namespace Tempest {
+namespace Detail {
+
+struct ShaderKey {
+  uint64_t hash[2] = {};
+  uint64_t size    = 0;
+  //! bytecode is passed through ShaderOptimizer; reflection is same for both variants
+  bool     optimize = false;
+
+  bool operator == (const ShaderKey& other) const {
+    return hash[0]==other.hash[0] && hash[1]==other.hash[1] && size==other.size && optimize==other.optimize;
+    }
+  };
+
+/**
+ * Device-level shader cache, keyed by content hash of SPIR-V.
+ *
+ * Same bytecode returns same shader handle, while shader is alive. Optionally,
+ * reflection data is persisted to disk, so repeated launches skip reflection.
+ */
+class ShaderCache {
+  public:
+    using Key = ShaderKey;
+
+    ShaderCache();
+    ~ShaderCache();
+
+    //! content key of bytecode, with current optimization setting
+    Key   key(const void* source, size_t size) const;
+
+    void  open(std::string_view file);
+    void  save();
+
+    AbstractGraphicsApi::PShader find(const Key& k);
+    AbstractGraphicsApi::PShader insert(const Key& k, AbstractGraphicsApi::PShader&& sh);
+    size_t                       size();
+
+    //! `k` is content key of same bytecode, if already computed
+    void  reflect(ShaderReflection::ModuleInfo& ret, const uint32_t* source, size_t size, const Key* k = nullptr);
+
+    //! run ShaderOptimizer on bytecode, before it's passed to driver
+    std::atomic_bool optimize{false};
+
+  private:
+    struct KeyHash {
+      size_t operator()(const Key& k) const { return size_t(k.hash[0]) ^ size_t(k.optimize); }
+      };
+
+    static void serialize  (std::vector<uint8_t>& out, const ShaderReflection::ModuleInfo& info);
+    static bool deserialize(ShaderReflection::ModuleInfo& out, const std::vector<uint8_t>& data);
+    void        sweep();
+
+    std::mutex                                                   sync;
+    std::unordered_map<Key, AbstractGraphicsApi::PShader, KeyHash> shaders;
+    size_t                                                       sweepSize = 64;
+
+    std::string                                                  path;
+    std::unordered_map<Key, std::vector<uint8_t>, KeyHash>       reflection;
+    bool                                                         changed = false;
+  };
+
+}
+}
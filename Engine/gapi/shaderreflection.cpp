@@ -3,8 +3,11 @@
 #include <Tempest/Except>
 #include <Tempest/Log>
 #include <algorithm>
+#include <cstring>
 #include <libspirv/libspirv.h>
 
+#include "thirdparty/spirv_cross/spirv_cross.hpp"
+
 #if defined(__cpp_lib_bitops)
 #include <bit>
 #else
@@ -15,70 +18,366 @@ using namespace Tempest;
 using namespace Tempest::Detail;
 
 
-static const spirv_cross::SPIRType& typeFromVariable(const spirv_cross::Compiler& comp, spirv_cross::VariableID i) {
-  auto& ret = comp.get_type_from_variable(i);
-  if(ret.pointer) {
-    auto& base = comp.get_type(ret.parent_type);
-    return base;
+namespace {
+
+enum MetaFlags : uint16_t {
+  M_Block       = 1 << 0,
+  M_BufferBlock = 1 << 1,
+  M_BuiltIn     = 1 << 2,
+  M_NonWritable = 1 << 3,
+  M_NonReadable = 1 << 4,
+  M_RowMajor    = 1 << 5,
+  };
+
+struct Meta {
+  uint32_t binding  = 0;
+  uint32_t location = 0;
+  uint32_t stride   = 0;
+  uint32_t specId   = ShaderReflection::NoSpecId;
+  uint16_t flags    = 0;
+  };
+
+struct MemberMeta {
+  uint32_t type         = 0;
+  uint32_t member       = 0;
+  uint32_t offset       = 0;
+  uint32_t matrixStride = 0;
+  uint16_t flags        = 0;
+
+  bool operator < (const MemberMeta& other) const {
+    return type<other.type || (type==other.type && member<other.member);
     }
-  return ret;
-  }
+  };
 
-static bool isRuntimeSized(const spirv_cross::SPIRType& t) {
-  if(t.array.empty())
-    return false;
-  if(t.op==spv::OpTypeRuntimeArray)
-    return true;
-  // NOTE: unused runtime array has size of 1
-  return (!t.array.empty() && t.array[0]<=1);
-  }
+// Everything reflection needs is declared before first OpFunction, so module is scanned only once:
+// decorations and definitions are indexed by id, then resources are resolved from that index.
+struct SpvModule {
+  using OpCode = libspirv::Bytecode::OpCode;
 
-static uint32_t arraySize(const spirv_cross::SPIRType& t) {
-  if(isRuntimeSized(t))
-    return 0;
-  uint32_t cnt = 1;
-  for(auto& i:t.array)
-    cnt *= i;
-  return cnt;
-  }
+  SpvModule(const uint32_t* source, const size_t size):code(source, size) {
+    if(size<5 || source[0]!=spv::MagicNumber)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+
+    const uint32_t bound = code.bound();
+    def  .resize(bound, nullptr);
+    meta .resize(bound);
+    iface.resize(bound, 0);
+
+    uint32_t sourceFile = 0;
+    for(auto& i:code) {
+      if(i.length()==0 || code.toOffset(i)+i.length()>size)
+        throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+      if(i.op()==spv::OpFunction)
+        break;
+
+      switch(i.op()) {
+        case spv::OpExtension: {
+          std::string_view str = reinterpret_cast<const char*>(&i[1]);
+          if(str=="SPV_EXT_descriptor_indexing")
+            nonUniform = true;
+          break;
+          }
+        case spv::OpSourceExtension: {
+          std::string_view str = reinterpret_cast<const char*>(&i[1]);
+          if(str=="GL_EXT_nonuniform_qualifier")
+            nonUniform = true;
+          break;
+          }
+        case spv::OpEntryPoint: {
+          if(entry!=nullptr)
+            break;
+          entry = &i;
+          // name is nul-terminated string, padded to word boundary
+          const size_t name = std::strlen(reinterpret_cast<const char*>(&i[3]))/4 + 1;
+          for(size_t r=3+name; r<i.length(); ++r)
+            at(iface, i[uint16_t(r)]) = 1;
+          break;
+          }
+        case spv::OpExecutionMode: {
+          if(i[2]==spv::ExecutionModeLocalSize && i.length()>=6) {
+            wgSize.x = int(i[3]);
+            wgSize.y = int(i[4]);
+            wgSize.z = int(i[5]);
+            }
+          break;
+          }
+        case spv::OpExecutionModeId: {
+          if(i[2]==spv::ExecutionModeLocalSizeId && i.length()>=6) {
+            for(int r=0; r<3; ++r)
+              wgSizeId[r] = i[uint16_t(3+r)];
+            }
+          break;
+          }
+        case spv::OpString: {
+          at(def, i[1]) = &i;
+          break;
+          }
+        case spv::OpSource: {
+          if(sourceFile==0 && i.length()>3)
+            sourceFile = i[3];
+          break;
+          }
+        case spv::OpDecorate: {
+          auto& m = at(meta, i[1]);
+          switch(i[2]) {
+            case spv::DecorationBinding:     m.binding  = i[3];          break;
+            case spv::DecorationLocation:    m.location = i[3];          break;
+            case spv::DecorationArrayStride: m.stride   = i[3];          break;
+            case spv::DecorationBlock:       m.flags   |= M_Block;       break;
+            case spv::DecorationBufferBlock: m.flags   |= M_BufferBlock; break;
+            case spv::DecorationNonWritable: m.flags   |= M_NonWritable; break;
+            case spv::DecorationNonReadable: m.flags   |= M_NonReadable; break;
+            case spv::DecorationSpecId:      m.specId   = i[3];          break;
+            case spv::DecorationBuiltIn: {
+              m.flags |= M_BuiltIn;
+              if(i[3]==spv::BuiltInWorkgroupSize)
+                wgSizeBuiltIn = i[1];
+              if(i[3]==spv::BuiltInInstanceIndex || i[3]==spv::BuiltInBaseVertex)
+                hasBaseVertex = true;
+              if(i[3]==spv::BuiltInNumWorkgroups)
+                hasNumWorkgroups = true;
+              break;
+              }
+            default:
+              break;
+            }
+          break;
+          }
+        case spv::OpMemberDecorate: {
+          if(member.empty() || member.back().type!=i[1] || member.back().member!=i[2]) {
+            MemberMeta m;
+            m.type   = i[1];
+            m.member = i[2];
+            member.push_back(m);
+            }
+          auto& m = member.back();
+          switch(i[3]) {
+            case spv::DecorationOffset:       m.offset       = i[4];          break;
+            case spv::DecorationMatrixStride: m.matrixStride = i[4];          break;
+            case spv::DecorationRowMajor:     m.flags       |= M_RowMajor;    break;
+            case spv::DecorationNonWritable:  m.flags       |= M_NonWritable; break;
+            case spv::DecorationBuiltIn:      m.flags       |= M_BuiltIn;     break;
+            default:
+              break;
+            }
+          break;
+          }
+        case spv::OpConstant:
+        case spv::OpSpecConstant:
+        case spv::OpConstantComposite:
+        case spv::OpSpecConstantComposite: {
+          at(def, i[2]) = &i;
+          break;
+          }
+        case spv::OpVariable: {
+          at(def, i[2]) = &i;
+          if(i[3]!=spv::StorageClassFunction)
+            variables.push_back(i[2]);
+          break;
+          }
+        default:
+          if(libspirv::Bytecode::isTypeDecl(i.op()) || i.op()==spv::OpTypeAccelerationStructureKHR)
+            at(def, i[1]) = &i;
+          break;
+        }
+      }
+
+    if(entry==nullptr)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    if(sourceFile!=0 && sourceFile<bound && def[sourceFile]!=nullptr && def[sourceFile]->op()==spv::OpString)
+      srcFile = reinterpret_cast<const char*>(&(*def[sourceFile])[2]);
+
+    // decorations of same member are usually adjacent, but not necessarily
+    std::sort(member.begin(), member.end());
+    size_t cnt = 0;
+    for(size_t i=0; i<member.size(); ++i) {
+      if(cnt>0 && !(member[cnt-1]<member[i])) {
+        auto& m = member[cnt-1];
+        m.offset       = std::max(m.offset,       member[i].offset);
+        m.matrixStride = std::max(m.matrixStride, member[i].matrixStride);
+        m.flags       |= member[i].flags;
+        continue;
+        }
+      member[cnt] = member[i];
+      ++cnt;
+      }
+    member.resize(cnt);
+
+    // gl_WorkGroupSize takes precedence over LocalSize execution mode
+    if(wgSizeBuiltIn!=0) {
+      auto& c = op(wgSizeBuiltIn);
+      if(c.length()<6)
+        throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+      for(int r=0; r<3; ++r)
+        wgSizeId[r] = c[uint16_t(3+r)];
+      }
+    for(int r=0; r<3; ++r) {
+      if(wgSizeId[r]==0)
+        continue;
+      wg(r)       = int(constant(wgSizeId[r]));
+      wgSpecId[r] = meta[wgSizeId[r]].specId;
+      }
+    }
+
+  int& wg(int r) {
+    return r==0 ? wgSize.x : (r==1 ? wgSize.y : wgSize.z);
+    }
+
+  template<class T>
+  static T& at(std::vector<T>& v, uint32_t id) {
+    if(id>=v.size())
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    return v[id];
+    }
+
+  const OpCode& op(uint32_t id) const {
+    if(id>=def.size() || def[id]==nullptr)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    return *def[id];
+    }
+
+  uint32_t constant(uint32_t id) const {
+    auto& c = op(id);
+    if(c.op()!=spv::OpConstant && c.op()!=spv::OpSpecConstant)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    return c[3];
+    }
+
+  const MemberMeta* findMember(uint32_t type, uint32_t index) const {
+    MemberMeta key;
+    key.type   = type;
+    key.member = index;
+    auto it = std::lower_bound(member.begin(), member.end(), key);
+    if(it==member.end() || it->type!=type || it->member!=index)
+      return nullptr;
+    return &(*it);
+    }
 
-static bool is3dImage(const spirv_cross::SPIRType& t) {
-  if(t.op!=spv::OpTypeImage)
+  bool isInterface(uint32_t var, spv::StorageClass cls) const {
+    // in SPIR-V 1.4 and up, every global must be present in the entry point interface list
+    if(code.spirvVersion()<0x10400 && cls!=spv::StorageClassInput && cls!=spv::StorageClassOutput)
+      return true;
+    return iface[var]!=0;
+    }
+
+  bool isBuiltIn(uint32_t var, uint32_t type) const {
+    if(meta[var].flags & M_BuiltIn)
+      return true;
+    auto& t = op(type);
+    if(t.op()!=spv::OpTypeStruct)
+      return false;
+    for(uint32_t i=0; i+2<t.length(); ++i) {
+      auto m = findMember(type, i);
+      if(m!=nullptr && (m->flags & M_BuiltIn))
+        return true;
+      }
     return false;
-  return t.image.dim==spv::Dim3D;
-  }
+    }
 
-static uint32_t declaredSize(spirv_cross::Compiler& comp, const spirv_cross::SPIRType& t) {
-  assert(t.basetype==spirv_cross::SPIRType::Struct);
-  // Offsets can be declared out of order, so we need to deduce the actual size
-  // based on last member instead.
-  uint32_t member_index = 0;
-  size_t highest_offset = 0;
-  for(uint32_t i = 0; i < uint32_t(t.member_types.size()); i++) {
-    size_t offset = comp.type_struct_member_offset(t, i);
-    if(offset > highest_offset) {
-      highest_offset = offset;
-      member_index = i;
+  bool isReadOnly(uint32_t var, uint32_t type) const {
+    if(meta[var].flags & M_NonWritable)
+      return true;
+    // block is readonly, if all members are NonWritable
+    auto& t = op(type);
+    if(t.length()<=2)
+      return false;
+    for(uint32_t i=0; i+2<t.length(); ++i) {
+      auto m = findMember(type, i);
+      if(m==nullptr || (m->flags & M_NonWritable)==0)
+        return false;
       }
+    return true;
     }
 
-  size_t size = comp.get_declared_struct_member_size(t, member_index);
-  if(size==0)
-    return uint32_t(highest_offset); // runtime sized tail
-  return uint32_t(highest_offset + size);
-  }
+  uint32_t memberSize(uint32_t st, uint32_t index) const {
+    const uint32_t id = op(st)[uint16_t(2+index)];
+    auto&          t  = op(id);
+    switch(t.op()) {
+      case spv::OpTypeArray:
+        return meta[id].stride*constant(t[3]);
+      case spv::OpTypeRuntimeArray:
+        return 0;
+      case spv::OpTypeStruct:
+        return structSize(id, false);
+      case spv::OpTypePointer:
+        // buffer reference
+        return 8;
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+        return t[2]/8;
+      case spv::OpTypeVector:
+        return op(t[2])[2]/8 * t[3];
+      case spv::OpTypeMatrix: {
+        auto m = findMember(st, index);
+        if(m==nullptr)
+          throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+        if(m->flags & M_RowMajor)
+          return m->matrixStride * op(t[2])[3];
+        return m->matrixStride * t[3];
+        }
+      default:
+        // opaque types can't be part of a block
+        throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+      }
+    }
+
+  uint32_t structSize(uint32_t st, bool runtimeTail) const {
+    auto& t = op(st);
+    if(t.op()!=spv::OpTypeStruct || t.length()<=2)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    // Offsets can be declared out of order, so we need to deduce the actual size
+    // based on last member instead.
+    uint32_t memberIndex   = 0;
+    uint32_t highestOffset = 0;
+    for(uint32_t i=0; i+2<t.length(); ++i) {
+      auto m = findMember(st, i);
+      if(m!=nullptr && m->offset>highestOffset) {
+        highestOffset = m->offset;
+        memberIndex   = i;
+        }
+      }
+    const uint32_t sz = memberSize(st, memberIndex);
+    if(sz==0 && runtimeTail)
+      return highestOffset;
+    return highestOffset + sz;
+    }
 
-static uint32_t declaredVarSize(spirv_cross::Compiler& comp, const spirv_cross::SPIRType& t) {
-  for(uint32_t i = 0; i < uint32_t(t.member_types.size()); i++) {
+  uint32_t varSize(uint32_t st) const {
     // GLSL: There can only be one array of variable size per SSBO.
-    auto &type = comp.get_type(t.member_types[i]);
-    if(type.op!=spv::OpTypeRuntimeArray)
-      continue;
-    const uint32_t sz = comp.type_struct_member_array_stride(t, i);
-    return sz;
+    auto& t = op(st);
+    for(uint16_t i=2; i<t.length(); ++i) {
+      if(op(t[i]).op()==spv::OpTypeRuntimeArray)
+        return meta[t[i]].stride;
+      }
+    return 0;
+    }
+
+  bool is3dImage(uint32_t type) const {
+    auto* t = &op(type);
+    if(t->op()==spv::OpTypeSampledImage)
+      t = &op((*t)[2]);
+    return t->op()==spv::OpTypeImage && (*t)[3]==spv::Dim3D;
     }
-  return 0;
-  }
+
+  libspirv::Bytecode         code;
+  std::vector<const OpCode*> def;
+  std::vector<Meta>          meta;
+  std::vector<MemberMeta>    member;
+  std::vector<uint8_t>       iface;
+  std::vector<uint32_t>      variables;
+
+  const OpCode*              entry            = nullptr;
+  IVec3                      wgSize;
+  uint32_t                   wgSizeBuiltIn    = 0;
+  uint32_t                   wgSizeId[3]      = {};
+  uint32_t                   wgSpecId[3]      = {ShaderReflection::NoSpecId, ShaderReflection::NoSpecId, ShaderReflection::NoSpecId};
+  bool                       nonUniform       = false;
+  bool                       hasBaseVertex    = false;
+  bool                       hasNumWorkgroups = false;
+  const char*                srcFile          = nullptr;
+  };
+
+}
 
 static uint32_t bitCount(uint32_t b) {
 #if defined(__cpp_lib_bitops)
@@ -109,154 +408,151 @@ uint32_t ShaderReflection::LayoutDesc::numSamplers() const {
   }
 
 
-void ShaderReflection::getVertexDecl(std::vector<Decl::ComponentType>& data, spirv_cross::Compiler& comp) {
-  if(comp.get_execution_model()!=spv::ExecutionModelVertex)
-    return;
+static Decl::ComponentType vertexInput(const SpvModule& mod, uint32_t type) {
+  uint32_t n = 1;
+  auto*    t = &mod.op(type);
+  if(t->op()==spv::OpTypeMatrix)
+    t = &mod.op((*t)[2]);
+  if(t->op()==spv::OpTypeVector) {
+    n = (*t)[3];
+    t = &mod.op((*t)[2]);
+    }
+  if(n<1 || n>4)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+
+  if(t->op()==spv::OpTypeFloat && (*t)[2]==32)
+    return Decl::ComponentType(Decl::float1+n-1);
+  if(t->op()==spv::OpTypeFloat && (*t)[2]==16) {
+    // no half3 vertex format
+    switch(n) {
+      case 1: return Decl::half1;
+      case 2: return Decl::half2;
+      case 4: return Decl::half4;
+      }
+    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule, "f16vec3 vertex input");
+    }
+  if(t->op()==spv::OpTypeInt && (*t)[2]==32 && (*t)[3]!=0)
+    return Decl::ComponentType(Decl::int1+n-1);
+  if(t->op()==spv::OpTypeInt && (*t)[2]==32)
+    return Decl::ComponentType(Decl::uint1+n-1);
+  // TODO: add support for uint32_t packed color
+  throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+  }
 
-  spirv_cross::ShaderResources resources = comp.get_shader_resources();
-  for(auto &resource : resources.stage_inputs) {
-    auto&    t   = comp.get_type_from_variable(resource.id);
-    unsigned loc = comp.get_decoration(resource.id, spv::DecorationLocation);
-    data.resize(std::max<size_t>(loc+1,data.size()));
+void ShaderReflection::reflect(ModuleInfo& ret, const uint32_t* source, const size_t size) {
+  const SpvModule mod(source, size);
+
+  ret.stage            = getExecutionModel(spv::ExecutionModel((*mod.entry)[1]));
+  ret.wgSize           = mod.wgSize;
+  for(int r=0; r<3; ++r)
+    ret.wgSizeSpecId[r] = mod.wgSpecId[r];
+  ret.hasBaseVertex    = mod.hasBaseVertex;
+  ret.hasNumWorkgroups = mod.hasNumWorkgroups;
+  if(mod.srcFile!=nullptr)
+    ret.source = mod.srcFile;
+
+  auto& lay = ret.lay;
+  for(auto id:mod.variables) {
+    auto&       var = mod.op(id);
+    const auto  cls = spv::StorageClass(var[3]);
+    if(cls!=spv::StorageClassInput && cls!=spv::StorageClassUniform && cls!=spv::StorageClassUniformConstant &&
+       cls!=spv::StorageClassStorageBuffer && cls!=spv::StorageClassPushConstant)
+      continue;
+    if(!mod.isInterface(id, cls))
+      continue;
 
-    switch(t.basetype) {
-      case spirv_cross::SPIRType::Float: {
-        data[loc] = Decl::ComponentType(Decl::float1+t.vecsize-1);
-        break;
+    auto& ptr = mod.op(var[1]);
+    if(ptr.op()!=spv::OpTypePointer)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+
+    uint32_t elt       = ptr[3];
+    bool     isArray   = false;
+    bool     isRuntime = (mod.op(elt).op()==spv::OpTypeRuntimeArray);
+    uint32_t count     = 1;
+    uint32_t inner     = 1;
+    while(true) {
+      auto& t = mod.op(elt);
+      if(t.op()==spv::OpTypeArray) {
+        inner  = mod.constant(t[3]);
+        count *= inner;
         }
-      case spirv_cross::SPIRType::Int: {
-        data[loc] = Decl::ComponentType(Decl::int1+t.vecsize-1);
-        break;
+      else if(t.op()==spv::OpTypeRuntimeArray) {
+        inner  = 0;
         }
-      case spirv_cross::SPIRType::UInt: {
-        data[loc] = Decl::ComponentType(Decl::uint1+t.vecsize-1);
+      else {
         break;
         }
-      // TODO: add support for uint32_t packed color
-      default:
-        // not supported
-        throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+      isArray = true;
+      elt     = t[2];
       }
-    }
-  }
+    // NOTE: unused runtime array has size of 1
+    isRuntime = isArray && (isRuntime || inner<=1);
 
-void ShaderReflection::getBindings(std::vector<Binding>& lay, spirv_cross::Compiler& comp, const uint32_t* source, const size_t size) {
-  const Stage s = getExecutionModel(comp);
-
-  spirv_cross::ShaderResources resources = comp.get_shader_resources();
-  for(auto &resource : resources.sampled_images) {
-    auto&    t       = typeFromVariable(comp, resource.id);
-    unsigned binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-    Binding b;
-    b.layout       = binding;
-    b.cls          = Texture;
-    b.stage        = s;
-    b.spvId        = resource.id;
-    b.runtimeSized = isRuntimeSized(t);
-    b.arraySize    = arraySize(t);
-    b.is3DImage    = is3dImage(t);
-    lay.push_back(b);
-    }
-  for(auto &resource : resources.separate_images) {
-    auto&    t       = typeFromVariable(comp, resource.id);
-    unsigned binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-    Binding b;
-    b.layout       = binding;
-    b.cls          = Image;
-    b.stage        = s;
-    b.spvId        = resource.id;
-    b.runtimeSized = isRuntimeSized(t);
-    b.arraySize    = arraySize(t);
-    b.is3DImage    = is3dImage(t);
-    lay.push_back(b);
-    }
-  for(auto &resource : resources.separate_samplers) {
-    auto&    t       = typeFromVariable(comp, resource.id);
-    unsigned binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-    Binding b;
-    b.layout       = binding;
-    b.cls          = Sampler;
-    b.stage        = s;
-    b.spvId        = resource.id;
-    b.runtimeSized = isRuntimeSized(t);
-    b.arraySize    = arraySize(t);
-    lay.push_back(b);
-    }
-  for(auto &resource : resources.uniform_buffers) {
-    auto&    t       = typeFromVariable(comp, resource.id);
-    unsigned binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-    auto     sz      = declaredSize(comp,t);
-    Binding b;
-    b.layout       = binding;
-    b.cls          = Ubo;
-    b.stage        = s;
-    b.runtimeSized = isRuntimeSized(t);
-    b.arraySize    = arraySize(t);
-    b.byteSize     = sz;
-    b.spvId        = resource.id;
-    lay.push_back(b);
-    }
-  for(auto &resource : resources.storage_buffers) {
-    auto&    t        = typeFromVariable(comp, resource.id);
-    unsigned binding  = comp.get_decoration(resource.id, spv::DecorationBinding);
-    auto     readonly = comp.get_buffer_block_flags(resource.id);
-    auto     sz       = declaredSize(comp,t);
-    Binding b;
-    b.layout       = binding;
-    b.cls          = (readonly.get(spv::DecorationNonWritable) ? SsboR : SsboRW);
-    b.stage        = s;
-    b.runtimeSized = isRuntimeSized(t);
-    b.arraySize    = arraySize(t);
-    b.byteSize     = sz;
-    b.varByteSize  = declaredVarSize(comp, t);
-    b.spvId        = resource.id;
-    lay.push_back(b);
-    }
-  for(auto &resource : resources.storage_images) {
-    auto&    t        = typeFromVariable(comp, resource.id);
-    unsigned binding  = comp.get_decoration(resource.id, spv::DecorationBinding);
-    unsigned readonly = comp.get_decoration(resource.id, spv::DecorationNonWritable);
+    if(mod.isBuiltIn(id, elt))
+      continue;
 
-    Binding b;
-    b.layout       = binding;
-    b.cls          = readonly ? ImgR : ImgRW;
-    b.stage        = s;
-    b.runtimeSized = isRuntimeSized(t);
-    b.arraySize    = arraySize(t);
-    b.spvId        = resource.id;
-    b.is3DImage    = is3dImage(t);
-    lay.push_back(b);
-    }
-  for(auto &resource : resources.acceleration_structures) {
-    auto&    t       = typeFromVariable(comp, resource.id);
-    unsigned binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-    Binding b;
-    b.layout       = binding;
-    b.cls          = Tlas;
-    b.stage        = s;
-    b.runtimeSized = isRuntimeSized(t);
-    b.arraySize    = arraySize(t);
-    b.spvId        = resource.id;
-    lay.push_back(b);
-    }
-  for(auto &resource : resources.push_constant_buffers) {
-    auto&    t       = typeFromVariable(comp, resource.id);
-    unsigned binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-    auto     sz      = declaredSize(comp,t);
+    if(cls==spv::StorageClassInput) {
+      if(ret.stage!=Stage::Vertex)
+        continue;
+      auto& decl = ret.vertexDecl;
+      auto  loc  = mod.meta[id].location;
+      decl.resize(std::max<size_t>(loc+1,decl.size()));
+      decl[loc] = vertexInput(mod, elt);
+      continue;
+      }
 
+    auto&  t     = mod.op(elt);
+    auto&  meta  = mod.meta[elt];
     Binding b;
-    b.layout   = binding;
-    b.cls      = Push;
-    b.stage    = s;
-    b.byteSize = sz;
-    b.spvId    = resource.id;
+    b.layout       = mod.meta[id].binding;
+    b.stage        = ret.stage;
+    b.spvId        = id;
+    b.runtimeSized = isRuntime;
+    b.arraySize    = isRuntime ? 0 : count;
+
+    if(cls==spv::StorageClassUniform && (meta.flags & M_Block)) {
+      b.cls          = Ubo;
+      b.byteSize     = mod.structSize(elt, true);
+      }
+    else if((cls==spv::StorageClassUniform && (meta.flags & M_BufferBlock)) || cls==spv::StorageClassStorageBuffer) {
+      b.cls          = mod.isReadOnly(id, elt) ? SsboR : SsboRW;
+      b.byteSize     = mod.structSize(elt, true);
+      b.varByteSize  = mod.varSize(elt);
+      }
+    else if(cls==spv::StorageClassPushConstant) {
+      b.cls          = Push;
+      b.byteSize     = mod.structSize(elt, true);
+      b.runtimeSized = false;
+      b.arraySize    = 0;
+      }
+    else if(cls==spv::StorageClassUniformConstant && t.op()==spv::OpTypeImage && t[7]==2) {
+      b.cls          = (mod.meta[id].flags & M_NonWritable) ? ImgR : ImgRW;
+      b.is3DImage    = mod.is3dImage(elt);
+      }
+    else if(cls==spv::StorageClassUniformConstant && t.op()==spv::OpTypeImage && t[7]==1) {
+      b.cls          = Image;
+      b.is3DImage    = mod.is3dImage(elt);
+      }
+    else if(cls==spv::StorageClassUniformConstant && t.op()==spv::OpTypeSampler) {
+      b.cls          = Sampler;
+      }
+    else if(cls==spv::StorageClassUniformConstant && t.op()==spv::OpTypeSampledImage) {
+      b.cls          = Texture;
+      b.is3DImage    = mod.is3dImage(elt);
+      }
+    else if(cls==spv::StorageClassUniformConstant && t.op()==spv::OpTypeAccelerationStructureKHR) {
+      b.cls          = Tlas;
+      }
+    else {
+      continue;
+      }
     lay.push_back(b);
     }
 
   if(lay.size()==0)
     return;
 
-  const bool arrayWa = hasRuntimeArrays(lay) && !canHaveRuntimeArrays(comp, source, size);
+  const bool arrayWa = hasRuntimeArrays(lay) && !mod.nonUniform;
   if(arrayWa) {
     // WA for GLSL bug: https://github.com/KhronosGroup/GLSL/issues/231
     for(auto& i:lay) {
@@ -266,24 +562,6 @@ void ShaderReflection::getBindings(std::vector<Binding>& lay, spirv_cross::Compi
     }
   }
 
-bool ShaderReflection::canHaveRuntimeArrays(spirv_cross::Compiler& comp, const uint32_t* source, const size_t size) {
-  auto& ext = comp.get_declared_extensions();
-  for(auto& i:ext)
-    if(i=="SPV_EXT_descriptor_indexing")
-      return true;
-
-  libspirv::Bytecode code(source, size);
-  for(auto& i:code) {
-    if(i.op()==spv::OpSourceExtension) {
-      std::string_view str = reinterpret_cast<const char*>(&i[1]);
-      if(str=="GL_EXT_nonuniform_qualifier") {
-        return true;
-        }
-      }
-    }
-  return false;
-  }
-
 bool ShaderReflection::hasRuntimeArrays(const std::vector<Binding>& lay) {
   for(auto& i:lay) {
     if(i.runtimeSized || i.arraySize>1)
@@ -292,10 +570,6 @@ bool ShaderReflection::hasRuntimeArrays(const std::vector<Binding>& lay) {
   return false;
   }
 
-ShaderReflection::Stage ShaderReflection::getExecutionModel(spirv_cross::Compiler& comp) {
-  return getExecutionModel(comp.get_execution_model());
-  }
-
 ShaderReflection::Stage ShaderReflection::getExecutionModel(libspirv::Bytecode& comp) {
   auto c = comp.findExecutionModel();
   return getExecutionModel(c);
@@ -390,8 +664,7 @@ void ShaderReflection::finalize(std::vector<Binding>& ret) {
       }
   }
 
-size_t ShaderReflection::mslSizeOf(const spirv_cross::ID& spvId,
-                                   spirv_cross::Compiler& comp) {
+size_t ShaderReflection::mslSizeOf(uint32_t spvId, spirv_cross::Compiler& comp) {
   auto& t = comp.get_type_from_variable(spvId);
   return mslSizeOf(t,comp);
   }
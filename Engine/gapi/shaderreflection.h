@@ -1,14 +1,20 @@
 #pragma once
 
 #include <Tempest/AbstractGraphicsApi>
+#include <string>
 #include <vector>
 
-#include "thirdparty/spirv_cross/spirv_cross.hpp"
+#include "thirdparty/spirv_cross/spirv.hpp"
 
 namespace libspirv {
 class Bytecode;
 };
 
+namespace spirv_cross {
+class  Compiler;
+struct SPIRType;
+};
+
 namespace Tempest {
 namespace Detail {
 
@@ -53,7 +59,7 @@ class ShaderReflection final {
       bool            hasSampler() const { return cls==Texture || cls==Sampler; }
       bool            isArray()    const { return runtimeSized || arraySize>1;  } //NOTE: array with sizeof 1 is not an array
 
-      spirv_cross::ID spvId;
+      uint32_t        spvId       = 0;
       uint32_t        mslBinding  = uint32_t(-1);
       uint32_t        mslBinding2 = uint32_t(-1);
       uint32_t        mslSize     = 0;
@@ -88,12 +94,24 @@ class ShaderReflection final {
       uint32_t size  = 0;
       };
 
-    static void   getVertexDecl(std::vector<Decl::ComponentType>& data, spirv_cross::Compiler& comp);
-    static void   getBindings(std::vector<Binding>& b, spirv_cross::Compiler& comp, const uint32_t* source, const size_t size);
-    static Stage  getExecutionModel(spirv_cross::Compiler& comp);
+    static constexpr uint32_t NoSpecId = uint32_t(-1);
+
+    struct ModuleInfo {
+      Stage                            stage = None;
+      std::vector<Binding>             lay;
+      std::vector<Decl::ComponentType> vertexDecl;
+      IVec3                            wgSize;
+      uint32_t                         wgSizeSpecId[3]  = {NoSpecId, NoSpecId, NoSpecId};
+      bool                             hasBaseVertex    = false; // gl_BaseVertex or gl_InstanceIndex
+      bool                             hasNumWorkgroups = false;
+      std::string                      source;
+      };
+
+    //! single pass over the module: spirv_cross is only needed for MSL/HLSL code-gen
+    static void   reflect(ModuleInfo& ret, const uint32_t* source, const size_t size);
     static Stage  getExecutionModel(libspirv::Bytecode& comp);
     static Stage  getExecutionModel(spv::ExecutionModel m);
-    static size_t mslSizeOf(const spirv_cross::ID& spvId, spirv_cross::Compiler& comp);
+    static size_t mslSizeOf(uint32_t spvId, spirv_cross::Compiler& comp);
 
     static void   merge(std::vector<Binding>& ret,
                         PushBlock& pb,
@@ -108,7 +126,6 @@ class ShaderReflection final {
     static void finalize(std::vector<Binding>& p);
     static size_t mslSizeOf(const spirv_cross::SPIRType& type, spirv_cross::Compiler& comp);
     static bool hasRuntimeArrays(const std::vector<Binding>& lay);
-    static bool canHaveRuntimeArrays(spirv_cross::Compiler& comp, const uint32_t* source, const size_t size);
   };
 
 }
@@ -0,0 +1,270 @@
+#define SPV_ENABLE_UTILITY_CODE
+#include "shaderoptimizer.h"
+
+#include <algorithm>
+#include <string_view>
+
+ShaderOptimizer::ShaderOptimizer(libspirv::MutableBytecode& code):code(code) {
+  }
+
+void ShaderOptimizer::exec() {
+  stripDebugInfo();
+  removeDeadFunctions();
+  removeUnusedGlobals();
+  code.removeNops();
+  }
+
+void ShaderOptimizer::stripDebugInfo() {
+  std::vector<uint32_t> dbgSet;
+  bool                  keepStrings = false;
+
+  for(auto it = code.begin(), end = code.end(); it!=end; ++it) {
+    auto& i = *it;
+    if(i.op()!=spv::OpExtInstImport)
+      continue;
+    std::string_view name = reinterpret_cast<const char*>(&i[2]);
+    if(name.find("NonSemantic.Shader.DebugInfo")==0) {
+      dbgSet.push_back(i[1]);
+      it.setToNop();
+      }
+    else if(name.find("NonSemantic.")==0) {
+      // debugPrintf: format string is OpString
+      keepStrings = true;
+      }
+    }
+
+  for(auto it = code.begin(), end = code.end(); it!=end; ++it) {
+    auto& i = *it;
+    if(i.op()==spv::OpString && keepStrings)
+      continue;
+    if(isDebugOp(i.op())) {
+      it.setToNop();
+      continue;
+      }
+    if(i.op()==spv::OpExtInst && std::find(dbgSet.begin(), dbgSet.end(), i[3])!=dbgSet.end())
+      it.setToNop();
+    }
+  }
+
+void ShaderOptimizer::removeDeadFunctions() {
+  struct Func {
+    uint32_t              id = 0;
+    std::vector<uint32_t> calls;
+    };
+  std::vector<Func>     func;
+  std::vector<uint32_t> entry;
+
+  for(auto& i:code) {
+    if(i.op()==spv::OpEntryPoint)
+      entry.push_back(i[2]);
+    else if(i.op()==spv::OpFunction)
+      func.push_back({i[2], {}});
+    else if(i.op()==spv::OpFunctionCall && !func.empty())
+      func.back().calls.push_back(i[3]);
+    }
+
+  const uint32_t       bound = code.bound();
+  std::vector<uint8_t> live(bound, 0);
+  while(!entry.empty()) {
+    const uint32_t id = entry.back();
+    entry.pop_back();
+    if(id>=bound || live[id])
+      continue;
+    live[id] = 1;
+    for(auto& f:func)
+      if(f.id==id)
+        entry.insert(entry.end(), f.calls.begin(), f.calls.end());
+    }
+
+  std::vector<uint8_t> dead(bound, 0);
+  bool                 inDead = false;
+  bool                 any    = false;
+  for(auto it = code.findSection(libspirv::Bytecode::S_FuncDefinitions), end = code.end(); it!=end; ++it) {
+    auto&         i  = *it;
+    const spv::Op op = i.op();
+    if(op==spv::OpFunction)
+      inDead = !live[i[2]];
+    if(!inDead)
+      continue;
+
+    uint32_t id = 0;
+    if(resultId(i, id) && id<bound)
+      dead[id] = 1;
+    it.setToNop();
+    any = true;
+    if(op==spv::OpFunctionEnd)
+      inDead = false;
+    }
+
+  if(any)
+    removeDecorations(dead);
+  }
+
+void ShaderOptimizer::removeUnusedGlobals() {
+  for(auto& i:code) {
+    // decoration groups are not tracked
+    if(i.op()==spv::OpDecorationGroup)
+      return;
+    }
+
+  const uint32_t       bound = code.bound();
+  std::vector<uint8_t> live(bound, 0);
+  auto markOperands = [&](const libspirv::Bytecode::OpCode& i, uint16_t from) {
+    // literals are treated as ids as well: conservative, but no per-opcode operand tables are needed
+    for(uint16_t r=from; r<i.length(); ++r)
+      if(i[r]<bound)
+        live[i[r]] = 1;
+    };
+
+  const auto types = code.findSection(libspirv::Bytecode::S_Types);
+  const auto fn    = code.findSection(libspirv::Bytecode::S_FuncDefinitions);
+  for(auto it = code.begin(); it!=types; ++it) {
+    auto& i = *it;
+    switch(i.op()) {
+      case spv::OpEntryPoint:
+        live[i[2]] = 1;
+        break;
+      case spv::OpExecutionMode:
+      case spv::OpExecutionModeId:
+        markOperands(i, 1);
+        break;
+      case spv::OpDecorate:
+        // builtins are consumed by driver, not by code: gl_WorkGroupSize may define local size
+        if(i[2]==spv::DecorationBuiltIn)
+          live[i[1]] = 1;
+        break;
+      case spv::OpDecorateId:
+        markOperands(i, 3);
+        break;
+      default:
+        break;
+      }
+    }
+  for(auto it = fn, end = code.end(); it!=end; ++it)
+    markOperands(*it, 1);
+
+  std::vector<size_t> decl;
+  for(auto it = types; it!=fn; ++it) {
+    auto& i = *it;
+    if(i.op()==spv::OpTypeForwardPointer)
+      live[i[1]] = 1;
+    if(i.op()==spv::OpVariable && !isRemovable(spv::StorageClass(i[3])))
+      live[i[2]] = 1;
+    if(isSpecConstant(i.op()))
+      live[i[2]] = 1;
+    decl.push_back(it.toOffset());
+    }
+
+  // declarations may only reference preceding ones (forward pointers are pinned above)
+  std::vector<uint8_t> dead(bound, 0);
+  for(size_t r=decl.size(); r>0;) {
+    --r;
+    auto     it = code.fromOffset(decl[r]);
+    auto&    i  = *it;
+    uint32_t id = 0;
+    if(!resultId(i, id) || id>=bound || live[id]) {
+      markOperands(i, 1);
+      continue;
+      }
+    dead[id] = 1;
+    it.setToNop();
+    }
+
+  removeDecorations(dead);
+  }
+
+void ShaderOptimizer::removeDecorations(const std::vector<uint8_t>& dead) {
+  const auto types = code.findSection(libspirv::Bytecode::S_Types);
+  for(auto it = code.begin(); it!=types; ++it) {
+    auto& i = *it;
+    switch(i.op()) {
+      case spv::OpName:
+      case spv::OpMemberName:
+      case spv::OpDecorate:
+      case spv::OpMemberDecorate:
+      case spv::OpDecorateId:
+      case spv::OpDecorateString:
+      case spv::OpMemberDecorateString:
+        if(i[1]<dead.size() && dead[i[1]])
+          it.setToNop();
+        break;
+      case spv::OpEntryPoint: {
+        const size_t name = std::string_view(reinterpret_cast<const char*>(&i[3])).size()/4 + 1;
+        uint16_t     len  = uint16_t(3 + name);
+        const auto   prev = i.length();
+        for(uint16_t r=len; r<prev; ++r) {
+          const uint32_t id = i[r];
+          if(id<dead.size() && dead[id])
+            continue;
+          it.set(len, id);
+          ++len;
+          }
+        for(uint16_t r=len; r<prev; ++r)
+          it.set(r, libspirv::Bytecode::OpCode{uint16_t(spv::OpNop), 1});
+        it.set(0, libspirv::Bytecode::OpCode{uint16_t(spv::OpEntryPoint), len});
+        break;
+        }
+      default:
+        break;
+      }
+    }
+  }
+
+bool ShaderOptimizer::isDebugOp(spv::Op op) {
+  switch(op) {
+    case spv::OpSourceContinued:
+    case spv::OpSource:
+    case spv::OpSourceExtension:
+    case spv::OpName:
+    case spv::OpMemberName:
+    case spv::OpString:
+    case spv::OpLine:
+    case spv::OpNoLine:
+    case spv::OpModuleProcessed:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+bool ShaderOptimizer::isSpecConstant(spv::Op op) {
+  // part of pipeline interface: specialization info may reference them by SpecId
+  switch(op) {
+    case spv::OpSpecConstantTrue:
+    case spv::OpSpecConstantFalse:
+    case spv::OpSpecConstant:
+    case spv::OpSpecConstantComposite:
+    case spv::OpSpecConstantOp:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+bool ShaderOptimizer::isRemovable(spv::StorageClass cls) {
+  // outputs are matched against next stage; payloads and ray-tracing classes are shared between shaders
+  switch(cls) {
+    case spv::StorageClassUniformConstant:
+    case spv::StorageClassInput:
+    case spv::StorageClassUniform:
+    case spv::StorageClassWorkgroup:
+    case spv::StorageClassPrivate:
+    case spv::StorageClassPushConstant:
+    case spv::StorageClassStorageBuffer:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+bool ShaderOptimizer::resultId(const libspirv::Bytecode::OpCode& op, uint32_t& id) {
+  bool hasResult = false, hasType = false;
+  spv::HasResultAndType(op.op(), &hasResult, &hasType);
+  if(!hasResult)
+    return false;
+  const uint16_t at = hasType ? 2 : 1;
+  if(op.length()<=at)
+    return false;
+  id = op[at];
+  return true;
+  }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "libspirv/libspirv.h"
+
+/**
+ * Load-time cleanup of SPIR-V, before it's passed to driver.
+ *
+ * Removes debug instructions, functions unreachable from entry points and global declarations
+ * (variables, types, constants), not referenced by live code. Builtin-decorated ids, specialization
+ * constants and execution-mode operands are kept as roots. Reflection is expected to run on
+ * original bytecode: unused descriptors and vertex inputs stay in pipeline layout.
+ */
+class ShaderOptimizer {
+  public:
+    explicit ShaderOptimizer(libspirv::MutableBytecode& code);
+
+    void exec();
+
+    void stripDebugInfo();
+    void removeDeadFunctions();
+    void removeUnusedGlobals();
+
+  private:
+    void removeDecorations(const std::vector<uint8_t>& dead);
+
+    static bool isDebugOp(spv::Op op);
+    static bool isSpecConstant(spv::Op op);
+    static bool isRemovable(spv::StorageClass cls);
+    static bool resultId(const libspirv::Bytecode::OpCode& op, uint32_t& id);
+
+    libspirv::MutableBytecode& code;
+  };
@@ -81,9 +81,10 @@ class UploadEngine final {
       }
 
     using Commands = TransferCmd<CommandBuffer>;
+    using Fence    = typename Commands::Fence;
 
     std::unique_ptr<Commands> get();
-    void                      submit(std::unique_ptr<Commands>&& cmd);
+    Fence                     submit(std::unique_ptr<Commands>&& cmd);
     void                      submitAndWait(std::unique_ptr<Commands>&& cmd);
 
     Buffer                    allocStagingMemory(const void* data, size_t count, size_t size, size_t alignedSz, MemUsage usage, BufferHeap heap);
@@ -132,12 +133,14 @@ void UploadEngine<Device,CommandBuffer,Buffer>::wait() {
   }
 
 template<class Device, class CommandBuffer, class Buffer>
-void UploadEngine<Device,CommandBuffer,Buffer>::submit(std::unique_ptr<Commands>&& cmd) {
+auto UploadEngine<Device,CommandBuffer,Buffer>::submit(std::unique_ptr<Commands>&& cmd) -> Fence {
   cmd->fence = device.submit(*cmd);
+  Fence ret  = cmd->fence;
 
   std::lock_guard<SpinLock> guard(sync);
   this->cmd.push_back(std::move(cmd));
   hasWaits = true;
+  return ret;
   }
 
 template<class Device, class CommandBuffer, class Buffer>
@@ -4,17 +4,18 @@
 
 #include "vdevice.h"
 #include "vbuffer.h"
+#include "vblasbatch.h"
 
 using namespace Tempest;
 using namespace Tempest::Detail;
 
 void VBlasBuildCtx::pushGeometry(VDevice& dx,
-                                 const VBuffer& vbo, size_t vboSz, size_t stride,
+                                 const VBuffer& vbo, size_t vboSz, size_t stride, size_t voffset,
                                  const VBuffer& ibo, size_t iboSz, size_t ioffset, IndexClass icls) {
   VkAccelerationStructureBuildRangeInfoKHR range = {};
   range.primitiveCount  = uint32_t(iboSz/3);
   range.primitiveOffset = uint32_t(ioffset*sizeofIndex(icls));
-  range.firstVertex     = 0;
+  range.firstVertex     = uint32_t(voffset);
   range.transformOffset = 0;
 
   VkAccelerationStructureGeometryKHR geometry = {};
@@ -24,7 +25,7 @@ void VBlasBuildCtx::pushGeometry(VDevice& dx,
   geometry.geometry.triangles.sType           = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
   geometry.geometry.triangles.vertexFormat    = VK_FORMAT_R32G32B32_SFLOAT;
   geometry.geometry.triangles.vertexStride    = stride;
-  geometry.geometry.triangles.maxVertex       = uint32_t(vboSz);
+  geometry.geometry.triangles.maxVertex       = uint32_t(voffset+vboSz);
   geometry.geometry.triangles.indexType       = nativeFormat(icls);
   geometry.geometry.triangles.transformData   = VkDeviceOrHostAddressConstKHR{};
   geometry.flags                              = VK_GEOMETRY_OPAQUE_BIT_KHR;
@@ -66,36 +67,50 @@ VkAccelerationStructureBuildGeometryInfoKHR VBlasBuildCtx::buildCmd(VDevice& dx,
   buildGeometryInfo.geometryCount             = uint32_t(geometry.size());
   buildGeometryInfo.pGeometries               = geometry.data();
   buildGeometryInfo.ppGeometries              = nullptr;
-  buildGeometryInfo.scratchData.deviceAddress = scratch!=nullptr ? reinterpret_cast<const VBuffer&>(*scratch).toDeviceAddress(dx) : VkDeviceAddress{};
+  buildGeometryInfo.scratchData.deviceAddress = scratch!=nullptr ? reinterpret_cast<const VBuffer&>(*scratch).toDeviceAddress(dx) + scratchOffset : VkDeviceAddress{};
+  if(compact)
+    buildGeometryInfo.flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
   return buildGeometryInfo;
   }
 
 
-VAccelerationStructure::VAccelerationStructure(VDevice& dx, const AbstractGraphicsApi::RtGeometry* geom, size_t size)
+VAccelerationStructure::VAccelerationStructure(VDevice& dx)
   :owner(dx) {
-  auto device                        = dx.device.impl;
-  auto vkCreateAccelerationStructure = dx.vkCreateAccelerationStructure;
+  }
 
+VAccelerationStructure::VAccelerationStructure(VDevice& dx, const AbstractGraphicsApi::RtGeometry* geom, size_t size, BlasFlags flags)
+  :owner(dx) {
   VBlasBuildCtx ctx;
+  ctx.compact = (flags & BlasFlags::Compact)!=BlasFlags::None;
   for(size_t i=0; i<size; ++i) {
     auto& vbo     = *reinterpret_cast<const VBuffer*>(geom[i].vbo);
     auto  vboSz   = geom[i].vboSz;
     auto  stride  = geom[i].stride;
+    auto  voffset = geom[i].voffset;
     auto& ibo     = *reinterpret_cast<const VBuffer*>(geom[i].ibo);
     auto  iboSz   = geom[i].iboSz;
     auto  ioffset = geom[i].ioffset;
     auto  icls    = geom[i].icls;
-    ctx.pushGeometry(dx, vbo, vboSz, stride, ibo, iboSz, ioffset, icls);
+    ctx.pushGeometry(dx, vbo, vboSz, stride, voffset, ibo, iboSz, ioffset, icls);
     }
 
   const auto buildSizesInfo = ctx.buildSizes(dx);
   if(buildSizesInfo.accelerationStructureSize<=0)
     throw std::system_error(GraphicsErrc::UnsupportedExtension);
 
-  data = dx.allocator.alloc(nullptr, buildSizesInfo.accelerationStructureSize, MemUsage::AsStorage, BufferHeap::Device);
-  auto scratch = dx.dataMgr().allocStagingMemory(nullptr, buildSizesInfo.buildScratchSize, MemUsage::ScratchBuffer, BufferHeap::Device);
+  alloc(buildSizesInfo.accelerationStructureSize);
+  // actual build is deferred, see VBlasBatch
+  dx.blasBatch->push(*this, std::move(ctx), buildSizesInfo.buildScratchSize, geom, size);
+  }
+
+VAccelerationStructure::~VAccelerationStructure() {
+  auto device = owner.device.impl;
+  if(impl!=VK_NULL_HANDLE)
+    owner.vkDestroyAccelerationStructure(device,impl,nullptr);
+  }
 
-  DSharedPtr<AbstractGraphicsApi::Buffer*> pScratch(new VBuffer(std::move(scratch)));
+void VAccelerationStructure::alloc(VkDeviceSize size) {
+  data = owner.allocator.alloc(nullptr, size, MemUsage::AsStorage, BufferHeap::Device);
 
   VkAccelerationStructureCreateInfoKHR createInfo = {};
   createInfo.sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
@@ -103,33 +118,10 @@ VAccelerationStructure::VAccelerationStructure(VDevice& dx, const AbstractGraphi
   createInfo.createFlags   = 0;
   createInfo.buffer        = data.impl;
   createInfo.offset        = 0;
-  createInfo.size          = buildSizesInfo.accelerationStructureSize;
+  createInfo.size          = size;
   createInfo.type          = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
   createInfo.deviceAddress = VK_NULL_HANDLE;
-  vkCreateAccelerationStructure(device, &createInfo, nullptr, &impl);
-
-  DSharedPtr<AbstractGraphicsApi::AccelerationStructure*> pThis(this);
-
-  auto& mgr = dx.dataMgr();
-  auto  cmd = mgr.get();
-  cmd->begin(SyncHint::NoPendingReads);
-  for(size_t i=0; i<size; ++i) {
-    DSharedPtr<const AbstractGraphicsApi::Buffer*> vbo(geom[i].vbo);
-    DSharedPtr<const AbstractGraphicsApi::Buffer*> ibo(geom[i].ibo);
-    cmd->hold(vbo);
-    cmd->hold(ibo);
-    }
-  cmd->hold(pScratch);
-  cmd->hold(pThis);
-  cmd->buildBlas(impl,data,ctx,*pScratch.handler);
-  cmd->end();
-
-  mgr.submit(std::move(cmd));
-  }
-
-VAccelerationStructure::~VAccelerationStructure() {
-  auto device = owner.device.impl;
-  owner.vkDestroyAccelerationStructure(device,impl,nullptr);
+  owner.vkCreateAccelerationStructure(owner.device.impl, &createInfo, nullptr, &impl);
   }
 
 VkDeviceAddress VAccelerationStructure::toDeviceAddress(VDevice& dx) const {
@@ -145,6 +137,10 @@ VkDeviceAddress VAccelerationStructure::toDeviceAddress(VDevice& dx) const {
 
 VTopAccelerationStructure::VTopAccelerationStructure(VDevice& dx, const RtInstance* inst, AccelerationStructure*const* as, size_t asSize)
   :owner(dx) {
+  // blas addresses are final only after build (and compaction)
+  if(dx.blasBatch!=nullptr)
+    dx.blasBatch->flush(as, asSize);
+
   auto device                               = dx.device.impl;
   auto vkGetAccelerationStructureBuildSizes = dx.vkGetAccelerationStructureBuildSizes;
   auto vkCreateAccelerationStructure        = dx.vkCreateAccelerationStructure;
@@ -188,30 +184,20 @@ VTopAccelerationStructure::VTopAccelerationStructure(VDevice& dx, const RtInstan
 
   data = dx.allocator.alloc(nullptr, buildSizesInfo.accelerationStructureSize, MemUsage::AsStorage, BufferHeap::Device);
 
-  Detail::DSharedPtr<AbstractGraphicsApi::Buffer*> pBuf;
   if(asSize>0) {
     VBuffer buf = dx.allocator.alloc(nullptr, asSize*sizeof(VkAccelerationStructureInstanceKHR), MemUsage::StorageBuffer | MemUsage::Transfer, BufferHeap::Upload);
-    pBuf = Detail::DSharedPtr<AbstractGraphicsApi::Buffer*>(new Detail::VBuffer(std::move(buf)));
+    instances = Detail::DSharedPtr<AbstractGraphicsApi::Buffer*>(new Detail::VBuffer(std::move(buf)));
     }
 
   for(size_t i=0; i<asSize; ++i) {
-    auto blas = reinterpret_cast<VAccelerationStructure*>(as[i]);
-
-    VkAccelerationStructureInstanceKHR objInstance = {};
-    for(int x=0; x<3; ++x)
-      for(int y=0; y<4; ++y)
-        objInstance.transform.matrix[x][y] = inst[i].mat.at(y,x);
-    objInstance.instanceCustomIndex                    = inst[i].id;
-    objInstance.mask                                   = inst[i].mask;
-    objInstance.instanceShaderBindingTableRecordOffset = 0;
-    objInstance.flags                                  = nativeFormat(inst[i].flags);
-    objInstance.accelerationStructureReference         = blas->toDeviceAddress(dx);
-
-    pBuf.handler->update(&objInstance, i*sizeof(objInstance), sizeof(objInstance));
+    auto objInstance = toVkInstance(dx, inst[i], as[i]);
+    instances.handler->update(&objInstance, i*sizeof(objInstance), sizeof(objInstance));
     }
 
-  auto  scratch = dx.dataMgr().allocStagingMemory(nullptr, buildSizesInfo.buildScratchSize, MemUsage::ScratchBuffer, BufferHeap::Device);
-  DSharedPtr<AbstractGraphicsApi::Buffer*> pScratch(new VBuffer(std::move(scratch)));
+  // scratch is kept for Encoder::updateTlas
+  const VkDeviceSize scratchSize = std::max(buildSizesInfo.buildScratchSize, buildSizesInfo.updateScratchSize);
+  auto  pScratch = dx.dataMgr().allocStagingMemory(nullptr, scratchSize, MemUsage::ScratchBuffer, BufferHeap::Device);
+  scratch = DSharedPtr<AbstractGraphicsApi::Buffer*>(new VBuffer(std::move(pScratch)));
 
   VkAccelerationStructureCreateInfoKHR createInfo = {};
   createInfo.sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR,
@@ -228,12 +214,14 @@ VTopAccelerationStructure::VTopAccelerationStructure(VDevice& dx, const RtInstan
 
   auto cmd = dx.dataMgr().get();
   cmd->begin(SyncHint::NoPendingReads);
-  cmd->hold(pScratch);
-  cmd->hold(pBuf);
   cmd->hold(pThis);
-  cmd->buildTlas(impl,data,*pBuf.handler,uint32_t(asSize),*pScratch.handler);
+  cmd->buildTlas(impl,data,instances.handler,uint32_t(asSize),*scratch.handler,false);
   cmd->end();
 
+  capacity = uint32_t(asSize);
+  if(asSize>0)
+    padding = DSharedPtr<AbstractGraphicsApi::AccelerationStructure*>(as[0]);
+
   dx.dataMgr().submit(std::move(cmd));
   }
 
@@ -243,4 +231,19 @@ VTopAccelerationStructure::~VTopAccelerationStructure() {
   owner.descPool.notifyDestroy(this);
   }
 
+VkAccelerationStructureInstanceKHR VTopAccelerationStructure::toVkInstance(VDevice& dx, const RtInstance& inst, const AccelerationStructure* as) {
+  auto blas = reinterpret_cast<const VAccelerationStructure*>(as);
+
+  VkAccelerationStructureInstanceKHR objInstance = {};
+  for(int x=0; x<3; ++x)
+    for(int y=0; y<4; ++y)
+      objInstance.transform.matrix[x][y] = inst.mat.at(y,x);
+  objInstance.instanceCustomIndex                    = inst.id;
+  objInstance.mask                                   = inst.mask;
+  objInstance.instanceShaderBindingTableRecordOffset = 0;
+  objInstance.flags                                  = nativeFormat(inst.flags);
+  objInstance.accelerationStructureReference         = blas->toDeviceAddress(dx);
+  return objInstance;
+  }
+
 #endif
@@ -13,7 +13,7 @@ class VBuffer;
 
 struct VBlasBuildCtx : AbstractGraphicsApi::BlasBuildCtx {
   void pushGeometry(VDevice& dx,
-                    const VBuffer& vbo, size_t vboSz, size_t stride,
+                    const VBuffer& vbo, size_t vboSz, size_t stride, size_t voffset,
                     const VBuffer& ibo, size_t iboSz, size_t ioffset, IndexClass icls);
 
   VkAccelerationStructureBuildSizesInfoKHR    buildSizes(VDevice& dx) const;
@@ -22,13 +22,17 @@ struct VBlasBuildCtx : AbstractGraphicsApi::BlasBuildCtx {
   std::vector<VkAccelerationStructureBuildRangeInfoKHR> ranges;
   std::vector<VkAccelerationStructureGeometryKHR>       geometry;
   std::vector<uint32_t>                                 maxPrimitiveCounts;
+  VkDeviceSize                                          scratchOffset = 0;
+  bool                                                  compact       = false;
   };
 
 class VAccelerationStructure : public AbstractGraphicsApi::AccelerationStructure {
   public:
-    VAccelerationStructure(VDevice& owner, const AbstractGraphicsApi::RtGeometry* geom, size_t size);
+    VAccelerationStructure(VDevice& owner);
+    VAccelerationStructure(VDevice& owner, const AbstractGraphicsApi::RtGeometry* geom, size_t size, BlasFlags flags);
     ~VAccelerationStructure();
 
+    void                       alloc(VkDeviceSize size);
     VkDeviceAddress            toDeviceAddress(VDevice& owner) const;
 
     VDevice&                   owner;
@@ -41,9 +45,18 @@ class VTopAccelerationStructure : public AbstractGraphicsApi::AccelerationStruct
     VTopAccelerationStructure(VDevice& owner, const RtInstance* inst, AccelerationStructure* const * as, size_t size);
     ~VTopAccelerationStructure();
 
+    static VkAccelerationStructureInstanceKHR toVkInstance(VDevice& dx, const RtInstance& inst, const AccelerationStructure* blas);
+
     VDevice&                   owner;
     VkAccelerationStructureKHR impl = VK_NULL_HANDLE;
     VBuffer                    data;
+
+    // kept alive for in-place update
+    DSharedPtr<AbstractGraphicsApi::Buffer*> instances;
+    DSharedPtr<AbstractGraphicsApi::Buffer*> scratch;
+    // referenced by disabled instances: every build has exactly `capacity` primitives
+    DSharedPtr<AbstractGraphicsApi::AccelerationStructure*> padding;
+    uint32_t                   capacity      = 0;
   };
 
 }
@@ -37,21 +37,22 @@ VDevice* VAllocator::device() {
   }
 
 VAllocator::Provider::~Provider() {
-  if(lastFree!=VK_NULL_HANDLE)
-    vkFreeMemory(device->device.impl,lastFree,nullptr);
+  if(lastFree.impl!=VK_NULL_HANDLE)
+    vkFreeMemory(device->device.impl,lastFree.impl,nullptr);
   }
 
 VAllocator::Provider::DeviceMemory VAllocator::Provider::alloc(size_t size, uint32_t typeId) {
-  if(lastFree!=VK_NULL_HANDLE){
+  if(lastFree.impl!=VK_NULL_HANDLE){
     if(lastType==typeId && lastSize==size){
-      VkDeviceMemory memory=lastFree;
-      lastFree=VK_NULL_HANDLE;
+      // still mapped, if it was
+      DeviceMemory memory=lastFree;
+      lastFree=DeviceMemory();
       return memory;
       }
-    vkFreeMemory(device->device.impl,lastFree,nullptr);
-    lastFree=VK_NULL_HANDLE;
+    vkFreeMemory(device->device.impl,lastFree.impl,nullptr);
+    lastFree=DeviceMemory();
     }
-  VkDeviceMemory memory=VK_NULL_HANDLE;
+  DeviceMemory memory;
 
   VkMemoryAllocateInfo memoryAllocateInfo;
   memoryAllocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
@@ -67,15 +68,24 @@ VAllocator::Provider::DeviceMemory VAllocator::Provider::alloc(size_t size, uint
     memoryAllocateInfo.pNext = &flagsInfo;
     }
 
-  auto code = vkAllocateMemory(device->device.impl,&memoryAllocateInfo,nullptr,&memory);
+  auto code = vkAllocateMemory(device->device.impl,&memoryAllocateInfo,nullptr,&memory.impl);
   if(code!=VK_SUCCESS)
-    return VK_NULL_HANDLE;
+    return DeviceMemory();
+
+  const auto flags = device->memoryProperties.memoryTypes[typeId].propertyFlags;
+  if((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)!=0) {
+    // host-visible memory is mapped once, for entire lifetime of allocation
+    void* data = nullptr;
+    if(vkMapMemory(device->device.impl,memory.impl,0,VK_WHOLE_SIZE,0,&data)==VK_SUCCESS)
+      memory.mapped = reinterpret_cast<uint8_t*>(data);
+    memory.coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)!=0;
+    }
   return memory;
   }
 
 void VAllocator::Provider::free(VAllocator::Provider::DeviceMemory m, size_t size, uint32_t typeId) {
-  if(lastFree!=VK_NULL_HANDLE)
-    vkFreeMemory(device->device.impl,lastFree,nullptr);
+  if(lastFree.impl!=VK_NULL_HANDLE)
+    vkFreeMemory(device->device.impl,lastFree.impl,nullptr); // implicitly unmaps
 
   lastFree = m;
   lastSize = size;
@@ -202,7 +212,7 @@ VBuffer VAllocator::alloc(const void *mem, size_t size, MemUsage usage, BufferHe
     if(!ret.page.page)
       continue;
 
-    if(!commit(ret.page.page->memory,ret.page.page->mmapSync,ret.impl,ret.page.offset,mem,size)) {
+    if(!commit(ret.page,ret.impl,mem,size)) {
       throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
       }
     return ret;
@@ -243,7 +253,7 @@ VTexture VAllocator::alloc(const Pixmap& pm, uint32_t mip, VkFormat format) {
     ret.alloc = nullptr;
     throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
     }
-  if(!commit(ret.page.page->memory,ret.page.page->mmapSync,ret.impl,ret.page.offset)) {
+  if(!commit(ret.page,ret.impl)) {
     ret.alloc = nullptr;
     throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
     }
@@ -305,7 +315,7 @@ VTexture VAllocator::alloc(const uint32_t w, const uint32_t h, const uint32_t d,
     ret.alloc = nullptr;
     throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
     }
-  if(!commit(ret.page.page->memory,ret.page.page->mmapSync,ret.impl,ret.page.offset)) {
+  if(!commit(ret.page,ret.impl)) {
     ret.alloc = nullptr;
     throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
     }
@@ -424,149 +434,174 @@ void VAllocator::alignRange(VkMappedMemoryRange& rgn, size_t nonCoherentAtomSize
     rgn.size += nonCoherentAtomSize-rgn.size%nonCoherentAtomSize;
   }
 
-bool VAllocator::fill(VBuffer& dest, uint32_t mem, size_t offset, size_t size) {
-  auto& page = dest.page;
-  void* data = nullptr;
-
+VkMappedMemoryRange VAllocator::mappedRange(const Allocation& page, size_t offset, size_t size, size_t& shift) {
   VkMappedMemoryRange rgn={};
   rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = page.page->memory;
+  rgn.memory = page.page->memory.impl;
   rgn.offset = page.offset+offset;
   rgn.size   = size;
+  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
+  return rgn;
+  }
+
+bool VAllocator::fill(VBuffer& dest, uint32_t mem, size_t offset, size_t size) {
+  auto& page = dest.page;
+  if(auto ptr = map(dest)) {
+    std::fill_n(reinterpret_cast<uint32_t*>(ptr+offset), size/sizeof(uint32_t), mem);
+    flush(dest,offset,size);
+    return true;
+    }
 
   size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
+  auto   rgn   = mappedRange(page,offset,size,shift);
+  void*  data  = nullptr;
 
   std::lock_guard<std::mutex> g(page.page->mmapSync);
-  if(vkMapMemory(dev,page.page->memory,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
+  if(vkMapMemory(dev,page.page->memory.impl,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
     return false;
 
   data = reinterpret_cast<uint8_t*>(data) + shift;
   std::fill_n(reinterpret_cast<uint32_t*>(data), size/sizeof(uint32_t), mem);
 
   vkFlushMappedMemoryRanges(dev,1,&rgn);
-  vkUnmapMemory(dev,page.page->memory);
+  vkUnmapMemory(dev,page.page->memory.impl);
   return true;
   }
 
 bool VAllocator::update(VBuffer &dest, const void *mem, size_t offset, size_t size) {
   auto& page = dest.page;
-  void* data = nullptr;
-
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = page.page->memory;
-  rgn.offset = page.offset+offset;
-  rgn.size   = size;
+  if(auto ptr = map(dest)) {
+    std::memcpy(ptr+offset, mem, size);
+    flush(dest,offset,size);
+    return true;
+    }
 
   size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
+  auto   rgn   = mappedRange(page,offset,size,shift);
+  void*  data  = nullptr;
 
   std::lock_guard<std::mutex> g(page.page->mmapSync);
-  if(vkMapMemory(dev,page.page->memory,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
+  if(vkMapMemory(dev,page.page->memory.impl,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
     return false;
 
   data = reinterpret_cast<uint8_t*>(data) + shift;
   std::memcpy(data, mem, size);
 
   vkFlushMappedMemoryRanges(dev,1,&rgn);
-  vkUnmapMemory(dev,page.page->memory);
+  vkUnmapMemory(dev,page.page->memory.impl);
   return true;
   }
 
 bool VAllocator::read(VBuffer &src, void *mem, size_t offset, size_t size) {
   auto& page = src.page;
-  void* data = nullptr;
+  if(auto ptr = map(src)) {
+    invalidate(src,offset,size);
+    std::memcpy(mem, ptr+offset, size);
+    return true;
+    }
 
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = page.page->memory;
-  rgn.offset = page.offset+offset;
-  rgn.size   = size;
   size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
+  auto   rgn   = mappedRange(page,offset,size,shift);
+  void*  data  = nullptr;
 
   std::lock_guard<std::mutex> g(page.page->mmapSync);
-  if(vkMapMemory(dev,page.page->memory,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
+  if(vkMapMemory(dev,page.page->memory.impl,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
     return false;
   vkInvalidateMappedMemoryRanges(dev,1,&rgn);
 
   data = reinterpret_cast<uint8_t*>(data)+shift;
   std::memcpy(mem,data,size);
 
-  vkUnmapMemory(dev,page.page->memory);
+  vkUnmapMemory(dev,page.page->memory.impl);
   return true;
   }
 
+uint8_t* VAllocator::map(VBuffer& buf) {
+  auto& page = buf.page;
+  if(page.page==nullptr || page.page->memory.mapped==nullptr)
+    return nullptr;
+  return page.page->memory.mapped + page.offset;
+  }
+
+void VAllocator::flush(VBuffer& buf, size_t offset, size_t size) {
+  auto& page = buf.page;
+  if(page.page==nullptr || page.page->memory.coherent)
+    return;
+  size_t shift = 0;
+  auto   rgn   = mappedRange(page,offset,size,shift);
+  vkFlushMappedMemoryRanges(dev,1,&rgn);
+  }
+
+void VAllocator::invalidate(VBuffer& buf, size_t offset, size_t size) {
+  auto& page = buf.page;
+  if(page.page==nullptr || page.page->memory.coherent)
+    return;
+  size_t shift = 0;
+  auto   rgn   = mappedRange(page,offset,size,shift);
+  vkInvalidateMappedMemoryRanges(dev,1,&rgn);
+  }
+
 uint8_t* VAllocator::mapDescriptorHeap(VBuffer& src) {
+  if(auto ptr = map(src))
+    return ptr;
+
   auto& page = src.page;
   void* data = nullptr;
 
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = page.page->memory;
-  rgn.offset = page.offset;
-  rgn.size   = page.size;
   size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
+  auto   rgn   = mappedRange(page,0,page.size,shift);
 
   std::lock_guard<std::mutex> g(page.page->mmapSync);
-  if(vkMapMemory(dev,page.page->memory,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
+  if(vkMapMemory(dev,page.page->memory.impl,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
     return nullptr;
   return reinterpret_cast<uint8_t*>(data);
   }
 
 void VAllocator::unmapDescriptorHeap(VBuffer& src) {
-  if(src.page.page==nullptr)
+  if(src.page.page==nullptr || src.page.page->memory.mapped!=nullptr)
     return;
-  vkUnmapMemory(dev, src.page.page->memory);
+  vkUnmapMemory(dev, src.page.page->memory.impl);
   }
 
 void VAllocator::flushDescriptorHeap(VBuffer& src) {
   if(src.page.page==nullptr)
     return;
-  auto& page = src.page;
-
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = page.page->memory;
-  rgn.offset = page.offset;
-  rgn.size   = page.size;
-  size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
+  flush(src,0,src.page.size);
+  }
 
-  std::lock_guard<std::mutex> g(page.page->mmapSync);
-  vkFlushMappedMemoryRanges(dev,1,&rgn);
+bool VAllocator::commit(const Allocation& page, VkBuffer dest, const void* mem, size_t size) {
+  auto& dmem = page.page->memory;
+  {
+    std::lock_guard<std::mutex> g(page.page->mmapSync); // on practice bind requires external sync
+    if(vkBindBufferMemory(dev,dest,dmem.impl,page.offset)!=VK_SUCCESS)
+      return false;
   }
+  if(mem==nullptr)
+    return true;
 
-bool VAllocator::commit(VkDeviceMemory dmem, std::mutex &mmapSync, VkBuffer dest, size_t pageOffset, const void* mem, size_t size) {
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = dmem;
-  rgn.offset = pageOffset;
-  rgn.size   = size;
   size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
-
-  std::lock_guard<std::mutex> g(mmapSync); // on practice bind requires external sync
-  if(vkBindBufferMemory(dev,dest,dmem,pageOffset)!=VK_SUCCESS)
-    return false;
-  if(mem!=nullptr) {
-    void* data=nullptr;
-    if(vkMapMemory(dev,dmem,pageOffset,rgn.size,0,&data)!=VK_SUCCESS)
-      return false;
-    data = reinterpret_cast<uint8_t*>(data)+shift;
-    std::memcpy(data, mem, size);
-    vkFlushMappedMemoryRanges(dev,1,&rgn);
-    vkUnmapMemory(dev,dmem);
+  auto   rgn   = mappedRange(page,0,size,shift);
+  if(dmem.mapped!=nullptr) {
+    std::memcpy(dmem.mapped+page.offset, mem, size);
+    if(!dmem.coherent)
+      vkFlushMappedMemoryRanges(dev,1,&rgn);
+    return true;
     }
 
+  std::lock_guard<std::mutex> g(page.page->mmapSync);
+  void* data=nullptr;
+  if(vkMapMemory(dev,dmem.impl,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
+    return false;
+  data = reinterpret_cast<uint8_t*>(data)+shift;
+  std::memcpy(data, mem, size);
+  vkFlushMappedMemoryRanges(dev,1,&rgn);
+  vkUnmapMemory(dev,dmem.impl);
   return true;
   }
 
-bool VAllocator::commit(VkDeviceMemory dmem, std::mutex& mmapSync, VkImage dest, size_t offset) {
-  std::lock_guard<std::mutex> g(mmapSync); // on practice bind requires external sync
-  return vkBindImageMemory(dev, dest, dmem, offset)==VkResult::VK_SUCCESS;
+bool VAllocator::commit(const Allocation& page, VkImage dest) {
+  std::lock_guard<std::mutex> g(page.page->mmapSync); // on practice bind requires external sync
+  return vkBindImageMemory(dev, dest, page.page->memory.impl, page.offset)==VkResult::VK_SUCCESS;
   }
 
 #endif
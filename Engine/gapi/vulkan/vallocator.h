@@ -13,13 +13,21 @@ class VTexture;
 
 class VAllocator {
   private:
+    struct Memory {
+      VkDeviceMemory impl     = VK_NULL_HANDLE;
+      uint8_t*       mapped   = nullptr; // persistent mapping of host-visible memory
+      bool           coherent = false;
+
+      bool operator == (const Memory& other) const { return impl==other.impl; }
+      };
+
     struct Provider {
-      using DeviceMemory=VkDeviceMemory;
+      using DeviceMemory=Memory;
       ~Provider();
 
       VDevice*     device=nullptr;
 
-      DeviceMemory lastFree=VK_NULL_HANDLE;
+      DeviceMemory lastFree={};
       uint32_t     lastType=0;
       size_t       lastSize=0;
 
@@ -54,6 +62,10 @@ class VAllocator {
     bool     update(VBuffer& dest, const void *mem, size_t offset, size_t size);
     bool     read  (VBuffer& src,        void *mem, size_t offset, size_t size);
 
+    uint8_t* map       (VBuffer& buf);
+    void     flush     (VBuffer& buf, size_t offset, size_t size);
+    void     invalidate(VBuffer& buf, size_t offset, size_t size);
+
     uint8_t* mapDescriptorHeap(VBuffer& heap);
     void     unmapDescriptorHeap(VBuffer& heap);
     void     flushDescriptorHeap(VBuffer& heap);
@@ -69,8 +81,10 @@ class VAllocator {
 
     Allocation allocMemory(const MemRequirements& rq, const uint32_t heapId, const uint32_t typeId, bool hostVisible);
 
-    bool commit(VkDeviceMemory dev, std::mutex& mmapSync, VkBuffer dest, size_t offset, const void *mem, size_t size);
-    bool commit(VkDeviceMemory dev, std::mutex& mmapSync, VkImage  dest, size_t offset);
+    VkMappedMemoryRange mappedRange(const Allocation& page, size_t offset, size_t size, size_t& shift);
+
+    bool commit(const Allocation& page, VkBuffer dest, const void *mem, size_t size);
+    bool commit(const Allocation& page, VkImage  dest);
   };
 
 }}
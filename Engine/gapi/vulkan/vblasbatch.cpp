@@ -0,0 +1,203 @@
+#if defined(TEMPEST_BUILD_VULKAN)
+
+#include "vblasbatch.h"
+
+#include "vdevice.h"
+#include "vbuffer.h"
+#include "vcommandbuffer.h"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+VBlasBatch::VBlasBatch(VDevice& dev)
+  :dev(dev) {
+  }
+
+VBlasBatch::~VBlasBatch() {
+  // device is idle at this point
+  for(auto& c:compaction)
+    vkDestroyQueryPool(dev.device.impl, c.pool, nullptr);
+  }
+
+bool VBlasBatch::Compaction::contains(AbstractGraphicsApi::AccelerationStructure* const* as, size_t count) const {
+  for(auto& b:blas)
+    for(size_t i=0; i<count; ++i)
+      if(b.handler==as[i])
+        return true;
+  return false;
+  }
+
+void VBlasBatch::push(VAccelerationStructure& as, VBlasBuildCtx&& ctx, VkDeviceSize size,
+                      const AbstractGraphicsApi::RtGeometry* geom, size_t geomSize) {
+  const VkDeviceSize align = std::max<VkDeviceSize>(dev.props.accelerationStructureScratchOffsetAlignment, 1);
+  size = ((size+align-1)/align)*align;
+
+  std::lock_guard<std::mutex> guard(sync);
+  if(pending.size()>=MaxBuilds || (pending.size()>0 && scratchSize+size>MaxScratch))
+    implFlush();
+
+  Build b;
+  b.as  = AsPtr(&as);
+  b.ctx = std::move(ctx);
+  b.ctx.scratchOffset = scratchSize;
+  b.geom.reserve(geomSize*2);
+  for(size_t i=0; i<geomSize; ++i) {
+    b.geom.emplace_back(geom[i].vbo);
+    b.geom.emplace_back(geom[i].ibo);
+    }
+  pending.emplace_back(std::move(b));
+  scratchSize += size;
+  }
+
+void VBlasBatch::flush() {
+  std::lock_guard<std::mutex> guard(sync);
+  implFlush();
+  implPoll();
+  }
+
+void VBlasBatch::flush(AbstractGraphicsApi::AccelerationStructure* const* blas, size_t count) {
+  std::vector<std::shared_ptr<AbstractGraphicsApi::Fence>> wait;
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  implFlush();
+  implPoll();
+  for(auto& c:compaction) {
+    if(!c.contains(blas,count))
+      continue;
+    if(auto f = c.fence.lock())
+      wait.emplace_back(std::move(f));
+    }
+  }
+
+  if(wait.empty())
+    return;
+  // referenced blas'es are about to change address: wait for size query without holding the lock
+  for(auto& f:wait)
+    f->wait();
+
+  std::lock_guard<std::mutex> guard(sync);
+  implPoll();
+  }
+
+void VBlasBatch::implFlush() {
+  if(pending.empty())
+    return;
+
+  std::vector<VAccelerationStructure*> dest(pending.size());
+  std::vector<const VBlasBuildCtx*>    ctx (pending.size());
+  std::vector<VAccelerationStructure*> compact;
+  Compaction                           cp;
+  for(size_t i=0; i<pending.size(); ++i) {
+    dest[i] = reinterpret_cast<VAccelerationStructure*>(pending[i].as.handler);
+    ctx [i] = &pending[i].ctx;
+    if(pending[i].ctx.compact) {
+      compact.push_back(dest[i]);
+      cp.blas.push_back(pending[i].as);
+      }
+    }
+
+  auto  pScratch = scratchBuffer(scratchSize);
+  auto& mgr      = dev.dataMgr();
+  auto  cmd      = mgr.get();
+  cmd->begin(SyncHint::NoPendingReads);
+  for(auto& i:pending) {
+    for(auto& g:i.geom)
+      cmd->hold(g);
+    cmd->hold(i.as);
+    }
+  cmd->hold(pScratch);
+  cmd->buildBlas(dest.data(), ctx.data(), dest.size(), *pScratch.handler);
+
+  if(!compact.empty()) {
+    VkQueryPoolCreateInfo qinfo = {};
+    qinfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    qinfo.queryType  = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR;
+    qinfo.queryCount = uint32_t(compact.size());
+    vkAssert(vkCreateQueryPool(dev.device.impl, &qinfo, nullptr, &cp.pool));
+    // compacted size is only known after build; result is picked up by one of next flushes
+    cmd->queryBlasCompactedSize(compact.data(), compact.size(), cp.pool);
+    }
+
+  cmd->end();
+  scratchFence = mgr.submit(std::move(cmd));
+  pending.clear();
+  scratchSize = 0;
+
+  if(cp.pool!=VK_NULL_HANDLE) {
+    cp.fence = scratchFence;
+    compaction.emplace_back(std::move(cp));
+    }
+  }
+
+void VBlasBatch::implPoll() {
+  for(size_t i=0; i<compaction.size();) {
+    auto f = compaction[i].fence.lock();
+    if(f!=nullptr && !f->wait(0)) {
+      ++i;
+      continue;
+      }
+    if(!implCompact(compaction[i])) {
+      ++i;
+      continue;
+      }
+    vkDestroyQueryPool(dev.device.impl, compaction[i].pool, nullptr);
+    compaction[i] = std::move(compaction.back());
+    compaction.pop_back();
+    }
+  }
+
+bool VBlasBatch::implCompact(Compaction& c) {
+  std::vector<VkDeviceSize> size(c.blas.size());
+  VkResult ret = vkGetQueryPoolResults(dev.device.impl, c.pool, 0, uint32_t(size.size()), size.size()*sizeof(VkDeviceSize),
+                                       size.data(), sizeof(VkDeviceSize), VK_QUERY_RESULT_64_BIT);
+  if(ret==VK_NOT_READY)
+    return false;
+  vkAssert(ret);
+
+  std::vector<VAccelerationStructure*> dest, src;
+  dest.reserve(c.blas.size());
+  src .reserve(c.blas.size());
+
+  auto& mgr = dev.dataMgr();
+  auto  cmd = mgr.get();
+  cmd->begin(SyncHint::NoPendingReads);
+  for(size_t i=0; i<c.blas.size(); ++i) {
+    auto& as = *reinterpret_cast<VAccelerationStructure*>(c.blas[i].handler);
+    if(size[i]==0 || size[i]>=as.data.size())
+      continue;
+
+    // original storage is released, once copy is complete
+    AsPtr pPrev(new VAccelerationStructure(dev));
+    auto& prev = *reinterpret_cast<VAccelerationStructure*>(pPrev.handler);
+    std::swap(prev.impl, as.impl);
+    prev.data = std::move(as.data);
+    as.alloc(size[i]);
+
+    cmd->hold(pPrev);
+    cmd->hold(c.blas[i]);
+    dest.push_back(&as);
+    src .push_back(&prev);
+    }
+
+  if(dest.empty())
+    return true;
+  cmd->compactBlas(dest.data(), src.data(), dest.size());
+  cmd->end();
+  mgr.submit(std::move(cmd));
+  return true;
+  }
+
+auto VBlasBatch::scratchBuffer(VkDeviceSize size) -> BufPtr {
+  // scratch of previous batch is reused, if that batch is complete
+  auto fence = scratchFence.lock();
+  if(scratch.handler!=nullptr && scratchCapacity>=size && (fence==nullptr || fence->wait(0)))
+    return scratch;
+
+  const VkDeviceSize cap = std::max(size, scratchCapacity);
+  auto buf = dev.dataMgr().allocStagingMemory(nullptr, size_t(cap), MemUsage::ScratchBuffer, BufferHeap::Device);
+  scratch         = BufPtr(new VBuffer(std::move(buf)));
+  scratchCapacity = cap;
+  return scratch;
+  }
+
+#endif
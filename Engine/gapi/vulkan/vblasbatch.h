@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vulkan_sdk.h"
+#include "vaccelerationstructure.h"
+
+namespace Tempest {
+namespace Detail {
+
+class VDevice;
+
+/**
+ * Deferred BLAS builds: Device::blas only allocates storage, while builds are recorded in batches,
+ * with one vkCmdBuildAccelerationStructures per submit and a shared, reused scratch buffer.
+ * Batch is flushed when full, before TLAS build and before user submit.
+ *
+ * BLAS'es created with BlasFlags::Compact are compacted asynchronously: flush only submits
+ * compacted-size query after the build; once query fence is signalled, one of next flushes copies
+ * BLAS into tight storage and releases original one. TLAS builds need final addresses, so
+ * flush with list of referenced BLAS'es waits (outside of the batch lock) for their compaction.
+ */
+class VBlasBatch {
+  public:
+    explicit VBlasBatch(VDevice& dev);
+    ~VBlasBatch();
+
+    void push(VAccelerationStructure& as, VBlasBuildCtx&& ctx, VkDeviceSize scratchSize,
+              const AbstractGraphicsApi::RtGeometry* geom, size_t size);
+    void flush();
+    void flush(AbstractGraphicsApi::AccelerationStructure* const* blas, size_t count);
+
+  private:
+    enum : uint32_t {
+      MaxBuilds = 1024,
+      };
+    static constexpr VkDeviceSize MaxScratch = 128*1024*1024;
+
+    using AsPtr   = DSharedPtr<AbstractGraphicsApi::AccelerationStructure*>;
+    using BufPtr  = DSharedPtr<AbstractGraphicsApi::Buffer*>;
+    using CBufPtr = DSharedPtr<const AbstractGraphicsApi::Buffer*>;
+    using Fence   = std::weak_ptr<AbstractGraphicsApi::Fence>;
+
+    struct Build {
+      AsPtr                as;
+      std::vector<CBufPtr> geom;
+      VBlasBuildCtx        ctx;
+      };
+
+    struct Compaction {
+      std::vector<AsPtr>   blas;
+      VkQueryPool          pool = VK_NULL_HANDLE;
+      Fence                fence;
+      bool                 contains(AbstractGraphicsApi::AccelerationStructure* const* as, size_t count) const;
+      };
+
+    void   implFlush();
+    void   implPoll();
+    bool   implCompact(Compaction& c);
+    BufPtr scratchBuffer(VkDeviceSize size);
+
+    VDevice&           dev;
+    std::mutex         sync;
+    std::vector<Build> pending;
+    VkDeviceSize       scratchSize = 0;
+
+    BufPtr             scratch;
+    VkDeviceSize       scratchCapacity = 0;
+    Fence              scratchFence;
+
+    std::vector<Compaction> compaction;
+  };
+
+}
+}
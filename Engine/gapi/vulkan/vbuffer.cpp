@@ -111,6 +111,22 @@ void VBuffer::fill(uint32_t data, size_t off, size_t size) {
   assert(false);
   }
 
+uint8_t* VBuffer::map() {
+  if(!page.page->hostVisible)
+    return nullptr;
+  return alloc->map(*this);
+  }
+
+void VBuffer::flush(size_t off, size_t size) {
+  if(page.page->hostVisible)
+    alloc->flush(*this,off,size);
+  }
+
+void VBuffer::invalidate(size_t off, size_t size) {
+  if(page.page->hostVisible)
+    alloc->invalidate(*this,off,size);
+  }
+
 bool VBuffer::isHostVisible() const {
   return page.page->hostVisible;
   }
@@ -122,6 +138,13 @@ VkDeviceAddress VBuffer::toDeviceAddress(VDevice& owner) const {
   return owner.vkGetBufferDeviceAddress(owner.device.impl, &bufferDeviceAddressInfo);
   }
 
+uint64_t VBuffer::deviceAddress() const {
+  auto dev = alloc!=nullptr ? alloc->device() : nullptr;
+  if(dev==nullptr || !dev->props.hasDeviceAddress)
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  return toDeviceAddress(*dev);
+  }
+
 uint8_t* VBuffer::mapDescriptorHeap() {
   return alloc ? alloc->mapDescriptorHeap(*this) : nullptr;
   }
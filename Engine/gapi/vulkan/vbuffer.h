@@ -20,6 +20,11 @@ class VBuffer : public AbstractGraphicsApi::Buffer {
     void update(const void* data, size_t off, size_t size) override;
     void read  (      void* data, size_t off, size_t size) override;
 
+    uint8_t* map() override;
+    void flush     (size_t off, size_t size) override;
+    void invalidate(size_t off, size_t size) override;
+    uint64_t deviceAddress() const override;
+
     bool                   isHostVisible() const;
 
     VkDeviceAddress        toDeviceAddress(VDevice& owner) const;
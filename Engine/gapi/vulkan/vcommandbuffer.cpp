@@ -13,6 +13,11 @@
 #include "vtexture.h"
 #include "vframebuffermap.h"
 #include "vaccelerationstructure.h"
+#include "vmeshlethelper.h"
+#include "vblasbatch.h"
+#include "vcommandbundle.h"
+
+#include <bit>
 
 using namespace Tempest;
 using namespace Tempest::Detail;
@@ -148,6 +153,23 @@ static VkImageLayout toLayout(ResourceLayout rs, const VTexture* texture) {
   return VK_IMAGE_LAYOUT_GENERAL;
   }
 
+static void prePassBarrier(VkCommandBuffer cmd, VkPipelineStageFlags src, VkPipelineStageFlags dst, VkAccessFlags dstAccess) {
+  VkMemoryBarrier b = {};
+  b.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  b.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+  b.dstAccessMask = dstAccess;
+  vkCmdPipelineBarrier(cmd, src, dst, VkDependencyFlags(0), 1, &b, 0, nullptr, 0, nullptr);
+  }
+
+static void blasBuildBarrier(VkCommandBuffer cmd) {
+  VkMemoryBarrier b = {};
+  b.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  b.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+  b.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                       VkDependencyFlags(0), 1, &b, 0, nullptr, 0, nullptr);
+  }
+
 static VkImage toVkResource(const AbstractGraphicsApi::BarrierDesc& b) {
   if(b.texture!=nullptr) {
     auto& t = *reinterpret_cast<const VTexture*>(b.texture);
@@ -158,73 +180,52 @@ static VkImage toVkResource(const AbstractGraphicsApi::BarrierDesc& b) {
   return s.images[b.swId];
   }
 
-
 VCommandBuffer::VCommandBuffer(VDevice& device, VkCommandPoolCreateFlags flags)
-  :device(device), pool(device,flags), pushDescriptors(device) {
+  :device(device), pool(device,flags), pushDescriptors(device), uboRing(device) {
   }
 
 VCommandBuffer::~VCommandBuffer() {
-  if(impl!=nullptr) {
-    vkFreeCommandBuffers(device.device.impl,pool.impl,1,&impl);
-    }
-
-  if(chunks.size()==0)
-    return;
-
-  SmallArray<VkCommandBuffer,MaxCmdChunks> flat(chunks.size());
-  auto node = chunks.begin();
-  for(size_t i=0; i<chunks.size(); ++i) {
-    flat[i] = node->val[i%chunks.chunkSize].impl;
-    if(i+1==chunks.chunkSize)
-      node = node->next;
-    }
-  vkFreeCommandBuffers(device.device.impl,pool.impl,uint32_t(chunks.size()),flat.get());
+  // command buffers are owned by pool
   }
 
 void VCommandBuffer::reset() {
-  vkAssert(vkResetCommandPool(device.device.impl,pool.impl,0));
-
-  SmallArray<VkCommandBuffer,MaxCmdChunks> flat(chunks.size());
-  auto node = chunks.begin();
-  if(chunks.size()>0) {
-    impl = node->val[0].impl;
-    vkResetCommandBuffer(impl,VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
-    }
-  for(size_t i=1; i<chunks.size(); ++i) {
-    auto cmd = node->val[i%chunks.chunkSize].impl;
-    vkFreeCommandBuffers(device.device.impl,pool.impl,1,&cmd);
-    if(i+1==chunks.chunkSize)
-      node = node->next;
-    }
+  // caller guarantees that previous submit is complete (fence did signal): recycle everything in one go
+  pool.reset();
   chunks.clear();
+  impl = nullptr;
+
+  // recording may have been interrupted in the middle of render-pass
+  meshEmu.task      = nullptr;
+  meshEmu.mesh      = nullptr;
+  meshEmu.drawCount = 0;
+  meshEmu.hasTask   = false;
 
   swapchainSync.reserve(swapchainSync.size());
   swapchainSync.clear();
 
+  passContents = P_Pending;
+  passCmd      = nullptr;
+
+  fboRefs.clear();
+  bindlessRefs.clear();
   bindings = Bindings();
   pushDescriptors.reset();
+  uboRing.reset();
   }
 
 void VCommandBuffer::begin(SyncHint hint) {
   state  = Idle;
   curVbo = VK_NULL_HANDLE;
+  curIbo = VK_NULL_HANDLE;
   pushData.size  = 0;
   pushData.durty = true;
-  if(chunks.size()>0)
+  if(chunks.size()>0 || impl!=nullptr)
     reset();
 
   if(hint==Detail::SyncHint::NoPendingReads)
     resState.clearReaders();
 
-  if(impl==nullptr) {
-    newChunk();
-    } else {
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags            = 0;
-    beginInfo.pInheritanceInfo = nullptr;
-    vkAssert(vkBeginCommandBuffer(impl,&beginInfo));
-    }
+  newChunk();
   }
 
 void VCommandBuffer::begin() {
@@ -238,6 +239,7 @@ void VCommandBuffer::end() {
     }
   swapchainSync.reserve(swapchainSync.size());
   resState.finalize(*this);
+  uboRing.flush();
   state = NoRecording;
 
   pushChunk();
@@ -255,6 +257,12 @@ bool VCommandBuffer::isRecording() const {
   return state!=NoRecording;
   }
 
+CommandBufferStats VCommandBuffer::stats() const {
+  CommandBufferStats ret;
+  ret.allocations = pool.allocations();
+  return ret;
+  }
+
 void VCommandBuffer::beginRendering(const FrameBufferDesc& fbo, size_t fboSize, uint32_t width, uint32_t height) {
   for(size_t i=0; i<fboSize; ++i) {
     if(fbo.sw[i]!=nullptr)
@@ -340,9 +348,22 @@ void VCommandBuffer::beginRendering(const FrameBufferDesc& fbo, size_t fboSize,
       att.storeOp            = mkStoreOp(fbo.desc[i].store);
       }
     passDyn.colorAttachmentCount = info.colorAttachmentCount;
-    vkCmdBeginRenderingKHR(impl,&info);
+
+    passBegin.info  = info;
+    passBegin.depth = depthAtt;
+    std::memcpy(passBegin.color, colorAtt, sizeof(colorAtt));
+    passBegin.info.pColorAttachments = passBegin.color;
+    passBegin.info.pDepthAttachment  = (info.pDepthAttachment!=nullptr ? &passBegin.depth : nullptr);
+
+    if(!device.props.hasDynRendering) {
+      // render-pass object is needed by pipelines right away
+      auto fbo = device.fboMap.find(&passBegin.info, &passDyn);
+      passRp   = fbo->pass;
+      fboRefs.push_back(std::move(fbo));
+      }
   }
-  state = RenderPass;
+  state        = RenderPass;
+  passContents = P_Pending;
 
   // setup dynamic state
   // https://www.khronos.org/registry/vulkan/specs/1.1-extensions/html/vkspec.html#pipelines-dynamic-state
@@ -351,35 +372,55 @@ void VCommandBuffer::beginRendering(const FrameBufferDesc& fbo, size_t fboSize,
   }
 
 void VCommandBuffer::endRendering() {
+  if(passContents==P_Pending) {
+    // no draws: attachments still have to be cleared and stored
+    beginPass(P_Inline);
+    }
+  flushInline();
   vkCmdEndRenderingKHR(impl);
+  if(passContents==P_Secondary) {
+    // state of primary command buffer is undefined after vkCmdExecuteCommands
+    curVbo         = VK_NULL_HANDLE;
+    curIbo         = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    pushData.durty = true;
+    bindings.durty = true;
+    pushDescriptors.onNextCmdChunk();
+    }
+  passContents = P_Pending;
+  passCmd      = nullptr;
   resState.flush(*this);
   resState.endRendering(*this);
+  if(meshEmu.drawCount>0)
+    endMeshEmulation();
 
   state = PostRenderPass;
   resState.onUavUsage(bindings.read, bindings.write, PipelineStage::S_Graphics);
   }
 
 void VCommandBuffer::setPipeline(AbstractGraphicsApi::Pipeline& p) {
+  beginState();
   VPipeline& px   = reinterpret_cast<VPipeline&>(p);
+  applyRenderState(px.renderState());
 
   if(device.props.hasDescriptorHeap) {
     const auto prevPushSize = curDrawPipeline ? curDrawPipeline->pb.size : 0;
 
     auto rp   = (passRp!=nullptr ? passRp->pass : VK_NULL_HANDLE);
-    auto inst = px.instance(passDyn, rp, VK_NULL_HANDLE, px.defaultStride);
+    auto inst = px.instance(passDyn, rp, VK_NULL_HANDLE, px.defaultInput);
     vkCmdBindPipeline(impl, VK_PIPELINE_BIND_POINT_GRAPHICS, inst);
 
     pushData.durty  = pushData.durty || px.pb.size!=prevPushSize;
     bindings.durty  = bindings.durty || px.pb.size!=prevPushSize;
     curDrawPipeline = &px;
-    vboStride       = px.defaultStride;
+    vboInput        = px.defaultInput;
     pipelineLayout  = VK_NULL_HANDLE;
     return;
     }
 
   bindings.durty  = true;
   curDrawPipeline = &px;
-  vboStride       = px.defaultStride;
+  vboInput        = px.defaultInput;
   pipelineLayout  = VK_NULL_HANDLE; // clear until draw
   }
 
@@ -434,6 +475,13 @@ void VCommandBuffer::setPushData(const void* data, size_t size) {
   pushData.durty = true;
   }
 
+void VCommandBuffer::pushUniform(size_t id, const void* data, size_t size) {
+  auto a = uboRing.push(data, size);
+  setBinding(id, a.buf, a.offset);
+  bindings.pushed     |= (1u << id);
+  bindings.pushSz[id]  = uint32_t(size);
+  }
+
 void VCommandBuffer::handleSync(const ShaderReflection::LayoutDesc& lay, const ShaderReflection::SyncDesc& sync, PipelineStage st) {
   if(st!=PipelineStage::S_Graphics) {
     bindings.read  = NonUniqResId::I_None;
@@ -488,6 +536,16 @@ void VCommandBuffer::handleSync(const ShaderReflection::LayoutDesc& lay, const S
     if(sync.write & (1u<<i))
       bindings.write |= nonUniqId;
     }
+
+  bindings.read  |= bindings.addrRead;
+  bindings.write |= bindings.addrWrite;
+  bindings.host  |= bindings.addrHost;
+  }
+
+void VCommandBuffer::retainBindless(std::shared_ptr<void> ref) {
+  if(bindlessRefs.size()>0 && bindlessRefs.back()==ref)
+    return;
+  bindlessRefs.push_back(std::move(ref));
   }
 
 void VCommandBuffer::implSetUniforms(const PipelineStage st) {
@@ -526,6 +584,14 @@ void VCommandBuffer::implSetUniforms(const PipelineStage st) {
 
   handleSync(*lay, *sync, st);
 
+  // uniform block is bound with fixed range: ring memory past pushed data belongs to next push
+  for(uint32_t mask = (lay->active & bindings.pushed); mask!=0;) {
+    const int i = std::countr_zero(mask);
+    mask ^= (1u << i);
+    if(bindings.pushSz[i]<lay->bufferSz[i])
+      throw std::system_error(Tempest::GraphicsErrc::InvalidUniformBuffer, "pushUniform: data is smaller than uniform block");
+    }
+
   if(device.props.hasDescriptorHeap) {
     if(lay->active==0)
       return;
@@ -534,6 +600,11 @@ void VCommandBuffer::implSetUniforms(const PipelineStage st) {
 
     uint32_t heapIndices[MaxBindings] = {};
     pushDescriptors.pushHeap(impl, heapIndices, *pb, *lay, bindings);
+    for(uint32_t mask = (lay->active & bindings.array); mask!=0;) {
+      const int i = std::countr_zero(mask);
+      mask ^= (1u << i);
+      retainBindless(reinterpret_cast<VDescriptorHeapArray*>(bindings.data[i])->epoch());
+      }
 
     VkPushDataInfoEXT pushDataInfo = {VK_STRUCTURE_TYPE_PUSH_DATA_INFO_EXT};
     pushDataInfo.offset       = pb->size;
@@ -545,22 +616,39 @@ void VCommandBuffer::implSetUniforms(const PipelineStage st) {
 
   if(lay->isUpdateAfterBind()) {
     auto dset = device.descPool.allocBindless(*pb, *lay, bindings);
+    retainBindless(std::move(dset.ref));
+    for(uint32_t mask = (lay->active & bindings.array); mask!=0;) {
+      const int i = std::countr_zero(mask);
+      mask ^= (1u << i);
+      retainBindless(reinterpret_cast<VDescriptorArray*>(bindings.data[i])->epoch());
+      }
     pLay = dset.pLay;
     vkCmdBindDescriptorSets(impl, bindPoint,
                             pLay, 0, 1,
                             &dset.set, 0, nullptr);
     } else {
-    auto dset = pushDescriptors.push(*pb, *lay, bindings);
+    // offsets of uniform buffers are dynamic: set is reused, while only offsets do change
+    const uint32_t dynamic = device.dynamicUboMask(*lay);
+    uint32_t       offsets[MaxBindings] = {};
+    uint32_t       numOffsets = 0;
+    for(uint32_t mask = dynamic; mask!=0;) {
+      const int i = std::countr_zero(mask);
+      mask ^= (1u << i);
+      offsets[numOffsets] = bindings.offset[i];
+      ++numOffsets;
+      }
+
+    auto dset = pushDescriptors.push(*pb, *lay, bindings, dynamic);
     vkCmdBindDescriptorSets(impl, bindPoint,
                             pLay, 0, 1,
-                            &dset, 0, nullptr);
+                            &dset, numOffsets, offsets);
     }
 
   if(pLay!=pipelineLayout && st==PipelineStage::S_Graphics) {
     pipelineLayout = pLay;
     auto& pso  = *curDrawPipeline;
     auto  rp   = (passRp!=nullptr ? passRp->pass : VK_NULL_HANDLE);
-    auto  inst = pso.instance(passDyn, rp, pipelineLayout, vboStride);
+    auto  inst = pso.instance(passDyn, rp, pipelineLayout, vboInput);
     vkCmdBindPipeline(impl, bindPoint, inst);
     pushData.durty = true;
     }
@@ -622,6 +710,7 @@ void VCommandBuffer::setBinding(size_t id, AbstractGraphicsApi::Buffer *buf, siz
   bindings.offset[id] = uint32_t(offset);
   bindings.durty      = true;
   bindings.array      = bindings.array & ~(1u << id);
+  bindings.pushed     = bindings.pushed & ~(1u << id);
   }
 
 void VCommandBuffer::setBinding(size_t id, AbstractGraphicsApi::DescArray *arr) {
@@ -642,9 +731,28 @@ void VCommandBuffer::setBinding(size_t id, const Sampler &smp) {
   bindings.array   = bindings.array & ~(1u << id);
   }
 
+void VCommandBuffer::setAddressUsage(const AbstractGraphicsApi::Buffer* const* read,  size_t nread,
+                                     const AbstractGraphicsApi::Buffer* const* write, size_t nwrite) {
+  bindings.addrRead  = NonUniqResId::I_None;
+  bindings.addrWrite = NonUniqResId::I_None;
+  bindings.addrHost  = false;
+  for(size_t i=0; i<nread; ++i) {
+    auto buf = reinterpret_cast<const VBuffer*>(read[i]);
+    bindings.addrRead |= buf->nonUniqId;
+    }
+  for(size_t i=0; i<nwrite; ++i) {
+    auto buf = reinterpret_cast<const VBuffer*>(write[i]);
+    bindings.addrRead  |= buf->nonUniqId;
+    bindings.addrWrite |= buf->nonUniqId;
+    bindings.addrHost  |= buf->isHostVisible();
+    }
+  bindings.durty = true;
+  }
+
 void VCommandBuffer::draw(const AbstractGraphicsApi::Buffer* ivbo, size_t stride, size_t voffset, size_t vsize,
                           size_t firstInstance, size_t instanceCount) {
   const VBuffer* vbo=reinterpret_cast<const VBuffer*>(ivbo);
+  beginInline();
   if(T_LIKELY(vbo!=nullptr)) {
     bindVbo(*vbo,stride);
     }
@@ -657,17 +765,19 @@ void VCommandBuffer::drawIndexed(const AbstractGraphicsApi::Buffer* ivbo, size_t
                                  const AbstractGraphicsApi::Buffer& iibo, Detail::IndexClass cls,
                                  size_t ioffset, size_t isize, size_t firstInstance, size_t instanceCount) {
   const VBuffer* vbo = reinterpret_cast<const VBuffer*>(ivbo);
+  beginInline();
   const VBuffer& ibo = reinterpret_cast<const VBuffer&>(iibo);
   if(T_LIKELY(vbo!=nullptr)) {
     bindVbo(*vbo,stride);
     }
-  vkCmdBindIndexBuffer(impl, ibo.impl, 0, nativeFormat(cls));
+  bindIbo(ibo,cls);
   implSetUniforms(PipelineStage::S_Graphics);
   implSetPushData(PipelineStage::S_Graphics);
   vkCmdDrawIndexed    (impl, uint32_t(isize), uint32_t(instanceCount), uint32_t(ioffset), int32_t(voffset), uint32_t(firstInstance));
   }
 
 void VCommandBuffer::drawIndirect(const AbstractGraphicsApi::Buffer& indirect, size_t offset) {
+  beginInline();
   const VBuffer& ind = reinterpret_cast<const VBuffer&>(indirect);
 
   // block future writers
@@ -679,13 +789,23 @@ void VCommandBuffer::drawIndirect(const AbstractGraphicsApi::Buffer& indirect, s
   }
 
 void VCommandBuffer::dispatchMesh(size_t x, size_t y, size_t z) {
+  beginInline();
+  if(T_UNLIKELY(curDrawPipeline->isMeshEmulated())) {
+    emulatedDispatchMesh(x, y, z, nullptr, 0);
+    return;
+    }
   implSetUniforms(PipelineStage::S_Graphics);
   implSetPushData(PipelineStage::S_Graphics);
   device.vkCmdDrawMeshTasks(impl, uint32_t(x), uint32_t(y), uint32_t(z));
   }
 
 void VCommandBuffer::dispatchMeshIndirect(const AbstractGraphicsApi::Buffer& indirect, size_t offset) {
+  beginInline();
   const VBuffer& ind = reinterpret_cast<const VBuffer&>(indirect);
+  if(T_UNLIKELY(curDrawPipeline->isMeshEmulated())) {
+    emulatedDispatchMesh(0, 0, 0, &ind, offset);
+    return;
+    }
 
   // block future writers
   resState.onUavUsage(ind.nonUniqId, NonUniqResId::I_None, PipelineStage::S_Indirect);
@@ -695,6 +815,180 @@ void VCommandBuffer::dispatchMeshIndirect(const AbstractGraphicsApi::Buffer& ind
   device.vkCmdDrawMeshTasksIndirect(impl, ind.impl, VkDeviceSize(offset), 1, 0);
   }
 
+template<class Fn>
+void VCommandBuffer::implMeshPrePass(VkCommandBuffer cmd, Fn&& fn) {
+  // record into pre-pass command buffer, while graphics state of render-pass stays intact
+  const auto prevImpl  = impl;
+  const auto prevState = state;
+  const auto prevComp  = curCompPipeline;
+  const auto prevLay   = pipelineLayout;
+  const auto prevPush  = pushData;
+  const auto prevBind  = bindings;
+
+  impl           = cmd;
+  pipelineLayout = VK_NULL_HANDLE;
+  bindings.read  = NonUniqResId::I_None;
+  bindings.write = NonUniqResId::I_None;
+  bindings.host  = false;
+  pushDescriptors.onNextCmdChunk();
+
+  fn();
+
+  const auto read  = bindings.read;
+  const auto write = bindings.write;
+  const auto host  = bindings.host;
+
+  impl            = prevImpl;
+  state           = prevState;
+  curCompPipeline = prevComp;
+  pipelineLayout  = prevLay;
+  pushData        = prevPush;
+  bindings        = prevBind;
+  pushDescriptors.onNextCmdChunk();
+
+  // pre-pass is executed before render-pass, as compute; barriers are flushed at endRendering
+  resState.onUavUsage(read, write, PipelineStage::S_Compute, host);
+  }
+
+void VCommandBuffer::emulatedDispatchMesh(size_t x, size_t y, size_t z, const VBuffer* ind, size_t offset) {
+  auto& helper = *device.meshHelper;
+  auto& pso    = *curDrawPipeline;
+
+  if(meshEmu.drawCount==0)
+    beginMeshEmulation();
+  if(meshEmu.drawCount>=VMeshletHelper::MaxDraws)
+    throw std::system_error(Tempest::GraphicsErrc::TooLargeBuffer, "too many emulated mesh-shader draws in render-pass");
+
+  const VkDeviceSize cmdOffset = meshEmu.drawCount*helper.indirectStride();
+  meshEmu.drawCount++;
+
+  auto dispatchUsr = [&](VCompPipeline& comp) {
+    setComputePipeline(comp);
+    bindMeshEmulation(cmdOffset);
+    implSetUniforms(PipelineStage::S_Compute);
+    implSetPushData(PipelineStage::S_Compute);
+    if(ind!=nullptr)
+      vkCmdDispatchIndirect(impl, ind->impl, VkDeviceSize(offset)); else
+      vkCmdDispatch(impl, uint32_t(x), uint32_t(y), uint32_t(z));
+    };
+
+  if(pso.emu.task.handler!=nullptr) {
+    meshEmu.hasTask = true;
+    implMeshPrePass(meshEmu.task, [&]() {
+      dispatchUsr(*pso.emu.task.handler);
+      });
+    implMeshPrePass(meshEmu.mesh, [&]() {
+      // mesh workgroups count is resolved by task_post_pass
+      setComputePipeline(*pso.emu.mesh.handler);
+      bindMeshEmulation(cmdOffset);
+      implSetUniforms(PipelineStage::S_Compute);
+      implSetPushData(PipelineStage::S_Compute);
+      vkCmdDispatchIndirect(impl, meshEmu.indirect.impl, cmdOffset + VMeshletHelper::IndirectCmdNative);
+      });
+    } else {
+    implMeshPrePass(meshEmu.mesh, [&]() {
+      dispatchUsr(*pso.emu.mesh.handler);
+      });
+    }
+
+  setBinding(VMeshletHelper::ScratchSlot, &meshEmu.scratch, 0);
+  vkCmdBindIndexBuffer(impl, meshEmu.scratch.impl, sizeof(uint32_t), VK_INDEX_TYPE_UINT32);
+  curIbo = VK_NULL_HANDLE;
+  implSetUniforms(PipelineStage::S_Graphics);
+  implSetPushData(PipelineStage::S_Graphics);
+  vkCmdDrawIndexedIndirect(impl, meshEmu.indirect.impl, cmdOffset + VMeshletHelper::IndirectCmdNative, 1, 0);
+  // engine slot is not visible to user
+  bindings.data[VMeshletHelper::ScratchSlot] = nullptr;
+  }
+
+void VCommandBuffer::beginMeshEmulation() {
+  auto& helper = *device.meshHelper;
+  if(meshEmu.indirect.impl==VK_NULL_HANDLE) {
+    meshEmu.indirect = helper.allocIndirect();
+    meshEmu.meshlets = helper.allocMeshlets();
+    meshEmu.scratch  = helper.allocScratch();
+    }
+  meshEmu.task = allocChunk();
+  meshEmu.mesh = allocChunk();
+
+  const VkPipelineStageFlags comp = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  const VkPipelineStageFlags ind  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+  const VkAccessFlags        acc  = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  implMeshPrePass(meshEmu.task, [&]() {
+    // previous render-pass may still use scratch; user resources may be written by anything
+    prePassBarrier(impl, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, comp | ind, acc);
+    dispatchBuiltin(*helper.init.handler, (VMeshletHelper::MaxDraws*helper.indirectRate()+63)/64);
+    prePassBarrier(impl, comp, comp | ind, acc);
+    });
+  implMeshPrePass(meshEmu.mesh, [&]() {
+    prePassBarrier(impl, comp, comp | ind, acc);
+    });
+  }
+
+void VCommandBuffer::endMeshEmulation() {
+  auto& helper = *device.meshHelper;
+
+  const VkPipelineStageFlags comp = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  const VkAccessFlags        acc  = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  if(meshEmu.hasTask) {
+    implMeshPrePass(meshEmu.task, [&]() {
+      prePassBarrier(impl, comp, comp, acc);
+      dispatchBuiltin(*helper.taskPost.handler, 1);
+      prePassBarrier(impl, comp, comp, acc);
+      dispatchBuiltin(*helper.taskLut.handler, VMeshletHelper::WorkGroups);
+      });
+    }
+  implMeshPrePass(meshEmu.mesh, [&]() {
+    prePassBarrier(impl, comp, comp, acc);
+    dispatchBuiltin(*helper.prefix.handler, 1);
+    prePassBarrier(impl, comp, comp, acc);
+    dispatchBuiltin(*helper.compactage.handler, VMeshletHelper::WorkGroups);
+    prePassBarrier(impl, comp,
+                   VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
+                   VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+    });
+
+  // pre-passes are executed right before the render-pass: flush above already went to previous chunk
+  Chunk task, mesh;
+  task.impl = meshEmu.task;
+  mesh.impl = meshEmu.mesh;
+  chunks.push(task);
+  chunks.push(mesh);
+
+  meshEmu.task      = nullptr;
+  meshEmu.mesh      = nullptr;
+  meshEmu.drawCount = 0;
+  meshEmu.hasTask   = false;
+  }
+
+void VCommandBuffer::bindMeshEmulation(VkDeviceSize cmdOffset) {
+  setBinding(VMeshletHelper::IndirectSlot, &meshEmu.indirect, size_t(cmdOffset));
+  setBinding(VMeshletHelper::MeshletSlot,  &meshEmu.meshlets, 0);
+  setBinding(VMeshletHelper::ScratchSlot,  &meshEmu.scratch,  0);
+  }
+
+void VCommandBuffer::dispatchBuiltin(VCompPipeline& pso, size_t x) {
+  const uint32_t push[2] = {device.meshHelper->indirectRate(), meshEmu.drawCount};
+  setComputePipeline(pso);
+  setBinding(0, &meshEmu.indirect, 0);
+  setBinding(1, &meshEmu.meshlets, 0);
+  setBinding(2, &meshEmu.scratch,  0);
+  setPushData(push, sizeof(push));
+  implSetUniforms(PipelineStage::S_Compute);
+  implSetPushData(PipelineStage::S_Compute);
+  vkCmdDispatch(impl, uint32_t(x), 1, 1);
+  }
+
+void VCommandBuffer::bindIbo(const VBuffer& ibo, Detail::IndexClass cls) {
+  // pooled geometry shares buffer across draws: see GeometryPool
+  const VkIndexType type = nativeFormat(cls);
+  if(curIbo==ibo.impl && curIboType==type)
+    return;
+  vkCmdBindIndexBuffer(impl, ibo.impl, 0, type);
+  curIbo     = ibo.impl;
+  curIboType = type;
+  }
+
 void VCommandBuffer::bindVbo(const VBuffer& vbo, size_t stride) {
   if(curVbo!=vbo.impl) {
     VkBuffer     buffers[1] = {vbo.impl};
@@ -702,14 +996,56 @@ void VCommandBuffer::bindVbo(const VBuffer& vbo, size_t stride) {
     vkCmdBindVertexBuffers(impl, 0, 1, buffers, offsets);
     curVbo = vbo.impl;
     }
-  if(T_UNLIKELY(vboStride!=stride)) {
-    vboStride      = stride;
-    bindings.durty = true;
-    pipelineLayout = VK_NULL_HANDLE; // maybe need to rebuild pso
+  // previous input may differ in any field: formats, per-stream strides, instance mask
+  VPipeline::VertexInput vin;
+  vin.stride[0] = uint32_t(stride);
+  setVertexInput(vin);
+  }
+
+void VCommandBuffer::setVertexStreams(const VertexStream* vbo, size_t count) {
+  beginInline();
+  VkBuffer               buffers[MaxVertexStreams] = {};
+  VkDeviceSize           offsets[MaxVertexStreams] = {};
+  VPipeline::VertexInput vin;
+  uint32_t               numFormats = 0;
+  vin.count = uint8_t(count);
+  for(size_t i=0; i<count; ++i) {
+    buffers[i]     = reinterpret_cast<const VBuffer*>(vbo[i].vbo)->impl;
+    offsets[i]     = VkDeviceSize(vbo[i].offset);
+    vin.stride[i]  = uint32_t(vbo[i].stride);
+    vin.attribs[i] = vbo[i].formatSize;
+    if(vbo[i].rate==InputRate::PerInstance)
+      vin.instance |= uint8_t(1u << i);
+    for(uint32_t r=0; r<vbo[i].formatSize && numFormats<MaxVertexAttribs; ++r) {
+      vin.format[numFormats] = vbo[i].format[r];
+      ++numFormats;
+      }
+    }
+  vkCmdBindVertexBuffers(impl, 0, uint32_t(count), buffers, offsets);
+  // binding 0 is not at offset 0 anymore
+  curVbo = VK_NULL_HANDLE;
+  setVertexInput(vin);
+  }
+
+void VCommandBuffer::setVertexInput(const VPipeline::VertexInput& vin) {
+  if(vboInput==vin)
+    return;
+  vboInput       = vin;
+  bindings.durty = true;
+  pipelineLayout = VK_NULL_HANDLE; // maybe need to rebuild pso
+
+  if(device.props.hasDescriptorHeap && curDrawPipeline!=nullptr) {
+    // no layout switch with descriptor heap: pso is rebound right away
+    auto rp   = (passRp!=nullptr ? passRp->pass : VK_NULL_HANDLE);
+    auto inst = curDrawPipeline->instance(passDyn, rp, VK_NULL_HANDLE, vboInput);
+    vkCmdBindPipeline(impl, VK_PIPELINE_BIND_POINT_GRAPHICS, inst);
     }
   }
 
 void VCommandBuffer::setViewport(const Tempest::Rect &r) {
+  beginState();
+  curViewport = r;
+
   VkViewport viewPort = {};
   viewPort.x        = float(r.x);
   viewPort.y        = float(r.y);
@@ -722,12 +1058,93 @@ void VCommandBuffer::setViewport(const Tempest::Rect &r) {
   }
 
 void VCommandBuffer::setScissor(const Rect& r) {
+  beginState();
+  curScissor = r;
+
   VkRect2D scissor = {};
   scissor.offset = {r.x, r.y};
   scissor.extent = {uint32_t(r.w), uint32_t(r.h)};
   vkCmdSetScissor(impl,0,1,&scissor);
   }
 
+void VCommandBuffer::setCullMode(RenderState::CullMode cull) {
+  if(!device.props.hasExtDynState)
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  beginState();
+  dynState.setCullFaceMode(cull);
+  device.vkCmdSetCullMode(impl, nativeFormat(cull));
+  }
+
+void VCommandBuffer::setDepthTest(RenderState::ZTestMode z) {
+  if(!device.props.hasExtDynState)
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  beginState();
+  dynState.setZTestMode(z);
+  applyDepthState();
+  }
+
+void VCommandBuffer::setDepthWrite(bool enable) {
+  if(!device.props.hasExtDynState)
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  beginState();
+  dynState.setZWriteEnabled(enable);
+  applyDepthState();
+  }
+
+void VCommandBuffer::setBlend(RenderState::BlendMode src, RenderState::BlendMode dst, RenderState::BlendOp op) {
+  if(!device.props.hasExtDynState3)
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension);
+  beginState();
+  dynState.setBlendSource(src);
+  dynState.setBlendDest(dst);
+  dynState.setBlendOp(op);
+  applyBlendState();
+  }
+
+void VCommandBuffer::applyRenderState(const RenderState& st) {
+  // pipelines don't carry dynamic state: restore state of pipeline on each bind
+  dynState = st;
+  if(device.props.hasExtDynState) {
+    device.vkCmdSetCullMode(impl, nativeFormat(st.cullFaceMode()));
+    applyDepthState();
+    }
+  if(device.props.hasExtDynState3) {
+    applyBlendState();
+    }
+  }
+
+void VCommandBuffer::applyDepthState() {
+  const auto z    = dynState.zTestMode();
+  const bool zw   = dynState.isZWriteEnabled();
+  // Spec: Depth writes are always disabled when depthTestEnable is VK_FALSE.
+  const bool test = (z!=RenderState::ZTestMode::Always) || zw;
+  device.vkCmdSetDepthTestEnable (impl, test ? VK_TRUE : VK_FALSE);
+  device.vkCmdSetDepthWriteEnable(impl, zw   ? VK_TRUE : VK_FALSE);
+  device.vkCmdSetDepthCompareOp  (impl, nativeFormat(z));
+  }
+
+void VCommandBuffer::applyBlendState() {
+  const uint32_t cnt = passDyn.colorAttachmentCount;
+  if(cnt==0)
+    return;
+
+  VkBool32                enable[MaxFramebufferAttachments] = {};
+  VkColorBlendEquationEXT eq    [MaxFramebufferAttachments] = {};
+  for(uint32_t i=0; i<cnt; ++i) {
+    enable[i] = dynState.hasBlend() ? VK_TRUE : VK_FALSE;
+
+    auto& e = eq[i];
+    e.srcColorBlendFactor = nativeFormat(dynState.blendSource());
+    e.dstColorBlendFactor = nativeFormat(dynState.blendDest());
+    e.colorBlendOp        = nativeFormat(dynState.blendOperation());
+    e.srcAlphaBlendFactor = e.srcColorBlendFactor;
+    e.dstAlphaBlendFactor = e.dstColorBlendFactor;
+    e.alphaBlendOp        = e.colorBlendOp;
+    }
+  device.vkCmdSetColorBlendEnable  (impl, 0, cnt, enable);
+  device.vkCmdSetColorBlendEquation(impl, 0, cnt, eq);
+  }
+
 void VCommandBuffer::setDebugMarker(std::string_view tag) {
   if(isDbgRegion) {
     device.vkCmdDebugMarkerEnd(impl);
@@ -920,29 +1337,91 @@ void VCommandBuffer::blit(AbstractGraphicsApi::Texture& srcTex, uint32_t srcW, u
                  filter);
   }
 
-void VCommandBuffer::buildBlas(VkAccelerationStructureKHR dest, AbstractGraphicsApi::Buffer& bbo,
-                               AbstractGraphicsApi::BlasBuildCtx& rtctx, AbstractGraphicsApi::Buffer& scratch) {
-  auto& ctx = reinterpret_cast<VBlasBuildCtx&>(rtctx);
+void VCommandBuffer::updateTlas(AbstractGraphicsApi::AccelerationStructure& as, const RtInstance* inst,
+                                AbstractGraphicsApi::AccelerationStructure* const* blas, size_t count) {
+  auto& tlas = reinterpret_cast<VTopAccelerationStructure&>(as);
+  if(count>tlas.capacity)
+    throw std::system_error(Tempest::GraphicsErrc::TooLargeBuffer, "updateTlas: instance count exceeds size of tlas");
+  if(tlas.capacity==0)
+    return;
+
+  // blas addresses are final only after build (and compaction)
+  if(device.blasBatch!=nullptr)
+    device.blasBatch->flush(blas, count);
+
+  // instances are written inline into command buffer: no staging memory per update
+  // unused tail is filled by disabled instances, so primitive count of tlas never changes
+  // and refit is valid regardless of order, in which command buffers are recorded or submitted
+  VkAccelerationStructureInstanceKHR disabled = {};
+  disabled.accelerationStructureReference = reinterpret_cast<const VAccelerationStructure*>(tlas.padding.handler)->toDeviceAddress(device);
+  disabled.mask                           = 0;
+
+  VkAccelerationStructureInstanceKHR chunk[256] = {};
+  for(size_t i=0; i<tlas.capacity; i+=std::size(chunk)) {
+    const size_t n = std::min<size_t>(tlas.capacity-i, std::size(chunk));
+    for(size_t r=0; r<n; ++r)
+      chunk[r] = (i+r<count) ? VTopAccelerationStructure::toVkInstance(device, inst[i+r], blas[i+r]) : disabled;
+    copy(*tlas.instances.handler, i*sizeof(chunk[0]), chunk, n*sizeof(chunk[0]));
+    }
 
+  // full set of instances is refitted, partial one is rebuilt for better tree quality
+  const bool refit = (count==tlas.capacity);
+  buildTlas(tlas.impl, tlas.data, tlas.instances.handler, tlas.capacity, *tlas.scratch.handler, refit);
+  }
+
+void VCommandBuffer::buildBlas(VAccelerationStructure* const* dest, const VBlasBuildCtx* const* ctx, size_t count,
+                               AbstractGraphicsApi::Buffer& scratch) {
   // make sure BLAS'es are ready
-  resState.onUavUsage(NonUniqResId::I_None, reinterpret_cast<const VBuffer&>(bbo).nonUniqId, PipelineStage::S_RtAs);
+  for(size_t i=0; i<count; ++i)
+    resState.onUavUsage(NonUniqResId::I_None, dest[i]->data.nonUniqId, PipelineStage::S_RtAs);
   resState.flush(*this);
 
-  VkAccelerationStructureBuildRangeInfoKHR* pbuildRangeInfo = ctx.ranges.data();
-  auto buildGeometryInfo = ctx.buildCmd(device, dest, &reinterpret_cast<VBuffer&>(scratch));
-  device.vkCmdBuildAccelerationStructures(impl, 1, &buildGeometryInfo, &pbuildRangeInfo);
+  // all builds of batch are independent: each one has own range in scratch buffer
+  std::vector<VkAccelerationStructureBuildGeometryInfoKHR>     info (count);
+  std::vector<const VkAccelerationStructureBuildRangeInfoKHR*> range(count);
+  for(size_t i=0; i<count; ++i) {
+    info [i] = ctx[i]->buildCmd(device, dest[i]->impl, &reinterpret_cast<VBuffer&>(scratch));
+    range[i] = ctx[i]->ranges.data();
+    }
+  device.vkCmdBuildAccelerationStructures(impl, uint32_t(count), info.data(), range.data());
+  }
+
+void VCommandBuffer::queryBlasCompactedSize(VAccelerationStructure* const* as, size_t count, VkQueryPool pool) {
+  blasBuildBarrier(impl);
+
+  std::vector<VkAccelerationStructureKHR> handle(count);
+  for(size_t i=0; i<count; ++i)
+    handle[i] = as[i]->impl;
+
+  vkCmdResetQueryPool(impl, pool, 0, uint32_t(count));
+  device.vkCmdWriteAccelerationStructuresProperties(impl, uint32_t(count), handle.data(),
+                                                    VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, pool, 0);
+  }
+
+void VCommandBuffer::compactBlas(VAccelerationStructure* const* dest, VAccelerationStructure* const* src, size_t count) {
+  // source blas'es are built by previous submit
+  blasBuildBarrier(impl);
+
+  for(size_t i=0; i<count; ++i) {
+    VkCopyAccelerationStructureInfoKHR cpy = {};
+    cpy.sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR;
+    cpy.src   = src[i]->impl;
+    cpy.dst   = dest[i]->impl;
+    cpy.mode  = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+    device.vkCmdCopyAccelerationStructure(impl, &cpy);
+    }
   }
 
 void VCommandBuffer::buildTlas(VkAccelerationStructureKHR dest,
                                AbstractGraphicsApi::Buffer& tbo,
-                               const AbstractGraphicsApi::Buffer& instances, uint32_t numInstances,
-                               AbstractGraphicsApi::Buffer& scratch) {
+                               const AbstractGraphicsApi::Buffer* instances, uint32_t numInstances,
+                               AbstractGraphicsApi::Buffer& scratch, bool update) {
   VkAccelerationStructureGeometryInstancesDataKHR geometryInstancesData = {};
   geometryInstancesData.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
   geometryInstancesData.pNext                 = NULL;
   geometryInstancesData.arrayOfPointers       = VK_FALSE;
   if(numInstances>0)
-    geometryInstancesData.data.deviceAddress  = reinterpret_cast<const VBuffer&>(instances).toDeviceAddress(device);
+    geometryInstancesData.data.deviceAddress  = reinterpret_cast<const VBuffer*>(instances)->toDeviceAddress(device);
 
   VkAccelerationStructureGeometryKHR geometry = {};
   geometry.sType                              = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
@@ -956,8 +1435,8 @@ void VCommandBuffer::buildTlas(VkAccelerationStructureKHR dest,
   buildGeometryInfo.pNext                     = nullptr;
   buildGeometryInfo.type                      = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
   buildGeometryInfo.flags                     = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
-  buildGeometryInfo.mode                      = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
-  buildGeometryInfo.srcAccelerationStructure  = VK_NULL_HANDLE;
+  buildGeometryInfo.mode                      = update ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+  buildGeometryInfo.srcAccelerationStructure  = update ? dest : VK_NULL_HANDLE;
   buildGeometryInfo.dstAccelerationStructure  = dest;
   buildGeometryInfo.geometryCount             = 1;
   buildGeometryInfo.pGeometries               = &geometry;
@@ -971,7 +1450,8 @@ void VCommandBuffer::buildTlas(VkAccelerationStructureKHR dest,
   buildRangeInfo.transformOffset              = 0;
 
   // make sure TLAS is ready
-  resState.onUavUsage(NonUniqResId::I_None, reinterpret_cast<const VBuffer&>(tbo).nonUniqId, PipelineStage::S_RtAs);
+  const NonUniqResId instId = (instances!=nullptr) ? reinterpret_cast<const VBuffer*>(instances)->nonUniqId : NonUniqResId::I_None;
+  resState.onUavUsage(instId, reinterpret_cast<const VBuffer&>(tbo).nonUniqId, PipelineStage::S_RtAs);
   resState.flush(*this);
 
   VkAccelerationStructureBuildRangeInfoKHR* pbuildRangeInfo = &buildRangeInfo;
@@ -1096,22 +1576,8 @@ void VCommandBuffer::barrier(const AbstractGraphicsApi::SyncDesc& s, const Abstr
   auto cmd = impl;
   if(state==RenderPass) {
     if(chunks.size()==0) {
-      VkCommandBuffer cmdBuf = nullptr;
-      VkCommandBufferAllocateInfo allocInfo = {};
-      allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-      allocInfo.commandPool        = pool.impl;
-      allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-      allocInfo.commandBufferCount = 1;
-      vkAssert(vkAllocateCommandBuffers(device.device.impl,&allocInfo,&cmdBuf));
-
-      VkCommandBufferBeginInfo beginInfo = {};
-      beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-      beginInfo.flags            = 0;
-      beginInfo.pInheritanceInfo = nullptr;
-      vkAssert(vkBeginCommandBuffer(cmdBuf,&beginInfo));
-
       Chunk ch;
-      ch.impl = cmdBuf;
+      ch.impl = allocChunk();
       chunks.push(ch);
       }
     cmd = chunks.last().impl;
@@ -1120,15 +1586,17 @@ void VCommandBuffer::barrier(const AbstractGraphicsApi::SyncDesc& s, const Abstr
                        memCount, &memBarrier, bufCount, bufBarrier, imgCount, imgBarrier);
   }
 
-void VCommandBuffer::vkCmdBeginRenderingKHR(VkCommandBuffer impl, const VkRenderingInfo* info) {
+void VCommandBuffer::vkCmdBeginRenderingKHR(VkCommandBuffer impl, const VkRenderingInfo* info, bool secondary) {
   if(device.props.hasDynRendering) {
-    device.vkCmdBeginRenderingKHR(impl,info);
+    VkRenderingInfo rinfo = *info;
+    if(secondary)
+      rinfo.flags |= VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+    device.vkCmdBeginRenderingKHR(impl,&rinfo);
     return;
     }
 
-  auto fbo = device.fboMap.find(info, &passDyn);
-  auto fb  = fbo.get();
-  passRp   = fbo->pass;
+  // framebuffer is looked up by beginRendering
+  auto fb = fboRefs.back().get();
 
   VkClearValue clr[MaxFramebufferAttachments];
   for(size_t i=0; i<info->colorAttachmentCount; ++i) {
@@ -1148,7 +1616,7 @@ void VCommandBuffer::vkCmdBeginRenderingKHR(VkCommandBuffer impl, const VkRender
   rinfo.clearValueCount   = info->colorAttachmentCount + (info->pDepthAttachment!=nullptr ? 1 : 0);
   rinfo.pClearValues      = clr;
 
-  vkCmdBeginRenderPass(impl, &rinfo, VK_SUBPASS_CONTENTS_INLINE);
+  vkCmdBeginRenderPass(impl, &rinfo, secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
   }
 
 void VCommandBuffer::vkCmdEndRenderingKHR(VkCommandBuffer impl) {
@@ -1170,24 +1638,121 @@ void VCommandBuffer::pushChunk() {
 
 void VCommandBuffer::newChunk() {
   pushChunk();
+  impl = allocChunk();
+
+  curVbo         = VK_NULL_HANDLE;
+  curIbo         = VK_NULL_HANDLE;
+  pushData.durty = true;
+  bindings.durty = true;
+  pushDescriptors.onNextCmdChunk();
+  }
 
-  VkCommandBufferAllocateInfo allocInfo = {};
-  allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocInfo.commandPool        = pool.impl;
-  allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandBufferCount = 1;
-  vkAssert(vkAllocateCommandBuffers(device.device.impl,&allocInfo,&impl));
+VkCommandBuffer VCommandBuffer::allocChunk() {
+  VkCommandBuffer cmd = pool.alloc();
 
   VkCommandBufferBeginInfo beginInfo = {};
   beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   beginInfo.flags            = 0;
   beginInfo.pInheritanceInfo = nullptr;
-  vkAssert(vkBeginCommandBuffer(impl,&beginInfo));
+  vkAssert(vkBeginCommandBuffer(cmd,&beginInfo));
+  return cmd;
+  }
+
+VkCommandBuffer VCommandBuffer::beginSecondary(VkCommandBufferUsageFlags flags) {
+  VkCommandBuffer cmd = pool.allocSecondary();
+
+  VkCommandBufferInheritanceRenderingInfoKHR rinfo = {};
+  rinfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+  rinfo.viewMask                = passDyn.viewMask;
+  rinfo.colorAttachmentCount    = passDyn.colorAttachmentCount;
+  rinfo.pColorAttachmentFormats = passDyn.colorFrm;
+  rinfo.depthAttachmentFormat   = passDyn.depthAttachmentFormat;
+  rinfo.rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT;
+
+  VkCommandBufferInheritanceInfo inherit = {};
+  inherit.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  if(device.props.hasDynRendering) {
+    inherit.pNext = &rinfo;
+    } else {
+    inherit.renderPass = passRp->pass;
+    inherit.subpass    = 0;
+    }
+
+  VkCommandBufferBeginInfo beginInfo = {};
+  beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags            = flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  beginInfo.pInheritanceInfo = &inherit;
+  vkAssert(vkBeginCommandBuffer(cmd,&beginInfo));
+  return cmd;
+  }
+
+void VCommandBuffer::beginPass(PassContents c) {
+  // content of render-pass is fixed by first command in it: inline draw or bundle
+  vkCmdBeginRenderingKHR(impl, &passBegin.info, c==P_Secondary);
+  passContents = c;
+  if(c==P_Secondary)
+    passCmd = impl;
+  }
+
+void VCommandBuffer::implBeginInline() {
+  if(passContents==P_Pending) {
+    beginPass(P_Inline);
+    return;
+    }
+  if(passContents!=P_Secondary || impl!=passCmd)
+    return;
+  // render-pass accepts only secondary command buffers: draws are recorded into one, until next bundle
+  impl = beginSecondary(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+  restoreState();
+  }
+
+void VCommandBuffer::flushInline() {
+  if(passCmd==nullptr || impl==passCmd)
+    return;
+  vkAssert(vkEndCommandBuffer(impl));
+  vkCmdExecuteCommands(passCmd, 1, &impl);
+  impl = passCmd;
+  }
 
+void VCommandBuffer::restoreState() {
+  // secondary command buffer doesn't inherit any state
   curVbo         = VK_NULL_HANDLE;
+  curIbo         = VK_NULL_HANDLE;
+  pipelineLayout = VK_NULL_HANDLE;
   pushData.durty = true;
   bindings.durty = true;
   pushDescriptors.onNextCmdChunk();
+
+  setViewport(curViewport);
+  setScissor (curScissor);
+  if(curDrawPipeline==nullptr)
+    return;
+
+  const RenderState st = dynState;
+  applyRenderState(st);
+  if(device.props.hasDescriptorHeap) {
+    auto rp   = (passRp!=nullptr ? passRp->pass : VK_NULL_HANDLE);
+    auto inst = curDrawPipeline->instance(passDyn, rp, VK_NULL_HANDLE, vboInput);
+    vkCmdBindPipeline(impl, VK_PIPELINE_BIND_POINT_GRAPHICS, inst);
+    }
+  }
+
+bool VCommandBuffer::execute(AbstractGraphicsApi::CommandBuffer& ibundle) {
+  auto& bundle = reinterpret_cast<VCommandBundle&>(ibundle);
+  if(passContents==P_Inline)
+    return false; // render-pass was started with inline draws
+  if(passContents==P_Pending)
+    beginPass(P_Secondary);
+  flushInline();
+
+  vkCmdExecuteCommands(impl, 1, &bundle.cmd);
+  // barriers for resources of bundle are resolved at render-pass boundary, like for regular draws
+  bindings.read  |= bundle.read;
+  bindings.write |= bundle.write;
+  bindings.host  |= bundle.host;
+  if(bundle.indirect!=NonUniqResId::I_None)
+    resState.onUavUsage(bundle.indirect, NonUniqResId::I_None, PipelineStage::S_Indirect);
+  return true;
   }
 
 template<class T>
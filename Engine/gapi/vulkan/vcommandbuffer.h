@@ -3,14 +3,18 @@
 #include <Tempest/AbstractGraphicsApi>
 #include "vulkan_sdk.h"
 
+#include "gapi/vulkan/vbuffer.h"
 #include "gapi/vulkan/vcommandpool.h"
 #include "gapi/vulkan/vframebuffermap.h"
+#include "gapi/vulkan/vpipeline.h"
 #include "gapi/vulkan/vpushdescriptor.h"
 #include "gapi/vulkan/vswapchain.h"
+#include "gapi/vulkan/vuniformring.h"
 #include "gapi/resourcestate.h"
 #include "gapi/shaderreflection.h"
 
 #include "../utility/smallarray.h"
+#include "../utility/compiller_hints.h"
 
 namespace Tempest {
 namespace Detail {
@@ -22,6 +26,8 @@ class VPipeline;
 class VCompPipeline;
 class VBuffer;
 class VTexture;
+class VAccelerationStructure;
+struct VBlasBuildCtx;
 
 class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
   public:
@@ -34,7 +40,7 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
       };
 
     VCommandBuffer()=delete;
-    VCommandBuffer(VDevice &device, VkCommandPoolCreateFlags flags=VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VCommandBuffer(VDevice &device, VkCommandPoolCreateFlags flags=0);
     ~VCommandBuffer();
 
     void reset() override;
@@ -43,6 +49,7 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void begin() override;
     void end() override;
     bool isRecording() const override;
+    CommandBufferStats stats() const override;
 
     void beginRendering(const Detail::FrameBufferDesc& fbo, size_t fboSize, uint32_t w, uint32_t h) override;
     void endRendering() override;
@@ -51,16 +58,30 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void setScissor (const Rect& r) override;
     void setDebugMarker(std::string_view tag) override;
 
+    void setCullMode  (RenderState::CullMode cull) override;
+    void setDepthTest (RenderState::ZTestMode z) override;
+    void setDepthWrite(bool enable) override;
+    void setBlend     (RenderState::BlendMode src, RenderState::BlendMode dst, RenderState::BlendOp op) override;
+
     void setPipeline(AbstractGraphicsApi::Pipeline& p) override;
     void setComputePipeline(AbstractGraphicsApi::CompPipeline& p) override;
 
     void setPushData(const void* data, size_t size) override;
+    void pushUniform(size_t id, const void* data, size_t size) override;
     void setBinding (size_t id, AbstractGraphicsApi::Texture*   tex, uint32_t mipLevel, const ComponentMapping& m, const Sampler& smp) override;
     void setBinding (size_t id, AbstractGraphicsApi::Buffer*    buf, size_t offset) override;
     void setBinding (size_t id, AbstractGraphicsApi::DescArray* arr) override;
     void setBinding (size_t id, AbstractGraphicsApi::AccelerationStructure* tlas) override;
     void setBinding (size_t id, const Sampler& smp) override;
+    void setAddressUsage(const AbstractGraphicsApi::Buffer* const* read,  size_t nread,
+                         const AbstractGraphicsApi::Buffer* const* write, size_t nwrite) override;
+
+    void updateTlas (AbstractGraphicsApi::AccelerationStructure& tlas, const RtInstance* inst,
+                     AbstractGraphicsApi::AccelerationStructure* const* blas, size_t count) override;
 
+    bool execute(AbstractGraphicsApi::CommandBuffer& bundle) override;
+
+    void setVertexStreams(const VertexStream* vbo, size_t count) override;
     void draw       (const AbstractGraphicsApi::Buffer* vbo, size_t stride, size_t voffset, size_t vsize, size_t firstInstance, size_t instanceCount) override;
     void drawIndexed(const AbstractGraphicsApi::Buffer* vbo, size_t stride, size_t voffset,
                      const AbstractGraphicsApi::Buffer& ibo, Detail::IndexClass cls,
@@ -87,12 +108,14 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void fill(AbstractGraphicsApi::Texture& dest, uint32_t val);
     void fill(AbstractGraphicsApi::Buffer&  dest, size_t offsetDest, uint32_t val, size_t size);
 
-    void buildBlas(VkAccelerationStructureKHR dest, AbstractGraphicsApi::Buffer& bbo,
-                   AbstractGraphicsApi::BlasBuildCtx& ctx, AbstractGraphicsApi::Buffer& scratch);
+    void buildBlas(VAccelerationStructure* const* dest, const VBlasBuildCtx* const* ctx, size_t count,
+                   AbstractGraphicsApi::Buffer& scratch);
+    void queryBlasCompactedSize(VAccelerationStructure* const* as, size_t count, VkQueryPool pool);
+    void compactBlas(VAccelerationStructure* const* dest, VAccelerationStructure* const* src, size_t count);
 
     void buildTlas(VkAccelerationStructureKHR dest, AbstractGraphicsApi::Buffer& tbo,
-                   const AbstractGraphicsApi::Buffer& instances, uint32_t numInstances,
-                   AbstractGraphicsApi::Buffer& scratch);
+                   const AbstractGraphicsApi::Buffer* instances, uint32_t numInstances,
+                   AbstractGraphicsApi::Buffer& scratch, bool update);
 
     struct Chunk {
       VkCommandBuffer impl = nullptr;
@@ -101,9 +124,15 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     std::vector<VSwapchain::Sync*> swapchainSync;
 
   protected:
+    enum PassContents : uint8_t {
+      P_Pending,   // vkCmdBeginRendering is deferred until first draw or bundle
+      P_Inline,
+      P_Secondary, // render-pass executes bundles; draws are recorded into secondary command buffer
+      };
+
     void addDependency(VSwapchain& s, size_t imgId);
     void vkCmdPipelineBarrier2(VkCommandBuffer impl, const VkDependencyInfoKHR* info);
-    void vkCmdBeginRenderingKHR(VkCommandBuffer impl, const VkRenderingInfo* info);
+    void vkCmdBeginRenderingKHR(VkCommandBuffer impl, const VkRenderingInfo* info, bool secondary);
     void vkCmdEndRenderingKHR(VkCommandBuffer impl);
 
     void blit(AbstractGraphicsApi::Texture& src, uint32_t srcW, uint32_t srcH, uint32_t srcMip,
@@ -114,16 +143,46 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
 
     void pushChunk();
     void newChunk();
+    VkCommandBuffer allocChunk();
+    VkCommandBuffer beginSecondary(VkCommandBufferUsageFlags flags);
+
+    void beginInline() { if(T_UNLIKELY(passContents!=P_Inline)) implBeginInline(); }
+    void beginState()  { if(T_UNLIKELY(passContents==P_Secondary)) implBeginInline(); }
+    void implBeginInline();
+    void beginPass(PassContents c);
+    void flushInline();
+    void restoreState();
+
+    void emulatedDispatchMesh(size_t x, size_t y, size_t z, const VBuffer* indirect, size_t offset);
+    void beginMeshEmulation();
+    void endMeshEmulation();
+    void bindMeshEmulation(VkDeviceSize cmdOffset);
+    void dispatchBuiltin(VCompPipeline& pso, size_t x);
+    template<class Fn>
+    void implMeshPrePass(VkCommandBuffer cmd, Fn&& fn);
+
+    void applyRenderState(const RenderState& st);
+    void applyDepthState();
+    void applyBlendState();
 
     void bindVbo(const VBuffer& vbo, size_t stride);
+    void bindIbo(const VBuffer& ibo, Detail::IndexClass cls);
+    void setVertexInput(const VPipeline::VertexInput& vin);
     void implSetUniforms(const PipelineStage st);
     void implSetPushData(const PipelineStage st);
     void handleSync(const ShaderReflection::LayoutDesc& lay, const ShaderReflection::SyncDesc& sync, PipelineStage st);
+    void retainBindless(std::shared_ptr<void> ref);
 
     struct PipelineInfo:VkPipelineRenderingCreateInfoKHR {
       VkFormat colorFrm[MaxFramebufferAttachments];
       };
 
+    struct PassBegin {
+      VkRenderingAttachmentInfoKHR color[MaxFramebufferAttachments] = {};
+      VkRenderingAttachmentInfoKHR depth = {};
+      VkRenderingInfoKHR           info  = {};
+      };
+
     struct Push {
       uint8_t            data[256] = {};
       uint8_t            size      = 0;
@@ -135,6 +194,26 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
       NonUniqResId write = NonUniqResId::I_None;
       bool         host  = false;
       bool         durty = false;
+
+      // slots, filled by pushUniform, and size of pushed data
+      uint32_t     pushed = 0;
+      uint32_t     pushSz[MaxBindings] = {};
+
+      // buffers, accessed through device address; see setAddressUsage
+      NonUniqResId addrRead  = NonUniqResId::I_None;
+      NonUniqResId addrWrite = NonUniqResId::I_None;
+      bool         addrHost  = false;
+      };
+
+    struct MeshEmu {
+      VkCommandBuffer task      = nullptr; // pre-pass: mesh_init, task shaders, task lut
+      VkCommandBuffer mesh      = nullptr; // pre-pass: mesh shaders, prefix sum, compactage
+      uint32_t        drawCount = 0;
+      bool            hasTask   = false;
+
+      VBuffer         indirect;
+      VBuffer         meshlets;
+      VBuffer         scratch;
       };
 
     VDevice&                                device;
@@ -143,18 +222,30 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
 
     ResourceState                           resState;
     std::shared_ptr<VFramebufferMap::RenderPass> passRp;
+    std::vector<std::shared_ptr<VFramebufferMap::Fbo>> fboRefs; // keep framebuffers alive, while recorded
+    std::vector<std::shared_ptr<void>>      bindlessRefs;           // keep descriptor-array state alive, while recorded
     PipelineInfo                            passDyn = {};
+    PassBegin                               passBegin;
+    PassContents                            passContents = P_Pending;
+    VkCommandBuffer                         passCmd      = nullptr; // primary chunk of render-pass with secondary contents
+    Rect                                    curViewport;
+    Rect                                    curScissor;
 
     Push                                    pushData;
     Bindings                                bindings;
     VPushDescriptor                         pushDescriptors;
+    VUniformRing                            uboRing;
+    MeshEmu                                 meshEmu;
 
     RpState                                 state           = NoRecording;
     VPipeline*                              curDrawPipeline = nullptr;
     VCompPipeline*                          curCompPipeline = nullptr;
     VkBuffer                                curVbo          = VK_NULL_HANDLE;
-    size_t                                  vboStride       = 0;
+    VkBuffer                                curIbo          = VK_NULL_HANDLE;
+    VkIndexType                             curIboType      = VK_INDEX_TYPE_UINT16;
+    VPipeline::VertexInput                  vboInput;
     VkPipelineLayout                        pipelineLayout  = VK_NULL_HANDLE;
+    RenderState                             dynState; // extended dynamic state, see VkProps::hasExtDynState
 
     bool                                    isDbgRegion = false;
   };
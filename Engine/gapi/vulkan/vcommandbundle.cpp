@@ -0,0 +1,101 @@
+#if defined(TEMPEST_BUILD_VULKAN)
+
+#include "vcommandbundle.h"
+
+#include "vdevice.h"
+#include "vtexture.h"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+VCommandBundle::VCommandBundle(VDevice& device, const FrameBufferDesc& fbo, size_t fboSize, uint32_t w, uint32_t h)
+  :VCommandBuffer(device), width(w), height(h) {
+  VkRenderingAttachmentInfoKHR colorAtt[MaxFramebufferAttachments] = {};
+  VkRenderingAttachmentInfoKHR depthAtt = {};
+
+  VkRenderingInfoKHR info = {};
+  info.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+  info.renderArea.extent    = {w,h};
+  info.layerCount           = 1;
+  info.pColorAttachments    = colorAtt;
+
+  passDyn.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+  passDyn.pNext                   = nullptr;
+  passDyn.viewMask                = 0;
+  passDyn.colorAttachmentCount    = 0;
+  passDyn.pColorAttachmentFormats = passDyn.colorFrm;
+  passDyn.depthAttachmentFormat   = VK_FORMAT_UNDEFINED;
+
+  for(size_t i=0; i<fboSize; ++i) {
+    VkFormat frm = VK_FORMAT_UNDEFINED;
+    if(fbo.sw[i]!=nullptr)
+      frm = reinterpret_cast<VSwapchain*>(fbo.sw[i])->format(); else
+      frm = reinterpret_cast<VTexture*>(fbo.att[i])->format;
+
+    // load/store ops don't affect render-pass compatibility
+    auto& att = isDepthFormat(fbo.frm[i]) ? depthAtt : colorAtt[info.colorAttachmentCount];
+    att.sType   = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    att.loadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
+    att.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    if(isDepthFormat(fbo.frm[i])) {
+      att.imageLayout               = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+      info.pDepthAttachment         = &att;
+      passDyn.depthAttachmentFormat = frm;
+      } else {
+      att.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      passDyn.colorFrm[info.colorAttachmentCount] = frm;
+      ++info.colorAttachmentCount;
+      }
+    }
+  passDyn.colorAttachmentCount = info.colorAttachmentCount;
+
+  if(!device.props.hasDynRendering)
+    passRp = device.fboMap.findRenderpass(&info, &passDyn);
+  }
+
+void VCommandBundle::begin(SyncHint) {
+  begin();
+  }
+
+void VCommandBundle::begin() {
+  reset();
+  curDrawPipeline = nullptr;
+  curVbo          = VK_NULL_HANDLE;
+  curIbo          = VK_NULL_HANDLE;
+  pushData.size   = 0;
+  pushData.durty  = true;
+
+  cmd      = nullptr;
+  indirect = NonUniqResId::I_None;
+
+  // bundle is a body of render-pass: no barriers, no pass begin/end
+  state        = RenderPass;
+  passContents = P_Inline;
+  impl         = beginSecondary(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+
+  setViewport(Rect(0,0,int32_t(width),int32_t(height)));
+  setScissor (Rect(0,0,int32_t(width),int32_t(height)));
+  }
+
+void VCommandBundle::end() {
+  uboRing.flush();
+  vkAssert(vkEndCommandBuffer(impl));
+
+  cmd   = impl;
+  read  = bindings.read;
+  write = bindings.write;
+  host  = bindings.host;
+  impl  = nullptr;
+  state = NoRecording;
+  }
+
+void VCommandBundle::drawIndirect(const AbstractGraphicsApi::Buffer& iind, size_t offset) {
+  const VBuffer& ind = reinterpret_cast<const VBuffer&>(iind);
+  // indirect-stage read is resolved by executing command buffer
+  indirect |= ind.nonUniqId;
+  implSetUniforms(PipelineStage::S_Graphics);
+  implSetPushData(PipelineStage::S_Graphics);
+  vkCmdDrawIndirect(impl, ind.impl, VkDeviceSize(offset), 1, 0);
+  }
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "vcommandbuffer.h"
+
+namespace Tempest {
+namespace Detail {
+
+class VCommandBundle : public VCommandBuffer {
+  public:
+    VCommandBundle(VDevice& device, const FrameBufferDesc& fbo, size_t fboSize, uint32_t w, uint32_t h);
+
+    void begin(SyncHint hint) override;
+    void begin() override;
+    void end() override;
+
+    void drawIndirect(const AbstractGraphicsApi::Buffer& indirect, size_t offset) override;
+
+    // secondary command buffer, ready for vkCmdExecuteCommands
+    VkCommandBuffer cmd      = nullptr;
+    // resource usage, to be merged into render-pass of executing command buffer
+    NonUniqResId    read     = NonUniqResId::I_None;
+    NonUniqResId    write    = NonUniqResId::I_None;
+    NonUniqResId    indirect = NonUniqResId::I_None;
+    bool            host     = false;
+
+  private:
+    uint32_t        width  = 0;
+    uint32_t        height = 0;
+  };
+
+}
+}
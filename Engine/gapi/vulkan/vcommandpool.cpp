@@ -19,14 +19,54 @@ VCommandPool::VCommandPool(VDevice& device,VkCommandPoolCreateFlags flags)
   }
 
 VCommandPool::VCommandPool(VCommandPool &&other) {
-  std::swap(device,other.device);
-  std::swap(impl,  other.impl);
+  std::swap(device,   other.device);
+  std::swap(impl,     other.impl);
+  std::swap(primary,  other.primary);
+  std::swap(secondary,other.secondary);
+  std::swap(allocCount,other.allocCount);
   }
 
 VCommandPool::~VCommandPool() {
   if(device==nullptr)
     return;
+  // frees all of command buffers as well
   vkDestroyCommandPool(device,impl,nullptr);
   }
 
+VkCommandBuffer VCommandPool::alloc() {
+  return alloc(primary, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+  }
+
+VkCommandBuffer VCommandPool::allocSecondary() {
+  return alloc(secondary, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+  }
+
+VkCommandBuffer VCommandPool::alloc(Level& lv, VkCommandBufferLevel level) {
+  if(lv.used<lv.cmd.size()) {
+    return lv.cmd[lv.used++];
+    }
+
+  VkCommandBufferAllocateInfo allocInfo = {};
+  allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.commandPool        = impl;
+  allocInfo.level              = level;
+  allocInfo.commandBufferCount = 1;
+
+  VkCommandBuffer ret = nullptr;
+  lv.cmd.reserve(lv.cmd.size()+1);
+  vkAssert(vkAllocateCommandBuffers(device,&allocInfo,&ret));
+  ++allocCount;
+  lv.cmd.push_back(ret);
+  ++lv.used;
+  return ret;
+  }
+
+void VCommandPool::reset() {
+  if(primary.used==0 && secondary.used==0)
+    return;
+  vkAssert(vkResetCommandPool(device,impl,0));
+  primary.used   = 0;
+  secondary.used = 0;
+  }
+
 #endif
@@ -3,6 +3,8 @@
 #include <Tempest/AbstractGraphicsApi>
 #include "vulkan_sdk.h"
 
+#include <vector>
+
 namespace Tempest {
 namespace Detail {
 
@@ -14,10 +16,31 @@ class VCommandPool {
     VCommandPool(VCommandPool&& other);
     ~VCommandPool();
 
+    //! primary command buffer in initial state; recycled ones are handed out first
+    VkCommandBuffer alloc();
+    //! secondary command buffer in initial state
+    VkCommandBuffer allocSecondary();
+    //! resets pool as a whole: every command buffer, allocated so far, becomes available again
+    void            reset();
+    //! number of vkAllocateCommandBuffers calls
+    uint32_t        allocations() const { return allocCount; }
+
     VkCommandPool impl=VK_NULL_HANDLE;
 
   private:
     VkDevice      device=nullptr;
+
+    struct Level {
+      // command buffers are never freed one by one: [0..used) are handed out, rest are free
+      std::vector<VkCommandBuffer> cmd;
+      size_t                       used = 0;
+      };
+
+    VkCommandBuffer alloc(Level& lv, VkCommandBufferLevel level);
+
+    Level         primary;
+    Level         secondary;
+    uint32_t      allocCount = 0;
   };
 
 }}
@@ -114,6 +114,36 @@ auto VDescriptorAllocator::currentMemorySmp() const -> DSharedPtr<VDescriptorHea
   return providerSmp.memory;
   }
 
+void VDescriptorAllocator::write(uint32_t ptr, AbstractGraphicsApi::Buffer** buf, size_t cnt) {
+  allocatorRes.update([&]() {
+    auto hPtrR = providerRes.memory ? providerRes.memory.handler->hptr : nullptr;
+    for(size_t i=0; i<cnt; ++i) {
+      auto res = hPtrR + (ptr + i)*providerRes.elementSize;
+      VPushDescriptor::write(*providerRes.dev, res, ShaderReflection::SsboR, buf[i], 0, ComponentMapping());
+      }
+    });
+  }
+
+void VDescriptorAllocator::write(uint32_t ptr, AbstractGraphicsApi::Texture** tex, size_t cnt, uint32_t mipLevel) {
+  allocatorRes.update([&]() {
+    auto hPtrR = providerRes.memory ? providerRes.memory.handler->hptr : nullptr;
+    for(size_t i=0; i<cnt; ++i) {
+      auto res = hPtrR + (ptr + i)*providerRes.elementSize;
+      VPushDescriptor::write(*providerRes.dev, res, ShaderReflection::Image, tex[i], mipLevel, ComponentMapping());
+      }
+    });
+  }
+
+void VDescriptorAllocator::copy(uint32_t dst, uint32_t src, uint32_t num) {
+  if(num==0)
+    return;
+  allocatorRes.update([&]() {
+    auto hPtrR = providerRes.memory.handler->hptr;
+    auto sz    = providerRes.elementSize;
+    std::memcpy(hPtrR + dst*sz, hPtrR + src*sz, num*sz);
+    });
+  }
+
 void VDescriptorAllocator::free(uint32_t ptr, uint32_t num) {
   allocatorRes.free(ptr, num);
   return;
@@ -27,6 +27,10 @@ class VDescriptorAllocator {
     Allocation alloc(uint32_t num);
     Allocation alloc(const Sampler& s);
     void       free (uint32_t ptr, uint32_t num);
+    //! overrides previously allocated descriptors
+    void       write(uint32_t ptr, AbstractGraphicsApi::Buffer**  buf, size_t cnt);
+    void       write(uint32_t ptr, AbstractGraphicsApi::Texture** tex, size_t cnt, uint32_t mipLevel);
+    void       copy (uint32_t dst, uint32_t src, uint32_t num);
     void       flush();
 
     auto       currentMemory() const -> DSharedPtr<VDescriptorHeap*>;
@@ -6,37 +6,55 @@
 #include "vtexture.h"
 #include "vaccelerationstructure.h"
 
+#include <algorithm>
+#include <vector>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
 VDescriptorArray::VDescriptorArray(VDevice &dev, AbstractGraphicsApi::Texture **tex, size_t cnt, uint32_t mipLevel, const Sampler &smp)
-  : dev(dev), cnt(cnt) {
+  : dev(dev), cls(ShaderReflection::Texture), mipLevel(mipLevel), smp(smp), hasSmp(true), cnt(cnt) {
   // Roundup a little, to avoid spamming of layouts
-  const uint32_t cntRound = dev.roundUpDescriptorCount(ShaderReflection::Texture, cnt);
+  capacity = dev.roundUpDescriptorCount(cls, cnt);
+
+  const auto lay = dev.bindlessArrayLayout(cls, capacity);
+  alloc(lay, dev, cls, capacity);
+  write(0, tex, cnt);
 
-  const auto lay = dev.bindlessArrayLayout(ShaderReflection::Texture, cntRound);
-  alloc(lay, dev, ShaderReflection::Texture, cntRound);
-  populate(dev, tex, cnt, mipLevel, &smp);
+  slots.resize(uint32_t(cnt));
+  for(size_t i=0; i<cnt; ++i)
+    if(tex[i]!=nullptr)
+      slots.markUsed(uint32_t(i));
   }
 
 VDescriptorArray::VDescriptorArray(VDevice &dev, AbstractGraphicsApi::Texture **tex, size_t cnt, uint32_t mipLevel)
-  : dev(dev), cnt(cnt) {
+  : dev(dev), cls(ShaderReflection::Image), mipLevel(mipLevel), cnt(cnt) {
   // Roundup a little, to avoid spamming of layouts
-  const uint32_t cntRound = dev.roundUpDescriptorCount(ShaderReflection::Image, cnt);
+  capacity = dev.roundUpDescriptorCount(cls, cnt);
 
-  const auto lay = dev.bindlessArrayLayout(ShaderReflection::Image, cntRound);
-  alloc(lay, dev, ShaderReflection::Image, cntRound);
-  populate(dev, tex, cnt, mipLevel, nullptr);
+  const auto lay = dev.bindlessArrayLayout(cls, capacity);
+  alloc(lay, dev, cls, capacity);
+  write(0, tex, cnt);
+
+  slots.resize(uint32_t(cnt));
+  for(size_t i=0; i<cnt; ++i)
+    if(tex[i]!=nullptr)
+      slots.markUsed(uint32_t(i));
   }
 
 VDescriptorArray::VDescriptorArray(VDevice &dev, AbstractGraphicsApi::Buffer **buf, size_t cnt)
-  : dev(dev), cnt(cnt) {
+  : dev(dev), cls(ShaderReflection::SsboRW), cnt(cnt) {
   // Roundup a little, to avoid spamming of layouts
-  const uint32_t cntRound = dev.roundUpDescriptorCount(ShaderReflection::SsboRW, cnt);
+  capacity = dev.roundUpDescriptorCount(cls, cnt);
+
+  const auto lay = dev.bindlessArrayLayout(cls, capacity);
+  alloc(lay, dev, cls, capacity);
+  write(0, buf, cnt);
 
-  const auto lay = dev.bindlessArrayLayout(ShaderReflection::SsboRW, cntRound);
-  alloc(lay, dev, ShaderReflection::SsboRW, cntRound);
-  populate(dev, buf, cnt);
+  slots.resize(uint32_t(cnt));
+  for(size_t i=0; i<cnt; ++i)
+    if(buf[i]!=nullptr)
+      slots.markUsed(uint32_t(i));
   }
 
 VDescriptorArray::~VDescriptorArray() {
@@ -49,6 +67,148 @@ size_t VDescriptorArray::size() const {
   return cnt;
   }
 
+uint32_t VDescriptorArray::alloc(AbstractGraphicsApi::Texture* tex) {
+  if(cls==ShaderReflection::SsboRW)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  const uint32_t slot = allocSlot();
+  write(slot, &tex, 1);
+  return slot;
+  }
+
+uint32_t VDescriptorArray::alloc(AbstractGraphicsApi::Buffer* buf) {
+  if(cls!=ShaderReflection::SsboRW)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  const uint32_t slot = allocSlot();
+  write(slot, &buf, 1);
+  return slot;
+  }
+
+void VDescriptorArray::set(size_t slot, AbstractGraphicsApi::Texture* tex) {
+  if(cls==ShaderReflection::SsboRW || slot>=cnt)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  write(slot, &tex, 1);
+  slots.markUsed(uint32_t(slot));
+  }
+
+void VDescriptorArray::set(size_t slot, AbstractGraphicsApi::Buffer* buf) {
+  if(cls!=ShaderReflection::SsboRW || slot>=cnt)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  write(slot, &buf, 1);
+  slots.markUsed(uint32_t(slot));
+  }
+
+void VDescriptorArray::free(size_t slot) {
+  // bound sets are updated in place, so slot is reused once command buffers, that retained epoch, are reset
+  slots.release(uint32_t(slot));
+  }
+
+uint32_t VDescriptorArray::update(VkDescriptorSet dst, uint32_t binding, uint32_t count, uint32_t since) const {
+  if(since==writeSeq)
+    return writeSeq;
+
+  VkCopyDescriptorSet cpy[MaxDirty] = {};
+  uint32_t            num = 0;
+  auto copy = [&](uint32_t first, uint32_t n) {
+    if(first>=count)
+      return;
+    auto& cx = cpy[num];
+    cx.sType           = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    cx.srcSet          = dset;
+    cx.srcBinding      = 0;
+    cx.srcArrayElement = first;
+    cx.dstSet          = dst;
+    cx.dstBinding      = binding;
+    cx.dstArrayElement = first;
+    cx.descriptorCount = std::min(n, count-first);
+    ++num;
+    };
+
+  // history is trimmed: writes after `since` might be lost
+  const bool lost = dirty.empty() || dirty.front().seq>since+1;
+  if(lost) {
+    copy(0, uint32_t(cnt));
+    } else {
+    for(auto& d:dirty)
+      if(d.seq>since)
+        copy(d.first, d.num);
+    }
+
+  if(num>0)
+    vkUpdateDescriptorSets(dev.device.impl, 0, nullptr, num, cpy);
+  return writeSeq;
+  }
+
+uint32_t VDescriptorArray::allocSlot() {
+  uint32_t slot = 0;
+  auto     noop = [](const DescriptorSlots::Range&){};
+  if(slots.alloc(slot, noop))
+    return slot;
+  grow();
+  if(slots.alloc(slot, noop))
+    return slot;
+  throw std::system_error(Tempest::GraphicsErrc::OutOfVideoMemory, "descriptor array size");
+  }
+
+void VDescriptorArray::grow() {
+  const size_t prevCnt  = cnt;
+  const size_t nextCnt  = std::max<size_t>(64, cnt*2);
+  const size_t nextCap  = dev.roundUpDescriptorCount(cls, nextCnt);
+  if(nextCap<=cnt)
+    return;
+
+  if(nextCap>capacity) {
+    // array set is used only as copy source, see VPoolCache::initDescriptorSet
+    auto prevPool = pool;
+    auto prevSet  = dset;
+    pool = VK_NULL_HANDLE;
+    dset = VK_NULL_HANDLE;
+    try {
+      alloc(dev.bindlessArrayLayout(cls, nextCap), dev, cls, nextCap);
+      }
+    catch(...) {
+      if(pool!=VK_NULL_HANDLE)
+        vkDestroyDescriptorPool(dev.device.impl, pool, nullptr);
+      pool = prevPool;
+      dset = prevSet;
+      throw;
+      }
+
+    VkCopyDescriptorSet cpy = {};
+    cpy.sType           = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    cpy.srcSet          = prevSet;
+    cpy.dstSet          = dset;
+    cpy.descriptorCount = uint32_t(prevCnt);
+    if(cpy.descriptorCount>0)
+      vkUpdateDescriptorSets(dev.device.impl, 0, nullptr, 1, &cpy);
+    vkDestroyDescriptorPool(dev.device.impl, prevPool, nullptr);
+    capacity = nextCap;
+    }
+
+  cnt = std::min(nextCnt, capacity);
+  // new slots are null descriptors, same as null entries on creation
+  if(cls==ShaderReflection::SsboRW) {
+    std::vector<AbstractGraphicsApi::Buffer*> empty(cnt-prevCnt, nullptr);
+    write(prevCnt, empty.data(), empty.size());
+    } else {
+    std::vector<AbstractGraphicsApi::Texture*> empty(cnt-prevCnt, nullptr);
+    write(prevCnt, empty.data(), empty.size());
+    }
+  slots.resize(uint32_t(cnt));
+  // size of array is part of layout
+  ++version;
+  }
+
+void VDescriptorArray::markDirty(size_t first, size_t cnt) {
+  if(!dev.isInplaceUpdatable(cls)) {
+    // bound sets can't be written, while in use: copy of array is reallocated on next bind
+    ++version;
+    }
+  ++writeSeq;
+  if(dirty.size()>=MaxDirty)
+    dirty.erase(dirty.begin(), dirty.begin()+MaxDirty/2);
+  dirty.push_back({writeSeq, uint32_t(first), uint32_t(cnt)});
+  }
+
 void VDescriptorArray::alloc(VkDescriptorSetLayout lay, VDevice &dev, ShaderReflection::Class cls, size_t cnt) {
   VkDescriptorPoolSize       poolSize = {};
   poolSize.type            = nativeFormat(cls);
@@ -72,9 +232,10 @@ void VDescriptorArray::alloc(VkDescriptorSetLayout lay, VDevice &dev, ShaderRefl
   vkAssert(vkAllocateDescriptorSets(dev.device.impl,&allocInfo,&dset));
   }
 
-void VDescriptorArray::populate(VDevice &dev, AbstractGraphicsApi::Texture **t, size_t cnt, uint32_t mipLevel, const Sampler* smp) {
+void VDescriptorArray::write(size_t first, AbstractGraphicsApi::Texture **t, size_t cnt) {
   const bool is3DImage = false; //TODO
-  nonUniqId = NonUniqResId::I_None;
+  if(cnt==0)
+    return;
 
   // 16 is non-bindless limit
   SmallArray<VkDescriptorImageInfo,16> imageInfo(cnt);
@@ -82,7 +243,7 @@ void VDescriptorArray::populate(VDevice &dev, AbstractGraphicsApi::Texture **t,
     VTexture* tex = reinterpret_cast<VTexture*>(t[i]);
     imageInfo[i].imageLayout = tex!=nullptr ? tex->defaultLayout() : VK_IMAGE_LAYOUT_UNDEFINED;
     imageInfo[i].imageView   = tex!=nullptr ? tex->view(ComponentMapping(), mipLevel, is3DImage, false) : VK_NULL_HANDLE;
-    imageInfo[i].sampler     = smp!=nullptr ? dev.samplers.get(*smp) : VK_NULL_HANDLE;
+    imageInfo[i].sampler     = hasSmp ? dev.samplers.get(smp) : VK_NULL_HANDLE;
     // TODO: support mutable textures in bindless
     assert(tex==nullptr || tex->nonUniqId==0);
     if(tex!=nullptr)
@@ -93,16 +254,19 @@ void VDescriptorArray::populate(VDevice &dev, AbstractGraphicsApi::Texture **t,
   descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
   descriptorWrite.dstSet          = dset;
   descriptorWrite.dstBinding      = 0;
-  descriptorWrite.dstArrayElement = 0;
-  descriptorWrite.descriptorType  = smp!=nullptr ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  descriptorWrite.dstArrayElement = uint32_t(first);
+  descriptorWrite.descriptorType  = hasSmp ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
   descriptorWrite.descriptorCount = uint32_t(cnt);
   descriptorWrite.pImageInfo      = imageInfo.get();
 
   vkUpdateDescriptorSets(dev.device.impl, 1, &descriptorWrite, 0, nullptr);
+  markDirty(first, cnt);
   }
 
-void VDescriptorArray::populate(VDevice &dev, AbstractGraphicsApi::Buffer **b, size_t cnt) {
-  nonUniqId = NonUniqResId::I_None;
+void VDescriptorArray::write(size_t first, AbstractGraphicsApi::Buffer **b, size_t cnt) {
+  if(cnt==0)
+    return;
+
   // 16 is non-bindless limit
   SmallArray<VkDescriptorBufferInfo,16> bufInfo(cnt);
   for(size_t i=0; i<cnt; ++i) {
@@ -124,12 +288,13 @@ void VDescriptorArray::populate(VDevice &dev, AbstractGraphicsApi::Buffer **b, s
   descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
   descriptorWrite.dstSet          = dset;
   descriptorWrite.dstBinding      = uint32_t(0);
-  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.dstArrayElement = uint32_t(first);
   descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
   descriptorWrite.descriptorCount = uint32_t(cnt);
   descriptorWrite.pBufferInfo     = bufInfo.get();
 
   vkUpdateDescriptorSets(dev.device.impl, 1, &descriptorWrite, 0, nullptr);
+  markDirty(first, cnt);
   }
 
 
@@ -138,7 +303,7 @@ VDescriptorHeapArray::VDescriptorHeapArray(VDevice& dev, AbstractGraphicsApi::Te
   }
 
 VDescriptorHeapArray::VDescriptorHeapArray(VDevice& dev, AbstractGraphicsApi::Texture** tex, size_t cnt, uint32_t mipLevel, const Sampler* sampler)
-  : dev(dev), cnt(uint32_t(cnt)) {
+  : dev(dev), mipLevel(mipLevel), cnt(uint32_t(cnt)) {
   //NOTE: no bindless storage image
   try {
     auto alloc = dev.descAlloc.alloc(tex, cnt, mipLevel);
@@ -149,10 +314,13 @@ VDescriptorHeapArray::VDescriptorHeapArray(VDevice& dev, AbstractGraphicsApi::Te
       }
 
     nonUniqId = NonUniqResId::I_None;
+    slots.resize(uint32_t(cnt));
     for(size_t i=0; i<cnt; ++i) {
       auto* bx = reinterpret_cast<VTexture*>(tex[i]);
-      if(bx!=nullptr)
-        nonUniqId |= bx->nonUniqId;
+      if(bx==nullptr)
+        continue;
+      nonUniqId |= bx->nonUniqId;
+      slots.markUsed(uint32_t(i));
       }
     }
   catch(...) {
@@ -162,16 +330,19 @@ VDescriptorHeapArray::VDescriptorHeapArray(VDevice& dev, AbstractGraphicsApi::Te
   }
 
 VDescriptorHeapArray::VDescriptorHeapArray(VDevice& dev, AbstractGraphicsApi::Buffer** buf, size_t cnt)
-  : dev(dev), cnt(uint32_t(cnt)) {
+  : dev(dev), isBuffer(true), cnt(uint32_t(cnt)) {
   try {
     auto alloc = dev.descAlloc.alloc(buf, cnt);
     dPtrR = alloc.ptr;
 
     nonUniqId = NonUniqResId::I_None;
+    slots.resize(uint32_t(cnt));
     for(size_t i=0; i<cnt; ++i) {
       auto* bx = reinterpret_cast<VBuffer*>(buf[i]);
-      if(bx!=nullptr)
-        nonUniqId |= bx->nonUniqId;
+      if(bx==nullptr)
+        continue;
+      nonUniqId |= bx->nonUniqId;
+      slots.markUsed(uint32_t(i));
       }
     }
   catch(...) {
@@ -184,7 +355,72 @@ VDescriptorHeapArray::~VDescriptorHeapArray() {
   clear();
   }
 
+uint32_t VDescriptorHeapArray::alloc(AbstractGraphicsApi::Texture* tex) {
+  if(isBuffer)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  const uint32_t slot = allocSlot();
+  dev.descAlloc.write(dPtrR+slot, &tex, 1, mipLevel);
+  if(tex!=nullptr)
+    nonUniqId |= reinterpret_cast<VTexture*>(tex)->nonUniqId;
+  return slot;
+  }
+
+uint32_t VDescriptorHeapArray::alloc(AbstractGraphicsApi::Buffer* buf) {
+  if(!isBuffer)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  const uint32_t slot = allocSlot();
+  dev.descAlloc.write(dPtrR+slot, &buf, 1);
+  if(buf!=nullptr)
+    nonUniqId |= reinterpret_cast<VBuffer*>(buf)->nonUniqId;
+  return slot;
+  }
+
+void VDescriptorHeapArray::set(size_t slot, AbstractGraphicsApi::Texture* tex) {
+  if(isBuffer || slot>=cnt)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  dev.descAlloc.write(dPtrR+uint32_t(slot), &tex, 1, mipLevel);
+  if(tex!=nullptr)
+    nonUniqId |= reinterpret_cast<VTexture*>(tex)->nonUniqId;
+  slots.markUsed(uint32_t(slot));
+  }
+
+void VDescriptorHeapArray::set(size_t slot, AbstractGraphicsApi::Buffer* buf) {
+  if(!isBuffer || slot>=cnt)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  dev.descAlloc.write(dPtrR+uint32_t(slot), &buf, 1);
+  if(buf!=nullptr)
+    nonUniqId |= reinterpret_cast<VBuffer*>(buf)->nonUniqId;
+  slots.markUsed(uint32_t(slot));
+  }
+
+void VDescriptorHeapArray::free(size_t slot) {
+  slots.release(uint32_t(slot));
+  }
+
+uint32_t VDescriptorHeapArray::allocSlot() {
+  uint32_t slot    = 0;
+  auto     release = [this](const DescriptorSlots::Range& r){ dev.descAlloc.free(r.ptr, r.num); };
+  if(slots.alloc(slot, release))
+    return slot;
+  grow();
+  if(slots.alloc(slot, release))
+    return slot;
+  throw std::system_error(Tempest::GraphicsErrc::OutOfVideoMemory, "descriptor array size");
+  }
+
+void VDescriptorHeapArray::grow() {
+  const uint32_t nextCnt = std::max<uint32_t>(64, cnt*2);
+  const auto     next    = dev.descAlloc.alloc(nextCnt);
+  dev.descAlloc.copy(next.ptr, dPtrR, cnt);
+  // previous range can be in use by command buffers in flight
+  slots.release(DescriptorSlots::Range{dPtrR, cnt});
+  dPtrR = next.ptr;
+  cnt   = nextCnt;
+  slots.resize(cnt);
+  }
+
 void VDescriptorHeapArray::clear() {
+  slots.clear([this](const DescriptorSlots::Range& r){ dev.descAlloc.free(r.ptr, r.num); });
   dev.descAlloc.free(dPtrR, uint32_t(cnt));
   }
 
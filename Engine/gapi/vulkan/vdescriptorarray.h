@@ -2,6 +2,7 @@
 
 #include <Tempest/AbstractGraphicsApi>
 
+#include "gapi/descriptorslots.h"
 #include "gapi/shaderreflection.h"
 #include "vulkan_sdk.h"
 
@@ -17,20 +18,54 @@ class VDescriptorArray : public AbstractGraphicsApi::DescArray {
     VDescriptorArray(VDevice& dev, AbstractGraphicsApi::Buffer**  buf, size_t cnt);
     ~VDescriptorArray();
 
-    size_t size() const;
-    auto   set() const -> VkDescriptorSet { return dset; }
+    size_t   size() const override;
+    uint32_t alloc(AbstractGraphicsApi::Texture* tex) override;
+    uint32_t alloc(AbstractGraphicsApi::Buffer*  buf) override;
+    void     set  (size_t slot, AbstractGraphicsApi::Texture* tex) override;
+    void     set  (size_t slot, AbstractGraphicsApi::Buffer*  buf) override;
+    void     free (size_t slot) override;
 
-    NonUniqResId     nonUniqId = NonUniqResId::I_None;
+    auto     set() const -> VkDescriptorSet { return dset; }
+    //! sequence number of last write
+    uint32_t seq() const { return writeSeq; }
+    //! copies slots, written after `since`, into `binding` of `dst`; returns sequence number of last write
+    uint32_t update(VkDescriptorSet dst, uint32_t binding, uint32_t count, uint32_t since) const;
+
+    //! bound sets are updated in place: command buffers hold epoch, to delay reuse of released slots
+    auto     epoch() const { return slots.epoch(); }
+
+    // bumped on reallocation of array, or on every write, if array is not updated in place; descriptor sets, copied from array, are invalidated by it
+    // bumped on reallocation of array; descriptor sets, copied from array, are invalidated by it
+    uint32_t         version   = 0;
 
   private:
-    void alloc(VkDescriptorSetLayout lay, VDevice& dev, ShaderReflection::Class cls, size_t cnt);
-    void populate(VDevice &dev, AbstractGraphicsApi::Texture **tex, size_t cnt, uint32_t mipLevel, const Sampler *smp);
-    void populate(VDevice &dev, AbstractGraphicsApi::Buffer  **buf, size_t cnt);
-
-    VDevice&         dev;
-    size_t           cnt  = 0;
-    VkDescriptorPool pool = VK_NULL_HANDLE;
-    VkDescriptorSet  dset = VK_NULL_HANDLE;
+    void     alloc(VkDescriptorSetLayout lay, VDevice& dev, ShaderReflection::Class cls, size_t cnt);
+    void     write(size_t first, AbstractGraphicsApi::Texture** tex, size_t cnt);
+    void     write(size_t first, AbstractGraphicsApi::Buffer**  buf, size_t cnt);
+    uint32_t allocSlot();
+    void     grow();
+    void     markDirty(size_t first, size_t cnt);
+
+    struct Dirty {
+      uint32_t seq   = 0;
+      uint32_t first = 0;
+      uint32_t num   = 0;
+      };
+    // history of writes is short: older sets are copied as whole
+    static constexpr size_t MaxDirty = 64;
+
+    VDevice&                dev;
+    ShaderReflection::Class cls      = ShaderReflection::Texture;
+    uint32_t                mipLevel = 0;
+    Sampler                 smp;
+    bool                    hasSmp   = false;
+    size_t                  cnt      = 0;
+    size_t                  capacity = 0;
+    VkDescriptorPool        pool     = VK_NULL_HANDLE;
+    VkDescriptorSet         dset     = VK_NULL_HANDLE;
+    DescriptorSlots         slots;
+    uint32_t                writeSeq = 0;
+    std::vector<Dirty>      dirty;
   };
 
 class VDescriptorHeapArray : public AbstractGraphicsApi::DescArray {
@@ -40,18 +75,33 @@ class VDescriptorHeapArray : public AbstractGraphicsApi::DescArray {
     VDescriptorHeapArray(VDevice& dev, AbstractGraphicsApi::Buffer**  buf, size_t cnt);
     ~VDescriptorHeapArray();
 
+    size_t   size() const override { return cnt; }
+    uint32_t alloc(AbstractGraphicsApi::Texture* tex) override;
+    uint32_t alloc(AbstractGraphicsApi::Buffer*  buf) override;
+    void     set  (size_t slot, AbstractGraphicsApi::Texture* tex) override;
+    void     set  (size_t slot, AbstractGraphicsApi::Buffer*  buf) override;
+    void     free (size_t slot) override;
+
     uint32_t handleR()  const { return dPtrR; }
     uint32_t handleS()  const { return dPtrS; }
 
+    //! heap is written in place: command buffers hold epoch, to delay reuse of released slots
+    auto     epoch() const { return slots.epoch(); }
+
     NonUniqResId nonUniqId = NonUniqResId::I_None;
 
   private:
     void     clear();
+    uint32_t allocSlot();
+    void     grow();
 
-    VDevice& dev;
-    uint32_t dPtrR = 0xFFFFFFFF;
-    uint32_t dPtrS = 0xFFFFFFFF;
-    uint32_t cnt   = 0;
+    VDevice&        dev;
+    bool            isBuffer = false;
+    uint32_t        mipLevel = 0;
+    uint32_t        dPtrR    = 0xFFFFFFFF;
+    uint32_t        dPtrS    = 0xFFFFFFFF;
+    uint32_t        cnt      = 0;
+    DescriptorSlots slots;
   };
 
 }}
@@ -5,12 +5,15 @@
 #include "vcommandbuffer.h"
 #include "vdescriptorallocator.h"
 #include "vfence.h"
+#include "vmeshlethelper.h"
+#include "vblasbatch.h"
 #include "vswapchain.h"
 
 #include <Tempest/Application>
 #include <Tempest/Log>
 #include <cstring>
 #include <array>
+#include <bit>
 
 using namespace Tempest;
 using namespace Tempest::Detail;
@@ -80,10 +83,10 @@ VkResult VDevice::Queue::present(VkPresentInfoKHR& presentInfo) {
   }
 
 
-VDevice::VDevice(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice pdev)
+VDevice::VDevice(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice pdev, const bool emulateMesh)
   :instance(instance), hasDeviceFeatures2(hasDeviceFeatures2),
     fboMap(*this), setLayouts(*this), psoLayouts(*this), descPool(*this) {
-  deviceProps(instance, hasDeviceFeatures2, pdev, props);
+  deviceProps(instance, hasDeviceFeatures2, pdev, props, emulateMesh);
   deviceQueueProps(pdev, props);
 
   createLogicalDevice(pdev);
@@ -95,11 +98,19 @@ VDevice::VDevice(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalD
   if(props.hasDescriptorHeap)
     descAlloc.setDevice(*this);
   samplers.setDevice(*this);
+  if(props.meshlets.emulated)
+    meshHelper.reset(new VMeshletHelper(*this));
+  if(props.raytracing.rayQuery)
+    blasBatch.reset(new VBlasBatch(*this));
+  if(props.hasPipelineLibrary)
+    psoLinker.reset(new VPipelineLinker());
   data.reset(new DataMgr(*this));
   }
 
 VDevice::~VDevice() {
   vkDeviceWaitIdle(device.impl);
+  psoLinker.reset();
+  blasBatch.reset();
   data.reset();
 
   for(auto& i:timeline.timepoint) {
@@ -189,6 +200,23 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
   if(props.hasDescriptorHeap) {
     rqExt.push_back(VK_EXT_DESCRIPTOR_HEAP_EXTENSION_NAME);
     }
+  if(props.hasPipelineLibrary) {
+    rqExt.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+    rqExt.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    }
+  if(props.hasExtDynState) {
+    rqExt.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    }
+  if(props.hasExtDynState3) {
+    rqExt.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+    }
+  if(props.has16BitStorage) {
+    rqExt.push_back(VK_KHR_16BIT_STORAGE_EXTENSION_NAME);
+    }
+  if(props.hasPresentWait) {
+    rqExt.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    rqExt.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
 
   VkPhysicalDeviceFeatures supportedFeatures={};
   vkGetPhysicalDeviceFeatures(pdev,&supportedFeatures);
@@ -251,6 +279,24 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
     VkPhysicalDeviceDescriptorHeapFeaturesEXT dheapFeatures = {};
     dheapFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_HEAP_FEATURES_EXT;
 
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gplFeatures = {};
+    gplFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynStateFeatures = {};
+    dynStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynState3Features = {};
+    dynState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    VkPhysicalDevice16BitStorageFeatures storage16Features = {};
+    storage16Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+
     if(props.hasSync2) {
       sync2.pNext = features.pNext;
       features.pNext = &sync2;
@@ -298,6 +344,29 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
       dheapFeatures.pNext = features.pNext;
       features.pNext = &dheapFeatures;
       }
+    if(props.hasPipelineLibrary) {
+      gplFeatures.pNext = features.pNext;
+      features.pNext = &gplFeatures;
+      }
+    if(props.hasExtDynState) {
+      dynStateFeatures.pNext = features.pNext;
+      features.pNext = &dynStateFeatures;
+      }
+    if(props.hasExtDynState3) {
+      dynState3Features.pNext = features.pNext;
+      features.pNext = &dynState3Features;
+      }
+    if(props.hasPresentWait) {
+      presentIdFeatures.pNext = features.pNext;
+      features.pNext = &presentIdFeatures;
+
+      presentWaitFeatures.pNext = features.pNext;
+      features.pNext = &presentWaitFeatures;
+      }
+    if(props.has16BitStorage) {
+      storage16Features.pNext = features.pNext;
+      features.pNext = &storage16Features;
+      }
 
     auto vkGetPhysicalDeviceFeatures2 = PFN_vkGetPhysicalDeviceFeatures2(vkGetInstanceProcAddr(instance,"vkGetPhysicalDeviceFeatures2KHR"));
 
@@ -356,6 +425,8 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
     vkDestroyAccelerationStructure       = PFN_vkDestroyAccelerationStructureKHR(vkGetDeviceProcAddr(device.impl,"vkDestroyAccelerationStructureKHR"));
     vkGetAccelerationStructureBuildSizes = PFN_vkGetAccelerationStructureBuildSizesKHR(vkGetDeviceProcAddr(device.impl,"vkGetAccelerationStructureBuildSizesKHR"));
     vkCmdBuildAccelerationStructures     = PFN_vkCmdBuildAccelerationStructuresKHR(vkGetDeviceProcAddr(device.impl,"vkCmdBuildAccelerationStructuresKHR"));
+    vkCmdCopyAccelerationStructure       = PFN_vkCmdCopyAccelerationStructureKHR(vkGetDeviceProcAddr(device.impl,"vkCmdCopyAccelerationStructureKHR"));
+    vkCmdWriteAccelerationStructuresProperties = PFN_vkCmdWriteAccelerationStructuresPropertiesKHR(vkGetDeviceProcAddr(device.impl,"vkCmdWriteAccelerationStructuresPropertiesKHR"));
     }
 
   if(props.raytracing.rayQuery && props.hasDeviceAddress) {
@@ -372,6 +443,18 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
     vkCmdDebugMarkerEnd        = PFN_vkCmdDebugMarkerEndEXT       (vkGetDeviceProcAddr(device.impl,"vkCmdDebugMarkerEndEXT"));
     vkDebugMarkerSetObjectName = PFN_vkDebugMarkerSetObjectNameEXT(vkGetDeviceProcAddr(device.impl,"vkDebugMarkerSetObjectNameEXT"));
     }
+  if(props.hasExtDynState) {
+    vkCmdSetCullMode         = PFN_vkCmdSetCullModeEXT        (vkGetDeviceProcAddr(device.impl,"vkCmdSetCullModeEXT"));
+    vkCmdSetDepthTestEnable  = PFN_vkCmdSetDepthTestEnableEXT (vkGetDeviceProcAddr(device.impl,"vkCmdSetDepthTestEnableEXT"));
+    vkCmdSetDepthWriteEnable = PFN_vkCmdSetDepthWriteEnableEXT(vkGetDeviceProcAddr(device.impl,"vkCmdSetDepthWriteEnableEXT"));
+    vkCmdSetDepthCompareOp   = PFN_vkCmdSetDepthCompareOpEXT  (vkGetDeviceProcAddr(device.impl,"vkCmdSetDepthCompareOpEXT"));
+    }
+
+  if(props.hasExtDynState3) {
+    vkCmdSetColorBlendEnable   = PFN_vkCmdSetColorBlendEnableEXT  (vkGetDeviceProcAddr(device.impl,"vkCmdSetColorBlendEnableEXT"));
+    vkCmdSetColorBlendEquation = PFN_vkCmdSetColorBlendEquationEXT(vkGetDeviceProcAddr(device.impl,"vkCmdSetColorBlendEquationEXT"));
+    }
+
   dummyIfNull(vkCmdDebugMarkerBegin);
   dummyIfNull(vkCmdDebugMarkerEnd);
   dummyIfNull(vkDebugMarkerSetObjectName);
@@ -383,9 +466,14 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
     vkCmdBindResourceHeapEXT      = PFN_vkCmdBindResourceHeapEXT(vkGetDeviceProcAddr(device.impl,"vkCmdBindResourceHeapEXT"));
     vkCmdBindSamplerHeapEXT       = PFN_vkCmdBindSamplerHeapEXT(vkGetDeviceProcAddr(device.impl,"vkCmdBindSamplerHeapEXT"));
     }
+
+  if(props.hasPresentWait) {
+    vkWaitForPresent = PFN_vkWaitForPresentKHR(vkGetDeviceProcAddr(device.impl,"vkWaitForPresentKHR"));
+    }
   }
 
-void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice physicalDevice, VkProps& props) {
+void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice physicalDevice, VkProps& props,
+                          const bool emulateMesh) {
   const auto ext = extensionsList(physicalDevice);
   if(extensionSupport(ext,VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME))
     props.hasMemRq2 = true;
@@ -434,6 +522,25 @@ void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, Vk
   if(extensionSupport(ext,VK_KHR_VULKAN_MEMORY_MODEL_EXTENSION_NAME)) {
     props.memoryModel = true;
     }
+  if(hasDeviceFeatures2 && extensionSupport(ext,VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+    props.hasExtDynState = true;
+    }
+  if(hasDeviceFeatures2 && extensionSupport(ext,VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+    props.hasExtDynState3 = true;
+    }
+  if(hasDeviceFeatures2 && extensionSupport(ext,VK_KHR_16BIT_STORAGE_EXTENSION_NAME)) {
+    props.has16BitStorage = true;
+    }
+  if(hasDeviceFeatures2 &&
+     extensionSupport(ext,VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+     extensionSupport(ext,VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+    props.hasPresentWait = true;
+    }
+  if(hasDeviceFeatures2 &&
+     extensionSupport(ext,VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+     extensionSupport(ext,VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+    props.hasPipelineLibrary = true;
+    }
   if(extensionSupport(ext,VK_KHR_MAINTENANCE_5_EXTENSION_NAME) &&
      extensionSupport(ext,VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME) &&
      extensionSupport(ext,VK_EXT_DESCRIPTOR_HEAP_EXTENSION_NAME) &&
@@ -532,6 +639,27 @@ void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, Vk
     VkPhysicalDeviceDescriptorHeapPropertiesEXT dheapProps = {};
     dheapProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_HEAP_PROPERTIES_EXT;
 
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gplFeatures = {};
+    gplFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+    VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT gplProps = {};
+    gplProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynStateFeatures = {};
+    dynStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynState3Features = {};
+    dynState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    VkPhysicalDevice16BitStorageFeatures storage16Features = {};
+    storage16Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+
     if(props.hasSync2) {
       sync2.pNext = features.pNext;
       features.pNext = &sync2;
@@ -584,6 +712,32 @@ void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, Vk
       dheapProps.pNext = properties.pNext;
       properties.pNext = &dheapProps;
       }
+    if(props.hasPipelineLibrary) {
+      gplFeatures.pNext = features.pNext;
+      features.pNext = &gplFeatures;
+
+      gplProps.pNext = properties.pNext;
+      properties.pNext = &gplProps;
+      }
+    if(props.hasExtDynState) {
+      dynStateFeatures.pNext = features.pNext;
+      features.pNext = &dynStateFeatures;
+      }
+    if(props.hasExtDynState3) {
+      dynState3Features.pNext = features.pNext;
+      features.pNext = &dynState3Features;
+      }
+    if(props.hasPresentWait) {
+      presentIdFeatures.pNext = features.pNext;
+      features.pNext = &presentIdFeatures;
+
+      presentWaitFeatures.pNext = features.pNext;
+      features.pNext = &presentWaitFeatures;
+      }
+    if(props.has16BitStorage) {
+      storage16Features.pNext = features.pNext;
+      features.pNext = &storage16Features;
+      }
 
     auto vkGetPhysicalDeviceFeatures2   = PFN_vkGetPhysicalDeviceFeatures2  (vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
     auto vkGetPhysicalDeviceProperties2 = PFN_vkGetPhysicalDeviceProperties2(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
@@ -594,6 +748,17 @@ void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, Vk
     props.hasSync2                = (sync2.synchronization2==VK_TRUE);
     props.hasDynRendering         = (dynRendering.dynamicRendering==VK_TRUE);
     props.hasDeviceAddress        = (bdaFeatures.bufferDeviceAddress==VK_TRUE);
+    props.deviceAddress           = props.hasDeviceAddress;
+    props.hasPipelineLibrary      = (gplFeatures.graphicsPipelineLibrary==VK_TRUE) && (gplProps.graphicsPipelineLibraryFastLinking==VK_TRUE);
+    props.hasExtDynState          = (dynStateFeatures.extendedDynamicState==VK_TRUE);
+    props.hasExtDynState3         = (dynState3Features.extendedDynamicState3ColorBlendEnable==VK_TRUE) &&
+                                    (dynState3Features.extendedDynamicState3ColorBlendEquation==VK_TRUE);
+    props.hasPresentWait          = (presentIdFeatures.presentId==VK_TRUE) && (presentWaitFeatures.presentWait==VK_TRUE);
+    props.vbo.halfInput           = (storage16Features.storageInputOutput16==VK_TRUE);
+
+    props.dynamicState.cullMode   = props.hasExtDynState;
+    props.dynamicState.depthTest  = props.hasExtDynState;
+    props.dynamicState.blend      = props.hasExtDynState3;
     props.raytracing.rayQuery     = (rayQueryFeatures.rayQuery==VK_TRUE);
     props.meshlets.taskShader     = (meshFeatures.taskShader==VK_TRUE);
     props.meshlets.meshShader     = (meshFeatures.meshShader==VK_TRUE);
@@ -606,8 +771,6 @@ void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, Vk
 
     props.accelerationStructureScratchOffsetAlignment = asProperties.minAccelerationStructureScratchOffsetAlignment;
 
-    //props.meshlets.meshShader = false;
-
     if(indexingFeatures.runtimeDescriptorArray!=VK_FALSE) {
       // NOTE1: no UBO support - won't do
       // NOTE2: no Storage-image support on Intel
@@ -619,6 +782,11 @@ void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, Vk
         (indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind==VK_TRUE);
       }
 
+    props.hasUpdateUnusedWhilePending = (indexingFeatures.descriptorBindingUpdateUnusedWhilePending     ==VK_TRUE);
+    props.hasTextureUpdateAfterBind   = (indexingFeatures.descriptorBindingSampledImageUpdateAfterBind  ==VK_TRUE);
+    props.hasImageUpdateAfterBind     = (indexingFeatures.descriptorBindingStorageImageUpdateAfterBind  ==VK_TRUE);
+    props.hasSsboUpdateAfterBind      = (indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind ==VK_TRUE);
+
     if(indexingFeatures.runtimeDescriptorArray!=VK_FALSE && !props.hasDescriptorHeap) {
       props.descriptors.maxSamplers = std::max(indexingProps.maxDescriptorSetUpdateAfterBindSamplers,
                                                indexingProps.maxPerStageDescriptorUpdateAfterBindSamplers);
@@ -676,6 +844,24 @@ void VDevice::deviceProps(VkInstance instance, const bool hasDeviceFeatures2, Vk
 
   props.ubo.offsetAlign   = size_t(devP.limits.minUniformBufferOffsetAlignment);
   props.ubo.maxRange      = size_t(devP.limits.maxUniformBufferRange);
+  props.maxDynamicUbo     = devP.limits.maxDescriptorSetUniformBuffersDynamic;
+
+  props.pipelineLibrary = props.hasPipelineLibrary && !props.hasDescriptorHeap;
+
+  if(emulateMesh) {
+    props.meshlets.taskShader = false;
+    props.meshlets.meshShader = false;
+    }
+  if(!props.meshlets.meshShader) {
+    // fallback: MeshConverter + compute, see VMeshletHelper
+    props.meshlets.emulated       = true;
+    props.meshlets.maxGroups.x    = int(devP.limits.maxComputeWorkGroupCount[0]);
+    props.meshlets.maxGroups.y    = int(devP.limits.maxComputeWorkGroupCount[1]);
+    props.meshlets.maxGroups.z    = int(devP.limits.maxComputeWorkGroupCount[2]);
+    props.meshlets.maxGroupSize.x = int(devP.limits.maxComputeWorkGroupSize[0]);
+    props.meshlets.maxGroupSize.y = int(devP.limits.maxComputeWorkGroupSize[1]);
+    props.meshlets.maxGroupSize.z = int(devP.limits.maxComputeWorkGroupSize[2]);
+    }
 
   if(!props.hasDescriptorHeap) {
     props.push.maxRange = size_t(devP.limits.maxPushConstantsSize);
@@ -956,6 +1142,45 @@ VkDescriptorSetLayout VDevice::bindlessArrayLayout(ShaderReflection::Class cls,
   return setLayouts.findLayout(lx);
   }
 
+uint32_t VDevice::dynamicUboMask(const ShaderReflection::LayoutDesc& lay) const {
+  // update-after-bind layouts can't have dynamic descriptors; descriptor-heap has no sets at all
+  if(props.hasDescriptorHeap || lay.isUpdateAfterBind())
+    return 0;
+
+  uint32_t mask = 0;
+  for(size_t i=0; i<MaxBindings; ++i) {
+    if(lay.bindings[i]!=ShaderReflection::Ubo || (lay.active & (1u << i))==0)
+      continue;
+    // no fixed size to bind with dynamic offset
+    if(lay.bufferSz[i]==0)
+      continue;
+    if(lay.count[i]>1)
+      return 0;
+    mask |= (1u << i);
+    }
+
+  if(uint32_t(std::popcount(mask))>props.maxDynamicUbo)
+    return 0;
+  return mask;
+  }
+
+bool VDevice::isInplaceUpdatable(ShaderReflection::Class cls) const {
+  if(!props.hasUpdateUnusedWhilePending)
+    return false;
+  // classes of VDescriptorArray
+  switch(cls) {
+    case ShaderReflection::Texture:
+      return props.hasTextureUpdateAfterBind;
+    case ShaderReflection::Image:
+      return props.hasImageUpdateAfterBind;
+    case ShaderReflection::SsboR:
+    case ShaderReflection::SsboRW:
+      return props.hasSsboUpdateAfterBind;
+    default:
+      return false;
+    }
+  }
+
 std::shared_ptr<VFence> VDevice::findAvailableFence() {
   for(int pass=0; pass<2; ++pass) {
     for(uint32_t id=0; id<MaxFences; ++id) {
@@ -1088,6 +1313,15 @@ void VDevice::waitIdle() {
   waitIdleSync(queues,sizeof(queues)/sizeof(queues[0]));
   }
 
+DeviceStats VDevice::stats() const {
+  DeviceStats st;
+  if(props.hasDynRendering)
+    return st;
+  st.framebuffers     = uint32_t(fboMap.size());
+  st.framebufferLimit = VFramebufferMap::MaxFbo;
+  return st;
+  }
+
 void VDevice::waitIdleSync(VDevice::Queue* q, size_t n) {
   if(n==0) {
     vkDeviceWaitIdle(device.impl);
@@ -20,6 +20,7 @@
 #include "gapi/vulkan/vpsolayoutcache.h"
 #include "gapi/vulkan/vdescriptorallocator.h"
 #include "gapi/vulkan/vsamplercache.h"
+#include "gapi/vulkan/vpipelinelinker.h"
 #include "gapi/uploadengine.h"
 #include "exceptions/exception.h"
 #include "utility/compiller_hints.h"
@@ -28,6 +29,8 @@ namespace Tempest {
 namespace Detail {
 
 class VTexture;
+class VMeshletHelper;
+class VBlasBatch;
 
 inline void vkAssert(VkResult code){
   if(T_LIKELY(code==VkResult::VK_SUCCESS))
@@ -102,6 +105,28 @@ inline VkFormat nativeFormat(TextureFormat f) {
       return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
     case TextureFormat::RGBA16F:
       return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case TextureFormat::R16F:
+      return VK_FORMAT_R16_SFLOAT;
+    case TextureFormat::RG16F:
+      return VK_FORMAT_R16G16_SFLOAT;
+    case TextureFormat::RGB10A2:
+      return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+    case TextureFormat::RGBA8_SRGB:
+      return VK_FORMAT_R8G8B8A8_SRGB;
+    case TextureFormat::DXT1_SRGB:
+      return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+    case TextureFormat::DXT3_SRGB:
+      return VK_FORMAT_BC2_SRGB_BLOCK;
+    case TextureFormat::DXT5_SRGB:
+      return VK_FORMAT_BC3_SRGB_BLOCK;
+    case TextureFormat::BC4:
+      return VK_FORMAT_BC4_UNORM_BLOCK;
+    case TextureFormat::BC5:
+      return VK_FORMAT_BC5_UNORM_BLOCK;
+    case TextureFormat::BC7:
+      return VK_FORMAT_BC7_UNORM_BLOCK;
+    case TextureFormat::BC7_SRGB:
+      return VK_FORMAT_BC7_SRGB_BLOCK;
     }
   return VK_FORMAT_UNDEFINED;
   }
@@ -216,6 +241,30 @@ inline VkFormat nativeFormat(Decl::ComponentType t) {
       return VK_FORMAT_R32G32B32_UINT;
     case Decl::uint4:
       return VK_FORMAT_R32G32B32A32_UINT;
+    case Decl::half1:
+      return VK_FORMAT_R16_SFLOAT;
+    case Decl::half2:
+      return VK_FORMAT_R16G16_SFLOAT;
+    case Decl::half4:
+      return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case Decl::unorm8x2:
+      return VK_FORMAT_R8G8_UNORM;
+    case Decl::unorm8x4:
+      return VK_FORMAT_R8G8B8A8_UNORM;
+    case Decl::snorm8x2:
+      return VK_FORMAT_R8G8_SNORM;
+    case Decl::snorm8x4:
+      return VK_FORMAT_R8G8B8A8_SNORM;
+    case Decl::unorm16x2:
+      return VK_FORMAT_R16G16_UNORM;
+    case Decl::unorm16x4:
+      return VK_FORMAT_R16G16B16A16_UNORM;
+    case Decl::snorm16x2:
+      return VK_FORMAT_R16G16_SNORM;
+    case Decl::snorm16x4:
+      return VK_FORMAT_R16G16B16A16_SNORM;
+    case Decl::a2b10g10r10:
+      return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
     }
   return VK_FORMAT_UNDEFINED;
   }
@@ -313,7 +362,7 @@ class VDevice : public AbstractGraphicsApi::Device {
 
     using SwapChainSupport = VSwapchain::SwapChainSupport;
 
-    VDevice(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice pdevice);
+    VDevice(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice pdevice, const bool emulateMesh = false);
     ~VDevice() override;
 
     struct autoDevice {
@@ -345,6 +394,14 @@ class VDevice : public AbstractGraphicsApi::Device {
 
       uint32_t heapAlignment       = 0;
 
+      uint32_t maxDynamicUbo       = 0;
+
+      // update-after-bind of descriptor array bindings, see VDevice::isInplaceUpdatable
+      bool     hasUpdateUnusedWhilePending = false;
+      bool     hasTextureUpdateAfterBind   = false;
+      bool     hasImageUpdateAfterBind     = false;
+      bool     hasSsboUpdateAfterBind      = false;
+
       bool     hasMemRq2          = false;
       bool     hasDedicatedAlloc  = false;
       bool     hasSync2           = false;
@@ -359,6 +416,11 @@ class VDevice : public AbstractGraphicsApi::Device {
       bool     hasMaintenance1    = false;
       bool     hasMaintenance5    = false;
       bool     hasDescriptorHeap  = false;
+      bool     hasPipelineLibrary = false;
+      bool     has16BitStorage    = false;
+      bool     hasExtDynState     = false;
+      bool     hasExtDynState3    = false;
+      bool     hasPresentWait     = false;
       };
 
     struct Queue final {
@@ -385,11 +447,13 @@ class VDevice : public AbstractGraphicsApi::Device {
       };
 
     void                    waitIdle() override;
+    DeviceStats             stats() const override;
     std::shared_ptr<VFence> submit(VCommandBuffer& cmd);
 
     static std::vector<VkExtensionProperties> extensionsList(VkPhysicalDevice dev);
 
-    static void             deviceProps(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice physicalDevice, VkProps& props);
+    static void             deviceProps(VkInstance instance, const bool hasDeviceFeatures2, VkPhysicalDevice physicalDevice, VkProps& props,
+                                        const bool emulateMesh = false);
     static void             deviceFormatProps(VkPhysicalDevice device, VkProps& props);
     static void             deviceQueueProps(VkPhysicalDevice device, VkProps& props);
 
@@ -403,6 +467,9 @@ class VDevice : public AbstractGraphicsApi::Device {
 
     uint32_t                roundUpDescriptorCount(ShaderReflection::Class cls, size_t cnt);
     VkDescriptorSetLayout   bindlessArrayLayout(ShaderReflection::Class cls, size_t cnt);
+    uint32_t                dynamicUboMask(const ShaderReflection::LayoutDesc& lay) const;
+    //! descriptor array binding of this class can be written, while bound set is in use
+    bool                    isInplaceUpdatable(ShaderReflection::Class cls) const;
 
     std::shared_ptr<VFence> findAvailableFence();
     void                    waitAny(uint64_t timeout);
@@ -430,6 +497,9 @@ class VDevice : public AbstractGraphicsApi::Device {
 
     VDescriptorAllocator    descAlloc;
     VSamplerCache           samplers;
+    std::unique_ptr<VMeshletHelper> meshHelper;
+    std::unique_ptr<VBlasBatch>     blasBatch;
+    std::unique_ptr<VPipelineLinker> psoLinker;
 
     VkProps                 props = {};
 
@@ -449,6 +519,8 @@ class VDevice : public AbstractGraphicsApi::Device {
     PFN_vkDestroyAccelerationStructureKHR       vkDestroyAccelerationStructure       = nullptr;
     PFN_vkGetAccelerationStructureBuildSizesKHR vkGetAccelerationStructureBuildSizes = nullptr;
     PFN_vkCmdBuildAccelerationStructuresKHR     vkCmdBuildAccelerationStructures     = nullptr;
+    PFN_vkCmdCopyAccelerationStructureKHR       vkCmdCopyAccelerationStructure       = nullptr;
+    PFN_vkCmdWriteAccelerationStructuresPropertiesKHR vkCmdWriteAccelerationStructuresProperties = nullptr;
 
     PFN_vkCmdDrawMeshTasksEXT                   vkCmdDrawMeshTasks = nullptr;
     PFN_vkCmdDrawMeshTasksIndirectEXT           vkCmdDrawMeshTasksIndirect = nullptr;
@@ -457,12 +529,21 @@ class VDevice : public AbstractGraphicsApi::Device {
     PFN_vkCmdDebugMarkerEndEXT                  vkCmdDebugMarkerEnd        = nullptr;
     PFN_vkDebugMarkerSetObjectNameEXT           vkDebugMarkerSetObjectName = nullptr;
 
+    PFN_vkCmdSetCullModeEXT                     vkCmdSetCullMode           = nullptr;
+    PFN_vkCmdSetDepthTestEnableEXT              vkCmdSetDepthTestEnable    = nullptr;
+    PFN_vkCmdSetDepthWriteEnableEXT             vkCmdSetDepthWriteEnable   = nullptr;
+    PFN_vkCmdSetDepthCompareOpEXT               vkCmdSetDepthCompareOp     = nullptr;
+    PFN_vkCmdSetColorBlendEnableEXT             vkCmdSetColorBlendEnable   = nullptr;
+    PFN_vkCmdSetColorBlendEquationEXT           vkCmdSetColorBlendEquation = nullptr;
+
     PFN_vkWriteResourceDescriptorsEXT vkWriteResourceDescriptorsEXT = nullptr;
     PFN_vkWriteSamplerDescriptorsEXT  vkWriteSamplerDescriptorsEXT = nullptr;
     PFN_vkCmdPushDataEXT              vkCmdPushDataEXT = nullptr;
     PFN_vkCmdBindResourceHeapEXT      vkCmdBindResourceHeapEXT = nullptr;
     PFN_vkCmdBindSamplerHeapEXT       vkCmdBindSamplerHeapEXT = nullptr;
 
+    PFN_vkWaitForPresentKHR           vkWaitForPresent = nullptr;
+
     static const std::initializer_list<const char*> requiredExtensions;
 
   private:
@@ -5,6 +5,8 @@
 #include "vdevice.h"
 #include "vtexture.h"
 
+#include <algorithm>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
@@ -31,6 +33,25 @@ bool VFramebufferMap::RenderPassDesc::operator ==(const RenderPassDesc& other) c
          std::memcmp(storeOp, other.storeOp, numAttachments*sizeof(storeOp[0]))==0;
   }
 
+size_t VFramebufferMap::RenderPassDesc::hash() const {
+  uint64_t h = hashBytes(&numAttachments, sizeof(numAttachments));
+  h = hashBytes(attachmentFormats, numAttachments*sizeof(attachmentFormats[0]), h);
+  h = hashBytes(loadOp,            numAttachments*sizeof(loadOp[0]),            h);
+  h = hashBytes(storeOp,           numAttachments*sizeof(storeOp[0]),           h);
+  return size_t(h);
+  }
+
+bool VFramebufferMap::FboDesc::operator ==(const FboDesc& other) const {
+  if(viewCount!=other.viewCount)
+    return false;
+  return std::memcmp(view, other.view, viewCount*sizeof(VkImageView))==0 && pass==other.pass;
+  }
+
+size_t VFramebufferMap::FboHash::operator()(const FboDesc& d) const {
+  uint64_t h = hashBytes(d.view, d.viewCount*sizeof(VkImageView), d.pass.hash());
+  return size_t(h);
+  }
+
 bool VFramebufferMap::RenderPass::isCompatible(const RenderPass& other) const {
   if(desc.numAttachments!=other.desc.numAttachments)
     return false;
@@ -47,12 +68,6 @@ bool VFramebufferMap::RenderPass::isSame(const RenderPassDesc& other) const {
   return desc==other;
   }
 
-bool VFramebufferMap::Fbo::isSame(const VkImageView* attach, size_t attCount, const RenderPassDesc& desc) const {
-  if(descSize!=attCount)
-    return false;
-  return std::memcmp(view, attach, attCount*sizeof(VkImageView))==0 && pass->desc==desc;
-  }
-
 bool VFramebufferMap::Fbo::hasImg(VkImageView v) const {
   for(size_t i=0; i<descSize; ++i)
     if(view[i]==v)
@@ -68,88 +83,86 @@ VFramebufferMap::~VFramebufferMap() {
   if(device==VK_NULL_HANDLE)
     return;
 
-  for(auto& i:val) {
-    auto& v = *i;
-    if(v.fbo!=VK_NULL_HANDLE)
-      vkDestroyFramebuffer(device,v.fbo,nullptr);
-    }
-  for(auto& i:rp) {
-    auto& v = *i;
-    if(v.pass!=VK_NULL_HANDLE)
-      vkDestroyRenderPass(device,v.pass,nullptr);
-    }
+  val.forEach([device](const FboDesc&, const std::shared_ptr<Fbo>& v) {
+    if(v->fbo!=VK_NULL_HANDLE)
+      vkDestroyFramebuffer(device,v->fbo,nullptr);
+    });
+  rp.forEach([device](const RenderPassDesc&, const std::shared_ptr<RenderPass>& v) {
+    if(v->pass!=VK_NULL_HANDLE)
+      vkDestroyRenderPass(device,v->pass,nullptr);
+    });
   }
 
 void VFramebufferMap::notifyDestroy(VkImageView img) {
   auto device = dev.device.impl;
-
-  std::lock_guard<std::mutex> guard(syncFbo);
-  for(size_t i=0; i<val.size();) {
-    auto& v = *val[i];
-    if(!v.hasImg(img)) {
-      ++i;
-      continue;
-      }
-    vkDestroyFramebuffer(device,v.fbo,nullptr);
-    val[i] = std::move(val.back());
-    val.pop_back();
-    }
+  val.eraseIf([device,img](const FboDesc&, const std::shared_ptr<Fbo>& v) {
+    if(!v->hasImg(img))
+      return false;
+    vkDestroyFramebuffer(device,v->fbo,nullptr);
+    return true;
+    });
   }
 
 std::shared_ptr<VFramebufferMap::Fbo> VFramebufferMap::find(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo) {
-  VkImageView attach[MaxFramebufferAttachments] = {};
+  FboDesc desc;
   for(uint8_t i=0; i<info->colorAttachmentCount; ++i) {
-    attach[i] = info->pColorAttachments[i].imageView;
+    desc.view[i] = info->pColorAttachments[i].imageView;
     }
   if(info->pDepthAttachment!=nullptr) {
     const uint32_t i = info->colorAttachmentCount;
-    attach[i] = info->pDepthAttachment->imageView;
+    desc.view[i] = info->pDepthAttachment->imageView;
+    }
+  desc.viewCount = uint8_t(info->colorAttachmentCount + (info->pDepthAttachment!=nullptr ? 1 : 0));
+  desc.pass      = RenderPassDesc(*info, *fbo);
+
+  bool created = false;
+  auto ret = val.findOrInsert(desc, [&]() {
+    auto f = std::make_shared<Fbo>();
+    mkFbo(*f, info, fbo, desc.view, desc.viewCount);
+    created = true;
+    return f;
+    });
+
+  // tick advances only on miss: hits stay read-only on shared state
+  if(created) {
+    ret->lastUse.store(useTick.fetch_add(1, std::memory_order_relaxed)+1, std::memory_order_relaxed);
+    if(val.size()>MaxFbo)
+      evict();
+    } else {
+    ret->lastUse.store(useTick.load(std::memory_order_relaxed), std::memory_order_relaxed);
     }
-  const uint32_t attCount = info->colorAttachmentCount + (info->pDepthAttachment!=nullptr ? 1 : 0);
+  return ret;
+  }
 
-  RenderPassDesc desc(*info, *fbo);
-  std::lock_guard<std::mutex> guard(syncFbo);
-  for(auto& i:val)
-    if(i->isSame(attach, attCount, desc))
-      return i;
-  val.push_back(std::make_shared<Fbo>());
-  try {
-    *val.back() = mkFbo(info, fbo, attach, attCount);
-    }
-  catch(...) {
-    val.pop_back();
-    throw;
-    }
-  return val.back();
+void VFramebufferMap::evict() {
+  std::unique_lock<std::mutex> guard(syncEvict, std::try_to_lock);
+  if(!guard.owns_lock())
+    return; // other thread is evicting already
+
+  auto device = dev.device.impl;
+  // under exclusive lock of the shard nobody can copy pointer, so use_count()==1 is stable
+  val.evictOldest(MaxFbo*3/4,
+                  [](const std::shared_ptr<Fbo>& v) { return v->lastUse.load(std::memory_order_relaxed); },
+                  [](const std::shared_ptr<Fbo>& v) { return v.use_count()==1; },
+                  [device](const std::shared_ptr<Fbo>& v) { vkDestroyFramebuffer(device,v->fbo,nullptr); });
   }
 
-VFramebufferMap::Fbo VFramebufferMap::mkFbo(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo, const VkImageView* attach, size_t attCount) {
-  Fbo ret = {};
+void VFramebufferMap::mkFbo(Fbo& ret, const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo, const VkImageView* attach, size_t attCount) {
   ret.pass = findRenderpass(info, fbo);
   ret.fbo  = mkFramebuffer(attach, attCount, info->renderArea.extent, ret.pass->pass);
 
   std::memcpy(ret.view, attach, attCount*sizeof(VkImageView));
   ret.descSize = uint8_t(attCount);
-  return ret;
   }
 
 std::shared_ptr<VFramebufferMap::RenderPass> VFramebufferMap::findRenderpass(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo) {
   RenderPassDesc desc(*info, *fbo);
-  std::lock_guard<std::mutex> guard(syncRp);
-  for(auto& i:rp)
-    if(i->isSame(desc))
-      return i;
-  auto ret = std::make_shared<RenderPass>();
-  rp.push_back(ret);
-  try {
+  return rp.findOrInsert(desc, [&]() {
+    auto ret = std::make_shared<RenderPass>();
     ret->pass = mkRenderPass(info, fbo);
-    }
-  catch(...) {
-    rp.pop_back();
-    throw;
-    }
-  ret->desc = desc;
-  return ret;
+    ret->desc = desc;
+    return ret;
+    });
   }
 
 VkRenderPass VFramebufferMap::mkRenderPass(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo) {
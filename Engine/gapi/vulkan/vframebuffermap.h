@@ -1,8 +1,10 @@
 #pragma once
 
 #include "gapi/abstractgraphicsapi.h"
+#include "utility/shardedmap.h"
 #include "vulkan_sdk.h"
 
+#include <atomic>
 #include <mutex>
 
 namespace Tempest {
@@ -23,6 +25,7 @@ class VFramebufferMap {
       RenderPassDesc(const VkRenderingInfo& info, const VkPipelineRenderingCreateInfoKHR& fbo);
 
       bool operator == (const RenderPassDesc& other) const;
+      size_t   hash() const;
 
       VkFormat            attachmentFormats[MaxFramebufferAttachments] = {};
       VkAttachmentLoadOp  loadOp[MaxFramebufferAttachments] = {};
@@ -45,26 +48,48 @@ class VFramebufferMap {
       VkImageView    view[MaxFramebufferAttachments] = {};
       uint8_t        descSize = 0;
 
-      bool           isSame(const VkImageView* attach, size_t attCount, const RenderPassDesc& desc) const;
+      std::atomic<uint64_t> lastUse{0};
+
       bool           hasImg(VkImageView v) const;
       };
 
-    std::shared_ptr<Fbo> find(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo);
-    void                 notifyDestroy(VkImageView img);
+    std::shared_ptr<Fbo>        find(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo);
+    std::shared_ptr<RenderPass> findRenderpass(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo);
+    void                        notifyDestroy(VkImageView img);
+    size_t                      size() const { return val.size(); }
+
+    // soft limit: framebuffers, not referenced by any command buffer, are evicted in LRU order
+    enum { MaxFbo = 256 };
 
   private:
-    std::shared_ptr<RenderPass> findRenderpass(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo);
-    Fbo                mkFbo(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo, const VkImageView* attach, size_t attCount);
+
+    struct FboDesc {
+      RenderPassDesc pass;
+      VkImageView    view[MaxFramebufferAttachments] = {};
+      uint8_t        viewCount = 0;
+
+      bool operator == (const FboDesc& other) const;
+      };
+
+    struct RpHash {
+      size_t operator()(const RenderPassDesc& d) const { return d.hash(); }
+      };
+    struct FboHash {
+      size_t operator()(const FboDesc& d) const;
+      };
+
+    void               mkFbo(Fbo& ret, const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo, const VkImageView* attach, size_t attCount);
     VkRenderPass       mkRenderPass(const VkRenderingInfo* info, const VkPipelineRenderingCreateInfoKHR* fbo);
     VkFramebuffer      mkFramebuffer(const VkImageView* view, size_t cnt, VkExtent2D size, VkRenderPass rp);
+    void               evict();
 
     VDevice&           dev;
 
-    std::mutex         syncFbo;
-    std::vector<std::shared_ptr<Fbo>>        val;
+    ShardedMap<FboDesc, std::shared_ptr<Fbo>, FboHash>               val;
+    std::atomic<uint64_t> useTick{0};
+    std::mutex         syncEvict;
 
-    std::mutex         syncRp;
-    std::vector<std::shared_ptr<RenderPass>> rp;
+    ShardedMap<RenderPassDesc, std::shared_ptr<RenderPass>, RpHash>  rp;
   };
 
 }
@@ -0,0 +1,80 @@
+#if defined(TEMPEST_BUILD_VULKAN)
+
+#include "vmeshlethelper.h"
+
+#include "vdevice.h"
+#include "vpipeline.h"
+#include "vshader.h"
+
+#include <libspirv/libspirv.h>
+#include <unordered_set>
+
+#include "builtin_shader.h"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+static DSharedPtr<VCompPipeline*> mkPipeline(VDevice& device, const uint8_t* code, size_t size) {
+  auto cs = DSharedPtr<VShader*>(new VShader(device,code,size));
+  return DSharedPtr<VCompPipeline*>(new VCompPipeline(device,*cs.handler,SpecializationConstants()));
+  }
+
+VMeshletHelper::VMeshletHelper(VDevice& device)
+  :device(device) {
+  // each command must be addressable, as ssbo-offset
+  const VkDeviceSize align = std::max<VkDeviceSize>(device.props.ssbo.offsetAlign, 1);
+  stride = ((IndirectCmdSize+align-1)/align)*align;
+
+  init       = mkPipeline(device, mesh_init_comp_sprv,        sizeof(mesh_init_comp_sprv));
+  taskPost   = mkPipeline(device, task_post_pass_comp_sprv,   sizeof(task_post_pass_comp_sprv));
+  taskLut    = mkPipeline(device, task_lut_pass_comp_sprv,    sizeof(task_lut_pass_comp_sprv));
+  prefix     = mkPipeline(device, mesh_prefix_pass_comp_sprv, sizeof(mesh_prefix_pass_comp_sprv));
+  compactage = mkPipeline(device, mesh_compactage_comp_sprv,  sizeof(mesh_compactage_comp_sprv));
+  }
+
+VMeshletHelper::~VMeshletHelper() {
+  }
+
+void VMeshletHelper::remapBindings(libspirv::MutableBytecode& code, ShaderReflection::Stage stage) {
+  // compute: indirect, meshlets, scratch; vertex pass-through: scratch
+  static const uint32_t compSlots[] = {IndirectSlot, MeshletSlot, ScratchSlot};
+  static const uint32_t vertSlots[] = {ScratchSlot};
+
+  const uint32_t* slots = (stage==ShaderReflection::Vertex) ? vertSlots : compSlots;
+  const size_t    count = (stage==ShaderReflection::Vertex) ? std::size(vertSlots) : std::size(compSlots);
+
+  std::unordered_set<uint32_t> engine;
+  for(auto it = code.begin(), end = code.end(); it!=end; ++it) {
+    auto& i = *it;
+    if(i.op()==spv::OpDecorate && i[2]==spv::DecorationDescriptorSet && i[3]==1) {
+      engine.insert(i[1]);
+      it.set(3, 0u);
+      }
+    }
+
+  for(auto it = code.begin(), end = code.end(); it!=end; ++it) {
+    auto& i = *it;
+    if(i.op()!=spv::OpDecorate || i[2]!=spv::DecorationBinding || engine.find(i[1])==engine.end())
+      continue;
+    if(i[3]>=count)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    it.set(3, slots[i[3]]);
+    }
+  }
+
+VBuffer VMeshletHelper::allocIndirect() {
+  const size_t size = size_t(stride)*MaxDraws;
+  return device.allocator.alloc(nullptr, size, MemUsage::StorageBuffer | MemUsage::Indirect, BufferHeap::Device);
+  }
+
+VBuffer VMeshletHelper::allocMeshlets() {
+  // taskletCnt, meshletCnt, iterator, Descriptor[]
+  const size_t size = 3*sizeof(uint32_t) + MaxMeshlets*3*sizeof(uint32_t);
+  return device.allocator.alloc(nullptr, size, MemUsage::StorageBuffer, BufferHeap::Device);
+  }
+
+VBuffer VMeshletHelper::allocScratch() {
+  return device.allocator.alloc(nullptr, ScratchSize, MemUsage::StorageBuffer | MemUsage::IndexBuffer, BufferHeap::Device);
+  }
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include "vulkan_sdk.h"
+
+#include "gapi/vulkan/vbuffer.h"
+#include "gapi/shaderreflection.h"
+#include "utility/dptr.h"
+
+namespace libspirv {
+class MutableBytecode;
+}
+
+namespace Tempest {
+namespace Detail {
+
+class VDevice;
+class VCompPipeline;
+
+/**
+ * Compute emulation of task/mesh shaders, for devices without VK_EXT_mesh_shader.
+ *
+ * MeshConverter splits mesh shader into compute (writes varyings and indices into scratch heap)
+ * and vertex pass-through (fetches varyings by gl_VertexIndex). All emulated draws of a render-pass
+ * are recorded into two command buffers, submitted in front of the pass:
+ *   task pre-pass: mesh_init, task shaders, task_post_pass, task_lut_pass
+ *   mesh pre-pass: mesh shaders, mesh_prefix_pass, mesh_compactage
+ * Each draw then becomes vkCmdDrawIndexedIndirect, with scratch heap bound as index buffer.
+ */
+class VMeshletHelper {
+  public:
+    enum : uint32_t {
+      IndirectSlot = MaxBindings-3,
+      MeshletSlot  = MaxBindings-2,
+      ScratchSlot  = MaxBindings-1,
+      };
+
+    enum : uint32_t {
+      MaxDraws    = 4096,             // emulated draws per render-pass
+      MaxMeshlets = 128*1024,         // meshlets per render-pass
+      ScratchSize = 32*1024*1024,     // varyings and indices per render-pass, in bytes
+      WorkGroups  = 128,              // for task_lut_pass and mesh_compactage
+      };
+
+    // DrawIndexedIndirectCommand in builtin shaders
+    static constexpr VkDeviceSize IndirectCmdSize  = 8*sizeof(uint32_t);
+    // offset of VkDrawIndexedIndirectCommand and VkDispatchIndirectCommand within the command
+    static constexpr VkDeviceSize IndirectCmdNative = 2*sizeof(uint32_t);
+
+    explicit VMeshletHelper(VDevice& device);
+    ~VMeshletHelper();
+
+    //! moves MeshConverter engine bindings (set=1) into reserved slots of set=0
+    static void  remapBindings(libspirv::MutableBytecode& code, ShaderReflection::Stage stage);
+
+    VkDeviceSize indirectStride() const { return stride; }
+    uint32_t     indirectRate()   const { return uint32_t(stride/IndirectCmdSize); }
+
+    VBuffer      allocIndirect();
+    VBuffer      allocMeshlets();
+    VBuffer      allocScratch();
+
+    DSharedPtr<VCompPipeline*> init;
+    DSharedPtr<VCompPipeline*> taskPost;
+    DSharedPtr<VCompPipeline*> taskLut;
+    DSharedPtr<VCompPipeline*> prefix;
+    DSharedPtr<VCompPipeline*> compactage;
+
+  private:
+    VDevice&     device;
+    VkDeviceSize stride = IndirectCmdSize;
+  };
+
+}}
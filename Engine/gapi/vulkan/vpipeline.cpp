@@ -7,11 +7,13 @@
 
 #include <Tempest/RenderState>
 
+#include <cstddef>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
-bool VPipeline::InstRp::isCompatible(const std::shared_ptr<VFramebufferMap::RenderPass>& dr, VkPipelineLayout pLay, size_t stride) const {
-  if(this->stride!=stride)
+bool VPipeline::InstRp::isCompatible(const std::shared_ptr<VFramebufferMap::RenderPass>& dr, VkPipelineLayout pLay, const VertexInput& vin) const {
+  if(this->vin!=vin)
     return false;
   if(this->pLay!=pLay)
     return false;
@@ -19,8 +21,8 @@ bool VPipeline::InstRp::isCompatible(const std::shared_ptr<VFramebufferMap::Rend
   return lay->isCompatible(*dr);
   }
 
-bool VPipeline::InstDr::isCompatible(const VkPipelineRenderingCreateInfoKHR& dr, VkPipelineLayout pLay, size_t stride) const {
-  if(this->stride!=stride)
+bool VPipeline::InstDr::isCompatible(const VkPipelineRenderingCreateInfoKHR& dr, VkPipelineLayout pLay, const VertexInput& vin) const {
+  if(this->vin!=vin)
     return false;
   if(this->pLay!=pLay)
     return false;
@@ -38,37 +40,43 @@ bool VPipeline::InstDr::isCompatible(const VkPipelineRenderingCreateInfoKHR& dr,
   }
 
 
-VPipeline::VPipeline(VDevice& device, Topology tp, const RenderState& st, const VShader** sh, size_t count)
-  : device(device), tp(tp), st(st) {
+VPipeline::VPipeline(VDevice& device, Topology tp, const RenderState& st, const SpecializationConstants& spec,
+                     const VShader** sh, size_t count)
+  : device(device), tp(tp), st(st), spec(spec) {
   try {
+    const VShader* stages[5] = {};
+    std::copy(sh, sh+count, stages);
+    if(device.props.meshlets.emulated)
+      setupMeshEmulation(stages, count);
+
     const std::vector<Detail::ShaderReflection::Binding>* bindings[5] = {};
     for(size_t i=0; i<count; ++i) {
-      if(sh[i]==nullptr)
+      if(stages[i]==nullptr)
         continue;
-      auto* s = reinterpret_cast<const Detail::VShader*>(sh[i]);
+      auto* s = reinterpret_cast<const Detail::VShader*>(stages[i]);
       bindings[i] = &s->lay;
       }
     ShaderReflection::setupLayout(pb, layout, sync, bindings, count);
 
     for(size_t i=0; i<count; ++i)
-      if(sh[i]!=nullptr)
-        modules[i] = Detail::DSharedPtr<const VShader*>{sh[i]};
+      if(stages[i]!=nullptr)
+        modules[i] = Detail::DSharedPtr<const VShader*>{stages[i]};
 
     if(auto vert=findShader(ShaderReflection::Stage::Vertex)) {
       declSize = vert->vert.decl.size();
       decl.reset(new Decl::ComponentType[declSize]);
       std::memcpy(decl.get(), vert->vert.decl.data(), declSize*sizeof(Decl::ComponentType));
-      defaultStride = 0;
+      defaultInput = VertexInput();
       for(size_t i=0;i<declSize;++i){
-        defaultStride += uint32_t(Decl::size(decl[i]));
+        defaultInput.stride[0] += uint32_t(Decl::size(decl[i]));
         }
       }
 
     if(auto task=findShader(ShaderReflection::Stage::Task)) {
-      wgSize = task->comp.wgSize;
+      wgSize = task->workGroupSize(spec);
       }
     else if(auto mesh=findShader(ShaderReflection::Stage::Mesh)) {
-      wgSize = mesh->comp.wgSize;
+      wgSize = mesh->workGroupSize(spec);
       }
 
     pipelineLayout = device.props.hasDescriptorHeap ? VK_NULL_HANDLE : device.psoLayouts.findLayout(pb, layout);
@@ -83,24 +91,43 @@ VPipeline::~VPipeline() {
   cleanup();
   }
 
-VkPipeline VPipeline::instance(const VkPipelineRenderingCreateInfoKHR& info, VkRenderPass pass, VkPipelineLayout pLay, size_t stride) {
+VkPipeline VPipeline::instance(const VkPipelineRenderingCreateInfoKHR& info, VkRenderPass pass, VkPipelineLayout pLay, const VertexInput& vin) {
   std::lock_guard<SpinLock> guard(syncInst);
 
   for(auto& i:instDr)
-    if(i.isCompatible(info,pLay,stride))
+    if(i.isCompatible(info,pLay,vin))
       return i.val;
-  VkPipeline val = VK_NULL_HANDLE;
+
+  const bool useLib  = useLibraries(pass);
+  VkPipeline libs[4] = {};
+  VkPipeline val     = VK_NULL_HANDLE;
   try {
-    val = initGraphicsPipeline(device,pLay,pass,&info,st,
-                               decl.get(),declSize,stride,
-                               tp,modules);
-    instDr.emplace_back(info,pLay,stride,val);
+    if(useLib) {
+      libs[0] = library(libInput,     Library{VK_NULL_HANDLE, 0,             vin}, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,    info);
+      libs[1] = library(libPreRaster, Library{pLay,           info.viewMask, {}},     VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, info);
+      libs[2] = library(libFragment,  Library{pLay,           info.viewMask, {}},     VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,           info);
+      libs[3] = libraryOutput(info);
+      val     = linkGraphicsPipeline(device,pLay,libs,4,false);
+      } else {
+      val     = initGraphicsPipeline(device,pLay,pass,&info,st,
+                                     decl.get(),declSize,vin,
+                                     tp,modules,0);
+      }
+    instDr.emplace_back(info,pLay,vin,val);
+    instDr.back().linked = useLib;
     }
   catch(...) {
     if(val!=VK_NULL_HANDLE)
       vkDestroyPipeline(device.device.impl,val,nullptr);
     throw;
     }
+
+  if(useLib) {
+    // fast-linked pipeline is usable right away; optimized one replaces it, once ready
+    device.psoLinker->push(this, [this, pLay, val, libs]() {
+      linkOptimized(pLay, val, libs);
+      });
+    }
   return instDr.back().val;
   }
 
@@ -108,7 +135,27 @@ IVec3 VPipeline::workGroupSize() const {
   return wgSize;
   }
 
+PipelineStats VPipeline::stats() const {
+  std::lock_guard<SpinLock> guard(syncInst);
+  PipelineStats ret;
+  ret.variants = uint32_t(instRp.size() + instDr.size());
+  for(auto& i:instDr) {
+    if(i.linked)
+      ret.linked++;
+    if(i.fast!=VK_NULL_HANDLE)
+      ret.optimized++;
+    }
+  return ret;
+  }
+
 size_t VPipeline::sizeofBuffer(size_t id, size_t arraylen) const {
+  if(isMeshEmulated() && (layout.active & (1u << id))==0) {
+    // binding is used only by task/mesh stage
+    auto& m = emu.mesh.handler->layout;
+    if(emu.task.handler!=nullptr && (m.active & (1u << id))==0)
+      return emu.task.handler->sizeofBuffer(id, arraylen);
+    return emu.mesh.handler->sizeofBuffer(id, arraylen);
+    }
   return layout.sizeofBuffer(id, arraylen);
   }
 
@@ -120,11 +167,143 @@ const VShader* VPipeline::findShader(ShaderReflection::Stage sh) const {
   return nullptr;
   }
 
+void VPipeline::setupMeshEmulation(const VShader** sh, size_t count) {
+  // task/mesh are replaced by compute pre-pass, while graphics pipeline is vertex-passthrough + fragment
+  for(size_t i=0; i<count; ++i) {
+    if(sh[i]==nullptr || sh[i]->emu.comp.handler==nullptr)
+      continue;
+    auto comp = DSharedPtr<VCompPipeline*>(new VCompPipeline(device, *sh[i]->emu.comp.handler, spec));
+    if(sh[i]->stage==ShaderReflection::Task) {
+      wgSize   = sh[i]->workGroupSize(spec);
+      emu.task = std::move(comp);
+      sh[i]    = nullptr;
+      } else {
+      if(emu.task.handler==nullptr)
+        wgSize = sh[i]->workGroupSize(spec);
+      emu.mesh = std::move(comp);
+      sh[i]    = sh[i]->emu.vert.handler;
+      }
+    }
+  }
+
+bool VPipeline::useLibraries(VkRenderPass pass) const {
+  if(device.psoLinker==nullptr || device.props.hasDescriptorHeap)
+    return false;
+  // legacy render-passes, rasterizer-discard and mesh pipelines are compiled as a whole
+  if(pass!=VK_NULL_HANDLE || st.isRasterDiscardEnabled())
+    return false;
+  return findShader(ShaderReflection::Stage::Vertex)!=nullptr;
+  }
+
+VkPipeline VPipeline::library(std::vector<Library>& cache, const Library& key, VkGraphicsPipelineLibraryFlagsEXT part,
+                              const VkPipelineRenderingCreateInfoKHR& info) {
+  for(auto& i:cache)
+    if(i.pLay==key.pLay && i.viewMask==key.viewMask && i.vin==key.vin)
+      return i.val;
+
+  auto val = initGraphicsPipeline(device,key.pLay,VK_NULL_HANDLE,&info,st,
+                                  decl.get(),declSize,key.vin,
+                                  tp,modules,part);
+  cache.push_back(key);
+  cache.back().val = val;
+  return val;
+  }
+
+VkPipeline VPipeline::libraryOutput(const VkPipelineRenderingCreateInfoKHR& info) {
+  for(auto& i:libOutput)
+    if(i.isCompatible(info,VK_NULL_HANDLE,VertexInput()))
+      return i.val;
+
+  auto val = initGraphicsPipeline(device,VK_NULL_HANDLE,VK_NULL_HANDLE,&info,st,
+                                  decl.get(),declSize,VertexInput(),
+                                  tp,modules,VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+  libOutput.emplace_back(info,VK_NULL_HANDLE,VertexInput(),val);
+  return val;
+  }
+
+void VPipeline::linkOptimized(VkPipelineLayout pLay, VkPipeline fast, const VkPipeline* libs) {
+  VkPipeline val = VK_NULL_HANDLE;
+  try {
+    val = linkGraphicsPipeline(device,pLay,libs,4,true);
+    }
+  catch(...) {
+    // fast-linked pipeline stays in use
+    return;
+    }
+
+  std::lock_guard<SpinLock> guard(syncInst);
+  for(auto& i:instDr) {
+    if(i.val!=fast)
+      continue;
+    // fast pipeline can be referenced by command buffers in flight
+    i.fast = fast;
+    i.val  = val;
+    return;
+    }
+  vkDestroyPipeline(device.device.impl,val,nullptr);
+  }
+
 void VPipeline::cleanup() {
+  if(device.psoLinker!=nullptr)
+    device.psoLinker->cancel(this);
+
+  VkDevice dev = device.device.impl;
   for(auto& i:instRp)
-    vkDestroyPipeline(device.device.impl,i.val,nullptr);
-  for(auto& i:instDr)
-    vkDestroyPipeline(device.device.impl,i.val,nullptr);
+    vkDestroyPipeline(dev,i.val,nullptr);
+  for(auto& i:instDr) {
+    vkDestroyPipeline(dev,i.val,nullptr);
+    if(i.fast!=VK_NULL_HANDLE)
+      vkDestroyPipeline(dev,i.fast,nullptr);
+    }
+  for(auto* lib:{&libInput, &libPreRaster, &libFragment})
+    for(auto& i:*lib)
+      vkDestroyPipeline(dev,i.val,nullptr);
+  for(auto& i:libOutput)
+    vkDestroyPipeline(dev,i.val,nullptr);
+  }
+
+uint32_t VPipeline::vertexAttributes(const Decl::ComponentType* decl, size_t declSize, const VertexInput& vin,
+                                     VkVertexInputAttributeDescription* out) {
+  uint32_t binding=0, offset=0, taken=0, explicitBase=0;
+  for(size_t i=0;i<declSize;++i){
+    if(binding+1<vin.count) {
+      // stream with explicit format takes exact amount of inputs, otherwise inputs, that fit into element
+      const bool next = vin.attribs[binding]>0 ? (taken==vin.attribs[binding])
+                                               : (offset+Decl::size(decl[i])>vin.stride[binding]);
+      if(next) {
+        explicitBase += vin.attribs[binding];
+        binding++;
+        offset = 0;
+        taken  = 0;
+        }
+      }
+    Decl::ComponentType frm = decl[i];
+    if(taken<vin.attribs[binding])
+      frm = vin.format[explicitBase+taken]; // compressed input, such as unorm8x4, is read as float by shader
+
+    // last stream takes the rest of inputs: they must fit into its element as well
+    if(vin.count>1 && offset+Decl::size(frm)>vin.stride[binding])
+      throw std::system_error(Tempest::GraphicsErrc::InvalidVertexInput, "vertex input doesn't fit into stream stride");
+
+    auto& loc=out[i];
+    loc.location = uint32_t(i);
+    loc.binding  = binding;
+    loc.format   = nativeFormat(frm);
+    loc.offset   = offset;
+
+    offset += uint32_t(Decl::size(frm));
+    taken  ++;
+    }
+
+  if(declSize==0)
+    return 0;
+  if(vin.count>1) {
+    if(binding+1!=vin.count)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidVertexInput, "more vertex streams, than shader inputs");
+    if(vin.attribs[binding]>0 && taken!=vin.attribs[binding])
+      throw std::system_error(Tempest::GraphicsErrc::InvalidVertexInput, "stream format doesn't match shader inputs");
+    }
+  return binding+1;
   }
 
 VkPipeline VPipeline::initGraphicsPipeline(VDevice& device,
@@ -132,8 +311,14 @@ VkPipeline VPipeline::initGraphicsPipeline(VDevice& device,
                                            const VkPipelineRenderingCreateInfoKHR* dynLay,
                                            const RenderState &st,
                                            const Decl::ComponentType *decl, size_t declSize,
-                                           size_t stride, Topology tp,
-                                           const DSharedPtr<const VShader*>* shaders) {
+                                           const VertexInput& vin, Topology tp,
+                                           const DSharedPtr<const VShader*>* shaders,
+                                           VkGraphicsPipelineLibraryFlagsEXT parts) {
+  // parts==0: monolithic pipeline, otherwise only state of given library parts is used
+  const bool preRaster = (parts==0 || (parts & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)!=0);
+  const bool fragment  = (parts==0 || (parts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)!=0);
+  const bool output    = (parts==0 || (parts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)!=0);
+
   SmallArray<VkDescriptorSetAndBindingMappingEXT, MaxBindings> mappings(this->layout.size());
   VkShaderDescriptorSetAndBindingMappingInfoEXT mappingInfo { VK_STRUCTURE_TYPE_SHADER_DESCRIPTOR_SET_AND_BINDING_MAPPING_INFO_EXT};
   if(device.props.hasDescriptorHeap) {
@@ -142,17 +327,24 @@ VkPipeline VPipeline::initGraphicsPipeline(VDevice& device,
     initPushMappings(device, mappingInfo, mappings.get(), pb, this->layout);
     }
 
+  SmallArray<VkSpecializationMapEntry, 16> specMap(spec.size());
+  VkSpecializationInfo                     specInfo = {};
+  const VkSpecializationInfo*              pSpec    = specializationInfo(spec, specInfo, specMap.get());
+
   VkPipelineShaderStageCreateInfo shaderStages[5] = {};
   size_t                          stagesCnt       = 0;
   for(size_t i=0; i<5; ++i) {
     if(shaders[i].handler==nullptr)
       continue;
+    if(!(shaders[i].handler->stage==ShaderReflection::Stage::Fragment ? fragment : preRaster))
+      continue;
 
     VkPipelineShaderStageCreateInfo& sh = shaderStages[stagesCnt];
     sh.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     sh.stage  = nativeFormat(shaders[i].handler->stage);
     sh.module = shaders[i].handler->impl;
     sh.pName  = "main";
+    sh.pSpecializationInfo = pSpec;
     if(device.props.hasDescriptorHeap) {
       mappingInfo.pNext = sh.pNext;
       sh.pNext          = &mappingInfo;
@@ -163,29 +355,23 @@ VkPipeline VPipeline::initGraphicsPipeline(VDevice& device,
   const bool useTesselation = (findShader(ShaderReflection::Stage::Evaluate)!=nullptr ||
                                findShader(ShaderReflection::Stage::Control) !=nullptr);
 
-  VkVertexInputBindingDescription vertexInputBindingDescription;
-  vertexInputBindingDescription.binding   = 0;
-  vertexInputBindingDescription.stride    = uint32_t(stride);
-  vertexInputBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  VkVertexInputBindingDescription vertexInputBindingDescription[MaxVertexStreams] = {};
+  for(uint32_t i=0; i<vin.count; ++i) {
+    auto& b = vertexInputBindingDescription[i];
+    b.binding   = i;
+    b.stride    = vin.stride[i];
+    b.inputRate = (vin.instance & (1u << i)) ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
+    }
 
   SmallArray<VkVertexInputAttributeDescription,16> vsInput(declSize);
-  uint32_t offset=0;
-  for(size_t i=0;i<declSize;++i){
-    auto& loc=vsInput[i];
-    loc.location = uint32_t(i);
-    loc.binding  = 0;
-    loc.format   = nativeFormat(decl[i]);
-    loc.offset   = offset;
-
-    offset += uint32_t(Decl::size(decl[i]));
-    }
+  const uint32_t bindingCount = vertexAttributes(decl, declSize, vin, vsInput.get());
 
   VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
   vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
   vertexInputInfo.pNext = nullptr;
   vertexInputInfo.flags = 0;
-  vertexInputInfo.vertexBindingDescriptionCount   = (declSize>0 ? 1 : 0);
-  vertexInputInfo.pVertexBindingDescriptions      = &vertexInputBindingDescription;
+  vertexInputInfo.vertexBindingDescriptionCount   = bindingCount;
+  vertexInputInfo.pVertexBindingDescriptions      = vertexInputBindingDescription;
   vertexInputInfo.vertexAttributeDescriptionCount = uint32_t(declSize);
   vertexInputInfo.pVertexAttributeDescriptions    = vsInput.get();
 
@@ -282,9 +468,26 @@ VkPipeline VPipeline::initGraphicsPipeline(VDevice& device,
 
   VkPipelineDynamicStateCreateInfo dynamic = {};
   dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-  const VkDynamicState dySt[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+  VkDynamicState dySt[8] = {};
+  uint32_t       dyCnt   = 0;
+  if(preRaster) {
+    dySt[dyCnt++] = VK_DYNAMIC_STATE_VIEWPORT;
+    dySt[dyCnt++] = VK_DYNAMIC_STATE_SCISSOR;
+    if(device.props.hasExtDynState)
+      dySt[dyCnt++] = VK_DYNAMIC_STATE_CULL_MODE_EXT;
+    }
+  if(fragment && device.props.hasExtDynState) {
+    // values are set by VCommandBuffer, from RenderState of pipeline or Encoder overrides
+    dySt[dyCnt++] = VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT;
+    dySt[dyCnt++] = VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT;
+    dySt[dyCnt++] = VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT;
+    }
+  if(output && device.props.hasExtDynState3) {
+    dySt[dyCnt++] = VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT;
+    dySt[dyCnt++] = VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT;
+    }
   dynamic.pDynamicStates    = dySt;
-  dynamic.dynamicStateCount = 2;
+  dynamic.dynamicStateCount = dyCnt;
 
   VkPipelineCreateFlags2CreateInfo createFlags2{VK_STRUCTURE_TYPE_PIPELINE_CREATE_FLAGS_2_CREATE_INFO};
   createFlags2.flags = VK_PIPELINE_CREATE_2_DESCRIPTOR_HEAP_BIT_EXT;
@@ -321,6 +524,36 @@ VkPipeline VPipeline::initGraphicsPipeline(VDevice& device,
     // rasterizer.polygonMode = VK_POLYGON_MODE_LINE;
     }
 
+  VkGraphicsPipelineLibraryCreateInfoEXT libInfo = {};
+  libInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+  libInfo.flags = parts;
+  if(parts!=0) {
+    libInfo.pNext      = pipelineInfo.pNext;
+    pipelineInfo.pNext = &libInfo;
+    pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    }
+
+  VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+  const auto err = vkCreateGraphicsPipelines(device.device.impl,VK_NULL_HANDLE,1,&pipelineInfo,nullptr,&graphicsPipeline);
+  if(err!=VK_SUCCESS)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+  return graphicsPipeline;
+  }
+
+VkPipeline VPipeline::linkGraphicsPipeline(VDevice& device, VkPipelineLayout layout,
+                                           const VkPipeline* libs, uint32_t count, bool optimize) {
+  VkPipelineLibraryCreateInfoKHR libInfo = {};
+  libInfo.sType        = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+  libInfo.libraryCount = count;
+  libInfo.pLibraries   = libs;
+
+  VkGraphicsPipelineCreateInfo pipelineInfo = {};
+  pipelineInfo.sType  = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipelineInfo.pNext  = &libInfo;
+  pipelineInfo.layout = layout;
+  if(optimize)
+    pipelineInfo.flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+
   VkPipeline graphicsPipeline = VK_NULL_HANDLE;
   const auto err = vkCreateGraphicsPipelines(device.device.impl,VK_NULL_HANDLE,1,&pipelineInfo,nullptr,&graphicsPipeline);
   if(err!=VK_SUCCESS)
@@ -328,6 +561,23 @@ VkPipeline VPipeline::initGraphicsPipeline(VDevice& device,
   return graphicsPipeline;
   }
 
+const VkSpecializationInfo* VPipeline::specializationInfo(const SpecializationConstants& spec, VkSpecializationInfo& info,
+                                                       VkSpecializationMapEntry* map) {
+  if(spec.isEmpty())
+    return nullptr;
+  // entries are {id,value} pairs - values are addressed in place
+  for(size_t i=0; i<spec.size(); ++i) {
+    map[i].constantID = spec.entries()[i].id;
+    map[i].offset     = uint32_t(i*sizeof(SpecializationConstants::Entry) + offsetof(SpecializationConstants::Entry, value));
+    map[i].size       = sizeof(uint32_t);
+    }
+  info.mapEntryCount = uint32_t(spec.size());
+  info.pMapEntries   = map;
+  info.dataSize      = spec.size()*sizeof(SpecializationConstants::Entry);
+  info.pData         = spec.entries();
+  return &info;
+  }
+
 void VPipeline::initPushMappings(VDevice& device, VkShaderDescriptorSetAndBindingMappingInfoEXT& info, VkDescriptorSetAndBindingMappingEXT* mappings,
                                  const PushBlock& pb, const LayoutDesc& lay) {
   auto nativeFormat = [](ShaderReflection::Class cls) -> VkSpirvResourceTypeFlagsEXT {
@@ -382,8 +632,8 @@ bool VCompPipeline::Inst::isCompatible(VkPipelineLayout lay) const {
   }
 
 
-VCompPipeline::VCompPipeline(VDevice& device, const VShader& comp)
-  :device(device), wgSize(comp.comp.wgSize) {
+VCompPipeline::VCompPipeline(VDevice& device, const VShader& comp, const SpecializationConstants& spec)
+  :device(device), wgSize(comp.workGroupSize(spec)), spec(spec) {
   const std::vector<Detail::ShaderReflection::Binding>* bindings = &comp.lay;
   ShaderReflection::setupLayout(pb, layout, sync, &bindings, 1);
 
@@ -397,6 +647,9 @@ VCompPipeline::VCompPipeline(VDevice& device, const VShader& comp)
   VkPipelineCreateFlags2CreateInfo createFlags2{VK_STRUCTURE_TYPE_PIPELINE_CREATE_FLAGS_2_CREATE_INFO};
   createFlags2.flags = VK_PIPELINE_CREATE_2_DESCRIPTOR_HEAP_BIT_EXT;
 
+  SmallArray<VkSpecializationMapEntry, 16> specMap(spec.size());
+  VkSpecializationInfo                     specInfo = {};
+
   pipelineLayout = device.props.hasDescriptorHeap ? VK_NULL_HANDLE : device.psoLayouts.findLayout(pb, layout);
   shader         = Detail::DSharedPtr<const VShader*>{&comp};
 
@@ -408,6 +661,7 @@ VCompPipeline::VCompPipeline(VDevice& device, const VShader& comp)
     info.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
     info.stage.module = comp.impl;
     info.stage.pName  = "main";
+    info.stage.pSpecializationInfo = VPipeline::specializationInfo(spec, specInfo, specMap.get());
     info.layout       = pipelineLayout;
     if(layout.isUpdateAfterBind() && !device.props.hasDescriptorHeap) {
       info.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
@@ -464,6 +718,9 @@ VkPipeline VCompPipeline::instance(VkPipelineLayout pLay) {
     if(i.isCompatible(pLay))
       return i.val;
 
+  SmallArray<VkSpecializationMapEntry, 16> specMap(spec.size());
+  VkSpecializationInfo                     specInfo = {};
+
   VkDevice   dev = device.device.impl;
   VkPipeline val = VK_NULL_HANDLE;
   try {
@@ -473,6 +730,7 @@ VkPipeline VCompPipeline::instance(VkPipelineLayout pLay) {
     info.stage.stage        = VK_SHADER_STAGE_COMPUTE_BIT;
     info.stage.module       = shader.handler->impl;
     info.stage.pName        = "main";
+    info.stage.pSpecializationInfo = VPipeline::specializationInfo(spec, specInfo, specMap.get());
     info.layout             = pLay;
     info.flags              = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
     info.basePipelineHandle = impl;
@@ -15,21 +15,42 @@ namespace Tempest {
 namespace Detail {
 
 class VDevice;
+class VCompPipeline;
 
 class VPipeline : public AbstractGraphicsApi::Pipeline {
   public:
-    VPipeline(VDevice &device, Topology tp, const RenderState &st, const VShader** sh, size_t count);
+    VPipeline(VDevice &device, Topology tp, const RenderState &st, const SpecializationConstants& spec,
+              const VShader** sh, size_t count);
     VPipeline(VPipeline&& other) = delete;
     ~VPipeline();
 
+    // vertex buffer bindings; shader inputs are split across streams in order of locations
+    struct VertexInput {
+      uint32_t            stride [MaxVertexStreams] = {};
+      uint8_t             attribs[MaxVertexStreams] = {}; // inputs with explicit format, per stream; 0 - as reflected
+      Decl::ComponentType format [MaxVertexAttribs] = {}; // explicit formats of all streams, in order
+      uint8_t             count    = 1;
+      uint8_t             instance = 0; // bit-mask of per-instance streams
+
+      bool operator == (const VertexInput& other) const {
+        return count==other.count && instance==other.instance &&
+               std::memcmp(stride,  other.stride,  count*sizeof(uint32_t))==0 &&
+               std::memcmp(attribs, other.attribs, sizeof(attribs))==0 &&
+               std::memcmp(format,  other.format,  sizeof(format))==0;
+        }
+      bool operator != (const VertexInput& other) const { return !(*this==other); }
+      };
+
     struct Inst {
-      Inst(VkPipeline val, VkPipelineLayout pLay, size_t stride):val(val),pLay(pLay),stride(stride){}
+      Inst(VkPipeline val, VkPipelineLayout pLay, const VertexInput& vin):val(val),pLay(pLay),vin(vin){}
       Inst(Inst&&)=default;
       Inst& operator = (Inst&&)=default;
 
       VkPipeline       val;
       VkPipelineLayout pLay = VK_NULL_HANDLE;
-      size_t           stride;
+      VertexInput      vin;
+      VkPipeline       fast = VK_NULL_HANDLE; // fast-linked pipeline, superseded by optimized one
+      bool             linked = false;          // built from pipeline-library parts
       };
 
     using Binding    = ShaderReflection::Binding;
@@ -42,52 +63,90 @@ class VPipeline : public AbstractGraphicsApi::Pipeline {
     SyncDesc           sync;
 
     VkPipelineLayout   pipelineLayout = VK_NULL_HANDLE;
-    uint32_t           defaultStride  = 0;
+    VertexInput        defaultInput;
+
+    // compute part of emulated task/mesh pipeline, see VMeshletHelper
+    struct MeshEmu {
+      DSharedPtr<VCompPipeline*> task;
+      DSharedPtr<VCompPipeline*> mesh;
+      };
+    MeshEmu            emu;
+    bool               isMeshEmulated() const { return emu.mesh.handler!=nullptr; }
 
-    VkPipeline         instance(const VkPipelineRenderingCreateInfoKHR& info, VkRenderPass pass, VkPipelineLayout pLay, size_t stride);
+    VkPipeline         instance(const VkPipelineRenderingCreateInfoKHR& info, VkRenderPass pass, VkPipelineLayout pLay, const VertexInput& vin);
 
     IVec3              workGroupSize() const override;
     size_t             sizeofBuffer(size_t id, size_t arraylen) const override;
+    PipelineStats      stats() const override;
+
+    const RenderState& renderState() const { return st; }
 
   private:
     struct InstRp : Inst {
-      InstRp(const std::shared_ptr<VFramebufferMap::RenderPass>& lay, VkPipelineLayout pLay, size_t stride, VkPipeline val):Inst(val,pLay,stride),lay(lay){}
+      InstRp(const std::shared_ptr<VFramebufferMap::RenderPass>& lay, VkPipelineLayout pLay, const VertexInput& vin, VkPipeline val):Inst(val,pLay,vin),lay(lay){}
       std::shared_ptr<VFramebufferMap::RenderPass> lay;
 
-      bool                             isCompatible(const std::shared_ptr<VFramebufferMap::RenderPass>& dr, VkPipelineLayout pLay, size_t stride) const;
+      bool                             isCompatible(const std::shared_ptr<VFramebufferMap::RenderPass>& dr, VkPipelineLayout pLay, const VertexInput& vin) const;
       };
 
     struct InstDr : Inst {
-      InstDr(const VkPipelineRenderingCreateInfoKHR& lay, VkPipelineLayout pLay, size_t stride, VkPipeline val):Inst(val,pLay,stride),lay(lay){
+      InstDr(const VkPipelineRenderingCreateInfoKHR& lay, VkPipelineLayout pLay, const VertexInput& vin, VkPipeline val):Inst(val,pLay,vin),lay(lay){
         std::memcpy(colorFrm, lay.pColorAttachmentFormats, lay.colorAttachmentCount*sizeof(VkFormat));
         }
       VkPipelineRenderingCreateInfoKHR lay;
       VkFormat                         colorFrm[MaxFramebufferAttachments] = {};
 
-      bool                             isCompatible(const VkPipelineRenderingCreateInfoKHR& dr, VkPipelineLayout pLay, size_t stride) const;
+      bool                             isCompatible(const VkPipelineRenderingCreateInfoKHR& dr, VkPipelineLayout pLay, const VertexInput& vin) const;
       };
 
     VDevice&                               device;
     Topology                               tp = Topology::Triangles;
     Tempest::RenderState                   st;
+    SpecializationConstants                spec;
     size_t                                 declSize=0;
     DSharedPtr<const VShader*>             modules[5] = {};
     std::unique_ptr<Decl::ComponentType[]> decl;
     IVec3                                  wgSize = {};
 
-    SpinLock                               syncInst;
+    mutable SpinLock                       syncInst;
     std::vector<InstRp>                    instRp;
     std::vector<InstDr>                    instDr;
 
+    // parts of VK_EXT_graphics_pipeline_library, shared by all instances
+    struct Library {
+      VkPipelineLayout pLay     = VK_NULL_HANDLE;
+      uint32_t         viewMask = 0;
+      VertexInput      vin      = {};
+      VkPipeline       val      = VK_NULL_HANDLE;
+      };
+    std::vector<Library>                   libInput;
+    std::vector<Library>                   libPreRaster;
+    std::vector<Library>                   libFragment;
+    std::vector<InstDr>                    libOutput;
+
     const VShader*                         findShader(ShaderReflection::Stage sh) const;
+    bool                                   useLibraries(VkRenderPass pass) const;
+    VkPipeline                             library(std::vector<Library>& cache, const Library& key, VkGraphicsPipelineLibraryFlagsEXT part,
+                                                   const VkPipelineRenderingCreateInfoKHR& info);
+    VkPipeline                             libraryOutput(const VkPipelineRenderingCreateInfoKHR& info);
+    void                                   linkOptimized(VkPipelineLayout pLay, VkPipeline fast, const VkPipeline* libs);
+    void                                   setupMeshEmulation(const VShader** sh, size_t count);
     void                                   cleanup();
 
     VkPipeline                   initGraphicsPipeline(VDevice& device, VkPipelineLayout layout,
                                                       const VkRenderPass rpass, const VkPipelineRenderingCreateInfoKHR* dynLay, const RenderState &st,
-                                                      const Decl::ComponentType *decl, size_t declSize, size_t stride,
+                                                      const Decl::ComponentType *decl, size_t declSize, const VertexInput& vin,
                                                       Topology tp,
-                                                      const DSharedPtr<const VShader*>* shaders);
-
+                                                      const DSharedPtr<const VShader*>* shaders,
+                                                      VkGraphicsPipelineLibraryFlagsEXT parts);
+    //! assigns shader inputs to streams of `vin`; returns count of used streams, throws on mismatch
+    static uint32_t              vertexAttributes(const Decl::ComponentType* decl, size_t declSize, const VertexInput& vin,
+                                                  VkVertexInputAttributeDescription* out);
+    static VkPipeline            linkGraphicsPipeline(VDevice& device, VkPipelineLayout layout,
+                                                      const VkPipeline* libs, uint32_t count, bool optimize);
+
+    static const VkSpecializationInfo* specializationInfo(const SpecializationConstants& spec, VkSpecializationInfo& info,
+                                                          VkSpecializationMapEntry* map);
     static void initPushMappings(VDevice& device,
                                  VkShaderDescriptorSetAndBindingMappingInfoEXT& info, VkDescriptorSetAndBindingMappingEXT* mappings,
                                  const PushBlock& pb, const LayoutDesc& layout);
@@ -97,7 +156,7 @@ class VPipeline : public AbstractGraphicsApi::Pipeline {
 
 class VCompPipeline : public AbstractGraphicsApi::CompPipeline {
   public:
-    VCompPipeline(VDevice &device, const VShader& comp);
+    VCompPipeline(VDevice &device, const VShader& comp, const SpecializationConstants& spec);
     VCompPipeline(VCompPipeline&& other) = delete;
     ~VCompPipeline();
 
@@ -130,8 +189,9 @@ class VCompPipeline : public AbstractGraphicsApi::CompPipeline {
       VkPipelineLayout      dLay;
       };
 
-    VDevice&           device;
-    IVec3              wgSize;
+    VDevice&                device;
+    IVec3                   wgSize;
+    SpecializationConstants spec;
 
     Detail::DSharedPtr<const VShader*> shader;
 
@@ -0,0 +1,59 @@
+#if defined(TEMPEST_BUILD_VULKAN)
+
+#include "vpipelinelinker.h"
+
+#include <algorithm>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+VPipelineLinker::VPipelineLinker() {
+  th = std::thread([this](){ threadFn(); });
+  }
+
+VPipelineLinker::~VPipelineLinker() {
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    exit = true;
+    pending.clear();
+  }
+  cv.notify_all();
+  th.join();
+  }
+
+void VPipelineLinker::push(const void* owner, std::function<void()>&& fn) {
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    pending.push_back({owner, std::move(fn)});
+  }
+  cv.notify_all();
+  }
+
+void VPipelineLinker::cancel(const void* owner) {
+  std::unique_lock<std::mutex> guard(sync);
+  pending.erase(std::remove_if(pending.begin(), pending.end(), [owner](const Task& t){ return t.owner==owner; }),
+                pending.end());
+  cv.wait(guard, [this, owner](){ return running!=owner; });
+  }
+
+void VPipelineLinker::threadFn() {
+  std::unique_lock<std::mutex> guard(sync);
+  while(true) {
+    cv.wait(guard, [this](){ return exit || !pending.empty(); });
+    if(exit)
+      return;
+
+    Task t = std::move(pending.front());
+    pending.erase(pending.begin());
+    running = t.owner;
+    guard.unlock();
+
+    t.fn();
+
+    guard.lock();
+    running = nullptr;
+    cv.notify_all();
+    }
+  }
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+/**
+ * Background worker for link-time optimized graphics pipelines (VK_EXT_graphics_pipeline_library).
+ *
+ * VPipeline::instance returns fast-linked pipeline right away and pushes optimized link here;
+ * result is swapped into instance cache, once ready. Tasks are tagged by owner: pipeline must
+ * call cancel, before it's destroyed.
+ */
+class VPipelineLinker {
+  public:
+    VPipelineLinker();
+    ~VPipelineLinker();
+
+    void push(const void* owner, std::function<void()>&& fn);
+    void cancel(const void* owner);
+
+  private:
+    struct Task {
+      const void*           owner = nullptr;
+      std::function<void()> fn;
+      };
+
+    void                    threadFn();
+
+    std::mutex              sync;
+    std::condition_variable cv;
+    std::vector<Task>       pending;
+    const void*             running = nullptr;
+    bool                    exit    = false;
+    std::thread             th;
+  };
+
+}
+}
@@ -4,6 +4,7 @@
 #include "vdevice.h"
 #include "vdescriptorarray.h"
 
+#include <algorithm>
 #include <bit>
 
 using namespace Tempest;
@@ -53,16 +54,20 @@ void VPoolCache::setupLimits() {
     }
   }
 
+VPoolCache::DSet::~DSet() {
+  if(pool!=VK_NULL_HANDLE)
+    vkDestroyDescriptorPool(dev, pool, nullptr);
+  }
+
 void VPoolCache::notifyDestroy(const AbstractGraphicsApi::NoCopy* res) {
   std::lock_guard<std::mutex> guard(sync);
 
   for(size_t i=0; i<descriptors.size();) {
     auto& d = descriptors[i];
-    if(!d.bindings.contains(res)) {
+    if(!d->bindings.contains(res)) {
       ++i;
       continue;
       }
-    vkDestroyDescriptorPool(dev.device.impl, d.pool, nullptr);
     d = std::move(descriptors.back());
     descriptors.pop_back();
     }
@@ -78,7 +83,7 @@ VkDescriptorPool VPoolCache::allocPool() {
       }
   }
 
-  VkDescriptorPoolSize poolSize[int(ShaderReflection::Class::Count)] = {};
+  VkDescriptorPoolSize poolSize[int(ShaderReflection::Class::Count)+1] = {};
   size_t               pSize   = 0;
 
   const uint32_t maxResources = 8096;
@@ -139,6 +144,14 @@ VkDescriptorPool VPoolCache::allocPool() {
       }
     }
 
+  if(dev.props.maxDynamicUbo>0) {
+    // see VDevice::dynamicUboMask
+    auto& sz = poolSize[pSize];
+    ++pSize;
+    sz.type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    sz.descriptorCount = std::min(limits.maxDescriptorSetUniformBuffers, maxResources);
+    }
+
   VkDescriptorPoolCreateInfo poolInfo = {};
   poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
   poolInfo.maxSets       = std::max(maxResources, maxSamplers);
@@ -227,12 +240,15 @@ VkDescriptorSet VPoolCache::allocDescSet(VkDescriptorPool pool, VkDescriptorSetL
   }
 
 VPoolCache::Inst VPoolCache::allocBindless(const PushBlock& pb, const LayoutDesc& layout, const Bindings& binding) {
-  auto lx = layout;
-  for(uint32_t mask = lx.runtime; mask!=0;) {
+  auto     lx = layout;
+  uint32_t version[MaxBindings] = {};
+  for(uint32_t mask = (lx.active & binding.array); mask!=0;) {
     const int i = std::countr_zero(mask);
     mask ^= (1u << i);
     auto* a = reinterpret_cast<const VDescriptorArray*>(binding.data[i]);
-    lx.count[i] = uint32_t(a->size());
+    if((lx.runtime & (1u << i))!=0)
+      lx.count[i] = uint32_t(a->size());
+    version[i] = a->version;
     }
 
   Inst ret;
@@ -240,29 +256,44 @@ VPoolCache::Inst VPoolCache::allocBindless(const PushBlock& pb, const LayoutDesc
   ret.pLay = dev.psoLayouts.findLayout(pb, ret.dLay);
 
   std::lock_guard<std::mutex> guard(sync);
-  for(auto& i:descriptors) {
-    if(i.dLay!=ret.dLay || i.bindings!=binding)
+  for(size_t i=0; i<descriptors.size();) {
+    auto& d = descriptors[i];
+    if(d->bindings!=binding) {
+      ++i;
       continue;
-    ret.set = i.set;
-    return ret;
+      }
+    if(!std::equal(std::begin(version), std::end(version), d->version)) {
+      // array was reallocated: old copy is released, once command buffers are done with it
+      d = std::move(descriptors.back());
+      descriptors.pop_back();
+      continue;
+      }
+    if(d->dLay==ret.dLay) {
+      // only slots, written since last use, are copied; set is update-after-bind
+      updateDescriptorSet(*d, lx);
+      ret.set = d->set;
+      ret.ref = d;
+      return ret;
+      }
+    ++i;
     }
 
-  auto& desc = descriptors.emplace_back();
-  try {
-    desc.dLay     = ret.dLay;
-    desc.bindings = binding;
-    desc.pool     = allocPool(lx);
-    desc.set      = allocDescSet(desc.pool, ret.dLay);
-    initDescriptorSet(desc.set, binding, lx);
-    }
-  catch(...) {
-    if(desc.pool!=VK_NULL_HANDLE)
-      vkDestroyDescriptorPool(dev.device.impl, desc.pool, nullptr);
-    descriptors.pop_back();
-    throw;
+  auto desc = std::make_shared<DSet>(dev.device.impl);
+  desc->dLay     = ret.dLay;
+  desc->bindings = binding;
+  std::copy(std::begin(version), std::end(version), desc->version);
+  for(uint32_t mask = (lx.active & binding.array); mask!=0;) {
+    const int i = std::countr_zero(mask);
+    mask ^= (1u << i);
+    desc->seq[i] = reinterpret_cast<const VDescriptorArray*>(binding.data[i])->seq();
     }
+  desc->pool     = allocPool(lx);
+  desc->set      = allocDescSet(desc->pool, ret.dLay);
+  initDescriptorSet(desc->set, binding, lx);
+  descriptors.push_back(desc);
 
-  ret.set  = desc.set;
+  ret.set = desc->set;
+  ret.ref = std::move(desc);
   return ret;
   }
 
@@ -290,7 +321,7 @@ void VPoolCache::initDescriptorSet(VkDescriptorSet dset, const Bindings &binding
       cx.dstSet          = dset;
       cx.dstBinding      = uint32_t(i);
       cx.dstArrayElement = 0;
-      cx.descriptorCount = uint32_t(arr->size());
+      cx.descriptorCount = std::min(uint32_t(arr->size()), l.count[i]);
       if(cx.descriptorCount>0)
         ++cntCpy;
       continue;
@@ -308,4 +339,13 @@ void VPoolCache::initDescriptorSet(VkDescriptorSet dset, const Bindings &binding
   vkUpdateDescriptorSets(dev.device.impl, cntWr, wr, cntCpy, cpy);
   }
 
+void VPoolCache::updateDescriptorSet(DSet& dset, const LayoutDesc& l) {
+  for(uint32_t mask = (l.active & dset.bindings.array); mask!=0;) {
+    const int i = std::countr_zero(mask);
+    mask ^= (1u << i);
+    auto arr = reinterpret_cast<const VDescriptorArray*>(dset.bindings.data[i]);
+    dset.seq[i] = arr->update(dset.set, uint32_t(i), l.count[i], dset.seq[i]);
+    }
+  }
+
 #endif
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <mutex>
 
@@ -24,6 +25,7 @@ class VPoolCache {
       VkDescriptorSet       set  = VK_NULL_HANDLE;
       VkDescriptorSetLayout dLay = VK_NULL_HANDLE;
       VkPipelineLayout      pLay = VK_NULL_HANDLE;
+      std::shared_ptr<void> ref; // keeps set alive, while in use by command buffer
       };
 
     void             setupLimits();
@@ -38,8 +40,14 @@ class VPoolCache {
     static constexpr const size_t MaxCache = 2;
 
     struct DSet {
+      explicit DSet(VkDevice dev):dev(dev) {}
+      ~DSet();
+
+      VkDevice              dev  = VK_NULL_HANDLE;
       VkDescriptorSetLayout dLay = VK_NULL_HANDLE;
       Bindings              bindings;
+      uint32_t              version[MaxBindings] = {}; // of descriptor arrays, at time of copy
+      uint32_t              seq    [MaxBindings] = {}; // last write of descriptor arrays, applied to set
 
       VkDescriptorPool      pool = VK_NULL_HANDLE;
       VkDescriptorSet       set  = VK_NULL_HANDLE;
@@ -48,6 +56,7 @@ class VPoolCache {
     VkDescriptorPool allocPool(const LayoutDesc &l);
     VkDescriptorSet  allocDescSet(VkDescriptorPool pool, VkDescriptorSetLayout lay);
     void             initDescriptorSet(VkDescriptorSet dset, const Bindings &binding, const LayoutDesc& l);
+    void             updateDescriptorSet(DSet& dset, const LayoutDesc& l);
 
     VDevice&                      dev;
     VkPhysicalDeviceLimits        limits = {};
@@ -55,7 +64,7 @@ class VPoolCache {
 
     std::mutex                    sync;
     std::vector<VkDescriptorPool> cache;
-    std::vector<DSet>             descriptors;
+    std::vector<std::shared_ptr<DSet>> descriptors;
   };
 
 }
@@ -11,46 +11,46 @@ VPsoLayoutCache::VPsoLayoutCache(VDevice& dev)
   }
 
 VPsoLayoutCache::~VPsoLayoutCache() {
-  for(auto& i:layouts)
-    vkDestroyPipelineLayout(dev.device.impl, i.pLay, nullptr);
+  layouts.forEach([this](const Key&, VkPipelineLayout pLay) {
+    vkDestroyPipelineLayout(dev.device.impl, pLay, nullptr);
+    });
   }
 
-VkPipelineLayout VPsoLayoutCache::findLayout(const ShaderReflection::PushBlock& pb, VkDescriptorSetLayout lay) {
-  std::lock_guard<std::mutex> guard(sync);
+size_t VPsoLayoutCache::Hash::operator()(const Key& k) const {
+  uint64_t h = hashBytes(&k.lay, sizeof(k.lay));
+  h = hashBytes(&k.pushStage, sizeof(k.pushStage), h);
+  h = hashBytes(&k.pushSize,  sizeof(k.pushSize),  h);
+  return size_t(h);
+  }
 
-  const auto stageFlags = nativeFormat(pb.stage);
-  for(auto& i:layouts)
-    if(i.lay==lay && i.pushStage==stageFlags && i.pushSize==pb.size)
-      return i.pLay;
+VkPipelineLayout VPsoLayoutCache::findLayout(const ShaderReflection::PushBlock& pb, VkDescriptorSetLayout lay) {
+  Key k;
+  k.lay       = lay;
+  k.pushStage = nativeFormat(pb.stage);
+  k.pushSize  = uint32_t(pb.size);
+  return layouts.findOrInsert(k, [&](){ return mkLayout(k); });
+  }
 
+VkPipelineLayout VPsoLayoutCache::mkLayout(const Key& k) {
   VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
   pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-  pipelineLayoutInfo.pSetLayouts            = &lay;
+  pipelineLayoutInfo.pSetLayouts            = &k.lay;
   pipelineLayoutInfo.setLayoutCount         = 1;
   pipelineLayoutInfo.pushConstantRangeCount = 0;
 
   VkPushConstantRange push = {};
-  if(pb.size>0) {
-    push.stageFlags = nativeFormat(pb.stage);
+  if(k.pushSize>0) {
+    push.stageFlags = k.pushStage;
     push.offset     = 0;
-    push.size       = uint32_t(pb.size);
+    push.size       = k.pushSize;
 
     pipelineLayoutInfo.pPushConstantRanges    = &push;
     pipelineLayoutInfo.pushConstantRangeCount = 1;
     }
 
-  auto& ret = layouts.emplace_back();
-  ret.lay       = lay;
-  ret.pushStage = stageFlags;
-  ret.pushSize  = uint32_t(pb.size);
-  try {
-    vkAssert(vkCreatePipelineLayout(dev.device.impl, &pipelineLayoutInfo, nullptr, &ret.pLay));
-    }
-  catch(...) {
-    layouts.pop_back();
-    throw;
-    }
-  return ret.pLay;
+  VkPipelineLayout ret = VK_NULL_HANDLE;
+  vkAssert(vkCreatePipelineLayout(dev.device.impl, &pipelineLayoutInfo, nullptr, &ret));
+  return ret;
   }
 
 VkPipelineLayout VPsoLayoutCache::findLayout(const ShaderReflection::PushBlock& pb, const ShaderReflection::LayoutDesc& lay) {
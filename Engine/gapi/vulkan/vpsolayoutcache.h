@@ -1,9 +1,7 @@
 #pragma once
 
-#include <vector>
-#include <mutex>
-
 #include "gapi/shaderreflection.h"
+#include "utility/shardedmap.h"
 #include "vulkan_sdk.h"
 
 namespace Tempest {
@@ -20,16 +18,23 @@ class VPsoLayoutCache {
     VkPipelineLayout      findLayout(const ShaderReflection::PushBlock &pb, const ShaderReflection::LayoutDesc& lay);
 
   private:
-    struct Layout {
+    struct Key {
       VkShaderStageFlags    pushStage = 0;
       uint32_t              pushSize  = 0;
       VkDescriptorSetLayout lay       = VK_NULL_HANDLE;
-      VkPipelineLayout      pLay      = VK_NULL_HANDLE;
+
+      bool operator == (const Key& other) const {
+        return lay==other.lay && pushStage==other.pushStage && pushSize==other.pushSize;
+        }
       };
+    struct Hash {
+      size_t operator()(const Key& k) const;
+      };
+
+    VkPipelineLayout                           mkLayout(const Key& k);
 
-    VDevice&             dev;
-    std::mutex           sync;
-    std::vector<Layout>  layouts;
+    VDevice&                                   dev;
+    ShardedMap<Key, VkPipelineLayout, Hash>    layouts;
   };
 
 }
@@ -6,6 +6,9 @@
 #include "gapi/vulkan/vdescriptorarray.h"
 #include "gapi/vulkan/vdevice.h"
 
+#include <algorithm>
+#include <bit>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
@@ -40,6 +43,7 @@ void VPushDescriptor::reset() {
   resPool.clear();
   memHeap.clear();
 
+  lastSet     = LastSet();
   lastResHeap = nullptr;
   lastSmpHeap = nullptr;
   }
@@ -73,11 +77,6 @@ VkDescriptorSet VPushDescriptor::allocSet(const VkDescriptorSetLayout dLayout) {
   return VK_NULL_HANDLE;
   }
 
-VkDescriptorSet VPushDescriptor::allocSet(const LayoutDesc& lay) {
-  auto lt = dev.setLayouts.findLayout(lay);
-  return allocSet(lt);
-  }
-
 uint32_t VPushDescriptor::allocHeap(VkCommandBuffer cmd, const uint32_t sz, const uint32_t step) {
   if(resPool.empty()) {
     resPool.emplace_back(dev, step);
@@ -175,8 +174,28 @@ void VPushDescriptor::bindHeap(VkCommandBuffer cmd, const DSharedPtr<VDescriptor
     }
   }
 
-VkDescriptorSet VPushDescriptor::push(const PushBlock& pb, const LayoutDesc& lay, const Bindings& binding) {
-  auto set = allocSet(lay);
+bool VPushDescriptor::isSame(const Bindings& a, const Bindings& b) {
+  if(a!=b)
+    return false;
+  for(size_t i=0; i<MaxBindings; ++i)
+    if(a.map[i]!=b.map[i])
+      return false;
+  return true;
+  }
+
+VkDescriptorSet VPushDescriptor::push(const PushBlock& pb, const LayoutDesc& lay, const Bindings& binding, uint32_t dynamic) {
+  const auto dLay = dev.setLayouts.findLayout(lay);
+
+  Bindings key = binding;
+  for(uint32_t mask = dynamic; mask!=0;) {
+    const int i = std::countr_zero(mask);
+    mask ^= (1u << i);
+    key.offset[i] = 0;
+    }
+  if(lastSet.set!=VK_NULL_HANDLE && lastSet.lay==dLay && isSame(lastSet.key, key))
+    return lastSet.set;
+
+  auto set = allocSet(dLay);
 
   WriteInfo              winfo[MaxBindings] = {};
   VkWriteDescriptorSet   wr   [MaxBindings] = {};
@@ -186,13 +205,25 @@ VkDescriptorSet VPushDescriptor::push(const PushBlock& pb, const LayoutDesc& lay
     auto  cls = lay.bindings[i];
     auto& wx  = wr[cntWr];
     VPushDescriptor::write(dev, wx, winfo[cntWr], uint32_t(i), cls,
-                           binding.data[i], binding.offset[i], binding.map[i], binding.smp[i]);
+                           binding.data[i], key.offset[i], binding.map[i], binding.smp[i]);
+    if((dynamic & (1u << i))!=0 && wx.descriptorCount>0) {
+      auto& info = winfo[cntWr].buffer;
+      auto* buf  = reinterpret_cast<VBuffer*>(binding.data[i]);
+      // dynamic offset + range must fit into buffer: bind fixed-size block, instead of VK_WHOLE_SIZE
+      if(info.range==VK_WHOLE_SIZE && buf!=nullptr && lay.bufferSz[i]>0)
+        info.range = std::min<VkDeviceSize>(lay.bufferSz[i], buf->size());
+      wx.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+      }
     wx.dstSet = set;
     if(wx.descriptorCount>0)
       ++cntWr;
     }
 
   vkUpdateDescriptorSets(dev.device.impl, cntWr, wr, 0, nullptr);
+
+  lastSet.lay = dLay;
+  lastSet.set = set;
+  lastSet.key = key;
   return set;
   }
 
@@ -31,7 +31,8 @@ class VPushDescriptor {
     void            onNextCmdChunk();
 
     void            pushHeap(VkCommandBuffer cmd, uint32_t* indices, const PushBlock& pb, const LayoutDesc& lay, const Bindings& binding);
-    VkDescriptorSet push(const PushBlock &pb, const LayoutDesc& lay, const Bindings& binding);
+    //! uniform buffers from `dynamic` mask are written with zero offset: binding offset is expected as dynamic offset
+    VkDescriptorSet push(const PushBlock &pb, const LayoutDesc& lay, const Bindings& binding, uint32_t dynamic);
 
     static void     write(VDevice &dev, VkWriteDescriptorSet &wx, WriteInfo &infoW, uint32_t dstBinding,
                           ShaderReflection::Class cls, AbstractGraphicsApi::NoCopy *data, uint32_t offset, const ComponentMapping& mapping, const Sampler &smp);
@@ -59,15 +60,23 @@ class VPushDescriptor {
       };
 
     VkDescriptorSet allocSet(const VkDescriptorSetLayout dLayout);
-    VkDescriptorSet allocSet(const LayoutDesc& layout);
     uint32_t        allocHeap(VkCommandBuffer cmd, const uint32_t sz, const uint32_t step);
 
+    static bool     isSame(const Bindings& a, const Bindings& b);
     void            bindHeap(VkCommandBuffer cmd, const DSharedPtr<VDescriptorHeap*>& res, const DSharedPtr<VDescriptorHeap*>& smp);
 
     std::vector<DescPool> descPool;
     std::vector<ResPool>  resPool;
     std::vector<DSharedPtr<VDescriptorHeap*>> memHeap;
 
+    // last pushed set; reused as long as only dynamic offsets do change
+    struct LastSet {
+      VkDescriptorSetLayout lay = VK_NULL_HANDLE;
+      VkDescriptorSet       set = VK_NULL_HANDLE;
+      Bindings              key;
+      };
+    LastSet          lastSet;
+
     VDescriptorHeap* lastResHeap = nullptr;
     VDescriptorHeap* lastSmpHeap = nullptr;
   };
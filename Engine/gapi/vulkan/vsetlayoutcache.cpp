@@ -6,7 +6,17 @@
 using namespace Tempest;
 using namespace Tempest::Detail;
 
-static bool compare(const ShaderReflection::LayoutDesc& a, const ShaderReflection::LayoutDesc& b) {
+size_t VSetLayoutCache::Hash::operator()(const LayoutDesc& l) const {
+  uint64_t h = hashBytes(l.bindings, sizeof(l.bindings));
+  h = hashBytes(l.stage, sizeof(l.stage), h);
+  h = hashBytes(l.count, sizeof(l.count), h);
+  h = hashBytes(&l.runtime, sizeof(l.runtime), h);
+  h = hashBytes(&l.array,   sizeof(l.array),   h);
+  h = hashBytes(&l.active,  sizeof(l.active),  h);
+  return size_t(h);
+  }
+
+bool VSetLayoutCache::Equal::operator()(const LayoutDesc& a, const LayoutDesc& b) const {
   if(std::memcmp(a.bindings, b.bindings, sizeof(a.bindings))!=0)
     return false;
   if(std::memcmp(a.stage, b.stage, sizeof(a.stage))!=0)
@@ -23,24 +33,20 @@ VSetLayoutCache::VSetLayoutCache(VDevice& dev)
   }
 
 VSetLayoutCache::~VSetLayoutCache() {
-  for(auto& i:layouts)
-    vkDestroyDescriptorSetLayout(dev.device.impl, i.lay, nullptr);
+  layouts.forEach([this](const LayoutDesc&, VkDescriptorSetLayout lay) {
+    vkDestroyDescriptorSetLayout(dev.device.impl, lay, nullptr);
+    });
   }
 
 VkDescriptorSetLayout VSetLayoutCache::findLayout(const ShaderReflection::LayoutDesc& l) {
-  std::lock_guard<std::mutex> guard(syncLay);
-  for(auto& i:layouts) {
-    if(!compare(i.desc,l))
-      continue;
-    return i.lay;
-    }
-
-  Layout& ret = layouts.emplace_back();
-  ret.desc = l;
+  return layouts.findOrInsert(l, [&](){ return mkLayout(l); });
+  }
 
+VkDescriptorSetLayout VSetLayoutCache::mkLayout(const LayoutDesc& l) {
   VkDescriptorSetLayoutBinding bind[MaxBindings] = {};
   VkDescriptorBindingFlags     flg [MaxBindings] = {};
   uint32_t                     count             = 0;
+  const uint32_t               dynamic           = dev.dynamicUboMask(l);
   for(size_t i=0; i<MaxBindings; ++i) {
     if(l.bindings[i]==ShaderReflection::Count)
       continue;
@@ -50,11 +56,17 @@ VkDescriptorSetLayout VSetLayoutCache::findLayout(const ShaderReflection::Layout
     auto& b = bind[count];
     if((l.runtime & (1u << i))!=0)
       flg[count] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    if((l.array & (1u << i))!=0 && dev.isInplaceUpdatable(l.bindings[i])) {
+      // descriptor arrays are updated in place, see VPoolCache::updateDescriptorSet
+      flg[count] |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+      }
 
     b.binding         = uint32_t(i);
     b.descriptorCount = l.count[i];
     b.descriptorCount = std::max<uint32_t>(1, b.descriptorCount); // WA for VUID-VkGraphicsPipelineCreateInfo-layout-07988
     b.descriptorType  = nativeFormat(l.bindings[i]);
+    if((dynamic & (1u << i))!=0)
+      b.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     b.stageFlags      = nativeFormat(l.stage[i]);
     ++count;
     }
@@ -76,14 +88,9 @@ VkDescriptorSetLayout VSetLayoutCache::findLayout(const ShaderReflection::Layout
     info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
     }
 
-  try {
-    vkAssert(vkCreateDescriptorSetLayout(dev.device.impl, &info, nullptr, &ret.lay));
-    }
-  catch(...) {
-    layouts.pop_back();
-    throw;
-    }
-  return ret.lay;
+  VkDescriptorSetLayout ret = VK_NULL_HANDLE;
+  vkAssert(vkCreateDescriptorSetLayout(dev.device.impl, &info, nullptr, &ret));
+  return ret;
   }
 
 #endif
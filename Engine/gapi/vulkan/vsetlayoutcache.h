@@ -1,9 +1,7 @@
 #pragma once
 
-#include <vector>
-#include <mutex>
-
 #include "gapi/shaderreflection.h"
+#include "utility/shardedmap.h"
 #include "vulkan_sdk.h"
 
 namespace Tempest {
@@ -21,14 +19,17 @@ class VSetLayoutCache {
   private:
     using LayoutDesc = ShaderReflection::LayoutDesc;
 
-    struct Layout {
-      LayoutDesc            desc;
-      VkDescriptorSetLayout lay;
+    struct Hash {
+      size_t operator()(const LayoutDesc& l) const;
+      };
+    struct Equal {
+      bool   operator()(const LayoutDesc& a, const LayoutDesc& b) const;
       };
 
-    VDevice&             dev;
-    std::mutex           syncLay;
-    std::vector<Layout>  layouts;
+    VkDescriptorSetLayout mkLayout(const LayoutDesc& l);
+
+    VDevice&                                                         dev;
+    ShardedMap<LayoutDesc, VkDescriptorSetLayout, Hash, Equal>       layouts;
   };
 
 }
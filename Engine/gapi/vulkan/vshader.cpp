@@ -3,11 +3,58 @@
 #include "vshader.h"
 
 #include "vdevice.h"
+#include "vmeshlethelper.h"
+
+#include "gapi/spirv/meshconverter.h"
+#include "gapi/spirv/shaderoptimizer.h"
+#include "gapi/shadercache.h"
 
 using namespace Tempest::Detail;
 
-VShader::VShader(VDevice& device, const void *source, size_t src_size)
-  :Shader(source, src_size), device(device.device.impl) {
+VShader::VShader(VDevice& device, const void *source, size_t src_size, ShaderCache* cache, const ShaderKey* key)
+  :Shader(source, src_size, cache, key), device(device.device.impl) {
+  if((stage==ShaderReflection::Task || stage==ShaderReflection::Mesh) && device.props.meshlets.emulated) {
+    convertMeshShader(device, source, src_size);
+    return;
+    }
+
+  if(key!=nullptr && key->optimize) {
+    // reflection is done on original bytecode already
+    libspirv::MutableBytecode code(reinterpret_cast<const uint32_t*>(source), src_size/4);
+    ShaderOptimizer opt(code);
+    opt.exec();
+    createModule(device, code.opcodes(), code.size()*4);
+    return;
+    }
+  createModule(device, source, src_size);
+  }
+
+VShader::VShader(VDevice& device)
+  :Shader(), device(device.device.impl) {
+  }
+
+void VShader::convertMeshShader(VDevice& device, const void* source, size_t src_size) {
+  for(auto& i:lay) {
+    if(i.layout>=VMeshletHelper::IndirectSlot)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule, "\"" + dbg.source + "\": binding slot is reserved for mesh emulation");
+    }
+
+  libspirv::MutableBytecode code(reinterpret_cast<const uint32_t*>(source), src_size/4);
+  MeshConverter conv(code);
+  conv.exec();
+
+  auto& comp = conv.computeShader();
+  VMeshletHelper::remapBindings(comp, ShaderReflection::Compute);
+  emu.comp = DSharedPtr<VShader*>(new VShader(device, comp.opcodes(), comp.size()*4));
+
+  if(stage==ShaderReflection::Mesh) {
+    auto& vert = conv.vertexPassthrough();
+    VMeshletHelper::remapBindings(vert, ShaderReflection::Vertex);
+    emu.vert = DSharedPtr<VShader*>(new VShader(device, vert.opcodes(), vert.size()*4));
+    }
+  }
+
+void VShader::createModule(VDevice& device, const void* source, size_t src_size) {
   VkShaderModuleCreateInfo createInfo = {};
   createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
   createInfo.codeSize = src_size;
@@ -23,10 +70,6 @@ VShader::VShader(VDevice& device, const void *source, size_t src_size)
   device.vkDebugMarkerSetObjectName(device.device.impl, &nameInfo);
   }
 
-VShader::VShader(VDevice& device)
-  :Shader(), device(device.device.impl) {
-  }
-
 VShader::~VShader() {
   if(impl!=VK_NULL_HANDLE)
     vkDestroyShaderModule(device,impl,nullptr);
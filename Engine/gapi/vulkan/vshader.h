@@ -3,6 +3,7 @@
 #include <Tempest/AbstractGraphicsApi>
 
 #include "gapi/shader.h"
+#include "utility/dptr.h"
 #include "vulkan_sdk.h"
 
 namespace Tempest {
@@ -12,14 +13,25 @@ class VDevice;
 
 class VShader : public Tempest::Detail::Shader {
   public:
-    VShader(VDevice& device, const void* source, size_t src_size);
+    VShader(VDevice& device, const void* source, size_t src_size, ShaderCache* cache = nullptr, const ShaderKey* key = nullptr);
     explicit VShader(VDevice& device);
     ~VShader();
 
     VkShaderModule impl = VK_NULL_HANDLE;
 
+    // converted task/mesh shader, when device has no native mesh-shading
+    struct MeshEmu {
+      DSharedPtr<VShader*> comp;
+      DSharedPtr<VShader*> vert;
+      };
+    MeshEmu        emu;
+
   protected:
     VkDevice       device;
+
+  private:
+    void           createModule(VDevice& device, const void* source, size_t src_size);
+    void           convertMeshShader(VDevice& device, const void* source, size_t src_size);
   };
 
 }}
@@ -8,6 +8,8 @@
 
 #include "vdevice.h"
 
+#include <chrono>
+
 #if defined(__UNIX__)
 #include "system/api/x11api.h"
 #endif
@@ -40,6 +42,21 @@ static VkResult VKAPI_CALL vkxRevertFence(VkDevice device, VkFence* pFence) {
   return vkCreateFence(device,&fenceInfo,nullptr,pFence);
   }
 
+static uint64_t timeUs() {
+  auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(t).count());
+  }
+
+static VkPresentModeKHR nativeFormat(PresentMode m) {
+  switch(m) {
+    case PresentMode::Fifo:        return VK_PRESENT_MODE_FIFO_KHR;
+    case PresentMode::FifoRelaxed: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    case PresentMode::Mailbox:     return VK_PRESENT_MODE_MAILBOX_KHR;
+    case PresentMode::Immediate:   return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+  return VK_PRESENT_MODE_FIFO_KHR;
+  }
+
 static VkResult vkAcquireNextImageDBG(
     VkDevice                                    device,
     VkSwapchainKHR                              swapchain,
@@ -149,8 +166,8 @@ VSwapchain::SemaphoreList::~SemaphoreList() {
     vkDestroySemaphore(dev,data[i],nullptr);
   }
 
-VSwapchain::VSwapchain(VDevice &device, SystemApi::Window* hwnd)
-  :device(device), hwnd(hwnd) {
+VSwapchain::VSwapchain(VDevice &device, SystemApi::Window* hwnd, const SwapchainDesc& desc)
+  :device(device), hwnd(hwnd), desc(desc) {
   try {
     surface = createSurface(device.instance, hwnd);
     }
@@ -159,9 +176,19 @@ VSwapchain::VSwapchain(VDevice &device, SystemApi::Window* hwnd)
     throw;
     }
   createSwapchain(device);
+  if(desc.presentThread)
+    presentThr = std::thread([this](){ presentLoop(); });
   }
 
 VSwapchain::~VSwapchain() {
+  if(presentThr.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(presentSync);
+      presentExit = true;
+    }
+    presentCv.notify_all();
+    presentThr.join();
+    }
   cleanup();
   }
 
@@ -182,6 +209,8 @@ bool VSwapchain::checkPresentSupport(VkPhysicalDevice device, uint32_t queueFami
   }
 
 void VSwapchain::cleanupSwapchain() noexcept {
+  // queued presents reference swapchain and semaphores
+  waitPresentIdle();
   // aquire is not a 'true' queue operation - have to wait explicitly on it
   aquireFence.waitAll();
   // wait for vkQueuePresent to finish, so we can delete semaphores
@@ -201,6 +230,10 @@ void VSwapchain::cleanupSwapchain() noexcept {
       vkDestroyImageView(device.device.impl,imageView,nullptr);
   views.clear();
   sync.clear();
+  pendingPresent.clear();
+  asyncPresent   = false;
+  frameId        = 0;
+  framesInFlight = 0;
 
   images.clear();
   if(swapChain!=VK_NULL_HANDLE)
@@ -269,6 +302,7 @@ void VSwapchain::createSwapchain(VDevice& device) {
         cleanupSwapchain();
         continue;
         }
+      vkAssert(code);
       break;
       }
     catch(...) {
@@ -322,12 +356,18 @@ VkResult VSwapchain::createSwapchain(VDevice& device, const SwapChainSupport& sw
 
   createImageViews(device);
 
-  sync.resize(views.size());
+  // acquire/present sync is per frame in flight; waiting on presentFence limits cpu run-ahead
+  framesInFlight = findFramesInFlight();
+  sync.resize(framesInFlight);
 
-  aquireFence  = FenceList(device.device.impl, uint32_t(views.size()));
-  presentFence = FenceList(device.device.impl, uint32_t(views.size()));
+  aquireFence  = FenceList(device.device.impl, framesInFlight);
+  presentFence = FenceList(device.device.impl, framesInFlight);
   presentSem   = SemaphoreList(device.device.impl, uint32_t(views.size()));
-  aquireSem    = SemaphoreList(device.device.impl, uint32_t(views.size()));
+  aquireSem    = SemaphoreList(device.device.impl, framesInFlight);
+
+  // next image is acquired, while current one is still queued to present thread: two images are held at once
+  const uint32_t minImages = swapChainSupport.capabilities.minImageCount;
+  asyncPresent = desc.presentThread && images.size()>=minImages+2;
 
   return implAcquireNextImage();
   }
@@ -378,20 +418,15 @@ VkPresentModeKHR VSwapchain::findSwapPresentMode(const std::vector<VkPresentMode
   /** intel says mailbox is better option for games
     * https://software.intel.com/content/www/us/en/develop/articles/api-without-secrets-introduction-to-vulkan-part-2.html
     **/
-  std::initializer_list<VkPresentModeKHR> modes={
-    VK_PRESENT_MODE_FIFO_KHR,         // vsync; optimal
-    VK_PRESENT_MODE_MAILBOX_KHR,      // vsync; wait until vsync
-    VK_PRESENT_MODE_FIFO_RELAXED_KHR, // vsync; optimal, but tearing
-    VK_PRESENT_MODE_IMMEDIATE_KHR,    // no vsync
-    };
-
-  for(auto mode:modes){
-    for(const auto available:availablePresentModes)
-      if(available==mode)
-        return mode;
-    }
+  const VkPresentModeKHR want = nativeFormat(desc.presentMode);
+  for(const auto available:availablePresentModes)
+    if(available==want) {
+      mode = desc.presentMode;
+      return want;
+      }
 
-  // no good modes
+  // fifo is required to be supported
+  mode = PresentMode::Fifo;
   return VK_PRESENT_MODE_FIFO_KHR;
   }
 
@@ -420,14 +455,29 @@ uint32_t VSwapchain::findImageCount(const SwapChainSupport& support) const {
    * It's not clear how many images make a good fit
    */
   uint32_t imageCount = minImages + 1;
+  if(desc.imageCount>0)
+    imageCount = desc.imageCount; else
+  if(desc.presentMode==PresentMode::Mailbox)
+    imageCount = std::max(imageCount, 3u); // one image on screen, one queued, one to draw
+  if(desc.imageCount==0 && desc.presentThread)
+    imageCount = std::max(imageCount, minImages+2); // one image in present thread, one to draw
 
   imageCount = std::clamp(imageCount, minImages, maxImages);
   return imageCount;
   }
 
+uint32_t VSwapchain::findFramesInFlight() const {
+  const uint32_t imgCount = uint32_t(images.size());
+  if(desc.maxFramesInFlight==0)
+    return imgCount;
+  return std::clamp(desc.maxFramesInFlight, 1u, imgCount);
+  }
+
 void VSwapchain::acquireNextImage() {
-  VkResult code = implAcquireNextImage();
+  checkAcquire(implAcquireNextImage());
+  }
 
+void VSwapchain::checkAcquire(VkResult code) {
   if(code==VK_ERROR_OUT_OF_DATE_KHR || code==VK_SUBOPTIMAL_KHR)
     throw SwapchainSuboptimal();
 
@@ -442,6 +492,7 @@ uint32_t VSwapchain::currentBackBufferIndex() {
 VkResult VSwapchain::implAcquireNextImage() {
   auto     dev  = device.device.impl;
   auto&    slot = sync[frameId];
+  auto     t0   = timeUs();
 
   vkWaitForFences(dev, 1, &aquireFence[frameId], VK_TRUE, std::numeric_limits<uint64_t>::max());
   vkResetFences(dev, 1, &aquireFence[frameId]);
@@ -451,12 +502,18 @@ VkResult VSwapchain::implAcquireNextImage() {
   vkResetFences(dev, 1, &presentFence[frameId]);
 
   uint32_t id   = uint32_t(-1);
-  VkResult code = vkAcquireNextImageDBG(device.device.impl,
-                                        swapChain,
-                                        std::numeric_limits<uint64_t>::max(),
-                                        aquireSem[frameId],
-                                        aquireFence[frameId],
-                                        &id);
+  VkResult code = VK_SUCCESS;
+  {
+    // swapchain handle is shared with present thread
+    std::lock_guard<std::mutex> guard(swapSync);
+    code = vkAcquireNextImageDBG(device.device.impl,
+                                 swapChain,
+                                 std::numeric_limits<uint64_t>::max(),
+                                 aquireSem[frameId],
+                                 aquireFence[frameId],
+                                 &id);
+  }
+  nextStats.acquireWait = timeUs() - t0;
 
   if(code==VK_ERROR_OUT_OF_DATE_KHR) {
     auto rc = vkxRevertFence(device.device.impl, &aquireFence[frameId]);
@@ -466,7 +523,7 @@ VkResult VSwapchain::implAcquireNextImage() {
     }
 
   if(code!=VK_SUCCESS && code!=VK_SUBOPTIMAL_KHR)
-    vkAssert(code);
+    return code;
 
   imgIndex     = id;
   slot.state   = S_Pending;
@@ -477,12 +534,14 @@ VkResult VSwapchain::implAcquireNextImage() {
   }
 
 void VSwapchain::present() {
-  auto& slot = sync[frameId];
-  auto& pf   = presentFence[frameId];
-  auto  ps   = presentSem  [imgIndex];
+  auto& slot       = sync[frameId];
+  auto& pf         = presentFence[frameId];
+  auto  ps         = presentSem  [imgIndex];
+  bool  emptyFrame = false;
   if(slot.state==S_Pending) {
     // empty frame with no command buffer. TODO: test
-    ps = aquireSem[frameId];
+    ps         = aquireSem[frameId];
+    emptyFrame = true;
     }
 
   if(false && device.vkQueueSubmit2!=nullptr) {
@@ -505,35 +564,138 @@ void VSwapchain::present() {
     device.graphicsQueue->submit(1, &submitInfo, pf);
     }
 
+  frameId      = (frameId + 1)%framesInFlight;
+  slot.state   = S_Idle;
+  slot.imgId   = uint32_t(-1);
+  slot.acquire = VK_NULL_HANDLE;
+
+  PresentJob job;
+  job.imgId = imgIndex;
+  job.sem   = ps;
+  job.id    = ++presentId;
+
+  // next acquire overrides stats of this frame
+  SwapchainStats st = nextStats;
+  nextStats = SwapchainStats();
+
+  const uint64_t tx      = timeUs();
+  const bool     async   = asyncPresent && presentThr.joinable() && !emptyFrame;
+  VkResult       code    = VK_SUCCESS;
+  VkResult       acquire = VK_SUCCESS;
+  uint64_t       dt      = 0;
+  if(device.vkWaitForPresent!=nullptr)
+    pendingPresent.push_back({presentId, tx});
+
+  if(async) {
+    // acquire on render thread, before present is queued: only a previous, late present may hold swapchain
+    acquire = implAcquireNextImage();
+    // errors of present thread are reported by one of next frames
+    code    = presentResult.exchange(VK_SUCCESS);
+    dt      = presentTime.load();
+    {
+      std::lock_guard<std::mutex> guard(presentSync);
+      presentJobs.push_back(job);
+    }
+    presentCv.notify_all();
+    } else {
+    // acquire semaphore of empty frame is reused by next acquire: present must be queued right now
+    waitPresentIdle();
+    code = implPresent(job);
+    dt   = timeUs() - tx;
+    }
+
+  const uint64_t latency = frameStats.displayLatency;
+  frameStats                = st;
+  frameStats.frameId        = presentId;
+  frameStats.presentTime    = dt;
+  frameStats.displayLatency = latency;
+
+  if(code==VK_ERROR_OUT_OF_DATE_KHR || code==VK_SUBOPTIMAL_KHR)
+    throw SwapchainSuboptimal();
+  Detail::vkAssert(code);
+
+  if(async)
+    checkAcquire(acquire); else
+    acquireNextImage();
+  pollPresentWait();
+  }
+
+VkResult VSwapchain::implPresent(const PresentJob& job) {
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
   presentInfo.waitSemaphoreCount = 1;
-  presentInfo.pWaitSemaphores    = &ps;
+  presentInfo.pWaitSemaphores    = &job.sem;
   presentInfo.swapchainCount     = 1;
   presentInfo.pSwapchains        = &swapChain;
-  presentInfo.pImageIndices      = &imgIndex;
+  presentInfo.pImageIndices      = &job.imgId;
+
+  VkPresentIdKHR presentIdInfo = {};
+  if(device.vkWaitForPresent!=nullptr) {
+    presentIdInfo.sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds    = &job.id;
+    presentInfo.pNext            = &presentIdInfo;
+    }
 
-  frameId      = (frameId + 1)%images.size();
-  slot.state   = S_Idle;
-  slot.imgId   = uint32_t(-1);
-  slot.acquire = VK_NULL_HANDLE;
+  std::lock_guard<std::mutex> guard(swapSync);
+  return device.presentQueue->present(presentInfo);
+  }
 
-  auto tx = Application::tickCount();
-  VkResult code = device.presentQueue->present(presentInfo);
-  if(code==VK_ERROR_OUT_OF_DATE_KHR || code==VK_SUBOPTIMAL_KHR)
-    throw SwapchainSuboptimal();
-  tx = Application::tickCount()-tx;
-  if(tx > 2) {
-    // std::chrono::system_clock::time_point p = std::chrono::system_clock::now();
-    // time_t t = std::chrono::system_clock::to_time_t(p);
-    // char str[26] = {};
-    // strftime(str, sizeof(str), "%H:%M.%S", localtime(&t));
-    // Log::i(str," : vkQueuePresentKHR[",imgIndex,"] = ", tx);
+void VSwapchain::presentLoop() {
+  std::unique_lock<std::mutex> guard(presentSync);
+  while(true) {
+    presentCv.wait(guard, [this](){ return !presentJobs.empty() || presentExit; });
+    if(presentJobs.empty())
+      return;
+    auto job = presentJobs.front();
+    presentJobs.pop_front();
+    presentBusy = true;
+    guard.unlock();
+
+    const uint64_t tx   = timeUs();
+    const VkResult code = implPresent(job);
+    presentTime.store(timeUs()-tx);
+    if(code!=VK_SUCCESS) {
+      VkResult expect = VK_SUCCESS;
+      presentResult.compare_exchange_strong(expect, code);
+      }
+
+    guard.lock();
+    presentBusy = false;
+    presentCv.notify_all();
     }
-  //Log::i("vkQueuePresentKHR[",imgIndex,"] = ", tx);
-  Detail::vkAssert(code);
+  }
 
-  acquireNextImage();
+void VSwapchain::waitPresentIdle() noexcept {
+  if(!presentThr.joinable())
+    return;
+  std::unique_lock<std::mutex> guard(presentSync);
+  presentCv.wait(guard, [this](){ return presentJobs.empty() && !presentBusy; });
+  }
+
+void VSwapchain::pollPresentWait() {
+  // NOTE: polled once per frame, after acquire - latency is rounded up to frame time
+  static const size_t MaxPending = 16;
+  if(pendingPresent.empty())
+    return;
+  std::unique_lock<std::mutex> guard(swapSync, std::try_to_lock);
+  if(!guard.owns_lock())
+    return; // present thread is blocked in vkQueuePresentKHR - poll on next frame
+  while(!pendingPresent.empty()) {
+    auto&    p    = pendingPresent.front();
+    VkResult code = device.vkWaitForPresent(device.device.impl, swapChain, p.id, 0);
+    if(code==VK_TIMEOUT)
+      break;
+    if(code!=VK_SUCCESS && code!=VK_SUBOPTIMAL_KHR) {
+      pendingPresent.clear();
+      break;
+      }
+    frameStats.displayLatency = timeUs() - p.time;
+    pendingPresent.pop_front();
+    }
+  // presentation engine is not required to report every frame
+  while(pendingPresent.size()>MaxPending)
+    pendingPresent.pop_front();
   }
 
 #endif
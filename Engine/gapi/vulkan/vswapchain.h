@@ -3,6 +3,12 @@
 #include <Tempest/AbstractGraphicsApi>
 #include "vulkan_sdk.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 namespace Tempest {
 
 namespace Detail {
@@ -12,7 +18,7 @@ class VFramebufferMap;
 
 class VSwapchain : public AbstractGraphicsApi::Swapchain {
   public:
-    VSwapchain(VDevice& device, SystemApi::Window* hwnd);
+    VSwapchain(VDevice& device, SystemApi::Window* hwnd, const SwapchainDesc& desc);
     VSwapchain(VSwapchain&& other) = delete;
     ~VSwapchain() override;
     VSwapchain& operator=(VSwapchain&& other) = delete;
@@ -33,6 +39,8 @@ class VSwapchain : public AbstractGraphicsApi::Swapchain {
     uint32_t                 imageCount() const override { return uint32_t(views.size()); }
 
     uint32_t                 currentBackBufferIndex() override;
+    PresentMode              presentMode() const override { return mode; }
+    SwapchainStats           stats() const override { return frameStats; }
     void                     present();
 
     VFramebufferMap*         map = nullptr;
@@ -94,12 +102,44 @@ class VSwapchain : public AbstractGraphicsApi::Swapchain {
     FenceList                presentFence;
     SemaphoreList            presentSem;
 
+    struct PendingPresent {
+      uint64_t id   = 0;
+      uint64_t time = 0;
+      };
+
+    struct PresentJob {
+      uint32_t    imgId = 0;
+      VkSemaphore sem   = VK_NULL_HANDLE;
+      uint64_t    id    = 0;
+      };
+
     VDevice&                 device;
     SystemApi::Window*       hwnd     = nullptr;
     VkSurfaceKHR             surface  = VK_NULL_HANDLE;
+    SwapchainDesc            desc;
+    PresentMode              mode     = PresentMode::Fifo;
 
     uint32_t                 imgIndex = 0;
     uint32_t                 frameId  = 0;
+    uint32_t                 framesInFlight = 0;
+
+    SwapchainStats           frameStats;
+    SwapchainStats           nextStats;
+    uint64_t                 presentId = 0;
+    std::deque<PendingPresent> pendingPresent;
+
+    // acquire and present require external sync of swapchain handle; next image is acquired by render thread,
+    // before present of current one is handed to present thread, so only a short acquire may wait on this lock
+    std::mutex               swapSync;
+    bool                     asyncPresent = false;
+    std::thread              presentThr;
+    std::mutex               presentSync;
+    std::condition_variable  presentCv;
+    std::deque<PresentJob>   presentJobs;
+    bool                     presentBusy = false;
+    bool                     presentExit = false;
+    std::atomic<VkResult>    presentResult{VK_SUCCESS};
+    std::atomic<uint64_t>    presentTime{0};
 
     VkFormat                 swapChainImageFormat = VK_FORMAT_UNDEFINED;
     VkExtent2D               swapChainExtent = {};
@@ -115,11 +155,18 @@ class VSwapchain : public AbstractGraphicsApi::Swapchain {
 
     VkSurfaceFormatKHR       findSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
     VkPresentModeKHR         findSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+    uint32_t                 findFramesInFlight() const;
     VkExtent2D               findSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities, uint32_t w, uint32_t h);
     uint32_t                 findImageCount(const SwapChainSupport& support) const;
 
     VkResult                 implAcquireNextImage();
     void                     acquireNextImage();
+    void                     checkAcquire(VkResult code);
+    void                     pollPresentWait();
+
+    VkResult                 implPresent(const PresentJob& job);
+    void                     presentLoop();
+    void                     waitPresentIdle() noexcept;
   };
 
 }}
@@ -0,0 +1,69 @@
+#if defined(TEMPEST_BUILD_VULKAN)
+
+#include "vuniformring.h"
+
+#include "vdevice.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+VUniformRing::VUniformRing(VDevice& dev)
+  :dev(dev) {
+  }
+
+VUniformRing::Alloc VUniformRing::push(const void* data, size_t size) {
+  const size_t align = std::max<size_t>(dev.props.ubo.offsetAlign, 1);
+  if(size>dev.props.ubo.maxRange)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidUniformBuffer);
+
+  size_t offset = ((used+align-1)/align)*align;
+  if(cur>=chunks.size() || offset+size>chunks[cur]->size()) {
+    if(cur<chunks.size())
+      ++cur;
+    offset = 0;
+    }
+
+  auto& buf = chunk(size);
+  std::memcpy(buf.map()+offset, data, size);
+  used = offset+size;
+
+  Alloc ret;
+  ret.buf    = &buf;
+  ret.offset = offset;
+  return ret;
+  }
+
+VBuffer& VUniformRing::chunk(size_t size) {
+  while(cur<chunks.size()) {
+    if(chunks[cur]->size()>=size)
+      return *chunks[cur];
+    // too small for this block; keep it for the next recording
+    ++cur;
+    }
+
+  const size_t sz  = std::max<size_t>(ChunkSize, size);
+  auto         buf = dev.allocator.alloc(nullptr, sz, MemUsage::UniformBuffer, BufferHeap::Upload);
+  chunks.reserve(chunks.size()+1);
+  chunks.emplace_back(std::make_unique<VBuffer>(std::move(buf)));
+  cur = chunks.size()-1;
+  return *chunks[cur];
+  }
+
+void VUniformRing::flush() {
+  if(chunks.empty())
+    return;
+  for(size_t i=0; i<cur && i<chunks.size(); ++i)
+    chunks[i]->flush(0, chunks[i]->size());
+  if(cur<chunks.size() && used>0)
+    chunks[cur]->flush(0, used);
+  }
+
+void VUniformRing::reset() {
+  cur  = 0;
+  used = 0;
+  }
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include "vulkan_sdk.h"
+
+#include "vbuffer.h"
+
+#include <memory>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+class VDevice;
+
+/**
+ * Linear allocator of per-draw uniform data, owned by command buffer.
+ *
+ * Data is copied into persistently mapped, host-visible chunks and bound with dynamic offset.
+ * Chunks are recycled on command buffer reset: caller guarantees, that previous submit is complete,
+ * so each command buffer in flight effectively holds its own part of the ring.
+ */
+class VUniformRing {
+  public:
+    struct Alloc {
+      VBuffer* buf    = nullptr;
+      size_t   offset = 0;
+      };
+
+    explicit VUniformRing(VDevice& dev);
+
+    Alloc push(const void* data, size_t size);
+    //! makes host writes visible to device; call once, at end of recording
+    void  flush();
+    void  reset();
+
+  private:
+    enum : size_t {
+      ChunkSize = 1024*1024,
+      };
+
+    VBuffer& chunk(size_t size);
+
+    VDevice&                              dev;
+    // chunks are never released one by one: [0..cur] are in use, rest are free
+    std::vector<std::unique_ptr<VBuffer>> chunks;
+    size_t                                cur  = 0;
+    size_t                                used = 0;
+  };
+
+}}
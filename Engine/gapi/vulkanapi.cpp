@@ -9,11 +9,14 @@
 #include "vulkan/vshader.h"
 #include "vulkan/vfence.h"
 #include "vulkan/vcommandbuffer.h"
+#include "vulkan/vcommandbundle.h"
 #include "vulkan/vdescriptorarray.h"
 #include "vulkan/vtexture.h"
 #include "vulkan/vaccelerationstructure.h"
+#include "vulkan/vblasbatch.h"
 
 #include <Tempest/Pixmap>
+#include <Tempest/SpecializationConstants>
 #include <Tempest/Log>
 #include <Tempest/Application>
 
@@ -89,8 +92,8 @@ static std::vector<VkExtensionProperties> instExtensionsList() {
 
 
 struct Tempest::VulkanApi::Impl {
-  Impl(bool validation)
-    :validation(validation) {
+  Impl(bool validation, bool emulateMesh)
+    :validation(validation), emulateMesh(emulateMesh) {
     std::initializer_list<const char*> validationLayers={};
     if(validation) {
       validationLayers = checkValidationLayerSupport();
@@ -192,6 +195,7 @@ struct Tempest::VulkanApi::Impl {
 
   VkInstance                          instance   = VK_NULL_HANDLE;
   bool                                validation = false;
+  bool                                emulateMesh = false;
   bool                                hasDeviceFeatures2 = false;
 
   VkDebugReportCallbackEXT            callback   = VK_NULL_HANDLE;
@@ -200,7 +204,8 @@ struct Tempest::VulkanApi::Impl {
 
 
 VulkanApi::VulkanApi(ApiFlags f) {
-  impl.reset(new Impl(ApiFlags::Validation==(f&ApiFlags::Validation)));
+  impl.reset(new Impl(ApiFlags::Validation==(f&ApiFlags::Validation),
+                      ApiFlags::EmulateMeshShader==(f&ApiFlags::EmulateMeshShader)));
   }
 
 VulkanApi::~VulkanApi(){
@@ -220,7 +225,7 @@ std::vector<AbstractGraphicsApi::Props> VulkanApi::devices() const {
   devList.reserve(devices.size());
   for(auto device : devices) {
     VDevice::VkProps props = {};
-    VDevice::deviceProps(impl->instance, impl->hasDeviceFeatures2, device, props);
+    VDevice::deviceProps(impl->instance, impl->hasDeviceFeatures2, device, props, impl->emulateMesh);
     VDevice::deviceQueueProps(device, props);
     if(!impl->isDeviceSuitable(device, props))
       continue;
@@ -241,40 +246,42 @@ AbstractGraphicsApi::Device* VulkanApi::createDevice(std::string_view gpuName) {
 
   for(const auto& device:devices) {
     VDevice::VkProps props = {};
-    VDevice::deviceProps(impl->instance, impl->hasDeviceFeatures2, device, props);
+    VDevice::deviceProps(impl->instance, impl->hasDeviceFeatures2, device, props, impl->emulateMesh);
     if(!gpuName.empty() && gpuName!=props.name)
       continue;
     VDevice::deviceQueueProps(device, props);
     if(!impl->isDeviceSuitable(device, props))
       continue;
-    return new VDevice(impl->instance, impl->hasDeviceFeatures2, device);
+    return new VDevice(impl->instance, impl->hasDeviceFeatures2, device, impl->emulateMesh);
     }
 
   throw std::system_error(Tempest::GraphicsErrc::NoDevice);
   }
 
-AbstractGraphicsApi::Swapchain *VulkanApi::createSwapchain(SystemApi::Window *w, AbstractGraphicsApi::Device *d) {
+AbstractGraphicsApi::Swapchain *VulkanApi::createSwapchain(SystemApi::Window *w, AbstractGraphicsApi::Device *d, const SwapchainDesc& desc) {
   Detail::VDevice* dx   = reinterpret_cast<Detail::VDevice*>(d);
-  return new Detail::VSwapchain(*dx, w);
+  return new Detail::VSwapchain(*dx, w, desc);
   }
 
 AbstractGraphicsApi::PPipeline VulkanApi::createPipeline(AbstractGraphicsApi::Device *d, const RenderState &st, Topology tp,
-                                                         const Shader*const* sh, size_t cnt) {
+                                                         const Shader*const* sh, size_t cnt, const SpecializationConstants& spec) {
   auto* dx = reinterpret_cast<Detail::VDevice*>(d);
   const Detail::VShader* shader[5] = {};
   for(size_t i=0; i<cnt; ++i)
     shader[i] = reinterpret_cast<const Detail::VShader*>(sh[i]);
-  return PPipeline(new Detail::VPipeline(*dx,tp,st,shader,cnt));
+  return PPipeline(new Detail::VPipeline(*dx,tp,st,spec,shader,cnt));
   }
 
-AbstractGraphicsApi::PCompPipeline VulkanApi::createComputePipeline(AbstractGraphicsApi::Device* d, AbstractGraphicsApi::Shader* shader) {
+AbstractGraphicsApi::PCompPipeline VulkanApi::createComputePipeline(AbstractGraphicsApi::Device* d, AbstractGraphicsApi::Shader* shader,
+                                                                    const SpecializationConstants& spec) {
   auto* dx = reinterpret_cast<Detail::VDevice*>(d);
-  return PCompPipeline(new Detail::VCompPipeline(*dx,*reinterpret_cast<Detail::VShader*>(shader)));
+  return PCompPipeline(new Detail::VCompPipeline(*dx,*reinterpret_cast<Detail::VShader*>(shader),spec));
   }
 
-AbstractGraphicsApi::PShader VulkanApi::createShader(AbstractGraphicsApi::Device *d, const void* source, size_t src_size) {
+AbstractGraphicsApi::PShader VulkanApi::createShader(AbstractGraphicsApi::Device *d, const void* source, size_t src_size,
+                                                     Detail::ShaderCache* cache, const Detail::ShaderKey* key) {
   Detail::VDevice* dx=reinterpret_cast<Detail::VDevice*>(d);
-  return PShader(new Detail::VShader(*dx,source,src_size));
+  return PShader(new Detail::VShader(*dx,source,src_size,cache,key));
   }
 
 AbstractGraphicsApi::PBuffer VulkanApi::createBuffer(AbstractGraphicsApi::Device *d, const void *mem, size_t size,
@@ -407,9 +414,9 @@ AbstractGraphicsApi::PTexture VulkanApi::createStorage(Device* d,
   return PTexture(ptex.handler);
   }
 
-AbstractGraphicsApi::AccelerationStructure* VulkanApi::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size) {
+AbstractGraphicsApi::AccelerationStructure* VulkanApi::createBottomAccelerationStruct(Device* d, const RtGeometry* geom, size_t size, BlasFlags flags) {
   auto& dx = *reinterpret_cast<VDevice*>(d);
-  return new VAccelerationStructure(dx, geom, size);
+  return new VAccelerationStructure(dx, geom, size, flags);
   }
 
 AbstractGraphicsApi::AccelerationStructure* VulkanApi::createTopAccelerationStruct(Device* d, const RtInstance* inst, AccelerationStructure*const* as, size_t size) {
@@ -440,9 +447,9 @@ void VulkanApi::readPixels(AbstractGraphicsApi::Device *d, Pixmap& out, const PT
   stage.read(out.data(),0,size);
   }
 
-void VulkanApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer* buf, void* out, size_t size) {
+void VulkanApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer* buf, void* out, size_t offset, size_t size) {
   Detail::VBuffer&  bx = *reinterpret_cast<Detail::VBuffer*>(buf);
-  bx.read(out,0,size);
+  bx.read(out,offset,size);
   }
 
 AbstractGraphicsApi::DescArray *VulkanApi::createDescriptors(Device *d, Texture **tex, size_t cnt, uint32_t mipLevel, const Sampler &smp) {
@@ -471,6 +478,11 @@ AbstractGraphicsApi::CommandBuffer* VulkanApi::createCommandBuffer(AbstractGraph
   return new Detail::VCommandBuffer(*dx);
   }
 
+AbstractGraphicsApi::CommandBuffer* VulkanApi::createCommandBundle(AbstractGraphicsApi::Device* d, const Detail::FrameBufferDesc& fbo, size_t fboSize, uint32_t w, uint32_t h) {
+  Detail::VDevice* dx=reinterpret_cast<Detail::VDevice*>(d);
+  return new Detail::VCommandBundle(*dx, fbo, fboSize, w, h);
+  }
+
 void VulkanApi::present(Device*, Swapchain *sw) {
   Detail::VSwapchain* sx=reinterpret_cast<Detail::VSwapchain*>(sw);
   sx->present();
@@ -479,6 +491,8 @@ void VulkanApi::present(Device*, Swapchain *sw) {
 std::shared_ptr<AbstractGraphicsApi::Fence> VulkanApi::submit(Device *d, CommandBuffer* cmd) {
   Detail::VDevice&        dx = *reinterpret_cast<Detail::VDevice*>(d);
   Detail::VCommandBuffer& cx = *reinterpret_cast<Detail::VCommandBuffer*>(cmd);
+  if(dx.blasBatch!=nullptr)
+    dx.blasBatch->flush();
   auto fn = dx.submit(cx);
   return fn;
   }
@@ -76,6 +76,7 @@ class AccelerationStructure final {
   friend class Tempest::Device;
   friend class Tempest::DescriptorSet;
   friend class Encoder<Tempest::CommandBuffer>;
+  friend class Encoder<Tempest::CommandBundle>;
   };
 
 }
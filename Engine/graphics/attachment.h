@@ -36,6 +36,8 @@ class Attachment final {
   friend class Tempest::Device;
   friend class Tempest::Swapchain;
   friend class Encoder<Tempest::CommandBuffer>;
+  friend class Encoder<Tempest::CommandBundle>;
+  friend class Tempest::CommandBundle;
 
   template<class T> friend T textureCast(Attachment& a);
   template<class T> friend T textureCast(const Attachment& a);
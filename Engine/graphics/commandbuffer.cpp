@@ -15,6 +15,12 @@ CommandBuffer::~CommandBuffer() {
   delete impl.handler;
   }
 
+CommandBufferStats CommandBuffer::stats() const {
+  if(impl.handler==nullptr)
+    return CommandBufferStats();
+  return impl.handler->stats();
+  }
+
 Encoder<CommandBuffer> CommandBuffer::startEncoding(Device& device) {
   if(impl.handler!=nullptr && impl.handler->isRecording())
     throw ConcurentRecordingException();
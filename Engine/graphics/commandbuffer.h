@@ -27,6 +27,8 @@ class CommandBuffer final {
 
     auto startEncoding(Tempest::Device& dev) -> Encoder<CommandBuffer>;
 
+    CommandBufferStats stats() const;
+
   private:
     CommandBuffer(Tempest::Device& dev, AbstractGraphicsApi::CommandBuffer* impl);
 
@@ -0,0 +1,409 @@
+#include "commandbundle.h"
+
+#include <Tempest/Attachment>
+#include <Tempest/ZBuffer>
+#include <Tempest/Texture2d>
+#include <Tempest/StorageBuffer>
+#include <Tempest/VertexBuffer>
+#include <Tempest/Except>
+#include <Tempest/Device>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace Tempest;
+
+CommandBundle::~CommandBundle() {
+  delete impl.handler;
+  }
+
+Encoder<CommandBundle> CommandBundle::startEncoding(Device& dev, std::initializer_list<AttachmentDesc> rd) {
+  return implStartEncoding(dev, rd.begin(), rd.size(), nullptr);
+  }
+
+Encoder<CommandBundle> CommandBundle::startEncoding(Device& dev, std::initializer_list<AttachmentDesc> rd, AttachmentDesc zd) {
+  return implStartEncoding(dev, rd.begin(), rd.size(), &zd);
+  }
+
+Encoder<CommandBundle> CommandBundle::implStartEncoding(Device& dev, const AttachmentDesc* rt, size_t rtSize, const AttachmentDesc* zd) {
+  if(state==Recording)
+    throw ConcurentRecordingException();
+  if((rtSize+(zd ? 1 : 0)) > MaxFramebufferAttachments || (rtSize==0 && zd==nullptr))
+    throw IncompleteFboException();
+
+  uint32_t w, h;
+  if(rtSize==0) {
+    w = uint32_t(zd->zbuffer->w());
+    h = uint32_t(zd->zbuffer->h());
+    } else {
+    w = uint32_t(rt[0].attachment->w());
+    h = uint32_t(rt[0].attachment->h());
+    }
+
+  Detail::FrameBufferDesc   fbo;
+  Detail::FrameBufferLayout lay;
+  for(size_t i=0; i<rtSize; ++i) {
+    Attachment* ax = rt[i].attachment;
+    if(ax->w()!=int(w) || ax->h()!=int(h))
+      throw IncompleteFboException();
+    fbo.desc[i] = rt[i];
+    if(ax->sImpl.swapchain!=nullptr) {
+      fbo.frm[i]   = TextureFormat::Undefined;
+      fbo.sw[i]    = ax->sImpl.swapchain;
+      fbo.imgId[i] = ax->sImpl.id;
+      } else {
+      fbo.frm[i]   = ax->tImpl.frm;
+      fbo.att[i]   = ax->tImpl.impl.handler;
+      }
+    lay.frm[i] = fbo.frm[i];
+    lay.sw [i] = fbo.sw[i];
+    }
+  if(zd!=nullptr) {
+    if(zd->zbuffer->w()!=int(w) || zd->zbuffer->h()!=int(h))
+      throw IncompleteFboException();
+    fbo.desc[rtSize] = *zd;
+    fbo.frm [rtSize] = zd->zbuffer->tImpl.frm;
+    fbo.att [rtSize] = zd->zbuffer->tImpl.impl.handler;
+    lay.frm [rtSize] = fbo.frm[rtSize];
+    }
+  lay.count = uint8_t(rtSize+(zd ? 1 : 0));
+  lay.w     = w;
+  lay.h     = h;
+
+  clear();
+  delete impl.handler;
+  impl.handler = nullptr;
+  impl.handler = dev.api.createCommandBundle(dev.dev, fbo, lay.count, w, h);
+  layout       = lay;
+  return Encoder<CommandBundle>(this);
+  }
+
+void CommandBundle::clear() {
+  cmd.clear();
+  push.clear();
+  streams.clear();
+  refs.clear();
+  state = Empty;
+  }
+
+void CommandBundle::addRef(AbstractGraphicsApi::Shared* r) {
+  if(r==nullptr)
+    return;
+  if(refs.size()>0 && refs.back().handler==r)
+    return;
+  refs.emplace_back(r);
+  }
+
+void CommandBundle::finalize(bool aborted) {
+  std::sort(refs.begin(), refs.end(), [](const auto& a, const auto& b){ return a.handler<b.handler; });
+  auto end = std::unique(refs.begin(), refs.end(), [](const auto& a, const auto& b){ return a.handler==b.handler; });
+  refs.erase(end, refs.end());
+  refs.shrink_to_fit();
+  cmd.shrink_to_fit();
+  streams.shrink_to_fit();
+  if(aborted || state==Invalid)
+    state = Invalid; else
+    state = Ready;
+  }
+
+void CommandBundle::exec(AbstractGraphicsApi::CommandBuffer& dst, const Cmd& c) const {
+  switch(c.type) {
+    case C_Pipeline:
+      dst.setPipeline(*static_cast<AbstractGraphicsApi::Pipeline*>(c.res));
+      break;
+    case C_PushData:
+      dst.setPushData(push.data()+c.arg[0], c.arg[1]);
+      break;
+    case C_BindTexture:
+      dst.setBinding(c.id, static_cast<AbstractGraphicsApi::Texture*>(c.res), c.mip, c.map, c.smp);
+      break;
+    case C_BindBuffer:
+      dst.setBinding(c.id, static_cast<AbstractGraphicsApi::Buffer*>(c.res), c.arg[0]);
+      break;
+    case C_BindSampler:
+      dst.setBinding(c.id, c.smp);
+      break;
+    case C_BindTlas:
+      dst.setBinding(c.id, static_cast<AbstractGraphicsApi::AccelerationStructure*>(c.res));
+      break;
+    case C_VertexStreams:
+      dst.setVertexStreams(streams.data()+c.arg[0], c.arg[1]);
+      break;
+    case C_Draw:
+      dst.draw(static_cast<const AbstractGraphicsApi::Buffer*>(c.res), c.arg[0], c.arg[1], c.arg[2], c.arg[3], c.arg[4]);
+      break;
+    case C_DrawIndexed:
+      dst.drawIndexed(static_cast<const AbstractGraphicsApi::Buffer*>(c.res), c.arg[0], c.arg[5],
+                      *static_cast<const AbstractGraphicsApi::Buffer*>(c.ibo), c.icls,
+                      c.arg[1], c.arg[2], c.arg[3], c.arg[4]);
+      break;
+    case C_DrawIndirect:
+      dst.drawIndirect(*static_cast<const AbstractGraphicsApi::Buffer*>(c.res), c.arg[0]);
+      break;
+    }
+  }
+
+
+Encoder<CommandBundle>::Encoder(CommandBundle* ow)
+  :owner(ow), impl(ow->impl.handler), exceptions(std::uncaught_exceptions()) {
+  owner->state = CommandBundle::Recording;
+  if(impl!=nullptr)
+    impl->begin();
+  }
+
+Encoder<CommandBundle>::Encoder(Encoder<CommandBundle>&& e)
+  :owner(e.owner), impl(e.impl), curPipeline(e.curPipeline), exceptions(e.exceptions) {
+  e.owner = nullptr;
+  e.impl  = nullptr;
+  }
+
+Encoder<CommandBundle>& Encoder<CommandBundle>::operator =(Encoder<CommandBundle>&& e) {
+  std::swap(owner,       e.owner);
+  std::swap(impl,        e.impl);
+  std::swap(curPipeline, e.curPipeline);
+  std::swap(exceptions,  e.exceptions);
+  return *this;
+  }
+
+Encoder<CommandBundle>::~Encoder() {
+  if(owner==nullptr)
+    return;
+  if(impl!=nullptr)
+    impl->end();
+  // recording, interrupted by exception, leaves bundle incomplete
+  owner->finalize(std::uncaught_exceptions()>exceptions);
+  }
+
+void Encoder<CommandBundle>::fail(Tempest::GraphicsErrc e, const char* msg) {
+  owner->state = CommandBundle::Invalid;
+  if(msg!=nullptr)
+    throw std::system_error(e, msg);
+  throw std::system_error(e);
+  }
+
+void Encoder<CommandBundle>::setPipeline(const RenderPipeline& p) {
+  assert(p.impl.handler);
+  if(curPipeline==p.impl.handler)
+    return;
+  CommandBundle::Cmd c;
+  c.type = CommandBundle::C_Pipeline;
+  c.res  = p.impl.handler;
+  owner->addRef(c.res);
+  implPush(c);
+  curPipeline = p.impl.handler;
+  }
+
+void Encoder<CommandBundle>::setPushData(const void* data, size_t size) {
+  auto& push = owner->push;
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_PushData;
+  c.arg[0] = push.size();
+  c.arg[1] = size;
+  push.insert(push.end(), reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data)+size);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implBindTexture(size_t id, AbstractGraphicsApi::Texture* tex, uint32_t mip, const ComponentMapping& m, const Sampler& smp) {
+  if(tex==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidTexture);
+  CommandBundle::Cmd c;
+  c.type = CommandBundle::C_BindTexture;
+  c.id   = uint32_t(id);
+  c.mip  = mip;
+  c.res  = tex;
+  c.map  = m;
+  c.smp  = smp;
+  owner->addRef(c.res);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const Texture2d& tex, const Sampler& smp) {
+  implBindTexture(id, tex.impl.handler, uint32_t(-1), ComponentMapping(), smp);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const Texture2d& tex, const ComponentMapping& m, const Sampler& smp) {
+  implBindTexture(id, tex.impl.handler, uint32_t(-1), m, smp);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const Attachment& tex, const Sampler& smp) {
+  implBindTexture(id, tex.tImpl.impl.handler, uint32_t(-1), ComponentMapping(), smp);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const ZBuffer& tex, const Sampler& smp) {
+  implBindTexture(id, tex.tImpl.impl.handler, uint32_t(-1), ComponentMapping(), smp);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const StorageImage& tex, const Sampler& smp, uint32_t mipLevel) {
+  implBindTexture(id, tex.tImpl.impl.handler, mipLevel, ComponentMapping(), smp);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const StorageBuffer& buf, size_t offset) {
+  if(buf.impl.impl.handler==nullptr && offset!=0)
+    fail(Tempest::GraphicsErrc::InvalidUniformBuffer);
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_BindBuffer;
+  c.id     = uint32_t(id);
+  c.res    = buf.impl.impl.handler;
+  c.arg[0] = buf.impl.off+offset;
+  owner->addRef(c.res);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implBindBuffer(size_t id, const Detail::VideoBuffer& buf) {
+  if(buf.impl.handler==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidUniformBuffer);
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_BindBuffer;
+  c.id     = uint32_t(id);
+  c.res    = buf.impl.handler;
+  c.arg[0] = buf.off;
+  owner->addRef(c.res);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const Sampler& smp) {
+  CommandBundle::Cmd c;
+  c.type = CommandBundle::C_BindSampler;
+  c.id   = uint32_t(id);
+  c.smp  = smp;
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::setBinding(size_t id, const AccelerationStructure& tlas) {
+  if(!tlas.impl.handler)
+    fail(Tempest::GraphicsErrc::InvalidAccelerationStructure);
+  CommandBundle::Cmd c;
+  c.type = CommandBundle::C_BindTlas;
+  c.id   = uint32_t(id);
+  c.res  = tlas.impl.handler;
+  owner->addRef(c.res);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implDraw(const Detail::VideoBuffer& vbo, size_t stride, size_t offset, size_t size, size_t firstInstance, size_t instanceCount) {
+  if(curPipeline==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidCommandBundle, "draw without pipeline");
+  if(size==0)
+    return;
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_Draw;
+  c.res    = vbo.impl.handler;
+  c.arg[0] = stride;
+  c.arg[1] = (stride>0 ? vbo.off/stride : 0) + offset;
+  c.arg[2] = size;
+  c.arg[3] = firstInstance;
+  c.arg[4] = instanceCount;
+  owner->addRef(c.res);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implDraw(const Detail::VideoBuffer& vbo, size_t stride, const Detail::VideoBuffer& ibo, Detail::IndexClass icls,
+                                      size_t offset, size_t size, size_t firstInstance, size_t instanceCount) {
+  if(curPipeline==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidCommandBundle, "draw without pipeline");
+  if(size==0 || !ibo.impl)
+    return;
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_DrawIndexed;
+  c.icls   = icls;
+  c.res    = vbo.impl.handler;
+  c.ibo    = ibo.impl.handler;
+  c.arg[0] = stride;
+  c.arg[1] = ibo.off/Detail::sizeofIndex(icls) + offset;
+  c.arg[2] = size;
+  c.arg[3] = firstInstance;
+  c.arg[4] = instanceCount;
+  c.arg[5] = (stride>0 ? vbo.off/stride : 0);
+  owner->addRef(c.res);
+  owner->addRef(c.ibo);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implDraw(const VertexStream* vbo, size_t vboSize, size_t offset, size_t size,
+                                      size_t firstInstance, size_t instanceCount) {
+  if(curPipeline==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidCommandBundle, "draw without pipeline");
+  if(size==0)
+    return;
+  implBindStreams(vbo,vboSize);
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_Draw;
+  c.arg[1] = offset;
+  c.arg[2] = size;
+  c.arg[3] = firstInstance;
+  c.arg[4] = instanceCount;
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implDraw(const VertexStream* vbo, size_t vboSize, const Detail::VideoBuffer& ibo, Detail::IndexClass icls,
+                                      size_t offset, size_t size, size_t firstInstance, size_t instanceCount) {
+  if(curPipeline==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidCommandBundle, "draw without pipeline");
+  if(size==0 || !ibo.impl)
+    return;
+  implBindStreams(vbo,vboSize);
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_DrawIndexed;
+  c.icls   = icls;
+  c.ibo    = ibo.impl.handler;
+  c.arg[1] = ibo.off/Detail::sizeofIndex(icls) + offset;
+  c.arg[2] = size;
+  c.arg[3] = firstInstance;
+  c.arg[4] = instanceCount;
+  owner->addRef(c.ibo);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implBindStreams(const VertexStream* vbo, size_t vboSize) {
+  if(vboSize==0 || vboSize>MaxVertexStreams)
+    fail(Tempest::GraphicsErrc::InvalidVertexInput, "vertex streams count");
+  size_t numFormats = 0;
+  for(size_t i=0; i<vboSize; ++i) {
+    size_t sz = 0;
+    for(size_t r=0; r<vbo[i].formatSize; ++r)
+      sz += Decl::size(vbo[i].format[r]);
+    if(sz>vbo[i].stride)
+      fail(Tempest::GraphicsErrc::InvalidVertexInput, "vertex stream format exceeds stride");
+    numFormats += vbo[i].formatSize;
+    }
+  if(numFormats>MaxVertexAttribs)
+    fail(Tempest::GraphicsErrc::InvalidVertexInput, "vertex streams format");
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_VertexStreams;
+  c.arg[0] = owner->streams.size();
+  c.arg[1] = vboSize;
+  for(size_t i=0; i<vboSize; ++i) {
+    auto& v = *vbo[i].vbo;
+    if(!v.impl)
+      fail(Tempest::GraphicsErrc::InvalidStorageBuffer);
+    AbstractGraphicsApi::VertexStream s;
+    s.vbo    = v.impl.handler;
+    s.offset = v.off;
+    s.stride = vbo[i].stride;
+    s.rate   = vbo[i].rate;
+    s.formatSize = uint8_t(vbo[i].formatSize);
+    std::copy_n(vbo[i].format, vbo[i].formatSize, s.format);
+    owner->streams.push_back(s);
+    owner->addRef(v.impl.handler);
+    }
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::drawIndirect(const StorageBuffer& indirect, size_t offset) {
+  if(curPipeline==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidCommandBundle, "draw without pipeline");
+  if(offset%4 != 0 || indirect.impl.impl.handler==nullptr)
+    fail(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  CommandBundle::Cmd c;
+  c.type   = CommandBundle::C_DrawIndirect;
+  c.res    = indirect.impl.impl.handler;
+  c.arg[0] = indirect.impl.off+offset;
+  owner->addRef(c.res);
+  implPush(c);
+  }
+
+void Encoder<CommandBundle>::implPush(const CommandBundle::Cmd& c) {
+  owner->cmd.push_back(c);
+  if(impl!=nullptr)
+    owner->exec(*impl, c);
+  }
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include <Tempest/RenderPipeline>
+#include <Tempest/StorageImage>
+#include <Tempest/UniformBuffer>
+#include <Tempest/AccelerationStructure>
+#include "../utility/dptr.h"
+
+#include <initializer_list>
+#include <vector>
+
+namespace Tempest {
+
+template<class T>
+class VertexBuffer;
+
+template<class T>
+class IndexBuffer;
+
+class VertexStream;
+class Device;
+class CommandBuffer;
+class CommandBundle;
+
+template<class T>
+class Encoder;
+
+/**
+ * Pre-recorded sequence of draw-calls, executed by Encoder<CommandBuffer>::execute, inside of render-pass.
+ *
+ * Bundle is recorded for render-pass layout: formats and size of attachments. Where backend supports it,
+ * bundle is translated into native commands once, at record time (Vulkan: secondary command buffer),
+ * otherwise it's replayed by encoder.
+ *
+ * Bundle keeps references to all of used resources (pipelines, buffers, textures, acceleration structures):
+ * they stay alive as long as bundle does. Destroying the resource object, that was used in recording, doesn't
+ * invalidate bundle - device memory is released only with bundle itself; there is no way to swap resource
+ * of recorded bundle, record new one instead.
+ * Bundle is invalid until recording is complete and after recording was aborted by an error.
+ * Like any other resource, bundle must outlive command buffers that execute it.
+ */
+class CommandBundle final {
+  public:
+    CommandBundle()=default;
+    CommandBundle(CommandBundle&& f)=default;
+    ~CommandBundle();
+    CommandBundle& operator = (CommandBundle&& other)=default;
+
+    //! load/store operations of `rd` are ignored; only formats and size of attachments matter
+    auto startEncoding(Device& dev, std::initializer_list<AttachmentDesc> rd) -> Encoder<CommandBundle>;
+    auto startEncoding(Device& dev, std::initializer_list<AttachmentDesc> rd, AttachmentDesc zd) -> Encoder<CommandBundle>;
+
+    bool isEmpty() const { return cmd.empty(); }
+    bool isValid() const { return state==Ready; }
+
+  private:
+    enum CmdType : uint8_t {
+      C_Pipeline,
+      C_PushData,
+      C_BindTexture,
+      C_BindBuffer,
+      C_BindSampler,
+      C_BindTlas,
+      C_VertexStreams,
+      C_Draw,
+      C_DrawIndexed,
+      C_DrawIndirect,
+      };
+
+    struct Cmd {
+      CmdType                      type   = C_Draw;
+      Detail::IndexClass           icls   = Detail::IndexClass::i16;
+      uint32_t                     id     = 0;
+      uint32_t                     mip    = 0;
+      AbstractGraphicsApi::Shared* res    = nullptr;
+      AbstractGraphicsApi::Shared* ibo    = nullptr;
+      size_t                       arg[6] = {};
+      ComponentMapping             map;
+      Sampler                      smp;
+      };
+
+    enum State : uint8_t {
+      Empty,
+      Recording,
+      Ready,
+      Invalid,
+      };
+
+    auto implStartEncoding(Device& dev, const AttachmentDesc* rt, size_t rtSize, const AttachmentDesc* zd) -> Encoder<CommandBundle>;
+    void clear();
+    void addRef(AbstractGraphicsApi::Shared* r);
+    void finalize(bool aborted);
+    void exec(AbstractGraphicsApi::CommandBuffer& dst, const Cmd& c) const;
+
+    Detail::DPtr<AbstractGraphicsApi::CommandBuffer*>          impl;
+    Detail::FrameBufferLayout                                  layout;
+    std::vector<Cmd>                                           cmd;
+    std::vector<uint8_t>                                       push;
+    std::vector<AbstractGraphicsApi::VertexStream>             streams;
+    std::vector<Detail::DSharedPtr<AbstractGraphicsApi::Shared*>> refs;
+    State                                                      state = Empty;
+
+  friend class Tempest::Encoder<CommandBundle>;
+  friend class Tempest::Encoder<CommandBuffer>;
+  };
+
+template<>
+class Encoder<Tempest::CommandBundle> {
+  public:
+    Encoder(Encoder&& e);
+    Encoder& operator = (Encoder&& e);
+    ~Encoder();
+
+    void setPipeline(const RenderPipeline& p);
+
+    template<class T>
+    void setPushData(const T& data) { setPushData(&data, sizeof(data)); }
+    void setPushData(const void* data, size_t size);
+
+    void setBinding(size_t id, const Texture2d&       tex, const Sampler& smp = Sampler::anisotrophy());
+    void setBinding(size_t id, const Attachment&      tex, const Sampler& smp = Sampler::anisotrophy());
+    void setBinding(size_t id, const ZBuffer&         tex, const Sampler& smp = Sampler::anisotrophy());
+    void setBinding(size_t id, const StorageImage&    tex, const Sampler& smp = Sampler::anisotrophy(), uint32_t mipLevel = uint32_t(-1));
+    void setBinding(size_t id, const StorageBuffer&   buf, size_t offset = 0);
+
+    void setBinding(size_t id, const Texture2d&       tex, const ComponentMapping& m, const Sampler& smp = Sampler::anisotrophy());
+
+    void setBinding(size_t id, const Sampler&         smp);
+    void setBinding(size_t id, const AccelerationStructure& tlas);
+    template<class T>
+    void setBinding(size_t id, const UniformBuffer<T>& buf) { implBindBuffer(id, buf.impl); }
+
+    // non-indexed + empty vbo
+    void draw(std::nullptr_t vbo, size_t offset, size_t count) { implDraw({},0,offset,count,0,1); }
+    void draw(std::nullptr_t vbo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount) { implDraw({},0,offset,count,firstInstance,instanceCount); }
+
+    // non-indexed
+    template<class T>
+    void draw(const VertexBuffer<T>& vbo) { implDraw(vbo.impl,sizeof(T),0,vbo.size(),0,1); }
+
+    template<class T>
+    void draw(const VertexBuffer<T>& vbo, size_t offset, size_t count) { implDraw(vbo.impl,sizeof(T),offset,count,0,1); }
+
+    template<class T>
+    void draw(const VertexBuffer<T>& vbo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount) { implDraw(vbo.impl,sizeof(T),offset,count,firstInstance,instanceCount); }
+
+    // indexed + empty vbo
+    template<class I>
+    void draw(std::nullptr_t vbo, const IndexBuffer<I>& ibo)
+      { implDraw({},0,ibo.impl,Detail::indexCls<I>(),0,ibo.size(),0,1); }
+
+    template<class I>
+    void draw(std::nullptr_t vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count)
+      { implDraw({},0,ibo.impl,Detail::indexCls<I>(),offset,count,0,1); }
+
+    // indexed
+    template<class T,class I>
+    void draw(const VertexBuffer<T>& vbo, const IndexBuffer<I>& ibo)
+         { implDraw(vbo.impl,sizeof(T),ibo.impl,Detail::indexCls<I>(),0,ibo.size(),0,1); }
+
+    template<class T,class I>
+    void draw(const VertexBuffer<T>& vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count)
+         { implDraw(vbo.impl,sizeof(T),ibo.impl,Detail::indexCls<I>(),offset,count,0,1); }
+
+    template<class T,class I>
+    void draw(const VertexBuffer<T>& vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount)
+         { implDraw(vbo.impl,sizeof(T),ibo.impl,Detail::indexCls<I>(),offset,count,firstInstance,instanceCount); }
+
+    // multiple vertex streams
+    void draw(std::initializer_list<VertexStream> vbo, size_t offset, size_t count) { implDraw(vbo.begin(),vbo.size(),offset,count,0,1); }
+    void draw(std::initializer_list<VertexStream> vbo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount)
+      { implDraw(vbo.begin(),vbo.size(),offset,count,firstInstance,instanceCount); }
+
+    template<class I>
+    void draw(std::initializer_list<VertexStream> vbo, const IndexBuffer<I>& ibo)
+      { implDraw(vbo.begin(),vbo.size(),ibo.impl,Detail::indexCls<I>(),0,ibo.size(),0,1); }
+
+    template<class I>
+    void draw(std::initializer_list<VertexStream> vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count)
+      { implDraw(vbo.begin(),vbo.size(),ibo.impl,Detail::indexCls<I>(),offset,count,0,1); }
+
+    template<class I>
+    void draw(std::initializer_list<VertexStream> vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount)
+      { implDraw(vbo.begin(),vbo.size(),ibo.impl,Detail::indexCls<I>(),offset,count,firstInstance,instanceCount); }
+
+    void drawIndirect(const StorageBuffer& indirect, size_t offset);
+
+  private:
+    explicit Encoder(CommandBundle* ow);
+
+    CommandBundle*                       owner       = nullptr;
+    AbstractGraphicsApi::CommandBuffer*  impl        = nullptr; // native bundle, if any
+    const AbstractGraphicsApi::Pipeline* curPipeline = nullptr;
+    int                                  exceptions  = 0;
+
+    void         fail(Tempest::GraphicsErrc e, const char* msg = nullptr);
+    void         implPush(const CommandBundle::Cmd& c);
+
+    void         implBindTexture(size_t id, AbstractGraphicsApi::Texture* tex, uint32_t mip, const ComponentMapping& m, const Sampler& smp);
+    void         implDraw(const Detail::VideoBuffer& vbo, size_t stride, size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
+    void         implDraw(const Detail::VideoBuffer& vbo, size_t stride, const Detail::VideoBuffer &ibo, Detail::IndexClass index,
+                          size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
+    void         implDraw(const VertexStream* vbo, size_t vboSize, size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
+    void         implDraw(const VertexStream* vbo, size_t vboSize, const Detail::VideoBuffer &ibo, Detail::IndexClass index,
+                          size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
+    void         implBindBuffer(size_t id, const Detail::VideoBuffer& buf);
+    void         implBindStreams(const VertexStream* vbo, size_t vboSize);
+
+  friend class CommandBundle;
+  };
+
+}
@@ -1,5 +1,9 @@
 #include "descriptorarray.h"
 
+#include <Tempest/Texture2d>
+#include <Tempest/StorageBuffer>
+#include <Tempest/Except>
+
 using namespace Tempest;
 
 DescriptorArray::DescriptorArray(Device&, AbstractGraphicsApi::DescArray *desc)
@@ -18,3 +22,40 @@ DescriptorArray& DescriptorArray::operator=(DescriptorArray&& u) {
   impl=std::move(u.impl);
   return *this;
   }
+
+size_t DescriptorArray::size() const {
+  return impl.handler!=nullptr ? impl.handler->size() : 0;
+  }
+
+uint32_t DescriptorArray::alloc(const Texture2d& tex) {
+  if(impl.handler==nullptr || !tex.impl)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  return impl.handler->alloc(tex.impl.handler);
+  }
+
+uint32_t DescriptorArray::alloc(const StorageBuffer& buf) {
+  if(impl.handler==nullptr || !buf.impl.impl)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  if(buf.impl.range!=nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer, "sub-allocated buffer in descriptor array");
+  return impl.handler->alloc(buf.impl.impl.handler);
+  }
+
+void DescriptorArray::set(size_t slot, const Texture2d& tex) {
+  if(impl.handler==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+  impl.handler->set(slot, tex.impl.handler);
+  }
+
+void DescriptorArray::set(size_t slot, const StorageBuffer& buf) {
+  if(impl.handler==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  if(buf.impl.range!=nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer, "sub-allocated buffer in descriptor array");
+  impl.handler->set(slot, buf.impl.impl.handler);
+  }
+
+void DescriptorArray::free(size_t slot) {
+  if(impl.handler!=nullptr)
+    impl.handler->free(slot);
+  }
@@ -4,6 +4,17 @@
 
 namespace Tempest {
 
+class Texture2d;
+class StorageBuffer;
+
+/**
+ * Bindless array of textures or storage buffers.
+ *
+ * Array is updatable: slots are written one by one, without rewriting the whole array.
+ * Null entries, given at creation, are free slots for `alloc`. A released slot is reused only after
+ * command buffers, that were recorded with the array before release, are reset.
+ * Updates must not overlap with recording of command buffers, that use the array.
+ */
 class DescriptorArray {
   public:
     DescriptorArray() = default;
@@ -11,7 +22,19 @@ class DescriptorArray {
     ~DescriptorArray();
     DescriptorArray& operator=(DescriptorArray&&);
 
-    bool isEmpty() const { return impl.handler==nullptr; }
+    bool     isEmpty() const { return impl.handler==nullptr; }
+    size_t   size() const;
+
+    //! writes resource into free slot and returns slot index; array grows, if there is no free slots
+    uint32_t alloc(const Texture2d&     tex);
+    uint32_t alloc(const StorageBuffer& buf);
+
+    //! overrides slot; writing a slot, that is still in use by GPU, is a race
+    void     set  (size_t slot, const Texture2d&     tex);
+    void     set  (size_t slot, const StorageBuffer& buf);
+
+    //! returns slot to array; content of slot is not changed until reuse
+    void     free (size_t slot);
 
   private:
     DescriptorArray(Device& dev, AbstractGraphicsApi::DescArray* desc);
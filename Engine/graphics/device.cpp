@@ -1,5 +1,6 @@
 #include "device.h"
 #include "utility/smallarray.h"
+#include "gapi/shadercache.h"
 
 #include <Tempest/Fence>
 #include <Tempest/UniformBuffer>
@@ -62,12 +63,12 @@ Device::Device(AbstractGraphicsApi& api)
   }
 
 Device::Device(AbstractGraphicsApi &api, std::string_view name)
-  :api(api), impl(api,name), dev(impl.dev), builtins(*this) {
+  :api(api), impl(api,name), dev(impl.dev), shaderCache(new Detail::ShaderCache()), builtins(*this) {
   api.getCaps(dev,devProps);
   }
 
 Device::Device(AbstractGraphicsApi& api, DeviceType type)
-  :api(api), impl(api,type), dev(impl.dev), builtins(*this) {
+  :api(api), impl(api,type), dev(impl.dev), shaderCache(new Detail::ShaderCache()), builtins(*this) {
   api.getCaps(dev,devProps);
   }
 
@@ -84,6 +85,10 @@ Fence Device::submit(const CommandBuffer &cmd) {
   }
 
 void Device::present(Swapchain& sw) {
+  if(sw.headless!=nullptr) {
+    sw.implPresent(*this);
+    return;
+    }
   api.present(dev,sw.impl.handler);
   }
 
@@ -94,9 +99,7 @@ Shader Device::shader(RFile &file) {
   file.read(reinterpret_cast<char*>(buffer.get()),fileSize);
 
   size_t size=uint32_t(fileSize);
-
-  Shader f(*this,api.createShader(dev,reinterpret_cast<const char*>(buffer.get()),size));
-  return f;
+  return shader(buffer.get(),size);
   }
 
 Shader Device::shader(const char *filename) {
@@ -110,8 +113,20 @@ Shader Device::shader(const char16_t *filename) {
   }
 
 Shader Device::shader(const void *source, const size_t length) {
-  Shader f(*this,api.createShader(dev,source,length));
-  return f;
+  auto key = shaderCache->key(source,length);
+  if(auto sh = shaderCache->find(key))
+    return Shader(*this,std::move(sh));
+
+  auto sh = api.createShader(dev,source,length,shaderCache.get(),&key);
+  return Shader(*this,shaderCache->insert(key,std::move(sh)));
+  }
+
+void Device::setShaderCache(std::string_view file) {
+  shaderCache->open(file);
+  }
+
+void Device::setShaderOptimization(bool enable) {
+  shaderCache->optimize.store(enable);
   }
 
 DescriptorArray Device::descriptors(const std::vector<const StorageBuffer *> &buf) {
@@ -122,8 +137,11 @@ DescriptorArray Device::descriptors(const StorageBuffer * const *buf, size_t siz
   if(!devProps.descriptors.nonUniformIndexing)
     throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension, "nonUniformIndexing");
   Detail::SmallArray<AbstractGraphicsApi::Buffer*,32> arr(size);
-  for(size_t i=0; i<size; ++i)
+  for(size_t i=0; i<size; ++i) {
+    if(buf[i]!=nullptr && buf[i]->impl.range!=nullptr)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer, "sub-allocated buffer in descriptor array");
     arr[i] = buf[i] ? buf[i]->impl.impl.handler : nullptr;
+    }
   DescriptorArray d(*this,api.createDescriptors(dev, arr.get(), size));
   return d;
   }
@@ -156,14 +174,29 @@ DescriptorArray Device::descriptors(const Texture2d * const *tex, size_t size, c
   return d;
   }
 
-Swapchain Device::swapchain(SystemApi::Window* w) const {
-  return Swapchain(api.createSwapchain(w,impl.dev));
+Swapchain Device::swapchain(SystemApi::Window* w, const SwapchainDesc& desc) const {
+  return Swapchain(api.createSwapchain(w,impl.dev,desc));
+  }
+
+Swapchain Device::swapchain(uint32_t w, uint32_t h, const SwapchainDesc& desc) const {
+  if(w>devProps.tex2d.maxSize || h>devProps.tex2d.maxSize)
+    throw std::system_error(Tempest::GraphicsErrc::TooLargeTexture, std::to_string(std::max(w,h)));
+  Swapchain sw(w,h,desc);
+  for(uint32_t i=0; i<sw.imageCount(); ++i) {
+    Texture2d t(*this,api.createTexture(dev,w,h,1,TextureFormat::RGBA8),w,h,1,TextureFormat::RGBA8);
+    sw.img[i] = Attachment(std::move(t));
+    }
+  return sw;
   }
 
 const Device::Props& Device::properties() const {
   return devProps;
   }
 
+DeviceStats Device::stats() const {
+  return impl.dev->stats();
+  }
+
 Attachment Device::attachment(TextureFormat frm, const uint32_t w, const uint32_t h, const bool mips) {
   if(!devProps.hasSamplerFormat(frm) && !devProps.hasAttachFormat(frm))
     throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat, formatName(frm));
@@ -196,9 +229,9 @@ Texture2d Device::texture(const Pixmap &pm, const bool mips) {
     if(devProps.hasSamplerFormat(format) && (!mips || pm.mipCount()>1)){
       mipCnt = pm.mipCount();
       } else {
-      alt    = Pixmap(pm,TextureFormat::RGBA8);
+      format = isSrgbFormat(format) ? TextureFormat::RGBA8_SRGB : TextureFormat::RGBA8;
+      alt    = Pixmap(pm,format);
       p      = &alt;
-      format = TextureFormat::RGBA8;
       }
     }
 
@@ -265,15 +298,15 @@ ZBuffer Device::zbuffer(TextureFormat frm, const Size sz) {
   return zbuffer(frm,sz.w,sz.h);
   }
 
-AccelerationStructure Device::blas(const std::vector<RtGeometry>& geom) {
-  return blas(geom.data(), geom.size());
+AccelerationStructure Device::blas(const std::vector<RtGeometry>& geom, BlasFlags flags) {
+  return blas(geom.data(), geom.size(), flags);
   }
 
-AccelerationStructure Device::blas(std::initializer_list<RtGeometry> geom) {
-  return blas(geom.begin(), geom.size());
+AccelerationStructure Device::blas(std::initializer_list<RtGeometry> geom, BlasFlags flags) {
+  return blas(geom.begin(), geom.size(), flags);
   }
 
-AccelerationStructure Device::blas(const RtGeometry* geom, size_t geomSize) {
+AccelerationStructure Device::blas(const RtGeometry* geom, size_t geomSize, BlasFlags flags) {
   if(!properties().raytracing.rayQuery)
     throw std::system_error(Tempest::GraphicsErrc::UnsupportedExtension, "rayQuery");
   if(geomSize==0)
@@ -288,12 +321,13 @@ AccelerationStructure Device::blas(const RtGeometry* geom, size_t geomSize) {
     gx.vbo     = geom[i].vbo->impl.impl.handler;
     gx.vboSz   = geom[i].vbo->byteSize()/stride;
     gx.stride  = geom[i].vboStride;
+    gx.voffset = geom[i].vbo->impl.off/stride;
     gx.ibo     = geom[i].ibo->impl.impl.handler;
     gx.iboSz   = geom[i].iboSize;
-    gx.ioffset = geom[i].iboOffset;
+    gx.ioffset = geom[i].ibo->impl.off/Detail::sizeofIndex(geom[i].icls) + geom[i].iboOffset;
     gx.icls    = geom[i].icls;
     }
-  auto blas = api.createBottomAccelerationStruct(dev, g.get(), geomSize);
+  auto blas = api.createBottomAccelerationStruct(dev, g.get(), geomSize, flags);
   return AccelerationStructure(*this,blas);
   }
 
@@ -350,49 +384,54 @@ Pixmap Device::readPixels(const StorageImage& t, uint32_t mip) {
   }
 
 void Device::readBytes(const StorageBuffer& ssbo, void* out, size_t size) {
-  api.readBytes(dev,ssbo.impl.impl.handler,out,size);
+  // buffer may be a view into GeometryPool page: read only [off,off+size)
+  api.readBytes(dev,ssbo.impl.impl.handler,out,ssbo.impl.off,size);
   }
 
-ComputePipeline Device::pipeline(const Shader& comp) {
+ComputePipeline Device::pipeline(const Shader& comp, const SpecializationConstants& spec) {
   if(!comp.impl)
     return ComputePipeline();
-  auto pipe = api.createComputePipeline(dev,comp.impl.handler);
+  auto pipe = api.createComputePipeline(dev,comp.impl.handler,spec);
   ComputePipeline f(std::move(pipe));
   return f;
   }
 
-RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &fs) {
+RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &fs,
+                                const SpecializationConstants& spec) {
   const Shader* sh[] = {&vs,nullptr,nullptr,nullptr,&fs};
-  return implPipeline(st,sh,tp);
+  return implPipeline(st,sh,tp,spec);
   }
 
-RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &gs, const Shader &fs) {
+RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &gs, const Shader &fs,
+                                const SpecializationConstants& spec) {
   const Shader* sh[] = {&vs,nullptr,nullptr,&gs,&fs};
-  return implPipeline(st,sh,tp);
+  return implPipeline(st,sh,tp,spec);
   }
 
-RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &tc, const Shader &te, const Shader &fs) {
+RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &tc, const Shader &te, const Shader &fs,
+                                const SpecializationConstants& spec) {
   const Shader* sh[] = {&vs,&tc,&te,nullptr,&fs};
-  return implPipeline(st,sh,tp);
+  return implPipeline(st,sh,tp,spec);
   }
 
-RenderPipeline Device::implPipeline(const RenderState &st, const Shader* sh[], Topology tp) {
+RenderPipeline Device::implPipeline(const RenderState &st, const Shader* sh[], Topology tp, const SpecializationConstants& spec) {
   AbstractGraphicsApi::Shader* shv[5] = {};
   for(size_t i=0; i<5; ++i)
     shv[i] = sh[i]!=nullptr ? sh[i]->impl.handler : nullptr;
 
-  auto pipe = api.createPipeline(dev,st,tp,shv,5);
+  auto pipe = api.createPipeline(dev,st,tp,shv,5,spec);
   RenderPipeline f(std::move(pipe));
   return f;
   }
 
-RenderPipeline Device::pipeline(const RenderState& st, const Shader& ts, const Shader& ms, const Shader& fs) {
+RenderPipeline Device::pipeline(const RenderState& st, const Shader& ts, const Shader& ms, const Shader& fs,
+                                const SpecializationConstants& spec) {
   const Shader*                sh [3] = {&ts,&ms,&fs};
   AbstractGraphicsApi::Shader* shv[3] = {};
   for(size_t i=0; i<3; ++i)
     shv[i] = sh[i]!=nullptr ? sh[i]->impl.handler : nullptr;
 
-  auto pipe = api.createPipeline(dev,st,Topology::Triangles,shv,3);
+  auto pipe = api.createPipeline(dev,st,Topology::Triangles,shv,3,spec);
   RenderPipeline f(std::move(pipe));
   return f;
   }
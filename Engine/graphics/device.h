@@ -5,6 +5,7 @@
 #include <Tempest/RenderPipeline>
 #include <Tempest/ComputePipeline>
 #include <Tempest/Shader>
+#include <Tempest/SpecializationConstants>
 #include <Tempest/Attachment>
 #include <Tempest/ZBuffer>
 #include <Tempest/Texture2d>
@@ -21,10 +22,15 @@
 
 #include "videobuffer.h"
 
+#include <memory>
 #include <vector>
 
 namespace Tempest {
 
+namespace Detail {
+class ShaderCache;
+}
+
 class Fence;
 class CommandPool;
 class DescriptorSet;
@@ -49,14 +55,21 @@ class Device {
     Fence                 submit(const CommandBuffer& cmd);
     void                  present(Swapchain& sw);
 
-    Swapchain             swapchain(SystemApi::Window* w) const;
+    Swapchain             swapchain(SystemApi::Window* w, const SwapchainDesc& desc = SwapchainDesc()) const;
+    //! headless swapchain, to run frame loop without display
+    Swapchain             swapchain(uint32_t w, uint32_t h, const SwapchainDesc& desc = SwapchainDesc()) const;
 
     Shader                shader(RFile&          file);
     Shader                shader(const char*     filename);
     Shader                shader(const char16_t* filename);
     Shader                shader(const void* source, const size_t length);
+    //! identical bytecode always shares one shader; with cache file, reflection data is reused between launches
+    void                  setShaderCache(std::string_view file);
+    //! strip debug info, dead functions and unused globals from SPIR-V, before it's passed to driver
+    void                  setShaderOptimization(bool enable);
 
     const Props&          properties() const;
+    DeviceStats           stats() const;
 
     template<class T>
     VertexBuffer<T>       vbo(const T* arr, size_t arrSize) {
@@ -131,9 +144,9 @@ class Device {
     ZBuffer               zbuffer    (TextureFormat frm, const Size sz);
     StorageImage          image2d    (TextureFormat frm, const Size sz, const bool mips = false);
 
-    AccelerationStructure blas(const std::vector<RtGeometry>& geom);
-    AccelerationStructure blas(std::initializer_list<RtGeometry> geom);
-    AccelerationStructure blas(const RtGeometry* geom, size_t geomSize);
+    AccelerationStructure blas(const std::vector<RtGeometry>& geom, BlasFlags flags = BlasFlags::None);
+    AccelerationStructure blas(std::initializer_list<RtGeometry> geom, BlasFlags flags = BlasFlags::None);
+    AccelerationStructure blas(const RtGeometry* geom, size_t geomSize, BlasFlags flags = BlasFlags::None);
 
     template<class V, class I>
     AccelerationStructure blas(const VertexBuffer<V>& vbo, const IndexBuffer<I>& ibo);
@@ -149,12 +162,16 @@ class Device {
     Pixmap                readPixels(const StorageImage& t, uint32_t mip=0);
     void                  readBytes (const StorageBuffer& ssbo, void* out, size_t size);
 
-    RenderPipeline        pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &fs);
-    RenderPipeline        pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &tc, const Shader &te, const Shader &fs);
-    RenderPipeline        pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &gs, const Shader &fs);
-    RenderPipeline        pipeline(const RenderState& st, const Shader &ts, const Shader &ms, const Shader &fs);
+    RenderPipeline        pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &fs,
+                                   const SpecializationConstants& spec = SpecializationConstants());
+    RenderPipeline        pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &tc, const Shader &te, const Shader &fs,
+                                   const SpecializationConstants& spec = SpecializationConstants());
+    RenderPipeline        pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &gs, const Shader &fs,
+                                   const SpecializationConstants& spec = SpecializationConstants());
+    RenderPipeline        pipeline(const RenderState& st, const Shader &ts, const Shader &ms, const Shader &fs,
+                                   const SpecializationConstants& spec = SpecializationConstants());
 
-    ComputePipeline       pipeline(const Shader &comp);
+    ComputePipeline       pipeline(const Shader &comp, const SpecializationConstants& spec = SpecializationConstants());
     CommandBuffer         commandBuffer();
     const Builtin&        builtin() const;
 
@@ -172,10 +189,11 @@ class Device {
     Impl                            impl;
     AbstractGraphicsApi::Device*    dev=nullptr;
     Props                           devProps;
+    std::unique_ptr<Detail::ShaderCache> shaderCache;
     Tempest::Builtin                builtins;
 
     Detail::VideoBuffer   createVideoBuffer(const void* data, size_t size, MemUsage usage, BufferHeap flg);
-    RenderPipeline        implPipeline(const RenderState &st, const Shader* shaders[], Topology tp);
+    RenderPipeline        implPipeline(const RenderState &st, const Shader* shaders[], Topology tp, const SpecializationConstants& spec);
     template<class T>
     UniformBuffer<T>      implUbo(BufferHeap ht, const void* data);
 
@@ -186,7 +204,9 @@ class Device {
   friend class Shader;
   friend class CommandPool;
   friend class CommandBuffer;
+  friend class CommandBundle;
   friend class DescriptorSet;
+  friend class GeometryPool;
 
   friend class Texture2d;
   };
@@ -1,12 +1,15 @@
 #include "encoder.h"
+#include "commandbundle.h"
 
 #include <Tempest/Attachment>
 #include <Tempest/ZBuffer>
 #include <Tempest/Texture2d>
 #include <Tempest/StorageBuffer>
+#include <Tempest/VertexBuffer>
 #include <cassert>
 
 #include "utility/compiller_hints.h"
+#include "utility/smallarray.h"
 
 using namespace Tempest;
 
@@ -62,6 +65,34 @@ void Encoder<Tempest::CommandBuffer>::setScissor(const Rect &vp) {
   impl->setScissor(vp);
   }
 
+void Encoder<Tempest::CommandBuffer>::setCullMode(RenderState::CullMode cull) {
+  if(state.stage!=Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  impl->setCullMode(cull);
+  state.dynState = true;
+  }
+
+void Encoder<Tempest::CommandBuffer>::setDepthTest(RenderState::ZTestMode z) {
+  if(state.stage!=Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  impl->setDepthTest(z);
+  state.dynState = true;
+  }
+
+void Encoder<Tempest::CommandBuffer>::setDepthWrite(bool enable) {
+  if(state.stage!=Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  impl->setDepthWrite(enable);
+  state.dynState = true;
+  }
+
+void Encoder<Tempest::CommandBuffer>::setBlend(RenderState::BlendMode src, RenderState::BlendMode dst, RenderState::BlendOp op) {
+  if(state.stage!=Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  impl->setBlend(src, dst, op);
+  state.dynState = true;
+  }
+
 void Encoder<Tempest::CommandBuffer>::setDebugMarker(std::string_view tag) {
   impl->setDebugMarker(tag);
   }
@@ -70,6 +101,42 @@ void Encoder<Tempest::CommandBuffer>::setPushData(const void* data, size_t size)
   impl->setPushData(data, size);
   }
 
+void Encoder<Tempest::CommandBuffer>::pushUniform(size_t id, const void* data, size_t size) {
+  if(size==0 || data==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidUniformBuffer);
+  impl->pushUniform(id, data, size);
+  }
+
+void Encoder<Tempest::CommandBuffer>::setPushAddresses(std::initializer_list<const StorageBuffer*> buf) {
+  Detail::SmallArray<uint64_t,16> addr(buf.size());
+  size_t i = 0;
+  for(auto b:buf) {
+    if(b==nullptr)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+    addr[i] = b->deviceAddress();
+    ++i;
+    }
+  impl->setPushData(addr.get(), buf.size()*sizeof(uint64_t));
+  }
+
+void Encoder<Tempest::CommandBuffer>::setAddressUsage(std::initializer_list<const StorageBuffer*> read, std::initializer_list<const StorageBuffer*> write) {
+  Detail::SmallArray<const AbstractGraphicsApi::Buffer*,16> r(read.size()), w(write.size());
+  size_t nr = 0, nw = 0;
+  for(auto b:read) {
+    if(b==nullptr || !b->impl.impl)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+    r[nr] = b->impl.impl.handler;
+    ++nr;
+    }
+  for(auto b:write) {
+    if(b==nullptr || !b->impl.impl)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+    w[nw] = b->impl.impl.handler;
+    ++nw;
+    }
+  impl->setAddressUsage(r.get(), nr, w.get(), nw);
+  }
+
 void Encoder<Tempest::CommandBuffer>::setBinding(size_t id, const Texture2d& tex, const Sampler& smp) {
   if(!tex.impl.handler)
     throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
@@ -103,7 +170,7 @@ void Encoder<Tempest::CommandBuffer>::setBinding(size_t id, const StorageImage&
 void Encoder<Tempest::CommandBuffer>::setBinding(size_t id, const StorageBuffer& buf, size_t offset) {
   if(buf.impl.impl.handler==nullptr && offset!=0)
     throw std::system_error(Tempest::GraphicsErrc::InvalidUniformBuffer);
-  impl->setBinding(id, buf.impl.impl.handler, offset);
+  impl->setBinding(id, buf.impl.impl.handler, buf.impl.off+offset);
   }
 
 void Encoder<Tempest::CommandBuffer>::setBinding(size_t id, const Detail::ResourcePtr<Texture2d>& tex, const ComponentMapping& m, const Sampler& smp) {
@@ -115,7 +182,7 @@ void Encoder<Tempest::CommandBuffer>::setBinding(size_t id, const Detail::Resour
 void Encoder<Tempest::CommandBuffer>::implBindBuffer(size_t id, const Detail::VideoBuffer& buf) {
   if(buf.impl.handler==nullptr)
     throw std::system_error(Tempest::GraphicsErrc::InvalidUniformBuffer);
-  impl->setBinding(id, buf.impl.handler, 0);
+  impl->setBinding(id, buf.impl.handler, buf.off);
   }
 
 void Encoder<Tempest::CommandBuffer>::setBinding(size_t id, const DescriptorArray& arr) {
@@ -138,9 +205,11 @@ void Encoder<Tempest::CommandBuffer>::setPipeline(const RenderPipeline& p) {
   if(state.stage!=Rendering)
     throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
   assert(p.impl.handler);
-  if(state.curPipeline!=p.impl.handler) {
+  if(state.curPipeline!=p.impl.handler || state.dynState) {
+    // rebind restores render-state of pipeline
     impl->setPipeline(*p.impl.handler);
     state.curPipeline = p.impl.handler;
+    state.dynState    = false;
     }
   }
 
@@ -161,7 +230,9 @@ void Encoder<Tempest::CommandBuffer>::implDraw(const Detail::VideoBuffer& vbo, s
     throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
   if(size==0)
     return;
-  impl->draw(vbo.impl.handler,stride,offset,size,firstInstance,instanceCount);
+  // sub-range of GeometryPool: base vertex
+  const size_t base = (stride>0 ? vbo.off/stride : 0);
+  impl->draw(vbo.impl.handler,stride,base+offset,size,firstInstance,instanceCount);
   }
 
 void Encoder<Tempest::CommandBuffer>::implDraw(const Detail::VideoBuffer &vbo, size_t stride, const Detail::VideoBuffer &ibo, Detail::IndexClass icls, size_t offset, size_t size,
@@ -170,7 +241,61 @@ void Encoder<Tempest::CommandBuffer>::implDraw(const Detail::VideoBuffer &vbo, s
     throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
   if(size==0 || !ibo.impl)
     return;
-  impl->drawIndexed(vbo.impl.handler,stride,0,*ibo.impl.handler,icls,offset,size, firstInstance,instanceCount);
+  // sub-ranges of GeometryPool: base vertex and first index
+  const size_t vbase = (stride>0 ? vbo.off/stride : 0);
+  const size_t ibase = ibo.off/Detail::sizeofIndex(icls);
+  impl->drawIndexed(vbo.impl.handler,stride,vbase,*ibo.impl.handler,icls,ibase+offset,size, firstInstance,instanceCount);
+  }
+
+void Encoder<Tempest::CommandBuffer>::implDraw(const VertexStream* vbo, size_t vboSize, size_t offset, size_t size,
+                                               size_t firstInstance, size_t instanceCount) {
+  if(state.stage!=Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  if(size==0)
+    return;
+  implBindStreams(vbo,vboSize);
+  impl->draw(nullptr,0,offset,size,firstInstance,instanceCount);
+  }
+
+void Encoder<Tempest::CommandBuffer>::implDraw(const VertexStream* vbo, size_t vboSize, const Detail::VideoBuffer& ibo, Detail::IndexClass icls,
+                                               size_t offset, size_t size, size_t firstInstance, size_t instanceCount) {
+  if(state.stage!=Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  if(size==0 || !ibo.impl)
+    return;
+  implBindStreams(vbo,vboSize);
+  const size_t ibase = ibo.off/Detail::sizeofIndex(icls);
+  impl->drawIndexed(nullptr,0,0,*ibo.impl.handler,icls,ibase+offset,size,firstInstance,instanceCount);
+  }
+
+void Encoder<Tempest::CommandBuffer>::implBindStreams(const VertexStream* vbo, size_t vboSize) {
+  if(vboSize==0 || vboSize>MaxVertexStreams)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidVertexInput, "vertex streams count");
+  size_t numFormats = 0;
+  for(size_t i=0; i<vboSize; ++i) {
+    size_t sz = 0;
+    for(size_t r=0; r<vbo[i].formatSize; ++r)
+      sz += Decl::size(vbo[i].format[r]);
+    if(sz>vbo[i].stride)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidVertexInput, "vertex stream format exceeds stride");
+    numFormats += vbo[i].formatSize;
+    }
+  if(numFormats>MaxVertexAttribs)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidVertexInput, "vertex streams format");
+  AbstractGraphicsApi::VertexStream s[MaxVertexStreams] = {};
+  for(size_t i=0; i<vboSize; ++i) {
+    auto& v = *vbo[i].vbo;
+    if(!v.impl)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+    // GeometryPool ranges are bound with offset: streams don't share base vertex
+    s[i].vbo    = v.impl.handler;
+    s[i].offset = v.off;
+    s[i].stride = vbo[i].stride;
+    s[i].rate   = vbo[i].rate;
+    s[i].formatSize = uint8_t(vbo[i].formatSize);
+    std::copy_n(vbo[i].format, vbo[i].formatSize, s[i].format);
+    }
+  impl->setVertexStreams(s,vboSize);
   }
 
 void Encoder<Tempest::CommandBuffer>::drawIndirect(const StorageBuffer& indirect, size_t offset) {
@@ -178,7 +303,25 @@ void Encoder<Tempest::CommandBuffer>::drawIndirect(const StorageBuffer& indirect
     throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
   if(offset%4 != 0)
     throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer); //TODO: error code
-  impl->drawIndirect(*indirect.impl.impl.handler, offset);
+  impl->drawIndirect(*indirect.impl.impl.handler, indirect.impl.off+offset);
+  }
+
+void Encoder<Tempest::CommandBuffer>::execute(const CommandBundle& bundle) {
+  if(state.stage!=Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  if(!bundle.isValid())
+    throw std::system_error(Tempest::GraphicsErrc::InvalidCommandBundle);
+  if(bundle.layout!=state.layout)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidCommandBundle, "render-pass layout mismatch");
+
+  // bundle leaves pipeline state undefined
+  state.curPipeline = nullptr;
+  state.dynState    = false;
+
+  if(bundle.impl.handler!=nullptr && impl->execute(*bundle.impl.handler))
+    return;
+  for(auto& c:bundle.cmd)
+    bundle.exec(*impl, c);
   }
 
 void Encoder<Tempest::CommandBuffer>::dispatchMesh(size_t x, size_t y, size_t z) {
@@ -192,7 +335,7 @@ void Encoder<Tempest::CommandBuffer>::dispatchMeshIndirect(const StorageBuffer&
     throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
   if(offset%4 != 0)
     throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
-  impl->dispatchMeshIndirect(*indirect.impl.impl.handler, offset);
+  impl->dispatchMeshIndirect(*indirect.impl.impl.handler, indirect.impl.off+offset);
   }
 
 void Encoder<Tempest::CommandBuffer>::dispatchMeshThreads(size_t x, size_t y, size_t z) {
@@ -236,7 +379,7 @@ void Encoder<Tempest::CommandBuffer>::dispatchThreads(Size sz) {
 void Encoder<CommandBuffer>::dispatchIndirect(const StorageBuffer& indirect, size_t offset) {
   if (offset % 4 != 0)
     throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
-  impl->dispatchIndirect(*indirect.impl.impl.handler, offset);
+  impl->dispatchIndirect(*indirect.impl.impl.handler, indirect.impl.off+offset);
   }
 
 void Encoder<CommandBuffer>::setFramebuffer(std::initializer_list<AttachmentDesc> rd, AttachmentDesc zd) {
@@ -301,6 +444,15 @@ void Tempest::Encoder<Tempest::CommandBuffer>::implSetFramebuffer(const Attachme
   impl->beginRendering(fbo, rtSize+(zd ? 1 : 0), w, h);
   state.stage       = Rendering;
   state.curPipeline = nullptr;
+
+  auto& lay = state.layout;
+  lay.count = uint8_t(rtSize+(zd ? 1 : 0));
+  lay.w     = w;
+  lay.h     = h;
+  for(size_t i=0; i<lay.count; ++i) {
+    lay.frm[i] = fbo.frm[i];
+    lay.sw [i] = fbo.sw[i];
+    }
   }
 
 void Encoder<CommandBuffer>::copy(const Attachment& src, uint32_t mip, StorageBuffer& dest, size_t offset) {
@@ -308,7 +460,7 @@ void Encoder<CommandBuffer>::copy(const Attachment& src, uint32_t mip, StorageBu
     throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
   uint32_t w = src.w(), h = src.h();
   auto& tx = *textureCast<const Texture2d&>(src).impl.handler;
-  impl->copy(*dest.impl.impl.handler,offset,tx,w,h,mip);
+  impl->copy(*dest.impl.impl.handler,dest.impl.off+offset,tx,w,h,mip);
   }
 
 void Encoder<CommandBuffer>::copy(const Texture2d& src, uint32_t mip, StorageBuffer& dest, size_t offset) {
@@ -316,7 +468,22 @@ void Encoder<CommandBuffer>::copy(const Texture2d& src, uint32_t mip, StorageBuf
     throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
   uint32_t w = src.w(), h = src.h();
   auto& tx = *src.impl.handler;
-  impl->copy(*dest.impl.impl.handler,offset,tx,w,h,mip);
+  impl->copy(*dest.impl.impl.handler,dest.impl.off+offset,tx,w,h,mip);
+  }
+
+void Encoder<CommandBuffer>::updateTlas(AccelerationStructure& tlas, const RtInstance* inst, size_t count) {
+  if(state.stage==Rendering)
+    throw std::system_error(Tempest::GraphicsErrc::ComputeCallInRenderPass);
+  if(tlas.impl.handler==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidAccelerationStructure);
+
+  Detail::SmallArray<AbstractGraphicsApi::AccelerationStructure*,32> blas(count);
+  for(size_t i=0; i<count; ++i) {
+    if(inst[i].blas==nullptr || inst[i].blas->impl.handler==nullptr)
+      throw std::system_error(Tempest::GraphicsErrc::InvalidAccelerationStructure);
+    blas[i] = inst[i].blas->impl.handler;
+    }
+  impl->updateTlas(*tlas.impl.handler, inst, blas.get(), count);
   }
 
 void Encoder<CommandBuffer>::generateMipmaps(Attachment& tex) {
@@ -8,6 +8,8 @@
 #include <Tempest/UniformBuffer>
 #include <Tempest/AccelerationStructure>
 
+#include <initializer_list>
+
 namespace Tempest {
 
 template<class T>
@@ -16,7 +18,9 @@ class VertexBuffer;
 template<class T>
 class IndexBuffer;
 
+class VertexStream;
 class CommandBuffer;
+class CommandBundle;
 
 template<class T>
 class Encoder;
@@ -38,6 +42,16 @@ class Encoder<Tempest::CommandBuffer> {
     void setPushData(const T& data) { setPushData(&data, sizeof(data)); }
     void setPushData(const void* data, size_t size);
 
+    //! copies data into per-command-buffer uniform ring and binds it as uniform buffer at slot `id`
+    template<class T>
+    void pushUniform(size_t id, const T& data) { pushUniform(id, &data, sizeof(data)); }
+    void pushUniform(size_t id, const void* data, size_t size);
+
+    //! device addresses of buffers as push data: one uint64_t per buffer, in order
+    void setPushAddresses(std::initializer_list<const StorageBuffer*> buf);
+    //! buffers, accessed through device address by following draws/dispatches; replaces previous declaration
+    void setAddressUsage(std::initializer_list<const StorageBuffer*> read, std::initializer_list<const StorageBuffer*> write = {});
+
     void setBinding(size_t id, const Texture2d&       tex, const Sampler& smp = Sampler::anisotrophy());
     void setBinding(size_t id, const Attachment&      tex, const Sampler& smp = Sampler::anisotrophy());
     void setBinding(size_t id, const ZBuffer&         tex, const Sampler& smp = Sampler::anisotrophy());
@@ -59,6 +73,12 @@ class Encoder<Tempest::CommandBuffer> {
     void setScissor(int x,int y,int w,int h);
     void setScissor(const Rect& vp);
 
+    //! dynamic render-state: overrides RenderState of current pipeline, until next setPipeline
+    void setCullMode  (RenderState::CullMode cull);
+    void setDepthTest (RenderState::ZTestMode z);
+    void setDepthWrite(bool enable);
+    void setBlend     (RenderState::BlendMode src, RenderState::BlendMode dst, RenderState::BlendOp op = RenderState::BlendOp::Add);
+
     void setDebugMarker(std::string_view tag);
 
     // non-indexed + empty vbo
@@ -101,8 +121,28 @@ class Encoder<Tempest::CommandBuffer> {
     void draw(const VertexBuffer<T>& vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount)
          { implDraw(vbo.impl,sizeof(T),ibo.impl,Detail::indexCls<I>(),offset,count,firstInstance,instanceCount); }
 
+    // multiple vertex streams
+    void draw(std::initializer_list<VertexStream> vbo, size_t offset, size_t count) { implDraw(vbo.begin(),vbo.size(),offset,count,0,1); }
+    void draw(std::initializer_list<VertexStream> vbo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount)
+      { implDraw(vbo.begin(),vbo.size(),offset,count,firstInstance,instanceCount); }
+
+    template<class I>
+    void draw(std::initializer_list<VertexStream> vbo, const IndexBuffer<I>& ibo)
+      { implDraw(vbo.begin(),vbo.size(),ibo.impl,Detail::indexCls<I>(),0,ibo.size(),0,1); }
+
+    template<class I>
+    void draw(std::initializer_list<VertexStream> vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count)
+      { implDraw(vbo.begin(),vbo.size(),ibo.impl,Detail::indexCls<I>(),offset,count,0,1); }
+
+    template<class I>
+    void draw(std::initializer_list<VertexStream> vbo, const IndexBuffer<I>& ibo, size_t offset, size_t count, size_t firstInstance, size_t instanceCount)
+      { implDraw(vbo.begin(),vbo.size(),ibo.impl,Detail::indexCls<I>(),offset,count,firstInstance,instanceCount); }
+
     void drawIndirect(const StorageBuffer& indirect, size_t offset);
 
+    //! executes pre-recorded bundle; render-pass must match layout of bundle. Pipeline and bindings have to be set again afterwards
+    void execute(const CommandBundle& bundle);
+
     void dispatchMesh(size_t x, size_t y=1, size_t z=1);
     void dispatchMeshIndirect(const StorageBuffer& indirect, size_t offset);
     void dispatchMeshThreads(size_t x, size_t y=1, size_t z=1);
@@ -117,6 +157,11 @@ class Encoder<Tempest::CommandBuffer> {
     void copy(const Attachment& src, uint32_t mip, StorageBuffer& dest, size_t offset);
     void copy(const Texture2d&  src, uint32_t mip, StorageBuffer& dest, size_t offset);
 
+    //! in-place refit of tlas; instance count must not exceed one, used to create tlas. Smaller count disables tail instances
+    void updateTlas(AccelerationStructure& tlas, const RtInstance* inst, size_t count);
+    void updateTlas(AccelerationStructure& tlas, const std::vector<RtInstance>& inst) { updateTlas(tlas, inst.data(), inst.size()); }
+    void updateTlas(AccelerationStructure& tlas, std::initializer_list<RtInstance> inst) { updateTlas(tlas, inst.begin(), inst.size()); }
+
     void generateMipmaps(Attachment& tex);
 
   private:
@@ -132,6 +177,8 @@ class Encoder<Tempest::CommandBuffer> {
       const AbstractGraphicsApi::Pipeline*     curPipeline = nullptr;
       const AbstractGraphicsApi::CompPipeline* curCompute  = nullptr;
       Stage                                    stage       = None;
+      bool                                     dynState    = false;
+      Detail::FrameBufferLayout                layout;
       };
 
     AbstractGraphicsApi::CommandBuffer* impl = nullptr;
@@ -141,7 +188,11 @@ class Encoder<Tempest::CommandBuffer> {
     void         implDraw(const Detail::VideoBuffer& vbo, size_t stride, size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
     void         implDraw(const Detail::VideoBuffer& vbo, size_t stride, const Detail::VideoBuffer &ibo, Detail::IndexClass index,
                           size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
+    void         implDraw(const VertexStream* vbo, size_t vboSize, size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
+    void         implDraw(const VertexStream* vbo, size_t vboSize, const Detail::VideoBuffer &ibo, Detail::IndexClass index,
+                          size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
     void         implBindBuffer(size_t id, const Detail::VideoBuffer& buf);
+    void         implBindStreams(const VertexStream* vbo, size_t vboSize);
 
   friend class CommandBuffer;
   };
@@ -0,0 +1,52 @@
+#include "geometrypool.h"
+
+#include <Tempest/Device>
+#include <Tempest/Except>
+
+#include <limits>
+#include <numeric>
+
+using namespace Tempest;
+
+GeometryPool::GeometryPool(Device& device, size_t pageSize)
+  :state(std::make_shared<State>(device)) {
+  if(pageSize>std::numeric_limits<uint32_t>::max())
+    throw std::system_error(Tempest::GraphicsErrc::TooLargeBuffer);
+  state->alloc.setDefaultPageSize(uint32_t(pageSize));
+  }
+
+GeometryPool::~GeometryPool() {
+  }
+
+GeometryPool::MemoryProvider::DeviceMemory GeometryPool::MemoryProvider::alloc(size_t size, uint32_t /*typeId*/) {
+  static const auto usageBits = MemUsage::VertexBuffer | MemUsage::IndexBuffer | MemUsage::StorageBuffer | MemUsage::Transfer;
+  auto buf = device->createVideoBuffer(nullptr,size,usageBits,BufferHeap::Device);
+  // page keeps reference, until released by DeviceAllocator
+  auto ret = buf.impl.handler;
+  buf.impl.handler = nullptr;
+  return ret;
+  }
+
+void GeometryPool::MemoryProvider::free(DeviceMemory m, size_t /*size*/, uint32_t /*typeId*/) {
+  AbstractGraphicsApi::PBuffer buf;
+  buf.handler = m;
+  }
+
+Detail::VideoBuffer GeometryPool::implAlloc(const void* data, size_t size, size_t align) {
+  if(size>std::numeric_limits<uint32_t>::max())
+    throw std::system_error(Tempest::GraphicsErrc::TooLargeBuffer);
+
+  // element alignment is kept for vertex/index offsets, ssbo alignment - for setBinding
+  const size_t ssboAlign = std::max<size_t>(state->provider.device->properties().ssbo.offsetAlign, 1);
+  align = std::lcm(align, ssboAlign);
+
+  auto a = state->alloc.alloc(size,align,0,0,false);
+  if(a.page==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::OutOfVideoMemory);
+
+  std::shared_ptr<void> range(nullptr,[st = state, a](void*) { st->alloc.free(a); });
+  AbstractGraphicsApi::PBuffer page(a.page->memory);
+  Detail::VideoBuffer ret(page,a.offset,size,std::move(range));
+  ret.update(data,0,size);
+  return ret;
+  }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Tempest/VertexBuffer>
+#include <Tempest/IndexBuffer>
+#include "../gapi/deviceallocator.h"
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace Tempest {
+
+class Device;
+
+/**
+ * Sub-allocates vertex and index buffers from a few large device-local buffers.
+ *
+ * Returned buffers are regular VertexBuffer/IndexBuffer objects; draws of pooled geometry
+ * use vertex/index offsets, so consecutive draws from same page share bindings.
+ * Destroying the buffer returns its range to the pool. Pool storage is kept alive, while any of
+ * the buffers exist. Ranges are aligned to `Props::ssbo.offsetAlign`, so pooled buffers can be bound
+ * as storage buffers.
+ */
+class GeometryPool final {
+  public:
+    explicit GeometryPool(Device& device, size_t pageSize = 32*1024*1024);
+    GeometryPool(const GeometryPool&)=delete;
+    ~GeometryPool();
+
+    template<class T>
+    VertexBuffer<T> vbo(const T* arr, size_t arrSize) {
+      if(arrSize==0)
+        return VertexBuffer<T>();
+      return VertexBuffer<T>(implAlloc(arr,arrSize*sizeof(T),std::lcm(sizeof(T),size_t(4))),arrSize);
+      }
+
+    template<class T>
+    VertexBuffer<T> vbo(const std::vector<T>& arr) { return vbo(arr.data(),arr.size()); }
+
+    template<class T>
+    IndexBuffer<T>  ibo(const T* arr, size_t arrSize) {
+      if(arrSize==0)
+        return IndexBuffer<T>();
+      return IndexBuffer<T>(implAlloc(arr,arrSize*sizeof(T),sizeof(uint32_t)),arrSize);
+      }
+
+    template<class T>
+    IndexBuffer<T>  ibo(const std::vector<T>& arr) { return ibo(arr.data(),arr.size()); }
+
+  private:
+    struct MemoryProvider {
+      using DeviceMemory = AbstractGraphicsApi::Buffer*;
+
+      Device*      device = nullptr;
+
+      DeviceMemory alloc(size_t size, uint32_t typeId);
+      void         free(DeviceMemory m, size_t size, uint32_t typeId);
+      };
+
+    struct State {
+      explicit State(Device& dev):alloc(provider){ provider.device = &dev; }
+
+      MemoryProvider                          provider;
+      Detail::DeviceAllocator<MemoryProvider> alloc;
+      };
+
+    Detail::VideoBuffer    implAlloc(const void* data, size_t size, size_t align);
+
+    std::shared_ptr<State> state;
+  };
+
+}
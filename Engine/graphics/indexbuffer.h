@@ -6,6 +6,7 @@
 namespace Tempest {
 
 class Device;
+class GeometryPool;
 
 namespace Detail {
   template<class T>
@@ -37,7 +38,9 @@ class IndexBuffer : public StorageBuffer {
     size_t sz = 0;
 
   friend class Tempest::Device;
+  friend class Tempest::GeometryPool;
   friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class Tempest::Encoder<Tempest::CommandBundle>;
   friend class Tempest::DescriptorSet;
   };
 
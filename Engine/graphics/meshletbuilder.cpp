@@ -0,0 +1,349 @@
+#include "meshletbuilder.h"
+
+#include <Tempest/Device>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace Tempest;
+
+namespace {
+
+// meshlet-local vertex lookup: open addressing, size is power of 2 and >= 2*MaxVertices
+struct LocalMap {
+  enum { Size = 512, Empty = uint32_t(-1) };
+
+  uint32_t key [Size];
+  uint8_t  slot[Size];
+
+  LocalMap() { clear(); }
+
+  void clear() {
+    std::memset(key,0xFF,sizeof(key));
+    }
+
+  static uint32_t hash(uint32_t v) {
+    v ^= v >> 16;
+    v *= 0x7feb352d;
+    v ^= v >> 15;
+    return v & (Size-1);
+    }
+
+  bool find(uint32_t v, uint8_t& s) const {
+    for(uint32_t i=hash(v); ; i=(i+1)&(Size-1)) {
+      if(key[i]==v) {
+        s = slot[i];
+        return true;
+        }
+      if(key[i]==Empty)
+        return false;
+      }
+    }
+
+  bool contains(uint32_t v) const {
+    uint8_t s = 0;
+    return find(v,s);
+    }
+
+  void insert(uint32_t v, uint8_t s) {
+    uint32_t i = hash(v);
+    while(key[i]!=Empty)
+      i = (i+1)&(Size-1);
+    key [i] = v;
+    slot[i] = s;
+    }
+  };
+
+}
+
+struct MeshletBuilder::Context {
+  const uint8_t*                          position    = nullptr;
+  size_t                                  stride      = 0;
+  const uint32_t*                         index       = nullptr;
+  uint32_t                                vertexCount = 0;
+  uint32_t                                triCount    = 0;
+
+  // vertex -> triangles
+  std::vector<uint32_t>                   adjOffset;
+  std::vector<uint32_t>                   adjTri;
+  std::unique_ptr<std::atomic<uint32_t>[]> live;
+  std::vector<uint8_t>                    emitted;
+
+  Vec3 pos(uint32_t v) const {
+    auto p = reinterpret_cast<const float*>(position + v*stride);
+    return Vec3(p[0],p[1],p[2]);
+    }
+  };
+
+MeshletBuilder::MeshletBuilder(uint32_t maxVertices, uint32_t maxPrimitives)
+  :maxVert(std::clamp<uint32_t>(maxVertices,  3, MaxVertices)),
+   maxPrim(std::clamp<uint32_t>(maxPrimitives,1, MaxPrimitives)) {
+  }
+
+uint32_t MeshletBuilder::threadCount() const {
+  if(numThreads>0)
+    return numThreads;
+  return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+MeshletBuilder::Result MeshletBuilder::build(const float* position, size_t stride, size_t vertexCount,
+                                             const uint32_t* index, size_t indexCount) const {
+  Result ret;
+  if(indexCount<3 || vertexCount==0)
+    return ret;
+
+  Context ctx;
+  ctx.position    = reinterpret_cast<const uint8_t*>(position);
+  ctx.stride      = stride;
+  ctx.index       = index;
+  ctx.vertexCount = uint32_t(vertexCount);
+  ctx.triCount    = uint32_t(indexCount/3);
+
+  ctx.adjOffset.assign(vertexCount+1, 0);
+  for(size_t i=0; i<ctx.triCount*3; ++i) {
+    if(index[i]>=vertexCount)
+      throw std::out_of_range("MeshletBuilder: index out of range");
+    ctx.adjOffset[index[i]+1]++;
+    }
+  for(size_t i=0; i<vertexCount; ++i)
+    ctx.adjOffset[i+1] += ctx.adjOffset[i];
+
+  ctx.live.reset(new std::atomic<uint32_t>[vertexCount]);
+  for(size_t i=0; i<vertexCount; ++i)
+    ctx.live[i].store(ctx.adjOffset[i+1]-ctx.adjOffset[i], std::memory_order_relaxed);
+
+  ctx.adjTri.resize(ctx.triCount*3);
+  std::vector<uint32_t> fill(ctx.adjOffset.begin(), ctx.adjOffset.end()-1);
+  for(uint32_t i=0; i<ctx.triCount; ++i) {
+    for(int r=0; r<3; ++r)
+      ctx.adjTri[fill[index[i*3+r]]++] = i;
+    }
+  fill.clear();
+  ctx.emitted.assign(ctx.triCount, 0);
+
+  // parallel path works on disjoint triangle ranges; keep ranges large, to not lose much on seams
+  static const uint32_t MinTrianglesPerThread = 64*1024;
+  const uint32_t        threads = std::max(1u, std::min(threadCount(), ctx.triCount/MinTrianglesPerThread));
+  if(threads==1) {
+    buildRange(ctx,0,ctx.triCount,ret);
+    return ret;
+    }
+
+  std::vector<Result>      part(threads);
+  std::vector<std::thread> th;
+  th.reserve(threads);
+  for(uint32_t i=0; i<threads; ++i) {
+    const uint32_t begin = uint32_t((uint64_t(ctx.triCount)*i    )/threads);
+    const uint32_t end   = uint32_t((uint64_t(ctx.triCount)*(i+1))/threads);
+    th.emplace_back([this,&ctx,&part,i,begin,end](){
+      buildRange(ctx,begin,end,part[i]);
+      });
+    }
+  for(auto& t:th)
+    t.join();
+
+  size_t meshletCount = 0, vertCount = 0, primCount = 0;
+  for(auto& p:part) {
+    meshletCount += p.meshlets.size();
+    vertCount    += p.vertices.size();
+    primCount    += p.primitives.size();
+    }
+  ret.meshlets  .reserve(meshletCount);
+  ret.bounds    .reserve(meshletCount);
+  ret.vertices  .reserve(vertCount);
+  ret.primitives.reserve(primCount);
+
+  for(auto& p:part) {
+    const uint32_t vOffset = uint32_t(ret.vertices.size());
+    const uint32_t pOffset = uint32_t(ret.primitives.size());
+    for(auto m:p.meshlets) {
+      m.vertexOffset    += vOffset;
+      m.primitiveOffset += pOffset;
+      ret.meshlets.push_back(m);
+      }
+    ret.bounds    .insert(ret.bounds.end(),     p.bounds.begin(),     p.bounds.end());
+    ret.vertices  .insert(ret.vertices.end(),   p.vertices.begin(),   p.vertices.end());
+    ret.primitives.insert(ret.primitives.end(), p.primitives.begin(), p.primitives.end());
+    }
+  return ret;
+  }
+
+void MeshletBuilder::buildRange(Context& ctx, uint32_t triBegin, uint32_t triEnd, Result& out) const {
+  auto     map     = std::make_unique<LocalMap>();
+  Meshlet  active;
+  uint32_t cursor  = triBegin;
+
+  active.vertexOffset    = uint32_t(out.vertices.size());
+  active.primitiveOffset = uint32_t(out.primitives.size());
+
+  auto flush = [&]() {
+    if(active.primitiveCount==0)
+      return;
+    Bounds b;
+    computeBounds(ctx,out,active,b);
+    out.meshlets.push_back(active);
+    out.bounds.push_back(b);
+    active = Meshlet();
+    active.vertexOffset    = uint32_t(out.vertices.size());
+    active.primitiveOffset = uint32_t(out.primitives.size());
+    map->clear();
+    };
+
+  auto newVertices = [&](uint32_t t) {
+    uint32_t cnt = 0;
+    for(int r=0; r<3; ++r)
+      if(!map->contains(ctx.index[t*3+r]))
+        ++cnt;
+    return cnt;
+    };
+
+  // prefer triangles with less new vertices, then ones that finish off vertices with few remaining triangles
+  auto findCandidate = [&](const uint32_t* vert, uint32_t vertCount, uint32_t& best) {
+    uint32_t bestNew = 4, bestLive = uint32_t(-1);
+    best = uint32_t(-1);
+    for(uint32_t i=0; i<vertCount; ++i) {
+      const uint32_t v = vert[i];
+      for(uint32_t a=ctx.adjOffset[v]; a<ctx.adjOffset[v+1]; ++a) {
+        const uint32_t t = ctx.adjTri[a];
+        if(t<triBegin || t>=triEnd || ctx.emitted[t])
+          continue;
+        const uint32_t nv   = newVertices(t);
+        uint32_t       live = 0;
+        for(int r=0; r<3; ++r)
+          live += ctx.live[ctx.index[t*3+r]].load(std::memory_order_relaxed);
+        if(nv<bestNew || (nv==bestNew && live<bestLive)) {
+          best     = t;
+          bestNew  = nv;
+          bestLive = live;
+          }
+        }
+      }
+    return best!=uint32_t(-1);
+    };
+
+  std::vector<uint32_t> prevVerts;
+  while(true) {
+    uint32_t tri = uint32_t(-1);
+    if(active.vertexCount>0) {
+      findCandidate(out.vertices.data()+active.vertexOffset, active.vertexCount, tri);
+      }
+    else if(!prevVerts.empty()) {
+      // seed next meshlet next to previous one
+      findCandidate(prevVerts.data(), uint32_t(prevVerts.size()), tri);
+      }
+
+    if(tri==uint32_t(-1)) {
+      while(cursor<triEnd && ctx.emitted[cursor])
+        ++cursor;
+      if(cursor==triEnd)
+        break;
+      tri = cursor;
+      }
+
+    if(active.vertexCount+newVertices(tri)>maxVert || active.primitiveCount+1>maxPrim) {
+      prevVerts.assign(out.vertices.begin()+active.vertexOffset, out.vertices.end());
+      flush();
+      continue;
+      }
+
+    uint8_t local[3] = {};
+    for(int r=0; r<3; ++r) {
+      const uint32_t v = ctx.index[tri*3+r];
+      if(!map->find(v,local[r])) {
+        local[r] = uint8_t(active.vertexCount);
+        map->insert(v,local[r]);
+        out.vertices.push_back(v);
+        active.vertexCount++;
+        }
+      ctx.live[v].fetch_sub(1, std::memory_order_relaxed);
+      }
+    out.primitives.push_back(uint32_t(local[0]) | (uint32_t(local[1])<<8) | (uint32_t(local[2])<<16));
+    active.primitiveCount++;
+    ctx.emitted[tri] = 1;
+    }
+
+  flush();
+  }
+
+void MeshletBuilder::computeBounds(const Context& ctx, const Result& r, const Meshlet& m, Bounds& b) const {
+  const uint32_t* vert = r.vertices.data() + m.vertexOffset;
+
+  // Ritter's bounding sphere
+  Vec3 p0 = ctx.pos(vert[0]);
+  Vec3 p1 = p0;
+  for(uint32_t i=0; i<m.vertexCount; ++i) {
+    Vec3 p = ctx.pos(vert[i]);
+    if((p-p0).quadLength()>(p1-p0).quadLength())
+      p1 = p;
+    }
+  Vec3 p2 = p1;
+  for(uint32_t i=0; i<m.vertexCount; ++i) {
+    Vec3 p = ctx.pos(vert[i]);
+    if((p-p1).quadLength()>(p2-p1).quadLength())
+      p2 = p;
+    }
+
+  Vec3  center = (p1+p2)*0.5f;
+  float radius = (p2-p1).length()*0.5f;
+  for(uint32_t i=0; i<m.vertexCount; ++i) {
+    Vec3  p = ctx.pos(vert[i]);
+    float d = (p-center).length();
+    if(d>radius) {
+      float nr = (radius+d)*0.5f;
+      center += (p-center)*((nr-radius)/d);
+      radius  = nr;
+      }
+    }
+
+  // normal cone
+  const uint32_t* prim = r.primitives.data() + m.primitiveOffset;
+  Vec3  axis;
+  for(uint32_t i=0; i<m.primitiveCount; ++i) {
+    Vec3 a = ctx.pos(vert[(prim[i]    )&0xFF]);
+    Vec3 b = ctx.pos(vert[(prim[i]>>8 )&0xFF]);
+    Vec3 c = ctx.pos(vert[(prim[i]>>16)&0xFF]);
+    axis += Vec3::normalize(Vec3::crossProduct(b-a,c-a));
+    }
+  axis = Vec3::normalize(axis);
+
+  float minDot = 1.f;
+  for(uint32_t i=0; i<m.primitiveCount; ++i) {
+    Vec3 a = ctx.pos(vert[(prim[i]    )&0xFF]);
+    Vec3 b = ctx.pos(vert[(prim[i]>>8 )&0xFF]);
+    Vec3 c = ctx.pos(vert[(prim[i]>>16)&0xFF]);
+    Vec3 n = Vec3::normalize(Vec3::crossProduct(b-a,c-a));
+    minDot = std::min(minDot, Vec3::dotProduct(n,axis));
+    }
+
+  b.center[0] = center.x;
+  b.center[1] = center.y;
+  b.center[2] = center.z;
+  b.radius    = radius;
+  b.coneAxis[0] = axis.x;
+  b.coneAxis[1] = axis.y;
+  b.coneAxis[2] = axis.z;
+  // normals spread over more than a hemisphere: not cullable
+  b.coneCutoff  = (minDot<=0.f) ? 1.f : std::sqrt(1.f - minDot*minDot);
+  }
+
+bool MeshletBuilder::isBackfacing(const Bounds& b, const Vec3& camera) {
+  const Vec3 center = Vec3(b.center[0],b.center[1],b.center[2]);
+  const Vec3 axis   = Vec3(b.coneAxis[0],b.coneAxis[1],b.coneAxis[2]);
+  const Vec3 view   = center-camera;
+  return Vec3::dotProduct(view,axis) >= b.coneCutoff*view.length() + b.radius;
+  }
+
+MeshletBuilder::Buffers MeshletBuilder::upload(Device& device, const Result& r) {
+  Buffers ret;
+  ret.meshlets     = device.ssbo(r.meshlets);
+  ret.vertices     = device.ssbo(r.vertices);
+  ret.primitives   = device.ssbo(r.primitives);
+  ret.bounds       = device.ssbo(r.bounds);
+  ret.meshletCount = uint32_t(r.meshlets.size());
+  return ret;
+  }
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Tempest/StorageBuffer>
+#include <Tempest/Point>
+
+#include <cstdint>
+#include <vector>
+
+namespace Tempest {
+
+class Device;
+
+/**
+ * @brief Splits indexed triangle list into meshlets, suitable for mesh-shader rendering
+ *
+ * Triangles are gathered greedily by vertex adjacency, to maximize vertex reuse within meshlet.
+ * For each meshlet bounding sphere and normal cone are computed, for task-shader culling:
+ * meshlet is backfacing, if dot(center-camera, coneAxis) >= coneCutoff*length(center-camera) + radius.
+ * Radius term accounts for triangles, that are not located at sphere center; see `isBackfacing`.
+ */
+class MeshletBuilder {
+  public:
+    enum {
+      MaxVertices   = 256,
+      MaxPrimitives = 256,
+      };
+
+    struct Meshlet {
+      uint32_t vertexOffset    = 0;
+      uint32_t vertexCount     = 0;
+      uint32_t primitiveOffset = 0;
+      uint32_t primitiveCount  = 0;
+      };
+
+    // std430 friendly layout
+    struct Bounds {
+      float    center[3]  = {};
+      float    radius     = 0;
+      float    coneAxis[3]= {};
+      float    coneCutoff = 1;
+      };
+
+    struct Result {
+      std::vector<Meshlet>  meshlets;
+      // global vertex index, per meshlet-local vertex
+      std::vector<uint32_t> vertices;
+      // packed meshlet-local triangle: a | b<<8 | c<<16
+      std::vector<uint32_t> primitives;
+      std::vector<Bounds>   bounds;
+      };
+
+    struct Buffers {
+      StorageBuffer         meshlets;
+      StorageBuffer         vertices;
+      StorageBuffer         primitives;
+      StorageBuffer         bounds;
+      uint32_t              meshletCount = 0;
+      };
+
+    MeshletBuilder(uint32_t maxVertices = 64, uint32_t maxPrimitives = 124);
+
+    uint32_t maxVertices()   const { return maxVert; }
+    uint32_t maxPrimitives() const { return maxPrim; }
+
+    //! number of worker threads; 0 - use hardware concurrency
+    void     setThreadCount(uint32_t count) { numThreads = count; }
+    uint32_t threadCount()   const;
+
+    Result   build(const float* position, size_t stride, size_t vertexCount,
+                   const uint32_t* index, size_t indexCount) const;
+
+    template<class V>
+    Result   build(const std::vector<V>& vbo, const std::vector<uint32_t>& ibo) const {
+      static_assert(sizeof(V)>=3*sizeof(float), "vertex must start with float3 position");
+      return build(reinterpret_cast<const float*>(vbo.data()), sizeof(V), vbo.size(), ibo.data(), ibo.size());
+      }
+
+    static Buffers upload(Device& device, const Result& r);
+
+    //! conservative normal-cone test: true if no triangle of meshlet can face the camera
+    static bool    isBackfacing(const Bounds& b, const Vec3& camera);
+
+  private:
+    struct Context;
+
+    void     buildRange(Context& ctx, uint32_t triBegin, uint32_t triEnd, Result& out) const;
+    void     computeBounds(const Context& ctx, const Result& r, const Meshlet& m, Bounds& b) const;
+
+    uint32_t maxVert     = 64;
+    uint32_t maxPrim     = 124;
+    uint32_t numThreads  = 0;
+  };
+
+}
@@ -0,0 +1,305 @@
+#include "meshoptimizer.h"
+
+#include <Tempest/Vec>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+using namespace Tempest;
+
+namespace {
+
+struct Adjacency {
+  std::vector<uint32_t> offset;
+  std::vector<uint32_t> tri;
+
+  template<class I>
+  Adjacency(const I* ibo, size_t indexCount, size_t vertexCount) {
+    offset.assign(vertexCount+1, 0);
+    for(size_t i=0; i<indexCount; ++i)
+      offset[ibo[i]+1]++;
+    for(size_t i=0; i<vertexCount; ++i)
+      offset[i+1] += offset[i];
+
+    tri.resize(indexCount);
+    std::vector<uint32_t> fill(offset.begin(), offset.end()-1);
+    for(size_t i=0; i<indexCount; ++i)
+      tri[fill[ibo[i]]++] = uint32_t(i/3);
+    }
+
+  uint32_t valence(uint32_t v) const { return offset[v+1]-offset[v]; }
+  };
+
+// FIFO cache: vertex is in cache, if it was inserted less than cacheSize misses ago
+struct CacheSim {
+  std::vector<uint32_t> stamp;
+  uint32_t              time      = 0;
+  uint32_t              cacheSize = 0;
+
+  CacheSim(size_t vertexCount, uint32_t cacheSize):stamp(vertexCount,0),cacheSize(cacheSize) {}
+
+  void reset() {
+    // move time forward, instead of clearing stamps
+    time += cacheSize+1;
+    }
+
+  bool access(uint32_t v) {
+    if(stamp[v]!=0 && time-stamp[v]<cacheSize)
+      return false;
+    stamp[v] = ++time;
+    return true;
+    }
+
+  template<class I>
+  uint32_t triangle(const I* t) {
+    return uint32_t(access(t[0])) + uint32_t(access(t[1])) + uint32_t(access(t[2]));
+    }
+  };
+
+}
+
+MeshOptimizer::MeshOptimizer(uint32_t cacheSize)
+  :cacheSize(std::max<uint32_t>(cacheSize,3)) {
+  }
+
+template<class I>
+float MeshOptimizer::acmr(const I* ibo, size_t indexCount, size_t vertexCount) const {
+  if(indexCount<3)
+    return 0;
+  CacheSim cache(vertexCount,cacheSize);
+  size_t   miss = 0;
+  for(size_t i=0; i+2<indexCount; i+=3)
+    miss += cache.triangle(ibo+i);
+  return float(miss)/float(indexCount/3);
+  }
+
+template<class I>
+float MeshOptimizer::atvr(const I* ibo, size_t indexCount, size_t vertexCount) const {
+  std::vector<bool> used(vertexCount,false);
+  size_t unique = 0;
+  for(size_t i=0; i<indexCount; ++i) {
+    if(!used[ibo[i]]) {
+      used[ibo[i]] = true;
+      ++unique;
+      }
+    }
+  if(unique==0)
+    return 0;
+  return acmr(ibo,indexCount,vertexCount)*float(indexCount/3)/float(unique);
+  }
+
+template<class I>
+void MeshOptimizer::optimizeVertexCache(I* ibo, size_t indexCount, size_t vertexCount) const {
+  // Tipsify: Sander, Nehab, Barczak - "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+  const size_t triCount = indexCount/3;
+  if(triCount==0)
+    return;
+
+  Adjacency             adj(ibo,triCount*3,vertexCount);
+  std::vector<uint32_t> live(vertexCount);
+  for(size_t i=0; i<vertexCount; ++i)
+    live[i] = adj.valence(uint32_t(i));
+
+  std::vector<uint32_t> stamp(vertexCount,0);
+  std::vector<uint8_t>  emitted(triCount,0);
+  std::vector<uint32_t> deadEnd;
+  std::vector<uint32_t> candidates;
+  std::vector<I>        out;
+  out.reserve(triCount*3);
+
+  deadEnd.reserve(triCount*3);
+  candidates.reserve(64);
+
+  const uint32_t k      = cacheSize;
+  uint32_t       time   = k+1;
+  uint32_t       cursor = 0;
+  int64_t        fan    = 0;
+
+  while(fan>=0) {
+    candidates.clear();
+    const uint32_t f = uint32_t(fan);
+    for(uint32_t a=adj.offset[f]; a<adj.offset[f+1]; ++a) {
+      const uint32_t t = adj.tri[a];
+      if(emitted[t])
+        continue;
+      for(int r=0; r<3; ++r) {
+        const uint32_t v = uint32_t(ibo[t*3+r]);
+        out.push_back(ibo[t*3+r]);
+        deadEnd.push_back(v);
+        candidates.push_back(v);
+        live[v]--;
+        if(time-stamp[v]>k) {
+          stamp[v] = time;
+          ++time;
+          }
+        }
+      emitted[t] = 1;
+      }
+
+    // next fanning vertex: one that stays in cache longest, after emitting its fan
+    fan = -1;
+    uint32_t best = 0;
+    for(auto v:candidates) {
+      if(live[v]==0)
+        continue;
+      uint32_t p = 0;
+      if(time-stamp[v]+2*live[v]<=k)
+        p = time-stamp[v];
+      if(p>best || fan<0) {
+        best = p;
+        fan  = v;
+        }
+      }
+    if(fan>=0)
+      continue;
+
+    while(!deadEnd.empty()) {
+      const uint32_t v = deadEnd.back();
+      deadEnd.pop_back();
+      if(live[v]>0) {
+        fan = v;
+        break;
+        }
+      }
+    if(fan>=0)
+      continue;
+
+    while(cursor<vertexCount) {
+      if(live[cursor]>0) {
+        fan = cursor;
+        break;
+        }
+      ++cursor;
+      }
+    }
+
+  std::copy(out.begin(), out.end(), ibo);
+  }
+
+template<class I>
+void MeshOptimizer::optimizeOverdraw(I* ibo, size_t indexCount, const float* position, size_t stride, size_t vertexCount) const {
+  // split cache-optimized sequence into clusters and sort them front-to-back, from outside of mesh
+  const size_t triCount = indexCount/3;
+  if(triCount<2)
+    return;
+
+  auto pos = [&](uint32_t v) {
+    auto p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(position) + v*stride);
+    return Vec3(p[0],p[1],p[2]);
+    };
+
+  // hard boundaries: triangles with full cache miss
+  std::vector<uint32_t> hard;
+  {
+  CacheSim cache(vertexCount,cacheSize);
+  for(size_t i=0; i<triCount; ++i)
+    if(cache.triangle(ibo+i*3)==3)
+      hard.push_back(uint32_t(i));
+  }
+  if(hard.empty() || hard[0]!=0)
+    hard.insert(hard.begin(),0);
+  hard.push_back(uint32_t(triCount));
+
+  // soft boundaries: split hard clusters, while ACMR stays within threshold
+  std::vector<uint32_t> clusters;
+  CacheSim cache(vertexCount,cacheSize);
+  for(size_t c=0; c+1<hard.size(); ++c) {
+    const uint32_t begin = hard[c], end = hard[c+1];
+
+    cache.reset();
+    uint32_t miss = 0;
+    for(uint32_t i=begin; i<end; ++i)
+      miss += cache.triangle(ibo+i*3);
+    const float limit = float(miss)/float(end-begin)*overdrawThreshold;
+
+    clusters.push_back(begin);
+    cache.reset();
+    uint32_t start = begin;
+    miss = 0;
+    for(uint32_t i=begin; i<end; ++i) {
+      miss += cache.triangle(ibo+i*3);
+      if(i+1<end && float(miss)/float(i-start+1)<=limit) {
+        clusters.push_back(i+1);
+        cache.reset();
+        start = i+1;
+        miss  = 0;
+        }
+      }
+    }
+  clusters.push_back(uint32_t(triCount));
+
+  const size_t          clusterCount = clusters.size()-1;
+  std::vector<Vec3>     centroid(clusterCount);
+  std::vector<Vec3>     normal  (clusterCount);
+  Vec3                  meshCenter;
+  float                 meshArea = 0;
+  for(size_t c=0; c<clusterCount; ++c) {
+    float area = 0;
+    for(uint32_t i=clusters[c]; i<clusters[c+1]; ++i) {
+      Vec3  a = pos(uint32_t(ibo[i*3+0]));
+      Vec3  b = pos(uint32_t(ibo[i*3+1]));
+      Vec3  d = pos(uint32_t(ibo[i*3+2]));
+      Vec3  n = Vec3::crossProduct(b-a,d-a);
+      float s = n.length();
+      centroid[c] += (a+b+d)*(s/3.f);
+      normal[c]   += n;
+      area        += s;
+      }
+    meshCenter += centroid[c];
+    meshArea   += area;
+    if(area>0)
+      centroid[c] /= area;
+    normal[c] = Vec3::normalize(normal[c]);
+    }
+  if(meshArea>0)
+    meshCenter /= meshArea;
+
+  std::vector<float>    sortKey(clusterCount);
+  std::vector<uint32_t> order  (clusterCount);
+  for(size_t c=0; c<clusterCount; ++c) {
+    sortKey[c] = Vec3::dotProduct(centroid[c]-meshCenter, normal[c]);
+    order[c]   = uint32_t(c);
+    }
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r){
+    return sortKey[l]>sortKey[r];
+    });
+
+  std::vector<I> out;
+  out.reserve(triCount*3);
+  for(auto c:order)
+    out.insert(out.end(), ibo+clusters[c]*3, ibo+clusters[c+1]*3);
+  std::copy(out.begin(), out.end(), ibo);
+  }
+
+template<class I>
+size_t MeshOptimizer::optimizeVertexFetch(void* vbo, size_t stride, size_t vertexCount, I* ibo, size_t indexCount) const {
+  std::vector<uint32_t> remap(vertexCount, uint32_t(-1));
+  uint32_t              next = 0;
+  for(size_t i=0; i<indexCount; ++i) {
+    auto& r = remap[ibo[i]];
+    if(r==uint32_t(-1))
+      r = next++;
+    ibo[i] = I(r);
+    }
+
+  auto                 src = reinterpret_cast<uint8_t*>(vbo);
+  std::vector<uint8_t> tmp(size_t(next)*stride);
+  for(size_t i=0; i<vertexCount; ++i) {
+    if(remap[i]!=uint32_t(-1))
+      std::memcpy(tmp.data()+remap[i]*stride, src+i*stride, stride);
+    }
+  std::memcpy(src, tmp.data(), tmp.size());
+  return next;
+  }
+
+template void   MeshOptimizer::optimizeVertexCache<uint16_t>(uint16_t*, size_t, size_t) const;
+template void   MeshOptimizer::optimizeVertexCache<uint32_t>(uint32_t*, size_t, size_t) const;
+template void   MeshOptimizer::optimizeOverdraw<uint16_t>(uint16_t*, size_t, const float*, size_t, size_t) const;
+template void   MeshOptimizer::optimizeOverdraw<uint32_t>(uint32_t*, size_t, const float*, size_t, size_t) const;
+template size_t MeshOptimizer::optimizeVertexFetch<uint16_t>(void*, size_t, size_t, uint16_t*, size_t) const;
+template size_t MeshOptimizer::optimizeVertexFetch<uint32_t>(void*, size_t, size_t, uint32_t*, size_t) const;
+template float  MeshOptimizer::acmr<uint16_t>(const uint16_t*, size_t, size_t) const;
+template float  MeshOptimizer::acmr<uint32_t>(const uint32_t*, size_t, size_t) const;
+template float  MeshOptimizer::atvr<uint16_t>(const uint16_t*, size_t, size_t) const;
+template float  MeshOptimizer::atvr<uint32_t>(const uint32_t*, size_t, size_t) const;
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Tempest {
+
+/**
+ * @brief Load-time reordering of indexed triangle lists
+ *
+ * Passes are applied in order: vertex cache (Tipsify), overdraw (cluster sort), vertex fetch.
+ * Index type can be uint16_t or uint32_t, same as IndexBuffer.
+ */
+class MeshOptimizer {
+  public:
+    struct Report {
+      float acmrBefore = 0; //! average cache miss ratio: transformed vertices per triangle
+      float acmrAfter  = 0;
+      float atvrBefore = 0; //! average transformed vertex ratio: transformed vertices per unique vertex
+      float atvrAfter  = 0;
+      };
+
+    MeshOptimizer(uint32_t cacheSize = 16);
+
+    //! threshold of acceptable ACMR degradation, in favor of overdraw; 0 - disable overdraw pass
+    void  setOverdrawThreshold(float t) { overdrawThreshold = t; }
+    void  setVertexFetchOptimization(bool e) { vertexFetch = e; }
+
+    template<class V, class I>
+    Report optimize(std::vector<V>& vbo, std::vector<I>& ibo) const {
+      static_assert(sizeof(V)>=3*sizeof(float), "vertex must start with float3 position");
+      Report r = {};
+      r.acmrBefore = acmr(ibo.data(), ibo.size(), vbo.size());
+      r.atvrBefore = atvr(ibo.data(), ibo.size(), vbo.size());
+
+      optimizeVertexCache(ibo.data(), ibo.size(), vbo.size());
+      if(overdrawThreshold>0)
+        optimizeOverdraw(ibo.data(), ibo.size(), reinterpret_cast<const float*>(vbo.data()), sizeof(V), vbo.size());
+      if(vertexFetch)
+        vbo.resize(optimizeVertexFetch(vbo.data(), sizeof(V), vbo.size(), ibo.data(), ibo.size()));
+
+      r.acmrAfter = acmr(ibo.data(), ibo.size(), vbo.size());
+      r.atvrAfter = atvr(ibo.data(), ibo.size(), vbo.size());
+      return r;
+      }
+
+    template<class I>
+    void   optimizeVertexCache(I* ibo, size_t indexCount, size_t vertexCount) const;
+
+    template<class I>
+    void   optimizeOverdraw(I* ibo, size_t indexCount, const float* position, size_t stride, size_t vertexCount) const;
+
+    //! reorders vertices in order of first use; unused vertices are dropped. Returns new vertex count
+    template<class I>
+    size_t optimizeVertexFetch(void* vbo, size_t stride, size_t vertexCount, I* ibo, size_t indexCount) const;
+
+    //! FIFO post-transform cache simulation
+    template<class I>
+    float  acmr(const I* ibo, size_t indexCount, size_t vertexCount) const;
+    template<class I>
+    float  atvr(const I* ibo, size_t indexCount, size_t vertexCount) const;
+
+  private:
+    uint32_t cacheSize         = 16;
+    float    overdrawThreshold = 1.05f;
+    bool     vertexFetch       = true;
+  };
+
+}
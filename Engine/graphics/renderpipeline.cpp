@@ -16,3 +16,9 @@ RenderPipeline &RenderPipeline::operator =(RenderPipeline&& other) {
 size_t RenderPipeline::sizeofBuffer(size_t layoutBind, size_t arraylen) const {
   return impl.handler->sizeofBuffer(layoutBind, arraylen);
   }
+
+PipelineStats RenderPipeline::stats() const {
+  if(impl.handler==nullptr)
+    return PipelineStats();
+  return impl.handler->stats();
+  }
@@ -22,6 +22,8 @@ class RenderPipeline final {
     bool isEmpty() const { return impl.handler==nullptr; }
 
     size_t sizeofBuffer(size_t layoutBind, size_t arraylen = 0) const;
+    //! backend variants (per framebuffer layout and vertex input), created so far
+    PipelineStats stats() const;
 
   private:
     RenderPipeline(Detail::DSharedPtr<AbstractGraphicsApi::Pipeline*>&& p);
@@ -30,6 +32,7 @@ class RenderPipeline final {
 
   friend class Tempest::Device;
   friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class Tempest::Encoder<Tempest::CommandBundle>;
 
   template<class T>
   friend class Tempest::Detail::ResourcePtr;
@@ -16,6 +16,10 @@ class Shader final {
 
     bool isEmpty() const { return impl.handler==nullptr; }
 
+    //! same backend shader object; Device returns same object for identical bytecode
+    bool operator == (const Shader& other) const { return impl.handler==other.impl.handler; }
+    bool operator != (const Shader& other) const { return impl.handler!=other.impl.handler; }
+
   private:
     Shader(Tempest::Device& dev,Detail::DSharedPtr<AbstractGraphicsApi::Shader*>&& impl);
 
@@ -0,0 +1,47 @@
+#include "specializationconstants.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Tempest;
+
+void SpecializationConstants::set(uint32_t id, uint32_t v) {
+  auto it = std::lower_bound(data.begin(), data.end(), id, [](const Entry& e, uint32_t id){ return e.id<id; });
+  if(it!=data.end() && it->id==id) {
+    it->value = v;
+    return;
+    }
+  data.insert(it, Entry{id, v});
+  }
+
+void SpecializationConstants::set(uint32_t id, int32_t v) {
+  set(id, uint32_t(v));
+  }
+
+void SpecializationConstants::set(uint32_t id, float v) {
+  uint32_t u = 0;
+  std::memcpy(&u, &v, sizeof(u));
+  set(id, u);
+  }
+
+void SpecializationConstants::set(uint32_t id, bool v) {
+  // VkBool32
+  set(id, uint32_t(v ? 1 : 0));
+  }
+
+bool SpecializationConstants::find(uint32_t id, uint32_t& v) const {
+  auto it = std::lower_bound(data.begin(), data.end(), id, [](const Entry& e, uint32_t id){ return e.id<id; });
+  if(it==data.end() || it->id!=id)
+    return false;
+  v = it->value;
+  return true;
+  }
+
+bool SpecializationConstants::operator ==(const SpecializationConstants& other) const {
+  if(data.size()!=other.data.size())
+    return false;
+  for(size_t i=0; i<data.size(); ++i)
+    if(data[i].id!=other.data[i].id || data[i].value!=other.data[i].value)
+      return false;
+  return true;
+  }
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Tempest {
+
+/**
+ * Values for specialization constants (`layout(constant_id = N)` in GLSL), applied at pipeline creation.
+ * Driver can constant-fold branches on such constants; workgroup size can be specialized as well,
+ * with `layout(local_size_x_id = N)`. Only 32-bit scalar constants are supported.
+ */
+class SpecializationConstants final {
+  public:
+    struct Entry {
+      uint32_t id    = 0;
+      uint32_t value = 0;
+      };
+
+    SpecializationConstants() = default;
+
+    void         set(uint32_t id, uint32_t v);
+    void         set(uint32_t id, int32_t  v);
+    void         set(uint32_t id, float    v);
+    void         set(uint32_t id, bool     v);
+
+    bool         find(uint32_t id, uint32_t& v) const;
+
+    bool         isEmpty() const { return data.empty(); }
+    size_t       size()    const { return data.size();  }
+    const Entry* entries() const { return data.data();  }
+
+    bool         operator == (const SpecializationConstants& other) const;
+    bool         operator != (const SpecializationConstants& other) const { return !(*this==other); }
+
+  private:
+    std::vector<Entry> data; // sorted by id
+  };
+
+}
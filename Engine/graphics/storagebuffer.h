@@ -4,6 +4,8 @@
 
 namespace Tempest {
 
+class VertexStream;
+
 class StorageBuffer {
   public:
     StorageBuffer()=default;
@@ -18,6 +20,18 @@ class StorageBuffer {
     void   update(const std::vector<T>& v)                      { return impl.update(v.data(),0,v.size()*sizeof(T)); }
     void   update(const void* data, size_t offset, size_t size) { return impl.update(data,offset,size); }
 
+    //! direct access to memory of BufferHeap::Upload/Readback buffer; throws, if buffer is not host-visible
+    template<class T = uint8_t>
+    MappedRange<T> map()                                { return MappedRange<T>(reinterpret_cast<T*>(impl.map()), impl.size()/sizeof(T)); }
+    //! byte range, written through map(); required by non-coherent memory
+    void   flush     (size_t offset, size_t size)       { impl.flush(offset,size); }
+    //! byte range, to be read through map(); required by non-coherent memory
+    void   invalidate(size_t offset, size_t size)       { impl.invalidate(offset,size); }
+
+    //! GPU pointer for GLSL buffer_reference; requires Device::properties().deviceAddress
+    //! accesses through it are tracked only when declared with Encoder::setAddressUsage
+    uint64_t deviceAddress() const                      { return impl.deviceAddress(); }
+
   private:
     explicit StorageBuffer(Tempest::Detail::VideoBuffer&& impl)
       :impl(std::move(impl)) {
@@ -28,7 +42,10 @@ class StorageBuffer {
   friend class Tempest::Device;
   friend class Tempest::CommandBuffer;
   friend class Tempest::DescriptorSet;
+  friend class Tempest::DescriptorArray;
   friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class Tempest::Encoder<Tempest::CommandBundle>;
+  friend class Tempest::VertexStream;
 
   template<class T>
   friend class VertexBuffer;
@@ -34,6 +34,7 @@ class StorageImage final {
   friend class Tempest::Device;
   friend class Tempest::DescriptorSet;
   friend class Encoder<Tempest::CommandBuffer>;
+  friend class Encoder<Tempest::CommandBundle>;
 
   template<class T>
   friend T textureCast(StorageImage& s);
@@ -2,9 +2,86 @@
 
 #include <Tempest/Attachment>
 #include <Tempest/Device>
+#include <Tempest/Pixmap>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 using namespace Tempest;
 
+struct Swapchain::Headless {
+  using clock = std::chrono::steady_clock;
+
+  uint32_t          w       = 0;
+  uint32_t          h       = 0;
+  uint32_t          count   = 0;
+  uint32_t          current = 0;
+  SwapchainDesc     desc;
+  PresentMode       mode    = PresentMode::Immediate;
+  clock::time_point origin;
+  SwapchainStats    stats;
+  Pixmap            frame;
+
+  // SwapchainDesc::presentThread: simulated present, with wait for vblank, is done by this thread
+  std::thread                   thr;
+  std::mutex                    sync;
+  std::condition_variable       cv;
+  std::deque<clock::time_point> queue;
+  uint32_t                      queued = 0; // images, that are presented, but not shown yet
+  bool                          exit   = false;
+
+  ~Headless();
+  clock::time_point vblank(clock::time_point t) const;
+  void              presentLoop();
+  };
+
+static uint64_t toUs(std::chrono::steady_clock::duration d) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+  }
+
+Swapchain::Headless::~Headless() {
+  if(!thr.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    exit = true;
+  }
+  cv.notify_all();
+  thr.join();
+  }
+
+Swapchain::Headless::clock::time_point Swapchain::Headless::vblank(clock::time_point t) const {
+  const auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::microseconds(desc.refreshInterval));
+  return origin + ((t-origin)/interval + 1)*interval;
+  }
+
+void Swapchain::Headless::presentLoop() {
+  std::unique_lock<std::mutex> guard(sync);
+  clock::time_point shown = origin;
+  while(true) {
+    cv.wait(guard, [this](){ return !queue.empty() || exit; });
+    if(queue.empty())
+      return;
+    const auto t0 = queue.front();
+    queue.pop_front();
+    guard.unlock();
+
+    // fifo: one image per vblank, in order of present
+    auto t1 = vblank(std::max(t0,shown));
+    if(mode==PresentMode::Fifo || mode==PresentMode::FifoRelaxed)
+      std::this_thread::sleep_until(t1);
+    shown = t1;
+
+    guard.lock();
+    stats.displayLatency = toUs(t1-t0);
+    --queued;
+    cv.notify_all();
+    }
+  }
+
 Swapchain::Swapchain(AbstractGraphicsApi::Swapchain* sw)
   : impl(sw) {
   implReset();
@@ -17,8 +94,31 @@ void Swapchain::implReset() {
     img[i] = Attachment(impl.handler,i);
   }
 
-Swapchain::Swapchain(Device& dev, SystemApi::Window* w) {
-  *this = dev.swapchain(w);
+Swapchain::Swapchain(Device& dev, SystemApi::Window* w, const SwapchainDesc& desc) {
+  *this = dev.swapchain(w,desc);
+  }
+
+Swapchain::Swapchain(Device& dev, uint32_t w, uint32_t h, const SwapchainDesc& desc) {
+  *this = dev.swapchain(w,h,desc);
+  }
+
+Swapchain::Swapchain(uint32_t w, uint32_t h, const SwapchainDesc& desc)
+  : headless(new Headless()) {
+  // images are created by Device::swapchain
+  auto& hs = *headless;
+  hs.w      = w;
+  hs.h      = h;
+  hs.count  = desc.imageCount==0 ? 3 : desc.imageCount;
+  hs.desc   = desc;
+  hs.mode   = desc.refreshInterval==0 ? PresentMode::Immediate : desc.presentMode;
+  hs.origin = Headless::clock::now();
+  img.reset(new Attachment[hs.count]);
+  if(desc.presentThread && hs.mode!=PresentMode::Immediate)
+    hs.thr = std::thread([&hs](){ hs.presentLoop(); });
+  }
+
+Swapchain::Swapchain(Swapchain&& s)
+  : impl(std::move(s.impl)), img(std::move(s.img)), headless(std::move(s.headless)) {
   }
 
 Swapchain::~Swapchain() {
@@ -26,28 +126,62 @@ Swapchain::~Swapchain() {
   }
 
 Swapchain& Swapchain::operator = (Swapchain&& s) {
-  std::swap(impl, s.impl);
-  std::swap(img,  s.img);
+  std::swap(impl,     s.impl);
+  std::swap(img,      s.img);
+  std::swap(headless, s.headless);
   return *this;
   }
 
 uint32_t Swapchain::w() const {
+  if(headless!=nullptr)
+    return headless->w;
   return impl.handler->w();
   }
 
 uint32_t Swapchain::h() const {
+  if(headless!=nullptr)
+    return headless->h;
   return impl.handler->h();
   }
 
 void Swapchain::reset() {
+  if(headless!=nullptr)
+    return;
   impl.handler->reset();
   implReset();
   }
 
 uint32_t Swapchain::imageCount() const {
+  if(headless!=nullptr)
+    return headless->count;
   return impl.handler->imageCount();
   }
 
+PresentMode Swapchain::presentMode() const {
+  if(headless!=nullptr)
+    return headless->mode;
+  return impl.handler->presentMode();
+  }
+
+SwapchainStats Swapchain::stats() const {
+  if(headless!=nullptr) {
+    std::lock_guard<std::mutex> guard(headless->sync);
+    return headless->stats;
+    }
+  return impl.handler->stats();
+  }
+
+bool Swapchain::isHeadless() const {
+  return headless!=nullptr;
+  }
+
+const Pixmap& Swapchain::presentedFrame() const {
+  static const Pixmap empty;
+  if(headless!=nullptr)
+    return headless->frame;
+  return empty;
+  }
+
 Attachment& Swapchain::operator[](size_t id) {
   return img[id];
   }
@@ -57,5 +191,47 @@ const Attachment& Swapchain::operator[](size_t id) const {
   }
 
 uint32_t Swapchain::currentImage() const {
+  if(headless!=nullptr)
+    return headless->current;
   return impl.handler->currentBackBufferIndex();
   }
+
+void Swapchain::implPresent(Device& dev) {
+  auto&      hs = *headless;
+  const auto t0 = Headless::clock::now();
+  if(hs.desc.readback)
+    hs.frame = dev.readPixels(img[hs.current]);
+  const auto t1 = Headless::clock::now();
+
+  if(hs.thr.joinable()) {
+    // image is queued to present thread; next image is acquired here, once it's not queued
+    std::unique_lock<std::mutex> guard(hs.sync);
+    hs.queue.push_back(t0);
+    ++hs.queued;
+    hs.cv.notify_all();
+    hs.cv.wait(guard, [&hs](){ return hs.queued<hs.count; });
+    const auto t2 = Headless::clock::now();
+
+    hs.stats.frameId     = hs.stats.frameId+1;
+    hs.stats.presentTime = toUs(t1-t0);
+    hs.stats.acquireWait = toUs(t2-t1);
+    hs.current = (hs.current+1)%hs.count;
+    return;
+    }
+
+  SwapchainStats st;
+  st.frameId     = hs.stats.frameId+1;
+  st.presentTime = toUs(t1-t0);
+  if(hs.mode!=PresentMode::Immediate) {
+    // image is shown on next simulated vblank
+    const auto vblank = hs.vblank(t1);
+    st.displayLatency = toUs(vblank-t0);
+    if(hs.mode==PresentMode::Fifo || hs.mode==PresentMode::FifoRelaxed) {
+      std::this_thread::sleep_until(vblank);
+      st.acquireWait = toUs(Headless::clock::now()-t1);
+      }
+    }
+
+  hs.stats   = st;
+  hs.current = (hs.current+1)%hs.count;
+  }
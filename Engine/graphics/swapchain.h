@@ -7,11 +7,20 @@ namespace Tempest {
 class Device;
 class Frame;
 class Attachment;
-
+class Pixmap;
+
+/**
+ * Set of presentable images.
+ *
+ * Swapchain, created without window, is headless: images are plain attachments in a ring, present
+ * only advances `currentImage()` with optional pacing by `SwapchainDesc::refreshInterval`.
+ * With `SwapchainDesc::presentThread` wait for simulated vblank is done by internal thread.
+ */
 class Swapchain final {
   public:
-    Swapchain(Device& dev, SystemApi::Window* w);
-    Swapchain(Swapchain&&)=default;
+    Swapchain(Device& dev, SystemApi::Window* w, const SwapchainDesc& desc = SwapchainDesc());
+    Swapchain(Device& dev, uint32_t w, uint32_t h, const SwapchainDesc& desc = SwapchainDesc());
+    Swapchain(Swapchain&&);
     ~Swapchain();
 
     Swapchain& operator = (Swapchain&& s);
@@ -26,16 +35,29 @@ class Swapchain final {
     Attachment&          operator[](size_t id);
     const Attachment&    operator[](size_t id) const;
 
+    //! present mode, selected by implementation
+    PresentMode          presentMode() const;
+    //! timings of last presented frame
+    SwapchainStats       stats() const;
+
+    bool                 isHeadless() const;
+    //! headless only: content of last presented image, if `SwapchainDesc::readback` is set
+    const Pixmap&        presentedFrame() const;
+
   private:
+    struct Headless;
+
     Swapchain(AbstractGraphicsApi::Swapchain* sw);
+    Swapchain(uint32_t w, uint32_t h, const SwapchainDesc& desc);
 
     void implReset();
+    void implPresent(Device& dev);
 
     Detail::DPtr<AbstractGraphicsApi::Swapchain*> impl;
     std::unique_ptr<Attachment[]>                 img;
+    std::unique_ptr<Headless>                     headless;
 
   friend class Device;
   };
 
 }
-
@@ -7,6 +7,7 @@ namespace Tempest {
 
 class Device;
 class DescriptorSet;
+class DescriptorArray;
 template<class T>
 class Encoder;
 class StorageImage;
@@ -29,7 +30,7 @@ class Texture2d final {
     uint32_t      mipCount() const;
 
   private:
-    Texture2d(Tempest::Device& dev, AbstractGraphicsApi::PTexture&& impl, uint32_t w, uint32_t h, uint32_t d, TextureFormat frm);
+    Texture2d(const Tempest::Device& dev, AbstractGraphicsApi::PTexture&& impl, uint32_t w, uint32_t h, uint32_t d, TextureFormat frm);
 
     Detail::DSharedPtr<AbstractGraphicsApi::Texture*> impl;
     TextureFormat                                     frm  = Undefined;
@@ -39,7 +40,10 @@ class Texture2d final {
 
   friend class Tempest::Device;
   friend class Tempest::DescriptorSet;
+  friend class Tempest::DescriptorArray;
   friend class Encoder<Tempest::CommandBuffer>;
+  friend class Encoder<Tempest::CommandBundle>;
+  friend class Tempest::CommandBundle;
   friend class Tempest::StorageImage;
 
   template<class T>
@@ -46,7 +46,14 @@ void TextureAtlas::emplace(TextureAtlas::Allocation &dest, const void* img,
       break;
     case TextureFormat::DXT1:
     case TextureFormat::DXT3:
-    case TextureFormat::DXT5:{
+    case TextureFormat::DXT5:
+    case TextureFormat::DXT1_SRGB:
+    case TextureFormat::DXT3_SRGB:
+    case TextureFormat::DXT5_SRGB:
+    case TextureFormat::BC4:
+    case TextureFormat::BC5:
+    case TextureFormat::BC7:
+    case TextureFormat::BC7_SRGB:{
       Log::d("compressed sprites are not implemented");
       break;
       }
@@ -102,7 +109,8 @@ void TextureAtlas::emplace(TextureAtlas::Allocation &dest, const void* img,
         }
       break;
       }
-    case TextureFormat::RGBA8: {
+    case TextureFormat::RGBA8:
+    case TextureFormat::RGBA8_SRGB: {
       for(uint32_t iy=0;iy<sh;++iy)
         std::memcpy(data+((y+iy)*dw+dx),src+iy*sw,sw);
       break;
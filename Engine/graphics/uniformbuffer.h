@@ -16,6 +16,10 @@ class UniformBuffer final {
 
     void   update(const T* data) { return impl.update(data,0,sizeof(T)); }
 
+    //! direct access to memory of BufferHeap::Upload buffer
+    MappedRange<T> map() { return MappedRange<T>(reinterpret_cast<T*>(impl.map()), 1); }
+    void   flush()       { impl.flush(0,sizeof(T)); }
+
   private:
     UniformBuffer(Tempest::Detail::VideoBuffer&& impl)
       :impl(std::move(impl)) {
@@ -27,6 +31,7 @@ class UniformBuffer final {
   friend class Tempest::CommandBuffer;
   friend class Tempest::DescriptorSet;
   friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class Tempest::Encoder<Tempest::CommandBundle>;
   };
 
 }
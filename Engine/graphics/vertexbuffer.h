@@ -2,11 +2,14 @@
 
 #include <Tempest/AbstractGraphicsApi>
 #include <Tempest/StorageBuffer>
+#include <algorithm>
+#include <initializer_list>
 #include <vector>
 
 namespace Tempest {
 
 class Device;
+class GeometryPool;
 
 template<class T>
 class Encoder;
@@ -20,6 +23,8 @@ class VertexBuffer : public StorageBuffer {
 
     size_t size() const { return sz; }
 
+    MappedRange<T> map() { return StorageBuffer::map<T>().first(sz); }
+
   private:
     VertexBuffer(Tempest::Detail::VideoBuffer&& impl,size_t size)
       :StorageBuffer(std::move(impl)),sz(size) {
@@ -28,8 +33,43 @@ class VertexBuffer : public StorageBuffer {
     size_t sz = 0;
 
   friend class Tempest::Device;
+  friend class Tempest::GeometryPool;
   friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class Tempest::Encoder<Tempest::CommandBundle>;
   friend class Tempest::DescriptorSet;
   };
 
+/**
+ * Vertex buffer, as one of multiple streams of a draw-call.
+ *
+ * Vertex shader inputs are assigned to streams in order of locations: each stream takes
+ * consecutive inputs, while they fit into sizeof(T). Per-instance streams advance once per instance.
+ *
+ * Explicit format describes compressed inputs, such as Decl::half2 or Decl::unorm8x4: stream takes
+ * exactly format.size() inputs, that shader reads as float. See VertexQuantizer.
+ */
+class VertexStream final {
+  public:
+    template<class T>
+    VertexStream(const VertexBuffer<T>& vbo, InputRate rate = InputRate::PerVertex)
+      :vbo(&vbo.impl),stride(sizeof(T)),rate(rate) {
+      }
+
+    template<class T>
+    VertexStream(const VertexBuffer<T>& vbo, std::initializer_list<Decl::ComponentType> format, InputRate rate = InputRate::PerVertex)
+      :vbo(&vbo.impl),stride(sizeof(T)),rate(rate),formatSize(format.size()) {
+      std::copy_n(format.begin(), std::min<size_t>(format.size(), MaxVertexAttribs), this->format);
+      }
+
+  private:
+    const Detail::VideoBuffer* vbo    = nullptr;
+    size_t                     stride = 0;
+    InputRate                  rate   = InputRate::PerVertex;
+    size_t                     formatSize = 0;
+    Decl::ComponentType        format[MaxVertexAttribs] = {};
+
+  friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class Tempest::Encoder<Tempest::CommandBundle>;
+  };
+
 }
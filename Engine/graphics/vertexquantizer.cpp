@@ -0,0 +1,199 @@
+#include "vertexquantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Tempest;
+
+uint16_t VertexQuantizer::toHalf(float v) {
+  uint32_t x = 0;
+  std::memcpy(&x, &v, sizeof(x));
+
+  const uint32_t sign = (x >> 16) & 0x8000;
+  const uint32_t exp  = (x >> 23) & 0xFF;
+  uint32_t       mant = x & 0x7FFFFF;
+
+  if(exp==0xFF)
+    return uint16_t(sign | 0x7C00 | (mant!=0 ? 0x200 : 0)); // inf, nan
+
+  const int32_t e = int32_t(exp) - 127 + 15;
+  if(e>=31)
+    return uint16_t(sign | 0x7C00);
+  if(e<=0) {
+    // denormal
+    if(e<-10)
+      return uint16_t(sign);
+    mant |= 0x800000;
+    const uint32_t shift = uint32_t(14-e);
+    const uint32_t rem   = mant & ((1u << shift)-1);
+    const uint32_t mid   = 1u << (shift-1);
+    uint32_t       h     = mant >> shift;
+    if(rem>mid || (rem==mid && (h&1)!=0))
+      ++h;
+    return uint16_t(sign | h);
+    }
+
+  uint32_t       h   = (uint32_t(e) << 10) | (mant >> 13);
+  const uint32_t rem = mant & 0x1FFF;
+  // carry into exponent is correct, up to infinity
+  if(rem>0x1000 || (rem==0x1000 && (h&1)!=0))
+    ++h;
+  return uint16_t(sign | h);
+  }
+
+float VertexQuantizer::fromHalf(uint16_t v) {
+  const uint32_t sign = uint32_t(v & 0x8000) << 16;
+  const uint32_t exp  = (v >> 10) & 0x1F;
+  const uint32_t mant = v & 0x3FF;
+
+  if(exp==0) {
+    const float f = float(mant)/16777216.f;
+    return sign!=0 ? -f : f;
+    }
+
+  uint32_t x = 0;
+  if(exp==31)
+    x = sign | 0x7F800000 | (mant << 13); else
+    x = sign | ((exp-15+127) << 23) | (mant << 13);
+  float ret = 0;
+  std::memcpy(&ret, &x, sizeof(ret));
+  return ret;
+  }
+
+uint8_t VertexQuantizer::toUnorm8(float v) {
+  return uint8_t(std::lround(std::clamp(v, 0.f, 1.f)*255.f));
+  }
+
+int8_t VertexQuantizer::toSnorm8(float v) {
+  return int8_t(std::lround(std::clamp(v, -1.f, 1.f)*127.f));
+  }
+
+uint16_t VertexQuantizer::toUnorm16(float v) {
+  return uint16_t(std::lround(std::clamp(v, 0.f, 1.f)*65535.f));
+  }
+
+int16_t VertexQuantizer::toSnorm16(float v) {
+  return int16_t(std::lround(std::clamp(v, -1.f, 1.f)*32767.f));
+  }
+
+uint32_t VertexQuantizer::toA2B10G10R10(float x, float y, float z, float w) {
+  const uint32_t r = uint32_t(std::lround(std::clamp(x, 0.f, 1.f)*1023.f));
+  const uint32_t g = uint32_t(std::lround(std::clamp(y, 0.f, 1.f)*1023.f));
+  const uint32_t b = uint32_t(std::lround(std::clamp(z, 0.f, 1.f)*1023.f));
+  const uint32_t a = uint32_t(std::lround(std::clamp(w, 0.f, 1.f)*3.f));
+  return r | (g << 10) | (b << 20) | (a << 30);
+  }
+
+size_t VertexQuantizer::componentCount(Decl::ComponentType frm) {
+  switch(frm) {
+    case Decl::float0:
+    case Decl::count:
+      return 0;
+    case Decl::float1:
+    case Decl::int1:
+    case Decl::uint1:
+    case Decl::half1:
+      return 1;
+    case Decl::float2:
+    case Decl::int2:
+    case Decl::uint2:
+    case Decl::half2:
+    case Decl::unorm8x2:
+    case Decl::snorm8x2:
+    case Decl::unorm16x2:
+    case Decl::snorm16x2:
+      return 2;
+    case Decl::float3:
+    case Decl::int3:
+    case Decl::uint3:
+    case Decl::a2b10g10r10:
+      return 3;
+    case Decl::float4:
+    case Decl::int4:
+    case Decl::uint4:
+    case Decl::half4:
+    case Decl::unorm8x4:
+    case Decl::snorm8x4:
+    case Decl::unorm16x4:
+    case Decl::snorm16x4:
+      return 4;
+    }
+  return 0;
+  }
+
+void VertexQuantizer::quantize(Decl::ComponentType frm, void* out, size_t outStride,
+                               const float* in, size_t inStride, size_t count) {
+  const size_t n = componentCount(frm);
+  for(size_t i=0; i<count; ++i) {
+    auto* src = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(in) + i*inStride);
+    auto* dst = reinterpret_cast<uint8_t*>(out) + i*outStride;
+
+    switch(frm) {
+      case Decl::float0:
+      case Decl::count:
+        break;
+      case Decl::float1:
+      case Decl::float2:
+      case Decl::float3:
+      case Decl::float4:
+        std::memcpy(dst, src, n*sizeof(float));
+        break;
+      case Decl::int1:
+      case Decl::int2:
+      case Decl::int3:
+      case Decl::int4:
+        for(size_t c=0; c<n; ++c) {
+          const int32_t v = int32_t(src[c]);
+          std::memcpy(dst + c*sizeof(v), &v, sizeof(v));
+          }
+        break;
+      case Decl::uint1:
+      case Decl::uint2:
+      case Decl::uint3:
+      case Decl::uint4:
+        for(size_t c=0; c<n; ++c) {
+          const uint32_t v = uint32_t(src[c]);
+          std::memcpy(dst + c*sizeof(v), &v, sizeof(v));
+          }
+        break;
+      case Decl::half1:
+      case Decl::half2:
+      case Decl::half4:
+        for(size_t c=0; c<n; ++c) {
+          const uint16_t v = toHalf(src[c]);
+          std::memcpy(dst + c*sizeof(v), &v, sizeof(v));
+          }
+        break;
+      case Decl::unorm8x2:
+      case Decl::unorm8x4:
+        for(size_t c=0; c<n; ++c)
+          dst[c] = toUnorm8(src[c]);
+        break;
+      case Decl::snorm8x2:
+      case Decl::snorm8x4:
+        for(size_t c=0; c<n; ++c)
+          dst[c] = uint8_t(toSnorm8(src[c]));
+        break;
+      case Decl::unorm16x2:
+      case Decl::unorm16x4:
+        for(size_t c=0; c<n; ++c) {
+          const uint16_t v = toUnorm16(src[c]);
+          std::memcpy(dst + c*sizeof(v), &v, sizeof(v));
+          }
+        break;
+      case Decl::snorm16x2:
+      case Decl::snorm16x4:
+        for(size_t c=0; c<n; ++c) {
+          const int16_t v = toSnorm16(src[c]);
+          std::memcpy(dst + c*sizeof(v), &v, sizeof(v));
+          }
+        break;
+      case Decl::a2b10g10r10: {
+        const uint32_t v = toA2B10G10R10(src[0], src[1], src[2]);
+        std::memcpy(dst, &v, sizeof(v));
+        break;
+        }
+      }
+    }
+  }
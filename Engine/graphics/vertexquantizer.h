@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Tempest {
+
+/**
+ * @brief Load-time conversion of float vertex attributes into compressed Decl formats
+ *
+ * Normalized values are clamped to [0..1] for unorm and [-1..1] for snorm and rounded to nearest.
+ * Half conversion rounds to nearest even; overflow is converted to infinity.
+ */
+class VertexQuantizer final {
+  public:
+    static uint16_t toHalf   (float v);
+    static float    fromHalf (uint16_t v);
+
+    static uint8_t  toUnorm8 (float v);
+    static int8_t   toSnorm8 (float v);
+    static uint16_t toUnorm16(float v);
+    static int16_t  toSnorm16(float v);
+
+    //! Decl::a2b10g10r10: x in low bits, w in top 2 bits; unsigned only, use toSnorm8/toSnorm16 for normals
+    static uint32_t toA2B10G10R10(float x, float y, float z, float w = 0);
+
+    //! converts one attribute of count vertices; input has as many floats, as output format has components
+    static void     quantize(Decl::ComponentType frm, void* out, size_t outStride,
+                             const float* in, size_t inStride, size_t count);
+
+    //! number of float components, consumed by quantize
+    static size_t   componentCount(Decl::ComponentType frm);
+  };
+
+}
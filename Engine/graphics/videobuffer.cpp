@@ -11,17 +11,24 @@ VideoBuffer::VideoBuffer(AbstractGraphicsApi::PBuffer&& impl, size_t size)
   :impl(std::move(impl)),sz(size) {
   }
 
+VideoBuffer::VideoBuffer(const AbstractGraphicsApi::PBuffer& impl, size_t offset, size_t size, std::shared_ptr<void>&& range)
+  :impl(impl),sz(size),off(offset),range(std::move(range)) {
+  }
+
 VideoBuffer::VideoBuffer(VideoBuffer &&other)
-  :impl(std::move(other.impl)),sz(other.sz) {
-  other.sz = 0;
+  :impl(std::move(other.impl)),sz(other.sz),off(other.off),range(std::move(other.range)) {
+  other.sz  = 0;
+  other.off = 0;
   }
 
 VideoBuffer::~VideoBuffer(){
   }
 
 VideoBuffer &VideoBuffer::operator=(VideoBuffer &&other) {
-  std::swap(impl,other.impl);
-  std::swap(sz,  other.sz);
+  std::swap(impl, other.impl);
+  std::swap(sz,   other.sz);
+  std::swap(off,  other.off);
+  std::swap(range,other.range);
   return *this;
   }
 
@@ -30,5 +37,34 @@ void VideoBuffer::update(const void* data, size_t offset, size_t size) {
     return;
   if(offset+size>sz)
     throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
-  impl.handler->update(data,offset,size);
+  impl.handler->update(data,off+offset,size);
+  }
+
+uint8_t* VideoBuffer::map() {
+  auto ret = impl ? impl.handler->map() : nullptr;
+  if(ret==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
+  return ret+off;
+  }
+
+void VideoBuffer::flush(size_t offset, size_t size) {
+  if(size==0)
+    return;
+  if(offset+size>sz)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
+  impl.handler->flush(off+offset,size);
+  }
+
+void VideoBuffer::invalidate(size_t offset, size_t size) {
+  if(size==0)
+    return;
+  if(offset+size>sz)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
+  impl.handler->invalidate(off+offset,size);
+  }
+
+uint64_t VideoBuffer::deviceAddress() const {
+  if(!impl)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidStorageBuffer);
+  return impl.handler->deviceAddress()+off;
   }
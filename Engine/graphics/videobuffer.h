@@ -3,14 +3,40 @@
 #include <Tempest/AbstractGraphicsApi>
 #include "../utility/dptr.h"
 
+#include <memory>
+
 namespace Tempest {
 
 class Device;
+class GeometryPool;
 class CommandBuffer;
 class DescriptorSet;
+class DescriptorArray;
 template<class T>
 class Encoder;
 
+//! view of host-visible buffer memory, returned by map(); valid as long as buffer is alive
+template<class T>
+class MappedRange final {
+  public:
+    MappedRange() = default;
+    MappedRange(T* data, size_t size):ptr(data),sz(size) {}
+
+    T*          data()  const { return ptr;     }
+    size_t      size()  const { return sz;      }
+    bool        empty() const { return sz==0;   }
+
+    T*          begin() const { return ptr;     }
+    T*          end()   const { return ptr+sz;  }
+    T&          operator[](size_t i) const { return ptr[i]; }
+
+    MappedRange first(size_t n) const { return MappedRange(ptr, n<sz ? n : sz); }
+
+  private:
+    T*     ptr = nullptr;
+    size_t sz  = 0;
+  };
+
 namespace Detail {
 
 class VideoBuffer {
@@ -21,18 +47,29 @@ class VideoBuffer {
     VideoBuffer& operator=(VideoBuffer&&);
 
     void   update(const void* data, size_t offset, size_t size);
+
+    uint8_t* map();
+    void     flush     (size_t offset, size_t size);
+    void     invalidate(size_t offset, size_t size);
+    uint64_t deviceAddress() const;
     size_t size() const { return sz; }
 
   private:
     VideoBuffer(AbstractGraphicsApi::PBuffer &&impl, size_t size);
+    VideoBuffer(const AbstractGraphicsApi::PBuffer& impl, size_t offset, size_t size, std::shared_ptr<void>&& range);
 
     Detail::DSharedPtr<AbstractGraphicsApi::Buffer*> impl;
     size_t                                           sz=0;
+    size_t                                           off=0;  // byte offset in shared buffer, see GeometryPool
+    std::shared_ptr<void>                            range;  // releases sub-allocation
 
   friend class Tempest::Device;
+  friend class Tempest::GeometryPool;
   friend class Tempest::CommandBuffer;
   friend class Tempest::DescriptorSet;
+  friend class Tempest::DescriptorArray;
   friend class Tempest::Encoder<Tempest::CommandBuffer>;
+  friend class Tempest::Encoder<Tempest::CommandBundle>;
   };
 
 }
@@ -31,6 +31,8 @@ class ZBuffer final {
   friend class Tempest::Device;
   friend class Tempest::DescriptorSet;
   friend class Encoder<Tempest::CommandBuffer>;
+  friend class Encoder<Tempest::CommandBundle>;
+  friend class Tempest::CommandBundle;
 
   template<class T>
   friend T textureCast(ZBuffer& s);
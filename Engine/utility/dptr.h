@@ -7,6 +7,7 @@ namespace Tempest {
 
 class DescriptorSet;
 class CommandBuffer;
+class CommandBundle;
 template<class T>
 class Encoder;
 
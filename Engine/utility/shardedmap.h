@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// FNV-1a, for cache keys made of plain data
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t h = 0xcbf29ce484222325ull) {
+  auto* p = reinterpret_cast<const uint8_t*>(data);
+  for(size_t i=0; i<size; ++i) {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+    }
+  return h;
+  }
+
+/**
+ * Hash map, split into independently locked shards, for read-mostly caches.
+ *
+ * Lookup takes shared lock of a single shard, so concurrent readers never block each other;
+ * insertion takes exclusive lock of one shard only. Values are returned by copy: use handles
+ * or shared pointers.
+ */
+template<class K, class V, class Hash, class Eq = std::equal_to<K>, size_t ShardBits = 4>
+class ShardedMap final {
+  public:
+    static constexpr size_t NumShards = size_t(1) << ShardBits;
+
+    template<class Fn>
+    V findOrInsert(const K& k, Fn&& mk) {
+      const size_t h  = Hash()(k);
+      auto&        sh = shard[shardId(h)];
+      {
+        std::shared_lock<std::shared_mutex> guard(sh.sync);
+        auto it = sh.map.find(k);
+        if(it!=sh.map.end())
+          return it->second;
+      }
+
+      std::lock_guard<std::shared_mutex> guard(sh.sync);
+      auto it = sh.map.find(k);
+      if(it!=sh.map.end()) {
+        // other thread did create same entry
+        return it->second;
+        }
+      V val = mk();
+      sh.map.emplace(k, val);
+      count.fetch_add(1, std::memory_order_relaxed);
+      return val;
+      }
+
+    template<class Fn>
+    void forEach(Fn&& fn) {
+      for(auto& sh:shard) {
+        std::shared_lock<std::shared_mutex> guard(sh.sync);
+        for(auto& i:sh.map)
+          fn(i.first, i.second);
+        }
+      }
+
+    //! erases entries, where pred returns true; pred is called under exclusive lock of shard
+    template<class Fn>
+    void eraseIf(Fn&& pred) {
+      for(auto& sh:shard) {
+        std::lock_guard<std::shared_mutex> guard(sh.sync);
+        for(auto it = sh.map.begin(); it!=sh.map.end();) {
+          if(pred(it->first, it->second)) {
+            it = sh.map.erase(it);
+            count.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+            ++it;
+            }
+          }
+        }
+      }
+
+    /**
+     * Erases oldest entries, until no more than `target` remain. Only entries with canEvict(v)==true
+     * are candidates; age(v) gives last use tick. onErase(v) is called under exclusive lock of shard.
+     * Returns number of erased entries.
+     */
+    template<class Age, class Pred, class Fn>
+    size_t evictOldest(size_t target, Age&& age, Pred&& canEvict, Fn&& onErase) {
+      const size_t sz = size();
+      if(sz<=target)
+        return 0;
+
+      std::vector<uint64_t> ticks;
+      ticks.reserve(sz);
+      forEach([&](const K&, const V& v) {
+        if(canEvict(v))
+          ticks.push_back(age(v));
+        });
+      if(ticks.empty())
+        return 0;
+
+      const size_t cnt = std::min(ticks.size(), sz-target);
+      std::nth_element(ticks.begin(), ticks.begin()+(cnt-1), ticks.end());
+      const uint64_t threshold = ticks[cnt-1];
+
+      size_t erased = 0;
+      eraseIf([&](const K&, const V& v) {
+        if(erased>=cnt || !canEvict(v) || age(v)>threshold)
+          return false;
+        onErase(v);
+        ++erased;
+        return true;
+        });
+      return erased;
+      }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+  private:
+    struct alignas(64) Shard {
+      std::shared_mutex               sync;
+      std::unordered_map<K,V,Hash,Eq> map;
+      };
+
+    static size_t shardId(size_t h) {
+      // top bits of multiplicative hash: independent from bucket index, used by unordered_map
+      return size_t((uint64_t(h)*0x9e3779b97f4a7c15ull) >> (64-ShardBits));
+      }
+
+    Shard               shard[NumShards];
+    std::atomic<size_t> count{0};
+  };
+
+}
+}
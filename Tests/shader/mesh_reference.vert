@@ -0,0 +1,17 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+out gl_PerVertex {
+  vec4 gl_Position;
+  };
+
+layout(location = 0) in  vec2 inPos;
+layout(location = 0) out vec4 outColor;
+
+// same output as simple_test.spv14.mesh, for classic pipeline
+const vec3 colors[3] = {vec3(1,0,0), vec3(0,1,0), vec3(0,0,1)};
+
+void main() {
+  outColor    = vec4(colors[gl_VertexIndex%3], 1.0);
+  gl_Position = vec4(inPos, 0.0, 1.0);
+  }
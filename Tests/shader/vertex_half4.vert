@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+
+out gl_PerVertex {
+  vec4 gl_Position;
+  };
+
+layout(location = 0) in  f16vec4 inPos;
+layout(location = 1) in  vec4    inColor;
+layout(location = 0) out vec4    outColor;
+
+void main() {
+  outColor    = inColor;
+  gl_Position = vec4(inPos);
+  }
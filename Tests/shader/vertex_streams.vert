@@ -0,0 +1,15 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+out gl_PerVertex {
+  vec4 gl_Position;
+  };
+
+layout(location = 0) in  vec2 inPos;   // per-vertex stream
+layout(location = 1) in  vec4 inColor; // per-instance stream
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  outColor    = inColor;
+  gl_Position = vec4(inPos.xy, 1.0, 1.0);
+  }
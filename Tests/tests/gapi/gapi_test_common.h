@@ -1,15 +1,23 @@
 #pragma once
 
 #include <Tempest/Device>
+#include <Tempest/CommandBundle>
+#include <Tempest/GeometryPool>
+#include <Tempest/VertexQuantizer>
 #include <Tempest/Except>
 #include <Tempest/Pixmap>
 #include <Tempest/Log>
 #include <Tempest/Matrix4x4>
 #include <Tempest/Vec>
 #include <Tempest/Fence>
+#include <Tempest/SystemApi>
+#include <Tempest/File>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
+#include <array>
+#include <chrono>
+#include <thread>
 
 #include "utils/imagevalidator.h"
 
@@ -129,6 +137,45 @@ void VboDyn() {
     }
   }
 
+template<class GraphicsApi>
+void MappedBuffer() {
+  using namespace Tempest;
+
+  Vertex readback[3] = {};
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    Vertex vboData2[3] = {vboData[0],{3,4},{5,6}};
+
+    auto ssbo = device.ssbo(BufferHeap::Upload,vboData,sizeof(vboData));
+    auto ptr  = ssbo.map<Vertex>();
+    EXPECT_EQ(ptr.size(),3);
+    ptr[1] = vboData2[1];
+    ptr[2] = vboData2[2];
+    ssbo.flush(1*sizeof(Vertex), 2*sizeof(Vertex));
+
+    device.readBytes(ssbo,readback,ssbo.byteSize());
+    for(int i=0; i<3; ++i) {
+      EXPECT_EQ(readback[i].x,vboData2[i].x);
+      EXPECT_EQ(readback[i].y,vboData2[i].y);
+      }
+
+    auto vbo = device.vbo(BufferHeap::Upload,vboData,3);
+    auto vp  = vbo.map();
+    EXPECT_EQ(vp.size(),3);
+    EXPECT_EQ(vp[2].x,vboData[2].x);
+
+    auto dev = device.ssbo(vboData,sizeof(vboData));
+    EXPECT_THROW(dev.map(), std::system_error);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
 template<class GraphicsApi, class T>
 void SsboDyn() {
   using namespace Tempest;
@@ -312,16 +359,55 @@ void Shader() {
   }
 
 template<class GraphicsApi>
-void Pso() {
+void ShaderLoadRate(bool warm) {
   using namespace Tempest;
 
   try {
-    GraphicsApi api{ApiFlags::Validation};
+    GraphicsApi api{ApiFlags::NoFlags};
     Device      device(api);
 
-    auto vert = device.shader("shader/simple_test.vert.sprv");
-    auto frag = device.shader("shader/simple_test.frag.sprv");
-    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+    const char* files[] = {
+      "shader/simple_test.vert.sprv",
+      "shader/simple_test.frag.sprv",
+      "shader/simple_test.comp.sprv",
+      "shader/ubo_input.vert.sprv",
+      "shader/texture.frag.sprv",
+      "shader/push_test.vert.sprv",
+      "shader/push_constant.comp.sprv",
+      "shader/array_ssbo.comp.sprv",
+      "shader/bindless.comp.sprv",
+      "shader/image_store_test.comp.sprv",
+      };
+    std::vector<std::vector<uint32_t>> code;
+    for(auto f:files) {
+      RFile file(f);
+      std::vector<uint32_t> data(file.size()/4);
+      file.read(data.data(), data.size()*4);
+      code.emplace_back(std::move(data));
+      }
+
+    std::vector<Tempest::Shader> keep;
+    if(warm) {
+      for(auto& c:code)
+        keep.emplace_back(device.shader(c.data(), c.size()*4));
+      }
+
+    const size_t iterations = warm ? 200 : 20;
+    const auto   start      = std::chrono::steady_clock::now();
+    for(size_t i=0; i<iterations; ++i)
+      for(size_t r=0; r<code.size(); ++r) {
+        auto& c = code[r];
+        if(!warm) {
+          // unique generator word: new content hash, so every load misses the cache
+          c[2] = uint32_t(i+1);
+          }
+        auto sh = device.shader(c.data(), c.size()*4);
+        if(warm)
+          EXPECT_TRUE(sh==keep[r]);
+        }
+    const auto   dt    = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const size_t count = iterations*code.size();
+    Log::i("Shader load rate (", warm ? "warm" : "cold", "): ", int64_t(double(count)/std::max(dt,1e-6)), " shaders/s (", count, " shaders)");
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -331,25 +417,69 @@ void Pso() {
   }
 
 template<class GraphicsApi>
-void PsoInconsistentVaryings() {
+void ShaderOptimize() {
   using namespace Tempest;
 
   try {
     GraphicsApi api{ApiFlags::Validation};
-    Device      device(api);
 
-    auto vert = device.shader("shader/simple_test.vert.sprv");
-    auto frag = device.shader("shader/varying_test.frag.sprv");
-    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+    for(bool optimize:{false, true}) {
+      Device device(api);
+      device.setShaderOptimization(optimize);
+
+      const auto start = std::chrono::steady_clock::now();
+      auto vert = device.shader("shader/simple_test.vert.sprv");
+      auto frag = device.shader("shader/simple_test.frag.sprv");
+      auto comp = device.shader("shader/simple_test.comp.sprv");
+      const auto mid = std::chrono::steady_clock::now();
+
+      auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+      auto cs   = device.pipeline(comp);
+      const auto end = std::chrono::steady_clock::now();
+
+      Log::i("Shader optimization ", optimize ? "on" : "off",
+             ": modules ",   std::chrono::duration_cast<std::chrono::microseconds>(mid-start).count(), "us,",
+             " pipelines ", std::chrono::duration_cast<std::chrono::microseconds>(end-mid).count(), "us");
+
+      // optimized modules must behave same as original ones
+      Vec4 inputCpu[3] = {Vec4(0,1,2,3),Vec4(4,5,6,7),Vec4(8,9,10,11)};
+      auto input  = device.ssbo(inputCpu,      sizeof(inputCpu));
+      auto output = device.ssbo(Uninitialized, sizeof(inputCpu));
+
+      // workgroup size is specialization constant: gl_WorkGroupSize is not referenced by code
+      auto specCs = device.shader("shader/spec_const.comp.sprv");
+      Tempest::SpecializationConstants spec;
+      spec.set(0, 16u);
+      spec.set(1, 7u);
+      spec.set(2, false);
+      auto specPso = device.pipeline(specCs, spec);
+      auto specOut = device.ssbo(Uninitialized, 64*sizeof(uint32_t));
+
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setBinding(0, input);
+        enc.setBinding(1, output);
+        enc.setPipeline(cs);
+        enc.dispatch(3,1,1);
+
+        enc.setBinding(0, specOut);
+        enc.setPipeline(specPso);
+        enc.dispatch(4,1,1);
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
 
-    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
-    auto cmd = device.commandBuffer();
-    {
-      auto enc = cmd.startEncoding(device);
-      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
-      enc.setPipeline(pso); // late linkpakage
-    }
+      Vec4 outputCpu[3] = {};
+      device.readBytes(output,outputCpu,sizeof(outputCpu));
+      for(size_t i=0; i<3; ++i)
+        EXPECT_EQ(outputCpu[i],inputCpu[i]);
 
+      uint32_t specCpu[64] = {};
+      device.readBytes(specOut,specCpu,sizeof(specCpu));
+      for(size_t i=0; i<64; ++i)
+        EXPECT_EQ(specCpu[i],7u) << "optimize = " << optimize << ", i = " << i;
+      }
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -359,19 +489,44 @@ void PsoInconsistentVaryings() {
   }
 
 template<class GraphicsApi>
-void PsoTess() {
+void ShaderCache() {
   using namespace Tempest;
 
   try {
     GraphicsApi api{ApiFlags::Validation};
-    Device      device(api);
+    {
+      Device device(api);
+      device.setShaderCache("ShaderCache.bin");
 
-    auto tese = device.shader("shader/tess.tese.sprv");
-    auto tesc = device.shader("shader/tess.tesc.sprv");
+      auto vert  = device.shader("shader/simple_test.vert.sprv");
+      auto frag  = device.shader("shader/simple_test.frag.sprv");
+      auto frag2 = device.shader("shader/simple_test.frag.sprv");
+      EXPECT_TRUE(frag==frag2);
+      EXPECT_TRUE(vert!=frag);
 
-    auto vert = device.shader("shader/tess.vert.sprv");
-    auto frag = device.shader("shader/tess.frag.sprv");
-    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,tesc,tese,frag);
+      // optimized module is different object, even if bytecode is same
+      device.setShaderOptimization(true);
+      auto frag3 = device.shader("shader/simple_test.frag.sprv");
+      auto frag4 = device.shader("shader/simple_test.frag.sprv");
+      EXPECT_TRUE(frag3!=frag);
+      EXPECT_TRUE(frag3==frag4);
+      device.setShaderOptimization(false);
+      EXPECT_TRUE(device.shader("shader/simple_test.frag.sprv")==frag);
+
+      auto pso   = device.pipeline(Topology::Triangles,RenderState(),vert,frag2);
+      auto pso2  = device.pipeline(Topology::Triangles,RenderState(),vert,frag3);
+    }
+
+    RFile file("ShaderCache.bin");
+    EXPECT_GT(file.size(), 0u);
+
+    // second launch: reflection comes from cache file
+    Device device(api);
+    device.setShaderCache("ShaderCache.bin");
+
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -381,36 +536,16 @@ void PsoTess() {
   }
 
 template<class GraphicsApi>
-void TesselationBasic(const char* outImg) {
+void Pso() {
   using namespace Tempest;
 
   try {
     GraphicsApi api{ApiFlags::Validation};
     Device      device(api);
 
-    auto vbo  = device.vbo<Vertex>({{-1, 1},{0,-1},{1,1}});
-
-    auto tese = device.shader("shader/tess_basic.tese.sprv");
-    auto tesc = device.shader("shader/tess_basic.tesc.sprv");
-
-    auto vert = device.shader("shader/tess_basic.vert.sprv");
-    auto frag = device.shader("shader/tess_basic.frag.sprv");
-    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,tesc,tese,frag);
-
-    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
-    auto cmd = device.commandBuffer();
-    {
-      auto enc = cmd.startEncoding(device);
-      enc.setFramebuffer({{tex,Vec4(0,0,0,1),Tempest::Preserve}});
-      enc.setPipeline(pso);
-      enc.draw(vbo);
-    }
-
-    auto sync = device.submit(cmd);
-    sync.wait();
-
-    auto pm = device.readPixels(tex);
-    pm.save(outImg);
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -420,40 +555,25 @@ void TesselationBasic(const char* outImg) {
   }
 
 template<class GraphicsApi>
-void GeomBasic(const char* outImg) {
+void PsoInconsistentVaryings() {
   using namespace Tempest;
 
   try {
-    const char* devName = nullptr;
     GraphicsApi api{ApiFlags::Validation};
-    auto dev = api.devices();
-    for(auto& i:dev)
-      if(i.geometryShader)
-        devName = i.name;
-    if(devName==nullptr)
-      return;
-
     Device      device(api);
 
-    auto vert = device.shader("shader/geom_basic.vert.sprv");
-    auto geom = device.shader("shader/geom_basic.geom.sprv");
-    auto frag = device.shader("shader/geom_basic.frag.sprv");
-    auto pso  = device.pipeline(Topology::Points,RenderState(),vert,geom,frag);
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/varying_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
     auto tex = device.attachment(TextureFormat::RGBA8,128,128);
     auto cmd = device.commandBuffer();
     {
       auto enc = cmd.startEncoding(device);
       enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
-      enc.setPipeline(pso);
-      enc.draw(nullptr, 0, 1);
+      enc.setPipeline(pso); // late linkpakage
     }
 
-    auto sync = device.submit(cmd);
-    sync.wait();
-
-    auto pm = device.readPixels(tex);
-    pm.save(outImg);
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -463,26 +583,69 @@ void GeomBasic(const char* outImg) {
   }
 
 template<class GraphicsApi>
-void Fbo(const char* outImg) {
+void PsoVariants() {
   using namespace Tempest;
 
   try {
     GraphicsApi api{ApiFlags::Validation};
     Device      device(api);
 
-    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
 
-    auto cmd = device.commandBuffer();
-    {
-      auto enc = cmd.startEncoding(device);
-      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
-    }
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
-    auto sync = device.submit(cmd);
-    sync.wait();
+    // same pipeline, linked against different attachment formats
+    const TextureFormat frm[] = {TextureFormat::RGBA8, TextureFormat::RGBA16, TextureFormat::RGBA8};
+    std::vector<Attachment> tex;
+    for(auto f:frm)
+      tex.push_back(device.attachment(f,128,128));
 
-    auto pm = device.readPixels(tex);
-    pm.save(outImg);
+    auto render = [&]() {
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        for(auto& t:tex) {
+          enc.setFramebuffer({{t,Vec4(0,0,1,1),Tempest::Preserve}});
+          enc.setPipeline(pso);
+          enc.draw(vbo,ibo);
+          }
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+
+      for(auto& t:tex) {
+        auto pm = device.readPixels(t);
+        ImageValidator val(pm);
+        auto lo = val.at(32,96);
+        auto hi = val.at(96,32);
+        EXPECT_NEAR(lo.x[2], 1.f, 0.01f);
+        EXPECT_NEAR(hi.x[0], (96.f+0.5f)/128.f, 0.01f);
+        EXPECT_NEAR(hi.x[1], (32.f+0.5f)/128.f, 0.01f);
+        }
+      };
+
+    render();
+    // RGBA8 variant is reused for third attachment
+    auto st = pso.stats();
+    EXPECT_EQ(st.variants, 2u);
+    if(!device.properties().pipelineLibrary) {
+      EXPECT_EQ(st.linked, 0u);
+      return;
+      }
+    EXPECT_EQ(st.linked, 2u);
+
+    // optimized pipelines are linked in background and replace fast-linked ones
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while(pso.stats().optimized<st.linked && std::chrono::steady_clock::now()<deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    st = pso.stats();
+    EXPECT_EQ(st.optimized, 2u);
+    EXPECT_EQ(st.variants,  2u);
+
+    render();
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -491,16 +654,17 @@ void Fbo(const char* outImg) {
     }
   }
 
-template<class GraphicsApi, Tempest::TextureFormat format>
-void Draw(const char* outImage) {
+template<class GraphicsApi>
+void DynamicState() {
   using namespace Tempest;
 
   try {
     GraphicsApi api{ApiFlags::Validation};
     Device      device(api);
 
-    if(!device.properties().hasAttachFormat(format)) {
-      Log::d("Skipping draw testcase: no format support");
+    auto& prop = device.properties();
+    if(!prop.dynamicState.cullMode || !prop.dynamicState.blend) {
+      Log::d("Skipping dynamic-state testcase: no extended dynamic state support");
       return;
       }
 
@@ -511,48 +675,28 @@ void Draw(const char* outImage) {
     auto frag = device.shader("shader/simple_test.frag.sprv");
     auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
-    auto tex  = device.attachment(format,128,128);
-
+    auto tex  = device.attachment(TextureFormat::RGBA8,128,128);
     auto cmd  = device.commandBuffer();
     {
       auto enc = cmd.startEncoding(device);
-      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setFramebuffer({{tex,Vec4(0,0,0,0),Tempest::Preserve}});
       enc.setPipeline(pso);
       enc.draw(vbo,ibo);
+      // additive blend, without new pipeline
+      enc.setBlend(RenderState::BlendMode::One,RenderState::BlendMode::One);
+      enc.draw(vbo,ibo);
+      // front-faces are culled: no-op
+      enc.setCullMode(RenderState::CullMode::Front);
+      enc.draw(vbo,ibo);
     }
-
     auto sync = device.submit(cmd);
     sync.wait();
 
-    auto pm = device.readPixels(tex);
-    pm.save(outImage);
-
-    const uint32_t ccnt = Pixmap::componentCount(pm.format());
-    uint32_t same = 0;
+    auto pm  = device.readPixels(tex);
     ImageValidator val(pm);
-    for(uint32_t y=0; y<pm.h(); ++y)
-      for(uint32_t x=0; x<pm.w(); ++x) {
-        auto pix = val.at(x,y);
-        auto ref = ImageValidator::Pixel();
-        if(x<y) {
-          ref.x[0] = 0;
-          ref.x[1] = 0;
-          ref.x[2] = 1;
-          ref.x[3] = 1;
-          } else {
-          const float u = (float(x)+0.5f)/float(pm.w());
-          const float v = (float(y)+0.5f)/float(pm.h());
-          ref.x[0] = u;
-          ref.x[1] = v;
-          ref.x[2] = 0;
-          ref.x[3] = 1;
-          }
-
-        for(uint32_t c=0; c<ccnt; ++c)
-          if(std::fabs(pix.x[c]-ref.x[c])<0.01f)
-            same++;
-        }
-    EXPECT_EQ(same,pm.w()*pm.h()*ccnt);
+    auto pix = val.at(96,32);
+    EXPECT_NEAR(pix.x[0], 1.f, 0.01f);
+    EXPECT_NEAR(pix.x[1], 2.f*(32.f+0.5f)/128.f, 0.01f);
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -562,11 +706,11 @@ void Draw(const char* outImage) {
   }
 
 template<class GraphicsApi>
-void InstanceIndex(const char* outImage) {
+void RecordingScaling() {
   using namespace Tempest;
 
   try {
-    GraphicsApi api{ApiFlags::Validation};
+    GraphicsApi api{ApiFlags::NoFlags};
     Device      device(api);
 
     auto vbo  = device.vbo(vboData,3);
@@ -576,48 +720,59 @@ void InstanceIndex(const char* outImage) {
     auto frag = device.shader("shader/simple_test.frag.sprv");
     auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
-    auto tex  = device.attachment(Tempest::RGBA8,128,128);
-
-    auto cmd  = device.commandBuffer();
-    {
-      auto enc = cmd.startEncoding(device);
-      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
-      enc.setPipeline(pso);
-      enc.draw(vbo,ibo, 0,ibo.size(), 123,1);
-    }
-
-    auto sync = device.submit(cmd);
-    sync.wait();
-
-    auto pm = device.readPixels(tex);
-    pm.save(outImage);
-
-    const uint32_t ccnt = Pixmap::componentCount(pm.format());
-    uint32_t same = 0;
-    ImageValidator val(pm);
-    for(uint32_t y=0; y<pm.h(); ++y)
-      for(uint32_t x=0; x<pm.w(); ++x) {
-        auto pix = val.at(x,y);
-        auto ref = ImageValidator::Pixel();
-        if(x<y) {
-          ref.x[0] = 0;
-          ref.x[1] = 0;
-          ref.x[2] = 1;
-          ref.x[3] = 1;
-          } else {
-          const float u = (float(x)+0.5f)/float(pm.w());
-          const float v = (float(y)+0.5f)/float(pm.h());
-          ref.x[0] = u;
-          ref.x[1] = v;
-          ref.x[2] = 123.f/255.f;
-          ref.x[3] = 1;
-          }
+    const size_t maxThreads = 8;
+    const size_t passes     = 64;
+    const size_t draws      = 64;
+
+    std::vector<Attachment> tex;
+    for(size_t i=0; i<maxThreads*2; ++i)
+      tex.push_back(device.attachment(TextureFormat::RGBA8,32,32));
+
+    double base = 0;
+    for(size_t threads=1; threads<=maxThreads; threads*=2) {
+      std::vector<CommandBuffer> cmd(threads);
+      for(auto& c:cmd)
+        c = device.commandBuffer();
+
+      const auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> th;
+      for(size_t id=0; id<threads; ++id) {
+        th.emplace_back([&, id]() {
+          auto enc = cmd[id].startEncoding(device);
+          for(size_t p=0; p<passes; ++p) {
+            enc.setFramebuffer({{tex[id*2 + p%2],Vec4(0,0,1,1),Tempest::Preserve}});
+            enc.setPipeline(pso);
+            for(size_t i=0; i<draws; ++i)
+              enc.draw(vbo,ibo);
+            }
+          });
+        }
+      for(auto& t:th)
+        t.join();
+      const auto dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      const size_t count = threads*passes*draws;
+      const double rate  = double(count)/std::max(dt,1e-6);
+      if(threads==1)
+        base = rate;
+      Log::i("Recording rate, ", threads, " threads: ", int64_t(rate), " draws/s (x", rate/std::max(base,1.0), ")");
+
+      for(auto& c:cmd) {
+        auto sync = device.submit(c);
+        sync.wait();
+        }
 
-        for(uint32_t c=0; c<ccnt; ++c)
-          if(std::fabs(pix.x[c]-ref.x[c])<0.01f)
-            same++;
+      // every recorded pass must reach the attachment
+      for(size_t i=0; i<threads*2; ++i) {
+        auto pm = device.readPixels(tex[i]);
+        ImageValidator val(pm);
+        auto clr = val.at(0,pm.h()-1);
+        auto tri = val.at(pm.w()-1,0);
+        EXPECT_NEAR(clr.x[2], 1.f, 0.01f);
+        EXPECT_NEAR(tri.x[0], (float(pm.w())-0.5f)/float(pm.w()), 0.01f);
+        EXPECT_NEAR(tri.x[2], 0.f, 0.01f);
         }
-    EXPECT_EQ(same,pm.w()*pm.h()*ccnt);
+      }
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -627,13 +782,19 @@ void InstanceIndex(const char* outImage) {
   }
 
 template<class GraphicsApi>
-void Viewport(const char* outImage) {
+void FboCacheEviction() {
   using namespace Tempest;
 
   try {
     GraphicsApi api{ApiFlags::Validation};
     Device      device(api);
 
+    const uint32_t limit = device.stats().framebufferLimit;
+    if(limit==0) {
+      Log::d("Skipping framebuffer cache testcase: no cache with dynamic rendering");
+      return;
+      }
+
     auto vbo  = device.vbo(vboData,3);
     auto ibo  = device.ibo(iboData,3);
 
@@ -641,18 +802,957 @@ void Viewport(const char* outImage) {
     auto frag = device.shader("shader/simple_test.frag.sprv");
     auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
-    auto tex  = device.attachment(TextureFormat::RGBA8,150,150);
-
-    auto cmd  = device.commandBuffer();
-    {
-      auto enc = cmd.startEncoding(device);
-      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
-      enc.setPipeline(pso);
-
-      enc.setViewport(-50,25,100,100);
-      enc.draw(vbo,ibo);
+    // more distinct framebuffers, than cache can hold
+    const size_t count = 2*limit;
+    std::vector<Attachment> tex;
+    for(size_t i=0; i<count; ++i)
+      tex.push_back(device.attachment(TextureFormat::RGBA8,16,16));
 
-      enc.setViewport(150,25,100,100);
+    auto render = [&](size_t begin, size_t end, float blue) {
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        for(size_t i=begin; i<end; ++i) {
+          enc.setFramebuffer({{tex[i],Vec4(0,0,blue,1),Tempest::Preserve}});
+          enc.setPipeline(pso);
+          enc.draw(vbo,ibo);
+          }
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+      };
+
+    auto check = [&](size_t i, float blue) {
+      auto pm = device.readPixels(tex[i]);
+      ImageValidator val(pm);
+      auto clr = val.at(0,pm.h()-1);
+      auto tri = val.at(pm.w()-1,0);
+      EXPECT_NEAR(clr.x[2], blue, 0.01f);
+      EXPECT_NEAR(tri.x[0], (float(pm.w())-0.5f)/float(pm.w()), 0.01f);
+      };
+
+    // one pass per command buffer: nothing keeps old framebuffers alive
+    for(size_t i=0; i<count; ++i) {
+      render(i, i+1, 1.f);
+      EXPECT_LE(device.stats().framebuffers, limit);
+      }
+    for(size_t i=0; i<count; i+=64)
+      check(i, 1.f);
+
+    // oldest entries are evicted by now: framebuffers have to be recreated
+    render(0, 8, 0.5f);
+    EXPECT_LE(device.stats().framebuffers, limit);
+    for(size_t i=0; i<8; ++i)
+      check(i, 0.5f);
+
+    // all in one command buffer: in-use framebuffers must survive eviction
+    render(0, count, 0.25f);
+    for(size_t i=0; i<count; i+=64)
+      check(i, 0.25f);
+
+    // once command buffer is gone, next miss shrinks cache back under the limit
+    tex.push_back(device.attachment(TextureFormat::RGBA8,16,16));
+    render(count, count+1, 1.f);
+    EXPECT_LE(device.stats().framebuffers, limit);
+    check(count, 1.f);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void CommandBufferReuse() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto tex0 = device.attachment(TextureFormat::RGBA8,128,128);
+    auto tex1 = device.attachment(TextureFormat::RGBA8,128,128);
+
+    // each pass is recorded into own chunk; chunks are recycled on every re-recording
+    CommandBuffer cmd;
+    uint32_t      warmUp = 0;
+    for(int frame=0; frame<4; ++frame) {
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer({{tex0,Vec4(0,0,0,1),Tempest::Preserve}});
+        enc.setPipeline(pso);
+        enc.draw(vbo,ibo);
+        enc.setFramebuffer({{tex1,Vec4(0,0,0,1),Tempest::Preserve}});
+        if(frame%2==0) {
+          enc.setPipeline(pso);
+          enc.draw(vbo,ibo);
+          }
+        enc.setFramebuffer({{tex0,Tempest::Preserve,Tempest::Preserve}});
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+
+      auto pm0 = device.readPixels(tex0);
+      auto pm1 = device.readPixels(tex1);
+      ImageValidator val0(pm0), val1(pm1);
+      EXPECT_NEAR(val0.at(32,96).x[2], 1.f, 0.01f);
+      EXPECT_NEAR(val1.at(32,96).x[2], frame%2==0 ? 1.f : 0.f, 0.01f);
+
+      // after first frame no new native command buffers are allocated
+      if(frame==0)
+        warmUp = cmd.stats().allocations;
+      EXPECT_EQ(cmd.stats().allocations-warmUp, 0u);
+      }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void CommandBundleKeepAlive() {
+  using namespace Tempest;
+
+  struct Ubo {
+    Vec4 color[3];
+    };
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+
+    Tempest::CommandBundle bundle;
+    {
+      const Ubo data = {{Vec4(1,0,0,1),Vec4(1,0,0,1),Vec4(1,0,0,1)}};
+
+      auto vbo  = device.vbo(vboData,3);
+      auto ibo  = device.ibo(iboData,3);
+      auto ubo  = device.ubo(data);
+      auto vert = device.shader("shader/ubo_input.vert.sprv");
+      auto frag = device.shader("shader/simple_test.frag.sprv");
+      auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+      auto enc = bundle.startEncoding(device, {{tex,Vec4(0,0,0,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      enc.setBinding(2,ubo);
+      enc.draw(vbo,ibo);
+    }
+    // every referenced resource is destroyed, before bundle is executed for the first time
+    EXPECT_TRUE(bundle.isValid());
+
+    CommandBuffer cmd;
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.execute(bundle);
+    }
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    ImageValidator val(pm);
+    for(uint32_t y=0; y<pm.h(); ++y)
+      for(uint32_t x=0; x<pm.w(); ++x) {
+        if(x==y)
+          continue;
+        auto pix = val.at(x,y);
+        auto ref = (x<y) ? Vec4(0,0,1,1) : Vec4(1,0,0,1);
+        ASSERT_NEAR(pix.x[0], ref.x, 0.01f);
+        ASSERT_NEAR(pix.x[1], ref.y, 0.01f);
+        ASSERT_NEAR(pix.x[2], ref.z, 0.01f);
+        }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void CommandBundle() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto tex  = device.attachment(TextureFormat::RGBA8,128,128);
+
+    Tempest::CommandBundle bundle;
+    {
+      auto enc = bundle.startEncoding(device, {{tex,Vec4(0,0,0,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      enc.draw(vbo,ibo);
+    }
+    EXPECT_TRUE(bundle.isValid());
+
+    auto render = [&](auto fn) {
+      CommandBuffer cmd;
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer({{tex,Vec4(0,0,0,1),Tempest::Preserve}});
+        fn(enc);
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+
+      auto pm = device.readPixels(tex);
+      ImageValidator val(pm);
+      auto hi = val.at(96,32);
+      EXPECT_NEAR(hi.x[0], (96.f+0.5f)/128.f, 0.01f);
+      EXPECT_NEAR(hi.x[1], (32.f+0.5f)/128.f, 0.01f);
+      auto lo = val.at(32,96);
+      EXPECT_EQ(lo.x[0], 0.f);
+      EXPECT_EQ(lo.x[1], 0.f);
+      };
+
+    // bundle only
+    for(int frame=0; frame<2; ++frame)
+      render([&](auto& enc){ enc.execute(bundle); });
+    // bundle, followed by regular draw
+    render([&](auto& enc){
+      enc.execute(bundle);
+      enc.setPipeline(pso);
+      enc.draw(vbo,ibo);
+      });
+    // regular draw, followed by bundle
+    render([&](auto& enc){
+      enc.setPipeline(pso);
+      enc.draw(vbo,ibo);
+      enc.execute(bundle);
+      });
+
+    // bundle keeps resources alive
+    vbo = VertexBuffer<Vertex>();
+    EXPECT_TRUE(bundle.isValid());
+    render([&](auto& enc){ enc.execute(bundle); });
+
+    // render-pass layout must match
+    {
+      auto tex2 = device.attachment(TextureFormat::RGBA8,64,64);
+      CommandBuffer cmd;
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex2,Vec4(0,0,0,1),Tempest::Preserve}});
+      EXPECT_THROW(enc.execute(bundle), std::system_error);
+    }
+
+    // draw without pipeline is rejected at record time
+    Tempest::CommandBundle broken;
+    {
+      auto enc = broken.startEncoding(device, {{tex,Vec4(0,0,0,1),Tempest::Preserve}});
+      EXPECT_THROW(enc.draw(nullptr,ibo), std::system_error);
+    }
+    EXPECT_FALSE(broken.isValid());
+    {
+      CommandBuffer cmd;
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,0,1),Tempest::Preserve}});
+      EXPECT_THROW(enc.execute(broken), std::system_error);
+    }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void PsoTess() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto tese = device.shader("shader/tess.tese.sprv");
+    auto tesc = device.shader("shader/tess.tesc.sprv");
+
+    auto vert = device.shader("shader/tess.vert.sprv");
+    auto frag = device.shader("shader/tess.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,tesc,tese,frag);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void TesselationBasic(const char* outImg) {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vbo  = device.vbo<Vertex>({{-1, 1},{0,-1},{1,1}});
+
+    auto tese = device.shader("shader/tess_basic.tese.sprv");
+    auto tesc = device.shader("shader/tess_basic.tesc.sprv");
+
+    auto vert = device.shader("shader/tess_basic.vert.sprv");
+    auto frag = device.shader("shader/tess_basic.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,tesc,tese,frag);
+
+    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,0,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      enc.draw(vbo);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImg);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void GeomBasic(const char* outImg) {
+  using namespace Tempest;
+
+  try {
+    const char* devName = nullptr;
+    GraphicsApi api{ApiFlags::Validation};
+    auto dev = api.devices();
+    for(auto& i:dev)
+      if(i.geometryShader)
+        devName = i.name;
+    if(devName==nullptr)
+      return;
+
+    Device      device(api);
+
+    auto vert = device.shader("shader/geom_basic.vert.sprv");
+    auto geom = device.shader("shader/geom_basic.geom.sprv");
+    auto frag = device.shader("shader/geom_basic.frag.sprv");
+    auto pso  = device.pipeline(Topology::Points,RenderState(),vert,geom,frag);
+
+    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      enc.draw(nullptr, 0, 1);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImg);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void Fbo(const char* outImg) {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImg);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void HeadlessSwapchain() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    SwapchainDesc desc;
+    desc.imageCount = 2;
+    desc.readback   = true;
+
+    auto sw = device.swapchain(32,32,desc);
+    EXPECT_TRUE(sw.isHeadless());
+    EXPECT_EQ(sw.imageCount(), 2u);
+    EXPECT_EQ(sw.w(), 32u);
+    EXPECT_EQ(sw.presentMode(), PresentMode::Immediate);
+
+    const Vec4 color[3] = {Vec4(1,0,0,1), Vec4(0,1,0,1), Vec4(0,0,1,1)};
+
+    auto cmd = device.commandBuffer();
+    for(uint32_t i=0; i<3; ++i) {
+      const uint32_t img = sw.currentImage();
+      EXPECT_EQ(img, i%2);
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer({{sw[img],color[i],Tempest::Preserve}});
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+      device.present(sw);
+
+      auto& pm = sw.presentedFrame();
+      auto  px = reinterpret_cast<const uint8_t*>(pm.data());
+      EXPECT_EQ(pm.w(), 32u);
+      EXPECT_EQ(px[0], uint8_t(color[i].x*255));
+      EXPECT_EQ(px[1], uint8_t(color[i].y*255));
+      EXPECT_EQ(px[2], uint8_t(color[i].z*255));
+      EXPECT_EQ(sw.stats().frameId, i+1);
+      }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void HeadlessSwapchainPacing() {
+  using namespace Tempest;
+  using clock = std::chrono::steady_clock;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    const uint64_t interval = 10000; // 100Hz, in microseconds
+    const uint32_t frames   = 6;
+
+    auto run = [&](PresentMode mode, uint64_t& wait) {
+      SwapchainDesc desc;
+      desc.presentMode     = mode;
+      desc.refreshInterval = interval;
+
+      auto sw = device.swapchain(32,32,desc);
+      EXPECT_EQ(sw.presentMode(), mode);
+
+      wait = 0;
+      const auto t0 = clock::now();
+      for(uint32_t i=0; i<frames; ++i) {
+        device.present(sw);
+        const auto st = sw.stats();
+        EXPECT_EQ(st.frameId, i+1);
+        // image is shown on next simulated vblank
+        EXPECT_GT(st.displayLatency, 0u);
+        EXPECT_LE(st.displayLatency, interval+st.presentTime+1);
+        if(mode==PresentMode::Mailbox)
+          EXPECT_EQ(st.acquireWait, 0u);
+        wait += st.acquireWait;
+        }
+      return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(clock::now()-t0).count());
+      };
+
+    // every fifo present waits for vblank
+    uint64_t wait = 0;
+    uint64_t time = run(PresentMode::Fifo, wait);
+    EXPECT_GE(time, (frames-1)*interval);
+    EXPECT_GE(wait, (frames-2)*interval);
+    EXPECT_LE(wait, time);
+
+    // mailbox replaces queued image, without blocking
+    time = run(PresentMode::Mailbox, wait);
+    EXPECT_EQ(wait, 0u);
+    EXPECT_LT(time, (frames-1)*interval);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void SwapchainPresentMode() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    const PresentMode modes[] = {PresentMode::Fifo, PresentMode::FifoRelaxed, PresentMode::Mailbox, PresentMode::Immediate};
+
+    for(auto m:modes) {
+      // headless swapchain without pacing has no vblank to wait for
+      SwapchainDesc desc;
+      desc.presentMode = m;
+
+      auto sw = device.swapchain(32,32,desc);
+      EXPECT_EQ(sw.presentMode(), PresentMode::Immediate);
+      for(uint32_t i=0; i<3; ++i) {
+        device.present(sw);
+        const auto st = sw.stats();
+        EXPECT_EQ(st.frameId,        i+1);
+        EXPECT_EQ(st.acquireWait,    0u);
+        EXPECT_EQ(st.displayLatency, 0u);
+        }
+      }
+
+    auto hwnd = SystemApi::createWindow(nullptr, 64, 64);
+    if(hwnd==nullptr) {
+      Log::d("Skipping swapchain testcase: no window system");
+      return;
+      }
+    struct Guard {
+      SystemApi::Window* hwnd = nullptr;
+      ~Guard() { SystemApi::destroyWindow(hwnd); }
+      } guard{hwnd};
+
+    for(auto m:modes) {
+      SwapchainDesc desc;
+      desc.presentMode = m;
+
+      auto sw = device.swapchain(hwnd,desc);
+      // unsupported mode falls back to Fifo; reported mode is the one in use
+      EXPECT_TRUE(sw.presentMode()==m || sw.presentMode()==PresentMode::Fifo);
+      EXPECT_EQ(sw.stats().frameId, 0u);
+
+      auto     cmd     = device.commandBuffer();
+      uint64_t frameId = 0;
+      for(uint32_t i=0; i<4; ++i) {
+        try {
+          const uint32_t img = sw.currentImage();
+          {
+            auto enc = cmd.startEncoding(device);
+            enc.setFramebuffer({{sw[img],Vec4(float(i%2),0,0,1),Tempest::Preserve}});
+          }
+          auto sync = device.submit(cmd);
+          device.present(sw);
+          sync.wait();
+
+          EXPECT_GT(sw.stats().frameId, frameId);
+          frameId = sw.stats().frameId;
+          }
+        catch(const SwapchainSuboptimal&) {
+          // window is resized by window manager
+          device.waitIdle();
+          sw.reset();
+          }
+        }
+      device.waitIdle();
+      }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void SwapchainPresentThread() {
+  using namespace Tempest;
+  using clock = std::chrono::steady_clock;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    {
+      // slow fifo present, that blocks until next simulated vblank
+      const uint64_t interval = 100000; // 10Hz, in microseconds
+
+      SwapchainDesc desc;
+      desc.presentMode     = PresentMode::Fifo;
+      desc.imageCount      = 3;
+      desc.refreshInterval = interval;
+      desc.presentThread   = true;
+
+      const auto t0  = clock::now();
+      auto       sw  = device.swapchain(32,32,desc);
+      auto       cmd = device.commandBuffer();
+      for(uint32_t i=0; i+1<sw.imageCount(); ++i) {
+        // next image is acquired by Device::present, without waiting for present of previous one
+        EXPECT_EQ(sw.currentImage(), i);
+        {
+          auto enc = cmd.startEncoding(device);
+          enc.setFramebuffer({{sw[i],Vec4(float(i%2),0,0,1),Tempest::Preserve}});
+        }
+        auto sync = device.submit(cmd);
+        sync.wait();
+
+        const auto tx = clock::now();
+        device.present(sw);
+        const auto dt = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(clock::now()-tx).count());
+        EXPECT_LT(dt, interval/2);
+        EXPECT_EQ(sw.stats().frameId,     i+1);
+        EXPECT_EQ(sw.stats().acquireWait, 0u);
+        }
+
+      // both frames are recorded before first vblank: none of presents is finished yet
+      const auto dt = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(clock::now()-t0).count());
+      if(dt<interval)
+        EXPECT_EQ(sw.stats().displayLatency, 0u);
+
+      std::this_thread::sleep_for(std::chrono::microseconds(3*interval));
+      EXPECT_GT(sw.stats().displayLatency, 0u);
+    }
+
+    auto hwnd = SystemApi::createWindow(nullptr, 64, 64);
+    if(hwnd==nullptr) {
+      Log::d("Skipping swapchain testcase: no window system");
+      return;
+      }
+    struct Guard {
+      SystemApi::Window* hwnd = nullptr;
+      ~Guard() { SystemApi::destroyWindow(hwnd); }
+      } guard{hwnd};
+
+    SwapchainDesc desc;
+    desc.presentThread = true;
+
+    auto sw = device.swapchain(hwnd,desc);
+    EXPECT_FALSE(sw.isHeadless());
+
+    auto     cmd     = device.commandBuffer();
+    uint64_t frameId = 0;
+    for(uint32_t i=0; i<16; ++i) {
+      try {
+        // image is acquired by previous Device::present, before its present is queued
+        const uint32_t img = sw.currentImage();
+        EXPECT_LT(img, sw.imageCount());
+        {
+          auto enc = cmd.startEncoding(device);
+          enc.setFramebuffer({{sw[img],Vec4(float(i%2),0,0,1),Tempest::Preserve}});
+        }
+        auto sync = device.submit(cmd);
+        device.present(sw);
+        sync.wait();
+
+        EXPECT_GT(sw.stats().frameId, frameId);
+        frameId = sw.stats().frameId;
+        }
+      catch(const SwapchainSuboptimal&) {
+        // window is resized by window manager
+        device.waitIdle();
+        sw.reset();
+        }
+      }
+    device.waitIdle();
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi, Tempest::TextureFormat format>
+void Draw(const char* outImage) {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    if(!device.properties().hasAttachFormat(format)) {
+      Log::d("Skipping draw testcase: no format support");
+      return;
+      }
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto tex  = device.attachment(format,128,128);
+
+    auto cmd  = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      enc.draw(vbo,ibo);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImage);
+
+    const uint32_t ccnt = Pixmap::componentCount(pm.format());
+    uint32_t same = 0;
+    ImageValidator val(pm);
+    for(uint32_t y=0; y<pm.h(); ++y)
+      for(uint32_t x=0; x<pm.w(); ++x) {
+        auto pix = val.at(x,y);
+        auto ref = ImageValidator::Pixel();
+        if(x<y) {
+          ref.x[0] = 0;
+          ref.x[1] = 0;
+          ref.x[2] = 1;
+          ref.x[3] = 1;
+          } else {
+          const float u = (float(x)+0.5f)/float(pm.w());
+          const float v = (float(y)+0.5f)/float(pm.h());
+          ref.x[0] = u;
+          ref.x[1] = v;
+          ref.x[2] = 0;
+          ref.x[3] = 1;
+          }
+
+        for(uint32_t c=0; c<ccnt; ++c)
+          if(std::fabs(pix.x[c]-ref.x[c])<0.01f)
+            same++;
+        }
+    EXPECT_EQ(same,pm.w()*pm.h()*ccnt);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void InstanceIndex(const char* outImage) {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto tex  = device.attachment(Tempest::RGBA8,128,128);
+
+    auto cmd  = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      enc.draw(vbo,ibo, 0,ibo.size(), 123,1);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImage);
+
+    const uint32_t ccnt = Pixmap::componentCount(pm.format());
+    uint32_t same = 0;
+    ImageValidator val(pm);
+    for(uint32_t y=0; y<pm.h(); ++y)
+      for(uint32_t x=0; x<pm.w(); ++x) {
+        auto pix = val.at(x,y);
+        auto ref = ImageValidator::Pixel();
+        if(x<y) {
+          ref.x[0] = 0;
+          ref.x[1] = 0;
+          ref.x[2] = 1;
+          ref.x[3] = 1;
+          } else {
+          const float u = (float(x)+0.5f)/float(pm.w());
+          const float v = (float(y)+0.5f)/float(pm.h());
+          ref.x[0] = u;
+          ref.x[1] = v;
+          ref.x[2] = 123.f/255.f;
+          ref.x[3] = 1;
+          }
+
+        for(uint32_t c=0; c<ccnt; ++c)
+          if(std::fabs(pix.x[c]-ref.x[c])<0.01f)
+            same++;
+        }
+    EXPECT_EQ(same,pm.w()*pm.h()*ccnt);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void Viewport(const char* outImage) {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto tex  = device.attachment(TextureFormat::RGBA8,150,150);
+
+    auto cmd  = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+
+      enc.setViewport(-50,25,100,100);
+      enc.draw(vbo,ibo);
+
+      enc.setViewport(150,25,100,100);
+      enc.draw(vbo,ibo);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImage);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void DepthWrite(const char* outImage) {
+  using namespace Tempest;
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto rs    = RenderState();
+    rs.setZTestMode(Tempest::RenderState::ZTestMode::Always);
+    rs.setZWriteEnabled(true);
+
+    auto vert  = device.shader("shader/depth_write_test.vert.sprv");
+    auto frag  = device.shader("shader/depth_only.frag.sprv");
+    auto pso   = device.pipeline(Topology::Triangles,rs,vert,frag);
+
+    auto depth = device.zbuffer(TextureFormat::Depth16,150,150);
+
+    auto cmd   = device.commandBuffer();
+    {
+      float depthDst = 0;
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({}, {depth, 0.5,Tempest::Preserve});
+
+      depthDst = 0.25f;
+      enc.setPushData(&depthDst, sizeof(depthDst));
+      enc.setPipeline(pso);
+      enc.setViewport(0,0,50,50);
+      enc.draw(nullptr, 0, 3);
+
+      depthDst = 0.8f;
+      enc.setPushData(&depthDst, sizeof(depthDst));
+      enc.setPipeline(pso);
+      enc.setViewport(100,100,50,50);
+      enc.draw(nullptr, 0, 3);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(textureCast<Texture2d&>(depth));
+    pm.save(outImage);
+
+    auto ptr = reinterpret_cast<const uint16_t*>(pm.data());
+    EXPECT_EQ(ptr[0],               uint16_t(0.25f*65535+0.5));
+    EXPECT_EQ(ptr[pm.w()*pm.h()-1], uint16_t( 0.8f*65535+0.5));
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void Uniforms(const char* outImage, bool useUbo) {
+  using namespace Tempest;
+
+  struct Ubo {
+    Vec4 color[3];
+    } data;
+  data.color[0] = Vec4(1,0,0,1);
+  data.color[1] = Vec4(0,1,0,1);
+  data.color[2] = Vec4(0,0,1,1);
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto ubo  = device.ubo(data);
+    auto ssbo = device.ssbo(&data,sizeof(data));
+
+    auto vert = device.shader("shader/ubo_input.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto tex  = device.attachment(TextureFormat::RGBA8,128,128);
+    auto cmd  = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      if(useUbo)
+        enc.setBinding(2, ubo); else
+        enc.setBinding(2, ssbo);
+      enc.setPipeline(pso);
       enc.draw(vbo,ibo);
     }
 
@@ -670,50 +1770,247 @@ void Viewport(const char* outImage) {
   }
 
 template<class GraphicsApi>
-void DepthWrite(const char* outImage) {
+void PushUniform(const char* outImage) {
   using namespace Tempest;
+
+  struct Ubo {
+    Vec4 color[16]; // 256 bytes: larger than block in shader
+    } data = {};
+  data.color[0] = Vec4(1,0,0,1);
+  data.color[1] = Vec4(0,1,0,1);
+  data.color[2] = Vec4(0,0,1,1);
+
   try {
     GraphicsApi api{ApiFlags::Validation};
     Device      device(api);
 
-    auto rs    = RenderState();
-    rs.setZTestMode(Tempest::RenderState::ZTestMode::Always);
-    rs.setZWriteEnabled(true);
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+    auto ubo  = device.ubo(data);
 
-    auto vert  = device.shader("shader/depth_write_test.vert.sprv");
-    auto frag  = device.shader("shader/depth_only.frag.sprv");
-    auto pso   = device.pipeline(Topology::Triangles,rs,vert,frag);
+    auto vert = device.shader("shader/ubo_input.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
-    auto depth = device.zbuffer(TextureFormat::Depth16,150,150);
+    auto render = [&](bool push) {
+      auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+        enc.setPipeline(pso);
+        if(push) {
+          // garbage first: only last block must be visible
+          Ubo dummy = {};
+          enc.pushUniform(2, dummy);
+          enc.draw(vbo,ibo);
+          enc.pushUniform(2, data);
+          } else {
+          enc.setBinding(2, ubo);
+          }
+        enc.draw(vbo,ibo);
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+      return device.readPixels(tex);
+      };
 
-    auto cmd   = device.commandBuffer();
+    auto ref = render(false);
+    auto pm  = render(true);
+    pm.save(outImage);
+
+    ASSERT_EQ(ref.dataSize(), pm.dataSize());
+    EXPECT_EQ(std::memcmp(ref.data(), pm.data(), pm.dataSize()), 0);
+
+    // pushed data must cover whole uniform block
     {
-      float depthDst = 0;
+      auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+      auto cmd = device.commandBuffer();
       auto enc = cmd.startEncoding(device);
-      enc.setFramebuffer({}, {depth, 0.5,Tempest::Preserve});
-
-      depthDst = 0.25f;
-      enc.setPushData(&depthDst, sizeof(depthDst));
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
       enc.setPipeline(pso);
-      enc.setViewport(0,0,50,50);
-      enc.draw(nullptr, 0, 3);
+      enc.pushUniform(2, data.color[0]);
+      EXPECT_THROW(enc.draw(vbo,ibo), std::system_error);
+    }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
 
-      depthDst = 0.8f;
-      enc.setPushData(&depthDst, sizeof(depthDst));
-      enc.setPipeline(pso);
-      enc.setViewport(100,100,50,50);
-      enc.draw(nullptr, 0, 3);
+template<class GraphicsApi>
+void PushUniformRate() {
+  using namespace Tempest;
+
+  struct Ubo {
+    Vec4 color[16];
+    };
+
+  try {
+    GraphicsApi api{ApiFlags::NoFlags};
+    Device      device(api);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.shader("shader/ubo_input.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    const size_t draws = 50000;
+    std::vector<Ubo> data(draws);
+    auto color = [](size_t i, int frame) {
+      return Vec4(float(i%256)/255.f, float((i/256)%256)/255.f, float(frame*64)/255.f, 1);
+      };
+
+    const int w   = 32;
+    const int h   = 32;
+    auto      tex = device.attachment(TextureFormat::RGBA8,w,h);
+    auto      cmd = device.commandBuffer();
+    for(int frame=0; frame<3; ++frame) {
+      // values differ from frame to frame: stale ring memory would show up
+      for(size_t i=0; i<draws; ++i)
+        for(auto& c:data[i].color)
+          c = color(i,frame);
+
+      // frame 0 allocates ring memory, next ones recycle it
+      const auto start = std::chrono::steady_clock::now();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+        enc.setPipeline(pso);
+        for(size_t i=0; i<draws; ++i) {
+          // each draw owns one pixel: last draw, that touches a pixel, defines its value
+          const int px = int(i%size_t(w*h));
+          enc.setScissor(px%w, px/w, 1, 1);
+          enc.pushUniform(2, data[i]);
+          enc.draw(vbo,ibo);
+          }
+      }
+      const auto dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      Log::i("PushUniform rate, frame ", frame, ": ", int64_t(double(draws)/std::max(dt,1e-6)), " draws/s");
+
+      auto sync = device.submit(cmd);
+      sync.wait();
+
+      auto pm = device.readPixels(tex);
+      ImageValidator val(pm);
+      for(int y=0; y<h; ++y)
+        for(int x=0; x<w; ++x) {
+          if(x==y)
+            continue; // pixel center on triangle edge
+          const size_t px   = size_t(y*w+x);
+          const size_t last = px + ((draws-1-px)/size_t(w*h))*size_t(w*h);
+          const Vec4   ref  = (x>y ? color(last,frame) : Vec4(0,0,1,1));
+          auto         pix  = val.at(uint32_t(x),uint32_t(y));
+          EXPECT_NEAR(pix.x[0], ref.x, 0.002f);
+          EXPECT_NEAR(pix.x[1], ref.y, 0.002f);
+          EXPECT_NEAR(pix.x[2], ref.z, 0.002f);
+          }
+      }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
     }
+  }
 
-    auto sync = device.submit(cmd);
-    sync.wait();
+template<class GraphicsApi>
+void GeometryPool(const char* outImage) {
+  using namespace Tempest;
 
-    auto pm = device.readPixels(textureCast<Texture2d&>(depth));
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    Tempest::GeometryPool pool(device,4096);
+    // non-zero offsets for the meshes below
+    auto pad  = pool.vbo(vboData,1);
+    auto pvbo = pool.vbo(vboData,3);
+    auto pibo = pool.ibo(iboData,3);
+
+    std::array<Vertex,3> back = {};
+    device.readBytes(pvbo,back.data(),sizeof(back));
+    EXPECT_EQ(std::memcmp(back.data(),vboData,sizeof(back)),0);
+
+    // return range to the pool and allocate again
+    pad = Tempest::VertexBuffer<Vertex>();
+    const Vertex vboData2[1] = {{7,8}};
+    auto pvbo2 = pool.vbo(vboData2,1);
+    ASSERT_EQ(pvbo2.size(), 1u);
+
+    // readback of pooled buffer covers only its own range
+    Vertex back2[2] = {{-5,-5},{-5,-5}};
+    device.readBytes(pvbo2,back2,sizeof(Vertex));
+    EXPECT_EQ(back2[0].x, vboData2[0].x);
+    EXPECT_EQ(back2[0].y, vboData2[0].y);
+    EXPECT_EQ(back2[1].x, -5.f);
+
+    // reused range doesn't overlap live allocations
+    back = {};
+    device.readBytes(pvbo,back.data(),sizeof(back));
+    EXPECT_EQ(std::memcmp(back.data(),vboData,sizeof(back)),0);
+
+    // pooled buffer is rejected by descriptor arrays, even at offset 0
+    if(device.properties().descriptors.nonUniformIndexing) {
+      const StorageBuffer* arr[] = {&pvbo2};
+      EXPECT_THROW(device.descriptors(arr,1), std::system_error);
+      }
+
+    // pooled buffer at non-zero offset, bound as ssbo
+    {
+      const Vec4 data[2] = {{1,2,3,4},{5,6,7,8}};
+      auto pdata = pool.vbo(data,2);
+      auto out   = device.ssbo(Uninitialized,sizeof(data));
+      auto pso   = device.pipeline(device.shader("shader/ssbo_read.comp.sprv"));
+
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setBinding(0,pdata);
+        enc.setBinding(1,out);
+        enc.setPipeline(pso);
+        enc.dispatch(2,1,1);
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+
+      Vec4 ret[2] = {};
+      device.readBytes(out,ret,sizeof(ret));
+      EXPECT_EQ(ret[0],data[0]);
+      EXPECT_EQ(ret[1],data[1]);
+    }
+
+    auto render = [&](auto& vbo, auto& ibo) {
+      auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+        enc.setPipeline(pso);
+        enc.draw(vbo,ibo);
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+      return device.readPixels(tex);
+      };
+
+    auto ref = render(vbo,ibo);
+    auto pm  = render(pvbo,pibo);
     pm.save(outImage);
 
-    auto ptr = reinterpret_cast<const uint16_t*>(pm.data());
-    EXPECT_EQ(ptr[0],               uint16_t(0.25f*65535+0.5));
-    EXPECT_EQ(ptr[pm.w()*pm.h()-1], uint16_t( 0.8f*65535+0.5));
+    ASSERT_EQ(ref.dataSize(), pm.dataSize());
+    EXPECT_EQ(std::memcmp(ref.data(), pm.data(), pm.dataSize()), 0);
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -723,27 +2020,20 @@ void DepthWrite(const char* outImage) {
   }
 
 template<class GraphicsApi>
-void Uniforms(const char* outImage, bool useUbo) {
+void VertexStreams(const char* outImage) {
   using namespace Tempest;
 
-  struct Ubo {
-    Vec4 color[3];
-    } data;
-  data.color[0] = Vec4(1,0,0,1);
-  data.color[1] = Vec4(0,1,0,1);
-  data.color[2] = Vec4(0,0,1,1);
+  static const Vec4 color[2] = {Vec4(0,1,0,1), Vec4(1,0,0,1)};
 
   try {
     GraphicsApi api{ApiFlags::Validation};
     Device      device(api);
 
     auto vbo  = device.vbo(vboData,3);
+    auto inst = device.vbo(color,2);
     auto ibo  = device.ibo(iboData,3);
 
-    auto ubo  = device.ubo(data);
-    auto ssbo = device.ssbo(&data,sizeof(data));
-
-    auto vert = device.shader("shader/ubo_input.vert.sprv");
+    auto vert = device.shader("shader/vertex_streams.vert.sprv");
     auto frag = device.shader("shader/simple_test.frag.sprv");
     auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
@@ -752,18 +2042,139 @@ void Uniforms(const char* outImage, bool useUbo) {
     {
       auto enc = cmd.startEncoding(device);
       enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
-      if(useUbo)
-        enc.setBinding(2, ubo); else
-        enc.setBinding(2, ssbo);
       enc.setPipeline(pso);
-      enc.draw(vbo,ibo);
+      // second instance only: per-instance stream must start from firstInstance
+      enc.draw({VertexStream(vbo), VertexStream(inst,InputRate::PerInstance)}, ibo, 0, 3, 1, 1);
+    }
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImage);
+
+    ImageValidator val(pm);
+    for(uint32_t y=0; y<pm.h(); ++y)
+      for(uint32_t x=0; x<pm.w(); ++x) {
+        if(x==y)
+          continue;
+        auto pix = val.at(x,y);
+        auto ref = (x<y) ? Vec4(0,0,1,1) : color[1];
+        ASSERT_NEAR(pix.x[0], ref.x, 0.01f);
+        ASSERT_NEAR(pix.x[1], ref.y, 0.01f);
+        ASSERT_NEAR(pix.x[2], ref.z, 0.01f);
+        }
+
+    // streams, that don't match shader inputs, are rejected
+    auto expectMismatch = [&](auto fn) {
+      auto cmd = device.commandBuffer();
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      try {
+        fn(enc);
+        ADD_FAILURE() << "vertex input mismatch is not detected";
+        }
+      catch(std::system_error& e) {
+        EXPECT_EQ(e.code(), Tempest::GraphicsErrc::InvalidVertexInput);
+        }
+      };
+    // vec4 input doesn't fit into 8-byte element
+    expectMismatch([&](auto& enc){ enc.draw({VertexStream(vbo), VertexStream(vbo,InputRate::PerInstance)}, ibo, 0, 3); });
+    // more streams, than inputs
+    expectMismatch([&](auto& enc){ enc.draw({VertexStream(vbo), VertexStream(inst), VertexStream(inst)}, ibo, 0, 3); });
+    // explicit format is larger, than element
+    expectMismatch([&](auto& enc){ enc.draw({VertexStream(vbo,{Decl::float4})}, ibo, 0, 3); });
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
     }
+  }
+
+template<class GraphicsApi>
+void VertexCompressed(const char* outImage) {
+  using namespace Tempest;
+
+  struct PackedVertex {
+    uint16_t pos[2];
+    uint8_t  color[4];
+    };
+  static_assert(sizeof(PackedVertex)==8);
+
+  static const float color[4] = {1,0,0,1};
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    PackedVertex packed[3] = {};
+    VertexQuantizer::quantize(Decl::half2,    packed[0].pos,   sizeof(PackedVertex), &vboData[0].x, sizeof(Vertex), 3);
+    VertexQuantizer::quantize(Decl::unorm8x4, packed[0].color, sizeof(PackedVertex), color,         0,              3);
+
+    auto vbo  = device.vbo(packed,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.shader("shader/vertex_streams.vert.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
 
+    auto tex  = device.attachment(TextureFormat::RGBA8,128,128);
+    auto cmd  = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(pso);
+      enc.draw({VertexStream(vbo,{Decl::half2,Decl::unorm8x4})}, ibo, 0, 3);
+    }
     auto sync = device.submit(cmd);
     sync.wait();
 
     auto pm = device.readPixels(tex);
     pm.save(outImage);
+
+    auto check = [](const Pixmap& pm) {
+      ImageValidator val(pm);
+      for(uint32_t y=0; y<pm.h(); ++y)
+        for(uint32_t x=0; x<pm.w(); ++x) {
+          if(x==y)
+            continue;
+          auto pix = val.at(x,y);
+          auto ref = (x<y) ? Vec4(0,0,1,1) : Vec4(1,0,0,1);
+          ASSERT_NEAR(pix.x[0], ref.x, 0.01f);
+          ASSERT_NEAR(pix.x[1], ref.y, 0.01f);
+          ASSERT_NEAR(pix.x[2], ref.z, 0.01f);
+          }
+      };
+    check(pm);
+
+    if(!device.properties().vbo.halfInput)
+      return;
+
+    // f16vec4 input is reflected as half4: 8 bytes, followed by color at offset 8
+    struct PackedVertex4 {
+      uint16_t pos[4];
+      uint8_t  color[4];
+      };
+    static_assert(sizeof(PackedVertex4)==12);
+
+    const float pos4[3][4] = {{-1,-1,1,1},{1,-1,1,1},{1,1,1,1}};
+    PackedVertex4 packed4[3] = {};
+    VertexQuantizer::quantize(Decl::half4,    packed4[0].pos,   sizeof(PackedVertex4), pos4[0], sizeof(pos4[0]), 3);
+    VertexQuantizer::quantize(Decl::unorm8x4, packed4[0].color, sizeof(PackedVertex4), color,   0,               3);
+
+    auto vbo4  = device.vbo(packed4,3);
+    auto vert4 = device.shader("shader/vertex_half4.vert.sprv");
+    auto pso4  = device.pipeline(Topology::Triangles,RenderState(),vert4,frag);
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(pso4);
+      enc.draw({VertexStream(vbo4,{Decl::half4,Decl::unorm8x4})}, ibo, 0, 3);
+    }
+    sync = device.submit(cmd);
+    sync.wait();
+    check(device.readPixels(tex));
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -873,27 +2284,68 @@ void SsboOverlap() {
     GraphicsApi api{ApiFlags::Validation};
     Device      device(api);
 
-    Buf  buf;
-    auto ssbo   = device.ssbo(&buf,sizeof(buf));
+    Buf  buf;
+    auto ssbo   = device.ssbo(&buf,sizeof(buf));
+
+    auto cs     = device.shader("shader/overlap_test.comp.sprv");
+    auto pso    = device.pipeline(cs);
+
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setBinding(0, ssbo);
+      enc.setPipeline(pso);
+      enc.dispatch(1);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    Buf output;
+    device.readBytes(ssbo,&output,sizeof(output));
+
+    EXPECT_EQ(buf.a,output.b);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void SpecializationConstants() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto output = device.ssbo(Uninitialized, 64*sizeof(uint32_t));
+    auto cs     = device.shader("shader/spec_const.comp.sprv");
 
-    auto cs     = device.shader("shader/overlap_test.comp.sprv");
-    auto pso    = device.pipeline(cs);
+    Tempest::SpecializationConstants spec;
+    spec.set(0, 16u);
+    spec.set(1, 7u);
+    spec.set(2, true);
+    auto pso = device.pipeline(cs, spec);
+    EXPECT_EQ(pso.workGroupSize(), IVec3(16,1,1));
 
     auto cmd = device.commandBuffer();
     {
       auto enc = cmd.startEncoding(device);
-      enc.setBinding(0, ssbo);
+      enc.setBinding(0, output);
       enc.setPipeline(pso);
-      enc.dispatch(1);
+      enc.dispatch(4,1,1);
     }
 
     auto sync = device.submit(cmd);
     sync.wait();
 
-    Buf output;
-    device.readBytes(ssbo,&output,sizeof(output));
-
-    EXPECT_EQ(buf.a,output.b);
+    uint32_t outputCpu[64] = {};
+    device.readBytes(output,outputCpu,sizeof(outputCpu));
+    for(size_t i=0; i<64; ++i)
+      EXPECT_EQ(outputCpu[i],14u);
     }
   catch(std::system_error& e) {
     if(e.code()==Tempest::GraphicsErrc::NoDevice)
@@ -1358,6 +2810,59 @@ void PushRemapping() {
     }
   }
 
+template<class GraphicsApi>
+void BufferAddress() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    if(!device.properties().deviceAddress) {
+      Log::d("Skipping graphics testcase: deviceAddress is not supported");
+      return;
+      }
+
+    Vec4 inputCpu[3] = {Vec4(0,1,2,3),Vec4(4,5,6,7),Vec4(8,9,10,11)};
+
+    auto input  = device.ssbo(inputCpu,      sizeof(inputCpu));
+    auto tmp    = device.ssbo(Uninitialized, sizeof(inputCpu));
+    auto output = device.ssbo(Uninitialized, sizeof(inputCpu));
+
+    auto cs     = device.shader("shader/buffer_address.comp.sprv");
+    auto pso    = device.pipeline(cs);
+
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setPipeline(pso);
+
+      enc.setAddressUsage({&input}, {&tmp});
+      enc.setPushAddresses({&input, &tmp});
+      enc.dispatch(3,1,1);
+
+      // second pass depends on first one: must be synchronized by declared usage
+      enc.setAddressUsage({&tmp}, {&output});
+      enc.setPushAddresses({&tmp, &output});
+      enc.dispatch(3,1,1);
+    }
+
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    Vec4 outputCpu[3] = {};
+    device.readBytes(output,outputCpu,sizeof(outputCpu));
+
+    for(size_t i=0; i<3; ++i)
+      EXPECT_EQ(outputCpu[i],inputCpu[i]);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
 template<class GraphicsApi>
 void PushRemappingGr(const char* outImage) {
   using namespace Tempest;
@@ -1724,6 +3229,108 @@ void Bindless2(const char* outImg) {
     }
   }
 
+template<class GraphicsApi>
+void DescriptorArrayUpdate() {
+  using namespace Tempest;
+  try {
+    const char* devName = nullptr;
+
+    GraphicsApi api{ApiFlags::Validation};
+    auto dev = api.devices();
+    for(auto& i:dev)
+      if(i.descriptors.nonUniformIndexing)
+        devName = i.name;
+    if(devName==nullptr)
+      return;
+    Device device(api,devName);
+
+    auto cs  = device.shader("shader/array_ssbo.comp.sprv");
+    auto pso = device.pipeline(cs);
+    auto ret = device.image2d(TextureFormat::RGBA8,32,32,false);
+
+    auto r = device.ssbo<Vec4>({Vec4(1,0,0,1)});
+    auto g = device.ssbo<Vec4>({Vec4(0,1,0,1)});
+    auto b = device.ssbo<Vec4>({Vec4(0,0,1,1)});
+    auto w = device.ssbo<Vec4>({Vec4(1,1,1,1)});
+
+    // empty slots only
+    std::vector<const Tempest::StorageBuffer*> pbuf(3, nullptr);
+    auto arr = device.descriptors(pbuf);
+    EXPECT_EQ(arr.size(), 3u);
+
+    // free slots are handed out in order
+    EXPECT_EQ(arr.alloc(r), 0u);
+    EXPECT_EQ(arr.alloc(g), 1u);
+    EXPECT_EQ(arr.alloc(b), 2u);
+
+    auto cmd = device.commandBuffer();
+    auto run = [&]() {
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setBinding(0, ret);
+        enc.setBinding(1, arr);
+        enc.setPipeline(pso);
+        enc.dispatch(ret.w(),ret.h(),1);
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+      return device.readPixels(ret);
+      };
+
+    auto pm = run();
+    auto px = reinterpret_cast<const uint8_t*>(pm.data());
+    EXPECT_EQ(px[0], 255);
+    EXPECT_EQ(px[1], 0);
+    EXPECT_EQ(px[10*4+1], 255);
+    EXPECT_EQ(px[20*4+2], 255);
+
+    // sparse write of a single slot, after array was used
+    arr.set(0, w);
+    arr.free(2);
+    // released slot still can be written explicitly
+    arr.set(2, b);
+
+    pm = run();
+    px = reinterpret_cast<const uint8_t*>(pm.data());
+    EXPECT_EQ(px[0], 255);
+    EXPECT_EQ(px[1], 255);
+    EXPECT_EQ(px[2], 255);
+    EXPECT_EQ(px[10*4+0], 0);
+    EXPECT_EQ(px[10*4+1], 255);
+    EXPECT_EQ(px[20*4+2], 255);
+
+    // released slot is not reused, while command buffer, recorded with array, is alive
+    arr.free(1);
+    EXPECT_EQ(arr.alloc(w), 3u);
+    EXPECT_GT(arr.size(), 3u);
+
+    // grown array keeps content; released slot is intact until reuse
+    pm = run();
+    px = reinterpret_cast<const uint8_t*>(pm.data());
+    EXPECT_EQ(px[0], 255);
+    EXPECT_EQ(px[2], 255);
+    EXPECT_EQ(px[10*4+0], 0);
+    EXPECT_EQ(px[10*4+1], 255);
+    EXPECT_EQ(px[20*4+2], 255);
+
+    // command buffer is re-recorded: released slot is reused and written into bound set
+    EXPECT_EQ(arr.alloc(r), 1u);
+
+    pm = run();
+    px = reinterpret_cast<const uint8_t*>(pm.data());
+    EXPECT_EQ(px[0], 255);
+    EXPECT_EQ(px[1], 255);
+    EXPECT_EQ(px[10*4+0], 255);
+    EXPECT_EQ(px[10*4+1], 0);
+    EXPECT_EQ(px[20*4+2], 255);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
 template<class GraphicsApi>
 void UnusedDescriptor(const char* outImg) {
   using namespace Tempest;
@@ -1899,6 +3506,156 @@ void RayQuery(const char* outImg) {
     }
   }
 
+template<class GraphicsApi>
+void RayQueryBatch(const char* outImg) {
+  using namespace Tempest;
+
+  try {
+    const char* rtDev = nullptr;
+
+    GraphicsApi api{ApiFlags::Validation};
+    auto dev = api.devices();
+    for(auto& i:dev)
+      if(i.raytracing.rayQuery)
+        rtDev = i.name;
+    if(rtDev==nullptr)
+      return;
+
+    Device device(api,rtDev);
+    auto vbo  = device.vbo(vboData3,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto fsq  = device.vbo<Vertex>({{-1,-1},{ 1,-1},{ 1, 1}, {-1,-1},{ 1, 1},{-1, 1}});
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/ray_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto render = [&](BlasFlags flags) {
+      // many small builds: recorded into shared submit
+      std::vector<AccelerationStructure> blas;
+      for(int i=0; i<64; ++i)
+        blas.emplace_back(device.blas({RtGeometry(vbo,ibo)}, flags));
+
+      auto m = Matrix4x4::mkIdentity();
+      m.translate(-1,1,0);
+      auto tlas = device.tlas({{m,0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas.back()}});
+
+      auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+        enc.setBinding(0, tlas);
+        enc.setPipeline(pso);
+        enc.draw(fsq);
+      }
+      auto sync = device.submit(cmd);
+      sync.wait();
+      return device.readPixels(tex);
+      };
+
+    auto ref = render(BlasFlags::None);
+    auto pm  = render(BlasFlags::Compact);
+    pm.save(outImg);
+
+    ASSERT_EQ(ref.dataSize(), pm.dataSize());
+    EXPECT_EQ(std::memcmp(ref.data(), pm.data(), pm.dataSize()), 0);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void RayQueryUpdate(const char* outImg) {
+  using namespace Tempest;
+
+  try {
+    const char* rtDev = nullptr;
+
+    GraphicsApi api{ApiFlags::Validation};
+    auto dev = api.devices();
+    for(auto& i:dev)
+      if(i.raytracing.rayQuery)
+        rtDev = i.name;
+    if(rtDev==nullptr)
+      return;
+
+    Device device(api,rtDev);
+    auto vbo  = device.vbo(vboData3,3);
+    auto ibo  = device.ibo(iboData,3);
+    auto blas = device.blas(vbo,ibo);
+
+    auto fsq  = device.vbo<Vertex>({{-1,-1},{ 1,-1},{ 1, 1}, {-1,-1},{ 1, 1},{-1, 1}});
+    auto vert = device.shader("shader/simple_test.vert.sprv");
+    auto frag = device.shader("shader/ray_test.frag.sprv");
+    auto pso  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+
+    auto m = Matrix4x4::mkIdentity();
+    m.translate(-1,1,0);
+    auto far = Matrix4x4::mkIdentity();
+    far.translate(100,100,0);
+
+    auto record = [&](CommandBuffer& cmd, Attachment& tex, AccelerationStructure& tlas, const std::vector<RtInstance>* update) {
+      auto enc = cmd.startEncoding(device);
+      if(update!=nullptr)
+        enc.updateTlas(tlas, *update);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setBinding(0, tlas);
+      enc.setPipeline(pso);
+      enc.draw(fsq);
+      };
+    auto render = [&](AccelerationStructure& tlas, const std::vector<RtInstance>* update) {
+      auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+      auto cmd = device.commandBuffer();
+      record(cmd, tex, tlas, update);
+      auto sync = device.submit(cmd);
+      sync.wait();
+      return device.readPixels(tex);
+      };
+    auto expectEq = [](const Pixmap& a, const Pixmap& b) {
+      ASSERT_EQ(a.dataSize(), b.dataSize());
+      EXPECT_EQ(std::memcmp(a.data(), b.data(), a.dataSize()), 0);
+      };
+
+    auto tref = device.tlas({{m,  0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas}});
+    auto tlas = device.tlas({{far,0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas}});
+
+    const std::vector<RtInstance> near = {{m,0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas}};
+    auto ref = render(tref, nullptr);
+    auto pm  = render(tlas, &near);
+    pm.save(outImg);
+    expectEq(ref, pm);
+
+    // partial update: unused instances must not be visible, and following full refit must stay valid
+    auto tlas2 = device.tlas({{far,0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas},
+                              {far,0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas}});
+    const std::vector<RtInstance> full = {{m,  0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas},
+                                          {far,0,0xFF,Tempest::RtInstanceFlags::Opaque,&blas}};
+    expectEq(ref, render(tlas2, &near));
+    expectEq(ref, render(tlas2, &full));
+
+    // recording order must not matter: second command buffer is recorded first, but submitted last
+    auto tex0 = device.attachment(TextureFormat::RGBA8,128,128);
+    auto tex1 = device.attachment(TextureFormat::RGBA8,128,128);
+    auto cmd0 = device.commandBuffer();
+    auto cmd1 = device.commandBuffer();
+    record(cmd1, tex1, tlas2, &full);
+    record(cmd0, tex0, tlas2, &near);
+    device.submit(cmd0).wait();
+    device.submit(cmd1).wait();
+    expectEq(ref, device.readPixels(tex0));
+    expectEq(ref, device.readPixels(tex1));
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
 template<class GraphicsApi>
 void RayQueryFace(const char* outImg) {
   using namespace Tempest;
@@ -2002,6 +3759,146 @@ void MeshShader(const char* outImg) {
     }
   }
 
+template<class GraphicsApi>
+void MeshShaderEmulated(const char* outImg) {
+  using namespace Tempest;
+
+  try {
+    const char* msDev = nullptr;
+
+    // force emulation, so path is covered on devices with native mesh shaders as well
+    GraphicsApi api{ApiFlags::Validation|ApiFlags::EmulateMeshShader};
+    auto dev = api.devices();
+    for(auto& i:dev)
+      if(i.meshlets.emulated)
+        msDev = i.name;
+    if(msDev==nullptr)
+      return;
+
+    Device device(api,msDev);
+    ASSERT_TRUE(device.properties().meshlets.emulated);
+    ASSERT_FALSE(device.properties().meshlets.meshShader);
+    auto vbo  = device.vbo(vboData,3);
+
+    auto task = device.shader("shader/simple_test.spv14.task.sprv");
+    auto mesh = device.shader("shader/simple_test.spv14.mesh.sprv");
+    auto frag = device.shader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline(RenderState(),task,mesh,frag);
+
+    auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setBinding(0, vbo);
+      enc.setPipeline(pso);
+      enc.dispatchMesh(1);
+    }
+    auto sync = device.submit(cmd);
+    sync.wait();
+
+    auto pm = device.readPixels(tex);
+    pm.save(outImg);
+
+    // same triangle, drawn by classic pipeline
+    auto ibo  = device.ibo(iboData,3);
+    auto vert = device.shader("shader/mesh_reference.vert.sprv");
+    auto ref  = device.pipeline(Topology::Triangles,RenderState(),vert,frag);
+    auto rtex = device.attachment(TextureFormat::RGBA8,128,128);
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setFramebuffer({{rtex,Vec4(0,0,1,1),Tempest::Preserve}});
+      enc.setPipeline(ref);
+      enc.draw(vbo,ibo);
+    }
+    sync = device.submit(cmd);
+    sync.wait();
+
+    auto rpm = device.readPixels(rtex);
+    ASSERT_EQ(pm.dataSize(), rpm.dataSize());
+    auto a = reinterpret_cast<const uint8_t*>(pm.data());
+    auto b = reinterpret_cast<const uint8_t*>(rpm.data());
+    for(size_t i=0; i<pm.dataSize(); ++i)
+      ASSERT_LE(std::abs(int(a[i])-int(b[i])), 1) << "pixel " << (i/4)%pm.w() << ", " << (i/4)/pm.w();
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void MeshShaderEmulationRate() {
+  using namespace Tempest;
+
+  try {
+    std::string msDev;
+    {
+      GraphicsApi api{ApiFlags::NoFlags};
+      for(auto& i:api.devices())
+        if(i.meshlets.meshShader && i.meshlets.taskShader)
+          msDev = i.name;
+    }
+    if(msDev.empty()) {
+      Log::d("Skipping mesh-shader testcase: no native mesh shader");
+      return;
+      }
+
+    const size_t draws = 4096;
+    auto run = [&](ApiFlags flags, Pixmap& out) {
+      GraphicsApi api{flags};
+      Device      device(api,msDev);
+      EXPECT_EQ(device.properties().meshlets.emulated, (flags & ApiFlags::EmulateMeshShader)!=ApiFlags::NoFlags);
+
+      auto vbo  = device.vbo(vboData,3);
+      auto task = device.shader("shader/simple_test.spv14.task.sprv");
+      auto mesh = device.shader("shader/simple_test.spv14.mesh.sprv");
+      auto frag = device.shader("shader/simple_test.frag.sprv");
+      auto pso  = device.pipeline(RenderState(),task,mesh,frag);
+
+      auto tex = device.attachment(TextureFormat::RGBA8,128,128);
+      auto cmd = device.commandBuffer();
+      double rate = 0;
+      for(int frame=0; frame<2; ++frame) {
+        // first frame is warm-up
+        const auto start = std::chrono::steady_clock::now();
+        {
+          auto enc = cmd.startEncoding(device);
+          enc.setFramebuffer({{tex,Vec4(0,0,1,1),Tempest::Preserve}});
+          enc.setBinding(0, vbo);
+          enc.setPipeline(pso);
+          for(size_t i=0; i<draws; ++i)
+            enc.dispatchMesh(1);
+        }
+        auto sync = device.submit(cmd);
+        sync.wait();
+        const auto dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rate = double(draws)/std::max(dt,1e-6);
+        }
+      out = device.readPixels(tex);
+      return rate;
+      };
+
+    Pixmap native, emulated;
+    const double rateNative   = run(ApiFlags::NoFlags,           native);
+    const double rateEmulated = run(ApiFlags::EmulateMeshShader, emulated);
+    Log::i("Mesh-shader rate, native: ",   int64_t(rateNative),   " draws/s");
+    Log::i("Mesh-shader rate, emulated: ", int64_t(rateEmulated), " draws/s (x", rateEmulated/std::max(rateNative,1.0), ")");
+
+    ASSERT_EQ(native.dataSize(), emulated.dataSize());
+    auto a = reinterpret_cast<const uint8_t*>(native.data());
+    auto b = reinterpret_cast<const uint8_t*>(emulated.data());
+    for(size_t i=0; i<native.dataSize(); ++i)
+      ASSERT_LE(std::abs(int(a[i])-int(b[i])), 1) << "pixel " << (i/4)%native.w() << ", " << (i/4)/native.w();
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
 template<class GraphicsApi>
 void MeshComputePrototype(const char* outImg) {
   using namespace Tempest;
@@ -85,6 +85,12 @@ TEST(MetalApi,Fbo) {
 #endif
   }
 
+TEST(MetalApi,SwapchainPresentMode) {
+#if defined(__OSX__)
+  GapiTestCommon::SwapchainPresentMode<MetalApi>();
+#endif
+  }
+
 TEST(MetalApi,Draw) {
 #if defined(__OSX__)
   GapiTestCommon::Draw<MetalApi,TextureFormat::RGBA8>  ("MetalApi_Draw_RGBA8.png");
@@ -38,6 +38,12 @@ TEST(VulkanApi,VboDyn) {
 #endif
   }
 
+TEST(VulkanApi,MappedBuffer) {
+#if !defined(__OSX__)
+  GapiTestCommon::MappedBuffer<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,SsboDyn) {
 #if !defined(__OSX__)
   GapiTestCommon::SsboDyn<VulkanApi,float>();
@@ -68,6 +74,30 @@ TEST(VulkanApi,Shader) {
 #endif
   }
 
+TEST(VulkanApi,ShaderLoadRateCold) {
+#if !defined(__OSX__)
+  GapiTestCommon::ShaderLoadRate<VulkanApi>(false);
+#endif
+  }
+
+TEST(VulkanApi,ShaderLoadRateWarm) {
+#if !defined(__OSX__)
+  GapiTestCommon::ShaderLoadRate<VulkanApi>(true);
+#endif
+  }
+
+TEST(VulkanApi,ShaderOptimize) {
+#if !defined(__OSX__)
+  GapiTestCommon::ShaderOptimize<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,ShaderCache) {
+#if !defined(__OSX__)
+  GapiTestCommon::ShaderCache<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,Pso) {
 #if !defined(__OSX__)
   GapiTestCommon::Pso<VulkanApi>();
@@ -80,12 +110,78 @@ TEST(VulkanApi,PsoInconsistentVaryings) {
 #endif
   }
 
+TEST(VulkanApi,PsoVariants) {
+#if !defined(__OSX__)
+  GapiTestCommon::PsoVariants<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,DynamicState) {
+#if !defined(__OSX__)
+  GapiTestCommon::DynamicState<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,RecordingScaling) {
+#if !defined(__OSX__)
+  GapiTestCommon::RecordingScaling<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,FboCacheEviction) {
+#if !defined(__OSX__)
+  GapiTestCommon::FboCacheEviction<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,CommandBufferReuse) {
+#if !defined(__OSX__)
+  GapiTestCommon::CommandBufferReuse<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,CommandBundle) {
+#if !defined(__OSX__)
+  GapiTestCommon::CommandBundle<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,CommandBundleKeepAlive) {
+#if !defined(__OSX__)
+  GapiTestCommon::CommandBundleKeepAlive<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,Fbo) {
 #if !defined(__OSX__)
   GapiTestCommon::Fbo<VulkanApi>("VulkanApi_Fbo.png");
 #endif
   }
 
+TEST(VulkanApi,HeadlessSwapchain) {
+#if !defined(__OSX__)
+  GapiTestCommon::HeadlessSwapchain<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,HeadlessSwapchainPacing) {
+#if !defined(__OSX__)
+  GapiTestCommon::HeadlessSwapchainPacing<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,SwapchainPresentMode) {
+#if !defined(__OSX__)
+  GapiTestCommon::SwapchainPresentMode<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,SwapchainPresentThread) {
+#if !defined(__OSX__)
+  GapiTestCommon::SwapchainPresentThread<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,Draw) {
 #if !defined(__OSX__)
   GapiTestCommon::Draw<VulkanApi,TextureFormat::RGBA8>  ("VulkanApi_Draw_RGBA8.png");
@@ -100,6 +196,11 @@ TEST(VulkanApi,Draw) {
   GapiTestCommon::Draw<VulkanApi,TextureFormat::RGB32F> ("VulkanApi_Draw_RGB32F.hdr");
   GapiTestCommon::Draw<VulkanApi,TextureFormat::RG32F>  ("VulkanApi_Draw_RG32F.hdr");
   GapiTestCommon::Draw<VulkanApi,TextureFormat::R32F>   ("VulkanApi_Draw_R32F.hdr");
+  GapiTestCommon::Draw<VulkanApi,TextureFormat::RGBA16F>("VulkanApi_Draw_RGBA16F.hdr");
+  GapiTestCommon::Draw<VulkanApi,TextureFormat::RG16F>  ("VulkanApi_Draw_RG16F.hdr");
+  GapiTestCommon::Draw<VulkanApi,TextureFormat::R16F>   ("VulkanApi_Draw_R16F.hdr");
+  GapiTestCommon::Draw<VulkanApi,TextureFormat::RGB10A2>("VulkanApi_Draw_RGB10A2.png");
+  GapiTestCommon::Draw<VulkanApi,TextureFormat::RGBA8_SRGB>("VulkanApi_Draw_RGBA8_SRGB.png");
 #endif
   }
 
@@ -128,6 +229,36 @@ TEST(VulkanApi,Uniforms) {
 #endif
   }
 
+TEST(VulkanApi,PushUniform) {
+#if !defined(__OSX__)
+  GapiTestCommon::PushUniform<VulkanApi>("VulkanApi_PushUniform.png");
+#endif
+  }
+
+TEST(VulkanApi,PushUniformRate) {
+#if !defined(__OSX__)
+  GapiTestCommon::PushUniformRate<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,GeometryPool) {
+#if !defined(__OSX__)
+  GapiTestCommon::GeometryPool<VulkanApi>("VulkanApi_GeometryPool.png");
+#endif
+  }
+
+TEST(VulkanApi,VertexStreams) {
+#if !defined(__OSX__)
+  GapiTestCommon::VertexStreams<VulkanApi>("VulkanApi_VertexStreams.png");
+#endif
+  }
+
+TEST(VulkanApi,VertexCompressed) {
+#if !defined(__OSX__)
+  GapiTestCommon::VertexCompressed<VulkanApi>("VulkanApi_VertexCompressed.png");
+#endif
+  }
+
 TEST(VulkanApi,SSBOReadOnly) {
 #if !defined(__OSX__)
   GapiTestCommon::SSBOReadOnly<VulkanApi>(true);
@@ -147,6 +278,12 @@ TEST(VulkanApi,SsboOverlap) {
 #endif
   }
 
+TEST(VulkanApi,SpecializationConstants) {
+#if !defined(__OSX__)
+  GapiTestCommon::SpecializationConstants<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,Compute) {
 #if !defined(__OSX__)
   GapiTestCommon::Compute<VulkanApi>();
@@ -240,6 +377,12 @@ TEST(VulkanApi,PushRemapping) {
 #endif
   }
 
+TEST(VulkanApi,BufferAddress) {
+#if !defined(__OSX__)
+  GapiTestCommon::BufferAddress<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,ArrayedTextures) {
 #if !defined(__OSX__)
   GapiTestCommon::ArrayedTextures<VulkanApi>("VulkanApi_ArrayedTextures.png");
@@ -276,6 +419,12 @@ TEST(VulkanApi,Bindless2) {
 #endif
   }
 
+TEST(VulkanApi,DescriptorArrayUpdate) {
+#if !defined(__OSX__)
+  GapiTestCommon::DescriptorArrayUpdate<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,UnusedDescriptor) {
 #if !defined(__OSX__)
   GapiTestCommon::UnusedDescriptor<VulkanApi>("VulkanApi_UnusedDescriptor.png");
@@ -300,6 +449,18 @@ TEST(VulkanApi,RayQuery) {
 #endif
   }
 
+TEST(VulkanApi,RayQueryBatch) {
+#if !defined(__OSX__)
+  GapiTestCommon::RayQueryBatch<VulkanApi>("VulkanApi_RayQueryBatch.png");
+#endif
+  }
+
+TEST(VulkanApi,RayQueryUpdate) {
+#if !defined(__OSX__)
+  GapiTestCommon::RayQueryUpdate<VulkanApi>("VulkanApi_RayQueryUpdate.png");
+#endif
+  }
+
 TEST(VulkanApi,RayQueryFace) {
 #if !defined(__OSX__)
   GapiTestCommon::RayQueryFace<VulkanApi>("VulkanApi_RayQueryFace.png");
@@ -312,6 +473,18 @@ TEST(VulkanApi,MeshShader) {
 #endif
   }
 
+TEST(VulkanApi,MeshShaderEmulated) {
+#if !defined(__OSX__)
+  GapiTestCommon::MeshShaderEmulated<VulkanApi>("VulkanApi_MeshShaderEmulated.png");
+#endif
+  }
+
+TEST(VulkanApi,MeshShaderEmulationRate) {
+#if !defined(__OSX__)
+  GapiTestCommon::MeshShaderEmulationRate<VulkanApi>();
+#endif
+  }
+
 TEST(VulkanApi,DISABLED_MeshComputePrototype) {
 #if !defined(__OSX__)
   GapiTestCommon::MeshComputePrototype<VulkanApi>("VulkanApi_MeshComputePrototype.png");
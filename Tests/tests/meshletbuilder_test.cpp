@@ -0,0 +1,131 @@
+#include <Tempest/MeshletBuilder>
+#include <Tempest/Log>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+#include <chrono>
+#include <set>
+
+using namespace testing;
+using namespace Tempest;
+
+static void makeGrid(uint32_t n, std::vector<Vec3>& vbo, std::vector<uint32_t>& ibo) {
+  for(uint32_t y=0; y<=n; ++y)
+    for(uint32_t x=0; x<=n; ++x)
+      vbo.push_back(Vec3(float(x),float(y),0));
+
+  for(uint32_t y=0; y<n; ++y)
+    for(uint32_t x=0; x<n; ++x) {
+      uint32_t i = y*(n+1)+x;
+      ibo.insert(ibo.end(), {i, i+1, i+n+1});
+      ibo.insert(ibo.end(), {i+1, i+n+2, i+n+1});
+      }
+  }
+
+static void validate(const MeshletBuilder& b, const MeshletBuilder::Result& r,
+                     const std::vector<uint32_t>& ibo) {
+  std::multiset<std::set<uint32_t>> src, dst;
+  for(size_t i=0; i<ibo.size(); i+=3)
+    src.insert({ibo[i+0], ibo[i+1], ibo[i+2]});
+
+  ASSERT_EQ(r.meshlets.size(), r.bounds.size());
+  for(auto& m:r.meshlets) {
+    EXPECT_LE(m.vertexCount,    b.maxVertices());
+    EXPECT_LE(m.primitiveCount, b.maxPrimitives());
+    for(uint32_t i=0; i<m.primitiveCount; ++i) {
+      uint32_t p = r.primitives[m.primitiveOffset+i];
+      uint32_t v[3] = {p&0xFF, (p>>8)&0xFF, (p>>16)&0xFF};
+      for(auto l:v)
+        ASSERT_LT(l, m.vertexCount);
+      dst.insert({r.vertices[m.vertexOffset+v[0]], r.vertices[m.vertexOffset+v[1]], r.vertices[m.vertexOffset+v[2]]});
+      }
+    }
+  EXPECT_TRUE(src==dst);
+  }
+
+TEST(main, MeshletBuilder) {
+  std::vector<Vec3>     vbo;
+  std::vector<uint32_t> ibo;
+  makeGrid(64, vbo, ibo);
+
+  MeshletBuilder builder(64, 124);
+  auto r = builder.build(vbo, ibo);
+  validate(builder, r, ibo);
+
+  // vertex reuse: grid meshlet should be much better than 3 vertices per triangle
+  EXPECT_LT(r.vertices.size(), ibo.size()/2);
+
+  for(auto& b:r.bounds) {
+    // flat grid: all normals are same
+    EXPECT_NEAR(std::abs(b.coneAxis[2]), 1.f, 0.001f);
+    EXPECT_NEAR(b.coneCutoff, 0.f, 0.001f);
+    EXPECT_GT(b.radius, 0.f);
+    }
+  }
+
+TEST(main, MeshletBuilderMultithreaded) {
+  std::vector<Vec3>     vbo;
+  std::vector<uint32_t> ibo;
+  makeGrid(384, vbo, ibo);
+
+  MeshletBuilder builder(64, 64);
+  builder.setThreadCount(4);
+  auto r = builder.build(vbo, ibo);
+  validate(builder, r, ibo);
+  }
+
+TEST(main, MeshletBuilderRate) {
+  std::vector<Vec3>     vbo;
+  std::vector<uint32_t> ibo;
+  makeGrid(512, vbo, ibo);
+
+  const size_t triCount = ibo.size()/3;
+  double       base     = 0;
+  for(uint32_t threads : {1u, 4u}) {
+    MeshletBuilder builder(64, 124);
+    builder.setThreadCount(threads);
+
+    const auto start = std::chrono::steady_clock::now();
+    auto       r     = builder.build(vbo, ibo);
+    const auto dt    = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // every triangle is emitted exactly once
+    ASSERT_EQ(r.primitives.size(), triCount);
+    size_t prim = 0;
+    for(auto& m:r.meshlets)
+      prim += m.primitiveCount;
+    EXPECT_EQ(prim, triCount);
+
+    const double rate = double(triCount)/std::max(dt,1e-6);
+    if(threads==1)
+      base = rate;
+    Log::i("Meshlet build rate, ", threads, " threads: ", int64_t(rate), " triangles/s (x", rate/std::max(base,1.0), ")");
+    }
+  }
+
+TEST(main, MeshletBuilderConeCulling) {
+  std::vector<Vec3>     vbo;
+  std::vector<uint32_t> ibo;
+  makeGrid(16, vbo, ibo);
+
+  MeshletBuilder builder(64, 124);
+  auto r = builder.build(vbo, ibo);
+  ASSERT_FALSE(r.bounds.empty());
+
+  for(auto& b:r.bounds) {
+    const float s = b.coneAxis[2]>0 ? 1.f : -1.f;
+    const Vec3  c = Vec3(b.center[0],b.center[1],b.center[2]);
+    // in front of the grid: visible
+    EXPECT_FALSE(MeshletBuilder::isBackfacing(b, c + Vec3(0,0, 10.f*s)));
+    // grazing view from front side, close to plane: sphere test must keep meshlet
+    EXPECT_FALSE(MeshletBuilder::isBackfacing(b, c + Vec3(b.radius*4.f,0, 0.01f*s)));
+    // behind the grid
+    EXPECT_TRUE (MeshletBuilder::isBackfacing(b, c + Vec3(0,0,-10.f*s - b.radius)));
+    }
+
+  MeshletBuilder::Bounds wide;
+  wide.radius     = 1;
+  wide.coneAxis[2]= 1;
+  wide.coneCutoff = 1;
+  EXPECT_FALSE(MeshletBuilder::isBackfacing(wide, Vec3(0,0,-100)));
+  }
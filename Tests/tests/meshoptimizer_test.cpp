@@ -0,0 +1,84 @@
+#include <Tempest/MeshOptimizer>
+#include <Tempest/Vec>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+#include <algorithm>
+#include <array>
+#include <random>
+#include <set>
+
+using namespace testing;
+using namespace Tempest;
+
+struct Vertex {
+  float x,y,z;
+  float u,v;
+  };
+
+static void makeShuffledGrid(uint32_t n, std::vector<Vertex>& vbo, std::vector<uint32_t>& ibo) {
+  for(uint32_t y=0; y<=n; ++y)
+    for(uint32_t x=0; x<=n; ++x)
+      vbo.push_back(Vertex{float(x),float(y),0,float(x),float(y)});
+
+  std::vector<std::array<uint32_t,3>> tri;
+  for(uint32_t y=0; y<n; ++y)
+    for(uint32_t x=0; x<n; ++x) {
+      uint32_t i = y*(n+1)+x;
+      tri.push_back({i, i+1, i+n+1});
+      tri.push_back({i+1, i+n+2, i+n+1});
+      }
+  std::mt19937 rng(42);
+  std::shuffle(tri.begin(), tri.end(), rng);
+  for(auto& t:tri)
+    ibo.insert(ibo.end(), t.begin(), t.end());
+  }
+
+static std::multiset<std::set<std::pair<float,float>>> triangles(const std::vector<Vertex>& vbo, const std::vector<uint32_t>& ibo) {
+  std::multiset<std::set<std::pair<float,float>>> ret;
+  for(size_t i=0; i<ibo.size(); i+=3) {
+    std::set<std::pair<float,float>> t;
+    for(size_t r=0; r<3; ++r)
+      t.insert({vbo[ibo[i+r]].x, vbo[ibo[i+r]].y});
+    ret.insert(t);
+    }
+  return ret;
+  }
+
+TEST(main, MeshOptimizer) {
+  std::vector<Vertex>   vbo;
+  std::vector<uint32_t> ibo;
+  makeShuffledGrid(64, vbo, ibo);
+
+  const auto src = triangles(vbo, ibo);
+
+  MeshOptimizer opt;
+  auto rep = opt.optimize(vbo, ibo);
+
+  EXPECT_EQ(triangles(vbo, ibo), src);
+  EXPECT_GT(rep.acmrBefore, 2.f);
+  EXPECT_LT(rep.acmrAfter,  1.f);
+  EXPECT_LT(rep.atvrAfter,  rep.atvrBefore);
+
+  // vertex fetch: vertices are referenced in order of first use
+  uint32_t next = 0;
+  for(auto i:ibo) {
+    EXPECT_LE(i, next);
+    if(i==next)
+      ++next;
+    }
+  EXPECT_EQ(next, vbo.size());
+  }
+
+TEST(main, MeshOptimizer16) {
+  std::vector<Vertex>   vbo;
+  std::vector<uint32_t> ibo32;
+  makeShuffledGrid(32, vbo, ibo32);
+
+  std::vector<uint16_t> ibo(ibo32.begin(), ibo32.end());
+  MeshOptimizer opt;
+  const float before = opt.acmr(ibo.data(), ibo.size(), vbo.size());
+  opt.optimizeVertexCache(ibo.data(), ibo.size(), vbo.size());
+  const float after  = opt.acmr(ibo.data(), ibo.size(), vbo.size());
+  EXPECT_LT(after, before);
+  }
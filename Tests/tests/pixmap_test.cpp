@@ -4,6 +4,7 @@
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
+#include <cstring>
 
 using namespace testing;
 using namespace Tempest;
@@ -54,3 +55,47 @@ TEST(main,PixmapConv) {
   EXPECT_EQ(px1.format(),TextureFormat::RGBA16);
   px1.save("tst-dxt5.png");
   }
+
+TEST(main,PixmapDdsDx10) {
+  auto put32 = [](std::vector<uint8_t>& v, size_t at, uint32_t val) {
+    std::memcpy(v.data()+at, &val, sizeof(val));
+    };
+
+  // "DDS " + DDSURFACEDESC2 + DDSHEADERDXT10 + 2 mips of 8x8 BC7
+  std::vector<uint8_t> dds(4+124+20, 0);
+  std::memcpy(dds.data(), "DDS ", 4);
+  put32(dds, 4+0,  124);        // dwSize
+  put32(dds, 4+8,  8);          // dwHeight
+  put32(dds, 4+12, 8);          // dwWidth
+  put32(dds, 4+24, 2);          // dwMipMapCount
+  put32(dds, 4+72+8, 0x30315844); // 'DX10'
+  put32(dds, 4+124+0, 99);      // DXGI_FORMAT_BC7_UNORM_SRGB
+  put32(dds, 4+124+12, 1);      // arraySize
+  dds.resize(dds.size() + (4+1)*16, 0x5A);
+
+  MemReader rd(dds);
+  Pixmap pm(rd);
+  EXPECT_EQ(pm.w(),         8);
+  EXPECT_EQ(pm.h(),         8);
+  EXPECT_EQ(pm.mipCount(),  2);
+  EXPECT_EQ(pm.format(),    TextureFormat::BC7_SRGB);
+  EXPECT_EQ(pm.dataSize(),  (4+1)*16);
+  EXPECT_TRUE(isCompressedFormat(pm.format()));
+  EXPECT_TRUE(isSrgbFormat(pm.format()));
+  }
+
+TEST(main,PixmapFormatSize) {
+  EXPECT_EQ(Pixmap::bppForFormat(TextureFormat::R16F),       2);
+  EXPECT_EQ(Pixmap::bppForFormat(TextureFormat::RG16F),      4);
+  EXPECT_EQ(Pixmap::bppForFormat(TextureFormat::RGB10A2),    4);
+  EXPECT_EQ(Pixmap::bppForFormat(TextureFormat::RGBA8_SRGB), 4);
+  EXPECT_EQ(Pixmap::bppForFormat(TextureFormat::BC7),        0);
+
+  EXPECT_EQ(Pixmap::blockSizeForFormat(TextureFormat::BC4),       8);
+  EXPECT_EQ(Pixmap::blockSizeForFormat(TextureFormat::BC5),       16);
+  EXPECT_EQ(Pixmap::blockSizeForFormat(TextureFormat::BC7_SRGB),  16);
+  EXPECT_EQ(Pixmap::blockSizeForFormat(TextureFormat::DXT1_SRGB), 8);
+
+  Pixmap bc4(5,5,TextureFormat::BC4);
+  EXPECT_EQ(bc4.dataSize(), 4*8);
+  }
@@ -0,0 +1,123 @@
+#include "../utility/shardedmap.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct Entry {
+  int      key     = 0;
+  uint64_t lastUse = 0;
+  };
+
+struct IntHash {
+  size_t operator()(int v) const { return size_t(hashBytes(&v, sizeof(v))); }
+  };
+
+using Map = ShardedMap<int, std::shared_ptr<Entry>, IntHash>;
+
+struct Cache {
+  Map      map;
+  uint64_t tick    = 0;
+  size_t   created = 0;
+  size_t   evicted = 0;
+
+  std::shared_ptr<Entry> find(int key, size_t limit) {
+    bool mk  = false;
+    auto ret = map.findOrInsert(key, [&]() {
+      auto e = std::make_shared<Entry>();
+      e->key = key;
+      mk     = true;
+      ++created;
+      return e;
+      });
+    ret->lastUse = ++tick;
+    if(mk && map.size()>limit) {
+      evicted += map.evictOldest(limit*3/4,
+                                 [](const std::shared_ptr<Entry>& v) { return v->lastUse; },
+                                 [](const std::shared_ptr<Entry>& v) { return v.use_count()==1; },
+                                 [](const std::shared_ptr<Entry>&) {});
+      }
+    return ret;
+    }
+  };
+
+}
+
+TEST(main,ShardedMapFindOrInsert) {
+  Map    map;
+  size_t calls = 0;
+  auto   mk    = [&]() { ++calls; return std::make_shared<Entry>(); };
+
+  auto a = map.findOrInsert(1, mk);
+  auto b = map.findOrInsert(1, mk);
+  auto c = map.findOrInsert(2, mk);
+
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(calls,      2u);
+  EXPECT_EQ(map.size(), 2u);
+  }
+
+TEST(main,ShardedMapConcurrentInsert) {
+  Map                      map;
+  std::vector<std::thread> th;
+  for(int t=0; t<8; ++t) {
+    th.emplace_back([&map]() {
+      for(int i=0; i<1000; ++i)
+        map.findOrInsert(i, [i]() { auto e = std::make_shared<Entry>(); e->key = i; return e; });
+      });
+    }
+  for(auto& t:th)
+    t.join();
+
+  EXPECT_EQ(map.size(), 1000u);
+  map.forEach([](int k, const std::shared_ptr<Entry>& v) {
+    EXPECT_EQ(k, v->key);
+    });
+  }
+
+TEST(main,ShardedMapEviction) {
+  const size_t limit = 256;
+  Cache        cache;
+
+  // pinned entry, like framebuffer referenced by command buffer
+  auto pinned = cache.find(0, limit);
+  for(int i=1; i<int(limit); ++i)
+    cache.find(i, limit);
+  EXPECT_EQ(cache.evicted, 0u);
+  EXPECT_EQ(cache.map.size(), limit);
+
+  // exceed the limit: oldest unreferenced entries are dropped
+  cache.find(int(limit), limit);
+  EXPECT_EQ(cache.map.size(), limit*3/4);
+  EXPECT_EQ(cache.evicted,    limit+1-limit*3/4);
+
+  size_t alive = 0;
+  cache.map.forEach([&](int k, const std::shared_ptr<Entry>&) {
+    if(k==0)
+      ++alive;
+    // survivors are the newest ones
+    if(k!=0)
+      EXPECT_GT(k, int(limit+1-limit*3/4));
+    });
+  EXPECT_EQ(alive, 1u);
+
+  // evicted entry is recreated on next use
+  const size_t created = cache.created;
+  auto e1 = cache.find(1, limit);
+  EXPECT_EQ(cache.created, created+1);
+  EXPECT_EQ(e1->key, 1);
+
+  // pinned entry is never recreated
+  auto p = cache.find(0, limit);
+  EXPECT_EQ(p, pinned);
+  EXPECT_EQ(cache.created, created+1);
+  }
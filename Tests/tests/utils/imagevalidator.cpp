@@ -1,5 +1,6 @@
 #include "imagevalidator.h"
 
+#include <Tempest/VertexQuantizer>
 #include <gtest/gtest.h>
 
 using namespace Tempest;
@@ -19,6 +20,7 @@ ImageValidator::Pixel ImageValidator::at(uint32_t x, uint32_t y) const {
     case TextureFormat::RGB8:
       return decode<uint8_t,3>(d);
     case TextureFormat::RGBA8:
+    case TextureFormat::RGBA8_SRGB:
       return decode<uint8_t,4>(d);
 
     case TextureFormat::R16:
@@ -59,11 +61,26 @@ ImageValidator::Pixel ImageValidator::at(uint32_t x, uint32_t y) const {
     case TextureFormat::DXT1:
     case TextureFormat::DXT3:
     case TextureFormat::DXT5:
+    case TextureFormat::DXT1_SRGB:
+    case TextureFormat::DXT3_SRGB:
+    case TextureFormat::DXT5_SRGB:
+    case TextureFormat::BC4:
+    case TextureFormat::BC5:
+    case TextureFormat::BC7:
+    case TextureFormat::BC7_SRGB:
       assert(false);
       break;
 
-    case TextureFormat::R11G11B10UF:
+    case TextureFormat::R16F:
+      return decodeHalf(reinterpret_cast<const uint16_t*>(d),1);
+    case TextureFormat::RG16F:
+      return decodeHalf(reinterpret_cast<const uint16_t*>(d),2);
     case TextureFormat::RGBA16F:
+      return decodeHalf(reinterpret_cast<const uint16_t*>(d),4);
+    case TextureFormat::RGB10A2:
+      return decodeRGB10A2(reinterpret_cast<const uint32_t*>(d));
+
+    case TextureFormat::R11G11B10UF:
       assert(false);
       break;
     }
@@ -106,6 +123,22 @@ ImageValidator::Pixel ImageValidator::decodeT(const float* x, uint32_t n) {
   return ret;
   }
 
+ImageValidator::Pixel ImageValidator::decodeHalf(const uint16_t* x, uint32_t n) {
+  Pixel ret;
+  for(uint32_t i=0; i<n; ++i)
+    ret.x[i] = VertexQuantizer::fromHalf(x[i]);
+  return ret;
+  }
+
+ImageValidator::Pixel ImageValidator::decodeRGB10A2(const uint32_t* x) {
+  Pixel ret;
+  ret.x[0] = float((x[0] >>  0) & 0x3FF)/1023.f;
+  ret.x[1] = float((x[0] >> 10) & 0x3FF)/1023.f;
+  ret.x[2] = float((x[0] >> 20) & 0x3FF)/1023.f;
+  ret.x[3] = float((x[0] >> 30) & 0x3)/3.f;
+  return ret;
+  }
+
 ImageValidator::Pixel ImageValidator::decodeD24(const uint32_t* x) {
   Pixel ret = {};
   ret.x[0] = float(x[0] & 0x00FFFFFF)/float(0xFFFFFF);
@@ -26,6 +26,8 @@ class ImageValidator {
     static Pixel decodeT(const uint16_t* x, uint32_t n);
     static Pixel decodeT(const uint32_t* x, uint32_t n);
     static Pixel decodeT(const float*    x, uint32_t n);
+    static Pixel decodeHalf(const uint16_t* x, uint32_t n);
+    static Pixel decodeRGB10A2(const uint32_t* x);
     static Pixel decodeD24(const uint32_t* x);
 
     const void*            pm    = nullptr;
@@ -0,0 +1,92 @@
+#include <Tempest/VertexQuantizer>
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace Tempest;
+
+TEST(VertexQuantizer,Half) {
+  EXPECT_EQ(VertexQuantizer::toHalf(0.f),      0x0000);
+  EXPECT_EQ(VertexQuantizer::toHalf(-0.f),     0x8000);
+  EXPECT_EQ(VertexQuantizer::toHalf(1.f),      0x3C00);
+  EXPECT_EQ(VertexQuantizer::toHalf(-2.f),     0xC000);
+  EXPECT_EQ(VertexQuantizer::toHalf(65504.f),  0x7BFF);
+  EXPECT_EQ(VertexQuantizer::toHalf(1e6f),     0x7C00);
+  EXPECT_EQ(VertexQuantizer::toHalf(std::numeric_limits<float>::infinity()), 0x7C00);
+  EXPECT_EQ(VertexQuantizer::toHalf(std::ldexp(1.f,-24)), 0x0001);
+  EXPECT_EQ(VertexQuantizer::toHalf(std::ldexp(1.f,-26)), 0x0000);
+  // tie rounds to even
+  EXPECT_EQ(VertexQuantizer::toHalf(1.f + std::ldexp(1.f,-11)), 0x3C00);
+  EXPECT_EQ(VertexQuantizer::toHalf(1.f + 3.f*std::ldexp(1.f,-11)), 0x3C02);
+
+  EXPECT_TRUE(std::isnan(VertexQuantizer::fromHalf(VertexQuantizer::toHalf(std::nanf("")))));
+
+  for(float v:{0.5f, -0.25f, 3.f, 1024.f, 0.1f, -65504.f}) {
+    float r = VertexQuantizer::fromHalf(VertexQuantizer::toHalf(v));
+    EXPECT_NEAR(r, v, std::abs(v)/1024.f);
+    }
+  EXPECT_EQ(VertexQuantizer::fromHalf(0x0001), std::ldexp(1.f,-24));
+  }
+
+TEST(VertexQuantizer,Normalized) {
+  EXPECT_EQ(VertexQuantizer::toUnorm8(0.f),  0);
+  EXPECT_EQ(VertexQuantizer::toUnorm8(1.f),  255);
+  EXPECT_EQ(VertexQuantizer::toUnorm8(2.f),  255);
+  EXPECT_EQ(VertexQuantizer::toUnorm8(0.5f), 128);
+
+  EXPECT_EQ(VertexQuantizer::toSnorm8(-1.f), -127);
+  EXPECT_EQ(VertexQuantizer::toSnorm8(-5.f), -127);
+  EXPECT_EQ(VertexQuantizer::toSnorm8(1.f),   127);
+
+  EXPECT_EQ(VertexQuantizer::toUnorm16(1.f),  65535);
+  EXPECT_EQ(VertexQuantizer::toSnorm16(-1.f), -32767);
+
+  EXPECT_EQ(VertexQuantizer::toA2B10G10R10(1,0,0,0), 0x000003FFu);
+  EXPECT_EQ(VertexQuantizer::toA2B10G10R10(0,1,0,0), 0x000FFC00u);
+  EXPECT_EQ(VertexQuantizer::toA2B10G10R10(0,0,1,0), 0x3FF00000u);
+  EXPECT_EQ(VertexQuantizer::toA2B10G10R10(0,0,0,1), 0xC0000000u);
+  }
+
+TEST(VertexQuantizer,Quantize) {
+  struct Vertex {
+    float pos  [4];
+    float nrm  [4];
+    float color[3];
+    float uv   [2];
+    };
+  struct Packed {
+    uint16_t pos[4];
+    int8_t   nrm[4];
+    uint32_t color;
+    uint16_t uv[2];
+    };
+
+  const Vertex src[2] = {
+    {{1,2,3,1},    {0,0,-1,0}, {0,0,1}, {0,1}},
+    {{-1,0.5f,0,1}, {-1,0,0,0}, {1,0,0}, {0.5f,0.25f}},
+    };
+  Packed dst[2] = {};
+  VertexQuantizer::quantize(Decl::half4,       dst[0].pos,    sizeof(Packed), src[0].pos,   sizeof(Vertex), 2);
+  VertexQuantizer::quantize(Decl::snorm8x4,    dst[0].nrm,    sizeof(Packed), src[0].nrm,   sizeof(Vertex), 2);
+  VertexQuantizer::quantize(Decl::a2b10g10r10, &dst[0].color, sizeof(Packed), src[0].color, sizeof(Vertex), 2);
+  VertexQuantizer::quantize(Decl::unorm16x2,   dst[0].uv,     sizeof(Packed), src[0].uv,    sizeof(Vertex), 2);
+
+  EXPECT_EQ(dst[0].pos[0], 0x3C00);
+  EXPECT_EQ(dst[0].pos[1], 0x4000);
+  EXPECT_EQ(dst[0].pos[3], 0x3C00);
+  EXPECT_EQ(dst[1].pos[0], 0xBC00);
+  // signed normals keep their sign
+  EXPECT_EQ(dst[0].nrm[2], -127);
+  EXPECT_EQ(dst[1].nrm[0], -127);
+  EXPECT_EQ(dst[1].nrm[1], 0);
+  EXPECT_EQ(dst[0].color,  0x3FF00000u);
+  EXPECT_EQ(dst[1].color,  0x000003FFu);
+  EXPECT_EQ(dst[0].uv[1],  65535);
+  EXPECT_EQ(dst[1].uv[0],  32768);
+
+  EXPECT_EQ(VertexQuantizer::componentCount(Decl::a2b10g10r10), 3u);
+  EXPECT_EQ(Decl::size(Decl::a2b10g10r10), 4u);
+  EXPECT_EQ(Decl::size(Decl::snorm8x4), 4u);
+  }